@@ -0,0 +1,54 @@
+#!/usr/bin/env bash
+# Build and run the REX benchmark suite (test/bench_rex.c)
+#
+# Builds natively by default and runs straight away. Set CROSS_PREFIX
+# (e.g. aarch64-linux-gnu-) to build for Move instead; copy build/bench/
+# to the device and run ./bench_rex --plugin ./dsp.so there.
+#
+# Usage: scripts/bench.sh [.rx2 files or folders...] > results.jsonl
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+REPO_ROOT="$(dirname "$SCRIPT_DIR")"
+cd "$REPO_ROOT"
+
+CC="${CROSS_PREFIX}gcc"
+CFLAGS="-O3 -DNDEBUG -Isrc/dsp"
+if [ -n "$CROSS_PREFIX" ]; then
+    CFLAGS="$CFLAGS -march=armv8-a -mtune=cortex-a72"
+fi
+
+mkdir -p build/bench
+
+echo "Compiling benchmark plugin..." >&2
+$CC $CFLAGS -shared -fPIC \
+    src/dsp/rex_plugin.c \
+    src/dsp/dwop.c \
+    src/dsp/rex_parser.c \
+    src/dsp/rex_cache.c \
+    src/dsp/rex_loader.c \
+    src/dsp/mapped_file.c \
+    src/dsp/rex_sidecar.c \
+    src/dsp/rex_library.c \
+    src/dsp/rex_catalog.c \
+    src/dsp/resample.c \
+    -o build/bench/dsp.so \
+    -lm -lpthread
+
+echo "Compiling bench_rex..." >&2
+$CC $CFLAGS \
+    test/bench_rex.c \
+    src/dsp/dwop.c \
+    src/dsp/dwop_encode.c \
+    src/dsp/byte_sink.c \
+    src/dsp/rex_writer.c \
+    src/dsp/rex_parser.c \
+    -o build/bench/bench_rex \
+    -lm -lpthread -ldl
+
+if [ -n "$CROSS_PREFIX" ]; then
+    echo "Cross build done: build/bench/bench_rex and build/bench/dsp.so" >&2
+    exit 0
+fi
+
+./build/bench/bench_rex --plugin build/bench/dsp.so "$@"
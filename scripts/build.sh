@@ -61,6 +61,62 @@ ${CROSS_PREFIX}gcc -O3 -fPIC \
     -c src/dsp/rex_parser.c -o build/rex_parser.o \
     -Isrc/dsp
 
+echo "Compiling mapped file reader..."
+${CROSS_PREFIX}gcc -O3 -fPIC \
+    -march=armv8-a -mtune=cortex-a72 \
+    -DNDEBUG \
+    -c src/dsp/mapped_file.c -o build/mapped_file.o \
+    -Isrc/dsp
+
+echo "Compiling REX sidecar..."
+${CROSS_PREFIX}gcc -O3 -fPIC \
+    -march=armv8-a -mtune=cortex-a72 \
+    -DNDEBUG \
+    -c src/dsp/rex_sidecar.c -o build/rex_sidecar.o \
+    -Isrc/dsp
+
+echo "Compiling REX library index..."
+${CROSS_PREFIX}gcc -O3 -fPIC \
+    -march=armv8-a -mtune=cortex-a72 \
+    -DNDEBUG \
+    -c src/dsp/rex_library.c -o build/rex_library.o \
+    -Isrc/dsp
+
+echo "Compiling REX catalog..."
+${CROSS_PREFIX}gcc -O3 -fPIC \
+    -march=armv8-a -mtune=cortex-a72 \
+    -DNDEBUG \
+    -c src/dsp/rex_catalog.c -o build/rex_catalog.o \
+    -Isrc/dsp
+
+echo "Compiling REX cache..."
+${CROSS_PREFIX}gcc -O3 -fPIC \
+    -march=armv8-a -mtune=cortex-a72 \
+    -DNDEBUG \
+    -c src/dsp/rex_cache.c -o build/rex_cache.o \
+    -Isrc/dsp
+
+echo "Compiling REX loader..."
+${CROSS_PREFIX}gcc -O3 -fPIC \
+    -march=armv8-a -mtune=cortex-a72 \
+    -DNDEBUG \
+    -c src/dsp/rex_loader.c -o build/rex_loader.o \
+    -Isrc/dsp
+
+echo "Compiling REX kits..."
+${CROSS_PREFIX}gcc -O3 -fPIC \
+    -march=armv8-a -mtune=cortex-a72 \
+    -DNDEBUG \
+    -c src/dsp/rex_kit.c -o build/rex_kit.o \
+    -Isrc/dsp
+
+echo "Compiling byte sinks..."
+${CROSS_PREFIX}gcc -O3 -fPIC \
+    -march=armv8-a -mtune=cortex-a72 \
+    -DNDEBUG \
+    -c src/dsp/byte_sink.c -o build/byte_sink.o \
+    -Isrc/dsp
+
 echo "Compiling DWOP encoder..."
 ${CROSS_PREFIX}gcc -O3 -fPIC \
     -march=armv8-a -mtune=cortex-a72 \
@@ -81,6 +137,20 @@ ${CROSS_PREFIX}gcc -O3 -fPIC \
     -c src/dsp/rex_writer.c -o build/rex_writer.o \
     -Isrc/dsp
 
+echo "Compiling resampler..."
+${CROSS_PREFIX}gcc -O3 -fPIC \
+    -march=armv8-a -mtune=cortex-a72 \
+    -DNDEBUG \
+    -c src/dsp/resample.c -o build/resample.o \
+    -Isrc/dsp
+
+echo "Compiling MIDI file reader..."
+${CROSS_PREFIX}gcc -O3 -fPIC \
+    -march=armv8-a -mtune=cortex-a72 \
+    -DNDEBUG \
+    -c src/dsp/midi_file.c -o build/midi_file.o \
+    -Isrc/dsp
+
 echo "Compiling REX plugin..."
 ${CROSS_PREFIX}gcc -O3 -shared -fPIC \
     -march=armv8-a -mtune=cortex-a72 \
@@ -88,23 +158,64 @@ ${CROSS_PREFIX}gcc -O3 -shared -fPIC \
     src/dsp/rex_plugin.c \
     build/dwop.o \
     build/rex_parser.o \
+    build/rex_cache.o \
+    build/rex_loader.o \
+    build/rex_kit.o \
+    build/mapped_file.o \
+    build/rex_sidecar.o \
+    build/rex_library.o \
+    build/rex_catalog.o \
+    build/resample.o \
     -o build/dsp.so \
     -Isrc/dsp \
-    -lm
+    -lm -lpthread
+
+echo "Compiling REX batch encoder..."
+${CROSS_PREFIX}gcc -O3 \
+    -march=armv8-a -mtune=cortex-a72 \
+    -DNDEBUG \
+    -c src/dsp/rex_batch.c -o build/rex_batch.o \
+    -Isrc/dsp
 
 echo "Compiling rex-encode CLI..."
 ${CROSS_PREFIX}gcc -O3 \
     -march=armv8-a -mtune=cortex-a72 \
     -DNDEBUG \
     src/dsp/rex_encode_main.c \
+    build/rex_batch.o \
+    build/byte_sink.o \
     build/dwop_encode.o \
     build/dwop.o \
     build/wav_reader.o \
     build/rex_writer.o \
     build/rex_parser.o \
+    build/mapped_file.o \
+    build/rex_sidecar.o \
     -o build/rex-encode \
     -Isrc/dsp \
-    -lm
+    -lm -lpthread
+
+echo "Compiling rex-render CLI..."
+${CROSS_PREFIX}gcc -O3 \
+    -march=armv8-a -mtune=cortex-a72 \
+    -DNDEBUG \
+    src/dsp/rex_render_main.c \
+    src/dsp/rex_plugin.c \
+    build/midi_file.o \
+    build/byte_sink.o \
+    build/dwop.o \
+    build/rex_parser.o \
+    build/rex_cache.o \
+    build/rex_loader.o \
+    build/rex_kit.o \
+    build/mapped_file.o \
+    build/rex_sidecar.o \
+    build/rex_library.o \
+    build/rex_catalog.o \
+    build/resample.o \
+    -o build/rex-render \
+    -Isrc/dsp \
+    -lm -lpthread
 
 # Copy files to dist (use cat to avoid ExtFS deallocation issues with Docker)
 echo "Packaging..."
@@ -115,6 +226,8 @@ cat build/dsp.so > dist/rex/dsp.so
 chmod +x dist/rex/dsp.so
 cat build/rex-encode > dist/rex/rex-encode
 chmod +x dist/rex/rex-encode
+cat build/rex-render > dist/rex/rex-render
+chmod +x dist/rex/rex-render
 
 # Create loops directory for user-supplied REX files
 mkdir -p dist/rex/loops
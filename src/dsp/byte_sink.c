@@ -0,0 +1,184 @@
+/*
+ * Byte Sinks
+ *
+ * License: MIT
+ */
+
+#include "byte_sink.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+void byte_sink_init_buffer(byte_sink_t *s, uint8_t *buf, size_t cap)
+{
+    memset(s, 0, sizeof(*s));
+    s->buf = buf;
+    s->cap = buf ? cap : 0;
+    s->fd = -1;
+    s->fd_start = -1;
+}
+
+void byte_sink_init_growable(byte_sink_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->fd = -1;
+    s->fd_start = -1;
+    s->owned = 1;
+}
+
+int byte_sink_init_fd(byte_sink_t *s, int fd)
+{
+    memset(s, 0, sizeof(*s));
+    s->fd = fd;
+    s->fd_start = lseek(fd, 0, SEEK_CUR);
+    s->owned = 1;
+    s->buf = (uint8_t *)malloc(BYTE_SINK_STAGING);
+    if (!s->buf) {
+        s->error = 1;
+        return -1;
+    }
+    s->cap = BYTE_SINK_STAGING;
+    return 0;
+}
+
+static int write_all(int fd, const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+int byte_sink_flush(byte_sink_t *s)
+{
+    if (s->error) return -1;
+    if (s->fd < 0 || s->len == 0) return 0;
+    if (write_all(s->fd, s->buf, s->len) != 0) {
+        s->error = 1;
+        return -1;
+    }
+    s->base += s->len;
+    s->len = 0;
+    return 0;
+}
+
+uint8_t *byte_sink_reserve(byte_sink_t *s, size_t want, size_t *avail)
+{
+    *avail = 0;
+    if (s->error) return NULL;
+    if (want == 0) want = 1;
+
+    if (s->cap - s->len < want) {
+        if (s->fd >= 0) {
+            if (byte_sink_flush(s) != 0) return NULL;
+            if (want > s->cap) want = s->cap;  /* offer the whole staging */
+        } else if (s->owned) {
+            size_t new_cap = s->cap ? s->cap : 4096;
+            while (new_cap - s->len < want) new_cap *= 2;
+            uint8_t *grown = (uint8_t *)realloc(s->buf, new_cap);
+            if (!grown) {
+                s->error = 1;
+                return NULL;
+            }
+            s->buf = grown;
+            s->cap = new_cap;
+        } else if (s->len == s->cap) {
+            s->error = 1;  /* fixed buffer full */
+            return NULL;
+        }
+    }
+
+    *avail = s->cap - s->len;
+    return s->buf + s->len;
+}
+
+void byte_sink_advance(byte_sink_t *s, size_t n)
+{
+    s->len += n;
+}
+
+int byte_sink_write(byte_sink_t *s, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    while (len > 0) {
+        size_t avail;
+        uint8_t *dst = byte_sink_reserve(s, len, &avail);
+        if (!dst) return -1;
+        size_t n = len < avail ? len : avail;
+        memcpy(dst, p, n);
+        s->len += n;
+        p += n;
+        len -= n;
+    }
+    return s->error ? -1 : 0;
+}
+
+size_t byte_sink_tell(const byte_sink_t *s)
+{
+    return s->base + s->len;
+}
+
+int byte_sink_patch(byte_sink_t *s, size_t offset, const void *data, size_t len)
+{
+    if (s->error) return -1;
+    if (offset + len > byte_sink_tell(s)) {
+        s->error = 1;
+        return -1;
+    }
+
+    /* Bytes still in the buffer */
+    const uint8_t *p = (const uint8_t *)data;
+    if (offset + len > s->base) {
+        size_t skip = offset < s->base ? s->base - offset : 0;
+        memcpy(s->buf + (offset + skip - s->base), p + skip, len - skip);
+        len = skip;
+    }
+
+    /* Bytes already written out to the fd */
+    while (len > 0) {
+        if (s->fd_start < 0) {
+            s->error = 1;
+            return -1;
+        }
+        ssize_t n = pwrite(s->fd, p, len, s->fd_start + (off_t)offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            s->error = 1;
+            return -1;
+        }
+        p += n;
+        offset += (size_t)n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+int byte_sink_error(const byte_sink_t *s)
+{
+    return s->error;
+}
+
+uint8_t *byte_sink_take(byte_sink_t *s, size_t *len)
+{
+    uint8_t *buf = s->buf;
+    *len = s->len;
+    s->buf = NULL;
+    s->len = 0;
+    s->cap = 0;
+    return buf;
+}
+
+void byte_sink_free(byte_sink_t *s)
+{
+    if (s->owned) free(s->buf);
+    s->buf = NULL;
+    s->len = 0;
+    s->cap = 0;
+}
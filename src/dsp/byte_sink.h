@@ -0,0 +1,80 @@
+/*
+ * Byte Sinks
+ *
+ * Destination for encoder and writer output that does not need its size
+ * guessed up front: a caller's fixed buffer (fails cleanly when full), a
+ * growable heap buffer, or a file descriptor fed through a staging buffer.
+ * Producers either copy bytes in with byte_sink_write() or, to avoid the
+ * copy, fill the window returned by byte_sink_reserve() and commit it with
+ * byte_sink_advance(). Bytes already written can be overwritten later with
+ * byte_sink_patch(), for sizes that are only known at the end.
+ *
+ * Errors are sticky: after the first failure every call fails and
+ * byte_sink_error() is set.
+ *
+ * License: MIT
+ */
+
+#ifndef BYTE_SINK_H
+#define BYTE_SINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#define BYTE_SINK_STAGING (64 * 1024)  /* fd sink staging buffer */
+
+typedef struct {
+    uint8_t *buf;      /* memory sinks: the output; fd sink: staging */
+    size_t len;        /* bytes in buf */
+    size_t cap;
+    size_t base;       /* fd sink: bytes written out before buf[0] */
+    int fd;            /* -1 for memory sinks */
+    off_t fd_start;    /* fd sink: file offset of byte 0, -1 if unseekable */
+    int owned;         /* buf is ours to grow and free */
+    int error;
+} byte_sink_t;
+
+/* Write into buf[0..cap); running out of room is an error */
+void byte_sink_init_buffer(byte_sink_t *s, uint8_t *buf, size_t cap);
+
+/* Write into a heap buffer that grows as needed (see byte_sink_take) */
+void byte_sink_init_growable(byte_sink_t *s);
+
+/* Write to fd from its current offset. Patching needs a seekable fd.
+ * Returns 0, or -1 if out of memory. */
+int byte_sink_init_fd(byte_sink_t *s, int fd);
+
+/* Append len bytes. Returns 0, or -1 on error. */
+int byte_sink_write(byte_sink_t *s, const void *data, size_t len);
+
+/* Writable window at the end of the output, ideally want bytes long (a
+ * fixed buffer may offer less). Sets *avail and returns it, or returns
+ * NULL on error or a full fixed buffer. The window is valid until the
+ * next call on the sink. */
+uint8_t *byte_sink_reserve(byte_sink_t *s, size_t want, size_t *avail);
+
+/* Commit n bytes filled in the last reserved window */
+void byte_sink_advance(byte_sink_t *s, size_t n);
+
+/* Bytes output so far */
+size_t byte_sink_tell(const byte_sink_t *s);
+
+/* Overwrite len bytes at offset (which must already be written).
+ * Returns 0, or -1 on error. */
+int byte_sink_patch(byte_sink_t *s, size_t offset, const void *data, size_t len);
+
+/* Write out anything staged (fd sink). Returns 0, or -1 on error. */
+int byte_sink_flush(byte_sink_t *s);
+
+int byte_sink_error(const byte_sink_t *s);
+
+/* Growable sink: hand over the buffer (release with free()) and its
+ * length. The sink is left empty. */
+uint8_t *byte_sink_take(byte_sink_t *s, size_t *len);
+
+/* Free owned buffers (staging, or an untaken growable buffer). Does not
+ * flush or close the fd. */
+void byte_sink_free(byte_sink_t *s);
+
+#endif /* BYTE_SINK_H */
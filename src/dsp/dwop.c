@@ -19,25 +19,38 @@
 #include "dwop.h"
 #include <string.h>
 
-/* Predictor case mapping: energy index -> prediction order.
- * Energy index 0 -> case 0 (order 0: raw sample)
- * Energy index 1 -> case 1 (order 1: 1st difference)
- * Energy index 2 -> case 4 (order 2: 2nd difference)
- * Energy index 3 -> case 2 (order 3: 3rd difference)
- * Energy index 4 -> case 3 (order 4: 4th difference) */
-static const int PRED_MAP[5] = {0, 1, 4, 2, 3};
+/* Predictor update masks, indexed by the selected (minimum-energy)
+ * predictor, which is also the difference order d belongs to:
+ * energy index 0 -> order 0 (raw sample), 1 -> 1st difference,
+ * 2 -> 2nd, 3 -> 3rd, 4 -> 4th difference.
+ *
+ * With o[] the previous state, the new state satisfies
+ * S[i] = S[i-1] - o[i-1] for every i and S[order] = d, so
+ * S[0] = d + o[0] + ... + o[order-1]: a masked prefix sum. */
+static const uint32_t PRED_MASK[5][4] = {
+    { 0,  0,  0,  0 },
+    { ~0u, 0,  0,  0 },
+    { ~0u, ~0u, 0,  0 },
+    { ~0u, ~0u, ~0u, 0 },
+    { ~0u, ~0u, ~0u, ~0u },
+};
 
 #define DWOP_ENERGY_INIT  2560
 #define DWOP_MAX_UNARY    50000
 
 /* --- Internal types for stereo (split bitreader from channel state) --- */
 
+/* 64-bit window bit reader. window holds the next unread bits MSB-aligned;
+ * avail of them are valid (bits below may already hold the following data).
+ * Reading past the end yields zero bits, which pad counts, so the position
+ * can be reported exactly like the byte-at-a-time reader it replaces. */
 typedef struct {
     const uint8_t *data;
     int data_len;
-    int byte_pos;
-    int bit_pos;
-    uint8_t cur;
+    int byte_pos;      /* next byte to move into the window */
+    int avail;
+    uint64_t window;
+    int64_t pad;
 } dwop_br_t;
 
 typedef struct {
@@ -47,187 +60,127 @@ typedef struct {
     int ba;
 } dwop_ch_t;
 
-/* --- Bit reader (MSB first, byte-by-byte) --- */
+/* --- Bit reader (MSB first, 64-bit window) --- */
 
-static inline int br_bit(dwop_state_t *st)
+static inline uint64_t load_be64(const uint8_t *p)
 {
-    if (!st->bit_pos) {
-        if (st->byte_pos >= st->data_len)
-            return 0;
-        st->cur = st->data[st->byte_pos++];
-        st->bit_pos = 8;
-    }
-    st->bit_pos--;
-    return (st->cur >> st->bit_pos) & 1;
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
 }
 
-static inline uint32_t br_bits(dwop_state_t *st, int n)
+/* Top up the window to at least 57 valid bits */
+static inline void br_refill(dwop_br_t *b)
 {
-    uint32_t v = 0;
-    for (int i = 0; i < n; i++)
-        v = (v << 1) | (uint32_t)br_bit(st);
-    return v;
+    if (b->avail > 56)
+        return;
+    if (b->byte_pos + 8 <= b->data_len) {
+        b->window |= load_be64(b->data + b->byte_pos) >> b->avail;
+        int take = (64 - b->avail) >> 3;
+        b->byte_pos += take;
+        b->avail += take * 8;
+        return;
+    }
+    while (b->avail <= 56) {
+        if (b->byte_pos < b->data_len)
+            b->window |= (uint64_t)b->data[b->byte_pos++] << (56 - b->avail);
+        else
+            b->pad += 8;
+        b->avail += 8;
+    }
 }
 
-/* --- Public API --- */
-
-void dwop_init(dwop_state_t *state, const uint8_t *data, int data_len)
+static inline void br_skip(dwop_br_t *b, int n)
 {
-    memset(state, 0, sizeof(*state));
-    state->data = data;
-    state->data_len = data_len;
-    state->rv = 2;
-    for (int i = 0; i < 5; i++)
-        state->e[i] = DWOP_ENERGY_INIT;
+    b->window = (n < 64) ? b->window << n : 0;
+    b->avail -= n;
 }
 
-int dwop_decode(dwop_state_t *state, int16_t *out, int max_samples, int out_shift)
+/* Read n bits, 1 <= n <= 32 */
+static inline uint32_t br_bits(dwop_br_t *b, int n)
 {
-    int n;
-
-    for (n = 0; n < max_samples; n++) {
-        /* 1. Find predictor with minimum energy */
-        uint32_t min_e = (uint32_t)state->e[0];
-        int p_order = 0;
-        for (int i = 1; i < 5; i++) {
-            if ((uint32_t)state->e[i] < min_e) {
-                min_e = (uint32_t)state->e[i];
-                p_order = i;
-            }
-        }
-
-        /* 2. Quantizer step */
-        uint32_t step = (min_e * 3 + 0x24) >> 7;
-
-        /* 3. Unary-coded quotient */
-        uint32_t acc = 0, cs = step;
-        int qc = 7, uc = 0;
-        for (;;) {
-            if (br_bit(state) == 1)
-                break;
-            acc += cs;
-            if (--qc == 0) {
-                cs <<= 2;
-                qc = 7;
-            }
-            if (++uc > DWOP_MAX_UNARY)
-                return n;  /* safety bail */
-        }
-
-        /* 4. Range coder for remainder */
-        int nb = state->ba;
-        if (cs >= state->rv) {
-            while (cs >= state->rv) {
-                state->rv <<= 1;
-                if (!state->rv)
-                    return n;
-                nb++;
-            }
-        } else {
-            nb++;
-            uint32_t t = state->rv;
-            for (;;) {
-                state->rv = t;
-                t >>= 1;
-                nb--;
-                if (cs >= t)
-                    break;
-            }
-        }
-
-        uint32_t ext = (nb > 0) ? br_bits(state, nb) : 0;
-        uint32_t co = state->rv - cs;
-        uint32_t rem;
-        if (ext < co) {
-            rem = ext;
-        } else {
-            int x = br_bit(state);
-            rem = co + (ext - co) * 2 + (uint32_t)x;
-        }
-
-        uint32_t val = acc + rem;
-        state->ba = nb;
-
-        /* 5. DWOP zigzag: produces doubled delta */
-        int32_t d = (int32_t)(val ^ (uint32_t)(-(int32_t)(val & 1)));
+    br_refill(b);
+    uint32_t v = (uint32_t)(b->window >> (64 - n));
+    br_skip(b, n);
+    return v;
+}
 
-        /* 6. Predictor update */
-        int32_t o[5];
-        memcpy(o, state->S, sizeof(o));
+static inline int br_bit(dwop_br_t *b)
+{
+    return (int)br_bits(b, 1);
+}
 
-        switch (PRED_MAP[p_order]) {
-        case 0: /* Order 0: d is the sample (doubled) */
-            state->S[0] = d;
-            state->S[1] = d - o[0];
-            state->S[2] = state->S[1] - o[1];
-            state->S[3] = state->S[2] - o[2];
-            state->S[4] = state->S[3] - o[3];
-            break;
-        case 1: /* Order 1: d is 1st difference (doubled) */
-            state->S[0] = o[0] + d;
-            state->S[1] = d;
-            state->S[2] = d - o[1];
-            state->S[3] = state->S[2] - o[2];
-            state->S[4] = state->S[3] - o[3];
-            break;
-        case 4: /* Order 2: d is 2nd difference (doubled) */
-            state->S[1] = o[1] + d;
-            state->S[0] = o[0] + state->S[1];
-            state->S[2] = d;
-            state->S[3] = d - o[2];
-            state->S[4] = state->S[3] - o[3];
-            break;
-        case 2: /* Order 3: d is 3rd difference (doubled) */
-            state->S[2] = o[2] + d;
-            state->S[1] = o[1] + state->S[2];
-            state->S[0] = o[0] + state->S[1];
-            state->S[3] = d;
-            state->S[4] = d - o[3];
-            break;
-        case 3: /* Order 4: d is 4th difference (doubled) */
-            state->S[3] = o[3] + d;
-            state->S[2] = o[2] + state->S[3];
-            state->S[1] = o[1] + state->S[2];
-            state->S[0] = o[0] + state->S[1];
-            state->S[4] = d;
-            break;
+/* Consume a run of 0 bits and its terminating 1 bit, counting the zeros
+ * with one CLZ per window. Returns the count, or -1 once more than
+ * DWOP_MAX_UNARY zeros have been consumed (the 1 bit is then left unread). */
+static inline int br_unary(dwop_br_t *b)
+{
+    int q = 0;
+    for (;;) {
+        br_refill(b);
+        int z = b->window ? __builtin_clzll(b->window) : 64;
+        if (z > b->avail)
+            z = b->avail;
+        if (q + z > DWOP_MAX_UNARY) {
+            br_skip(b, DWOP_MAX_UNARY + 1 - q);
+            return -1;
         }
-
-        /* Energy update: cheap abs = S ^ (S >> 31) */
-        for (int i = 0; i < 5; i++) {
-            int32_t as = state->S[i] ^ (state->S[i] >> 31);
-            state->e[i] = state->e[i] + as - (int32_t)((uint32_t)state->e[i] >> 5);
+        if (z < b->avail) {
+            br_skip(b, z + 1);
+            return q + z;
         }
-
-        /* 7. Output: right-shift to un-double and convert to 16-bit */
-        out[n] = (int16_t)(state->S[0] >> out_shift);
+        q += z;
+        br_skip(b, z);
     }
-
-    return n;
 }
 
-/* --- Stereo decoder internals --- */
-
-static inline int sbr_bit(dwop_br_t *b)
+/* Position the reader as the byte reader would be after byte_pos bytes
+ * were fetched with bit_pos bits of the last one still unread */
+static void br_seek(dwop_br_t *b, const uint8_t *data, int data_len,
+                    int byte_pos, int bit_pos)
 {
-    if (!b->bit_pos) {
-        if (b->byte_pos >= b->data_len)
-            return 0;
-        b->cur = b->data[b->byte_pos++];
-        b->bit_pos = 8;
+    int64_t consumed = (int64_t)byte_pos * 8 - bit_pos;
+    b->data = data;
+    b->data_len = data_len;
+    b->byte_pos = (int)(consumed >> 3);
+    b->avail = 0;
+    b->window = 0;
+    b->pad = 0;
+    if (consumed & 7) {
+        br_refill(b);
+        br_skip(b, (int)(consumed & 7));
     }
-    b->bit_pos--;
-    return (b->cur >> b->bit_pos) & 1;
 }
 
-static inline uint32_t sbr_bits(dwop_br_t *b, int n)
+/* Report the position in byte reader terms (the inverse of br_seek) */
+static void br_tell(const dwop_br_t *b, int *byte_pos, int *bit_pos, uint8_t *cur)
 {
-    uint32_t v = 0;
-    for (int i = 0; i < n; i++)
-        v = (v << 1) | (uint32_t)sbr_bit(b);
-    return v;
+    int64_t consumed = (int64_t)b->byte_pos * 8 + b->pad - b->avail;
+    if (consumed > (int64_t)b->data_len * 8)
+        consumed = (int64_t)b->data_len * 8;  /* the byte reader stops there */
+    int bytes = (int)((consumed + 7) >> 3);
+    *byte_pos = bytes;
+    *bit_pos = (int)((int64_t)bytes * 8 - consumed);
+    *cur = bytes > 0 ? b->data[bytes - 1] : 0;
 }
 
+/* Sum of the unary quotient: the step is added once per zero bit and
+ * quadruples after every 7 zeros. Closed form of that running sum, with
+ * the same wrap-around mod 2^32. cs receives the final step. */
+static inline uint32_t unary_sum(uint32_t step, int q, uint32_t *cs)
+{
+    int g = q / 7, r = q % 7;
+    uint32_t p = (g >= 16) ? 0 : 1u << (2 * g);          /* 4^g */
+    uint32_t geo = (g >= 16) ? 0x55555555u : (p - 1) / 3;  /* sum of 4^i, i < g */
+    *cs = step * p;
+    return 7u * step * geo + (uint32_t)r * step * p;
+}
+
+/* --- Channel kernel (shared by mono and stereo) --- */
+
 static void sch_init(dwop_ch_t *c)
 {
     memset(c->S, 0, sizeof(c->S));
@@ -237,11 +190,15 @@ static void sch_init(dwop_ch_t *c)
     c->ba = 0;
 }
 
-/* Decode one sample from channel state using shared bit reader.
- * Returns full-precision value (S[0] >> 1), caller applies output shift. */
-static int32_t stereo_decode_one(dwop_ch_t *ch, dwop_br_t *br)
+/* Decode one sample of one channel into ch->S (S[0] = sample * 2).
+ * Returns 0, or -1 on a corrupt stream. Forced inline: every caller is a
+ * per-sample loop and keeps ch in registers only when it is inlined. */
+static inline __attribute__((always_inline))
+int channel_step(dwop_ch_t *ch, dwop_br_t *br)
 {
-    /* 1. Find predictor with minimum energy */
+    /* 1. Find predictor with minimum energy (first wins on ties). Kept as
+     * a branch: the choice rarely changes between samples, and a predicted
+     * branch lets the quantizer step start before the compares resolve. */
     uint32_t min_e = (uint32_t)ch->e[0];
     int p_order = 0;
     for (int i = 1; i < 5; i++) {
@@ -255,27 +212,19 @@ static int32_t stereo_decode_one(dwop_ch_t *ch, dwop_br_t *br)
     uint32_t step = (min_e * 3 + 0x24) >> 7;
 
     /* 3. Unary-coded quotient */
-    uint32_t acc = 0, cs = step;
-    int qc = 7, uc = 0;
-    for (;;) {
-        if (sbr_bit(br) == 1)
-            break;
-        acc += cs;
-        if (--qc == 0) {
-            cs <<= 2;
-            qc = 7;
-        }
-        if (++uc > DWOP_MAX_UNARY)
-            return 0;
-    }
+    int q = br_unary(br);
+    if (q < 0)
+        return -1;  /* safety bail */
+    uint32_t cs;
+    uint32_t acc = unary_sum(step, q, &cs);
 
-    /* 4. Range coder for remainder */
+    /* 4. Range coder for remainder (rarely more than one step either way) */
     int nb = ch->ba;
     if (cs >= ch->rv) {
         while (cs >= ch->rv) {
             ch->rv <<= 1;
             if (!ch->rv)
-                return 0;
+                return -1;
             nb++;
         }
     } else {
@@ -290,77 +239,126 @@ static int32_t stereo_decode_one(dwop_ch_t *ch, dwop_br_t *br)
         }
     }
 
-    uint32_t ext = (nb > 0) ? sbr_bits(br, nb) : 0;
+    uint32_t ext = (nb > 0) ? br_bits(br, nb) : 0;
     uint32_t co = ch->rv - cs;
     uint32_t rem;
     if (ext < co) {
         rem = ext;
     } else {
-        int x = sbr_bit(br);
+        int x = br_bit(br);
         rem = co + (ext - co) * 2 + (uint32_t)x;
     }
 
     uint32_t val = acc + rem;
     ch->ba = nb;
 
-    /* 5. DWOP zigzag */
-    int32_t d = (int32_t)(val ^ (uint32_t)(-(int32_t)(val & 1)));
-
-    /* 6. Predictor update */
-    int32_t o[5];
-    memcpy(o, ch->S, sizeof(o));
-
-    switch (PRED_MAP[p_order]) {
-    case 0:
-        ch->S[0] = d;
-        ch->S[1] = d - o[0];
-        ch->S[2] = ch->S[1] - o[1];
-        ch->S[3] = ch->S[2] - o[2];
-        ch->S[4] = ch->S[3] - o[3];
-        break;
-    case 1:
-        ch->S[0] = o[0] + d;
-        ch->S[1] = d;
-        ch->S[2] = d - o[1];
-        ch->S[3] = ch->S[2] - o[2];
-        ch->S[4] = ch->S[3] - o[3];
-        break;
-    case 4:
-        ch->S[1] = o[1] + d;
-        ch->S[0] = o[0] + ch->S[1];
-        ch->S[2] = d;
-        ch->S[3] = d - o[2];
-        ch->S[4] = ch->S[3] - o[3];
-        break;
-    case 2:
-        ch->S[2] = o[2] + d;
-        ch->S[1] = o[1] + ch->S[2];
-        ch->S[0] = o[0] + ch->S[1];
-        ch->S[3] = d;
-        ch->S[4] = d - o[3];
-        break;
-    case 3:
-        ch->S[3] = o[3] + d;
-        ch->S[2] = o[2] + ch->S[3];
-        ch->S[1] = o[1] + ch->S[2];
-        ch->S[0] = o[0] + ch->S[1];
-        ch->S[4] = d;
-        break;
-    }
-
-    /* Energy update */
+    /* 5. DWOP zigzag: produces doubled delta */
+    uint32_t d = val ^ (uint32_t)(-(int32_t)(val & 1));
+
+    /* 6. Predictor update: prefix sum for S[0], then the difference chain
+     * (unsigned arithmetic: wraps exactly like the reference decoder) */
+    const uint32_t *m = PRED_MASK[p_order];
+    uint32_t o0 = (uint32_t)ch->S[0], o1 = (uint32_t)ch->S[1];
+    uint32_t o2 = (uint32_t)ch->S[2], o3 = (uint32_t)ch->S[3];
+    uint32_t s0 = d + (o0 & m[0]) + (o1 & m[1]) + (o2 & m[2]) + (o3 & m[3]);
+    uint32_t s1 = s0 - o0;
+    uint32_t s2 = s1 - o1;
+    uint32_t s3 = s2 - o2;
+    ch->S[0] = (int32_t)s0;
+    ch->S[1] = (int32_t)s1;
+    ch->S[2] = (int32_t)s2;
+    ch->S[3] = (int32_t)s3;
+    ch->S[4] = (int32_t)(s3 - o3);
+
+    /* Energy update: cheap abs = S ^ (S >> 31) */
     for (int i = 0; i < 5; i++) {
         int32_t as = ch->S[i] ^ (ch->S[i] >> 31);
-        ch->e[i] = ch->e[i] + as - (int32_t)((uint32_t)ch->e[i] >> 5);
+        ch->e[i] = (int32_t)((uint32_t)ch->e[i] + (uint32_t)as - ((uint32_t)ch->e[i] >> 5));
     }
 
+    return 0;
+}
+
+/* Stereo sample: full-precision value (S[0] >> 1), caller applies output
+ * shift. On a corrupt stream returns 0 and sets *bail (if non-NULL). */
+static inline int32_t stereo_decode_one(dwop_ch_t *ch, dwop_br_t *br, int *bail)
+{
+    if (channel_step(ch, br) != 0) {
+        if (bail) *bail = 1;
+        return 0;
+    }
     return ch->S[0] >> 1;
 }
 
+/* Full-precision frame loop (S[0] >> 1 per sample). Mono stops at a
+ * corrupt sample like dwop_decode; stereo carries on. */
+static int decode_frames_wide(dwop_br_t *br, dwop_ch_t *ch, int channels,
+                              int32_t *out, int max_frames)
+{
+    int n;
+    if (channels == 2) {
+        for (n = 0; n < max_frames; n++) {
+            int32_t l_val = stereo_decode_one(&ch[0], br, NULL);
+            int32_t r_delta = stereo_decode_one(&ch[1], br, NULL);
+            out[n * 2]     = l_val;
+            out[n * 2 + 1] = l_val + r_delta;
+        }
+    } else {
+        for (n = 0; n < max_frames; n++) {
+            int bail = 0;
+            int32_t v = stereo_decode_one(&ch[0], br, &bail);
+            if (bail)
+                break;
+            out[n] = v;
+        }
+    }
+    return n;
+}
+
+/* --- Public API --- */
+
+void dwop_init(dwop_state_t *state, const uint8_t *data, int data_len)
+{
+    memset(state, 0, sizeof(*state));
+    state->data = data;
+    state->data_len = data_len;
+    state->rv = 2;
+    for (int i = 0; i < 5; i++)
+        state->e[i] = DWOP_ENERGY_INIT;
+}
+
+int dwop_decode(dwop_state_t *state, int16_t *out, int max_samples, int out_shift)
+{
+    dwop_br_t br;
+    br_seek(&br, state->data, state->data_len, state->byte_pos, state->bit_pos);
+
+    dwop_ch_t ch;
+    memcpy(ch.S, state->S, sizeof(ch.S));
+    memcpy(ch.e, state->e, sizeof(ch.e));
+    ch.rv = state->rv;
+    ch.ba = state->ba;
+
+    int n;
+    for (n = 0; n < max_samples; n++) {
+        if (channel_step(&ch, &br) != 0)
+            break;
+        /* Output: right-shift to un-double and convert to 16-bit */
+        out[n] = (int16_t)(ch.S[0] >> out_shift);
+    }
+
+    memcpy(state->S, ch.S, sizeof(ch.S));
+    memcpy(state->e, ch.e, sizeof(ch.e));
+    state->rv = ch.rv;
+    state->ba = ch.ba;
+    br_tell(&br, &state->byte_pos, &state->bit_pos, &state->cur);
+    return n;
+}
+
 int dwop_decode_stereo(const uint8_t *data, int data_len,
                        int16_t *out, int max_frames, int out_shift)
 {
-    dwop_br_t br = {data, data_len, 0, 0, 0};
+    dwop_br_t br;
+    br_seek(&br, data, data_len, 0, 0);
     dwop_ch_t L, R;
     sch_init(&L);
     sch_init(&R);
@@ -371,8 +369,8 @@ int dwop_decode_stereo(const uint8_t *data, int data_len,
 
     int n;
     for (n = 0; n < max_frames; n++) {
-        int32_t l_val = stereo_decode_one(&L, &br);
-        int32_t r_delta = stereo_decode_one(&R, &br);
+        int32_t l_val = stereo_decode_one(&L, &br, NULL);
+        int32_t r_delta = stereo_decode_one(&R, &br, NULL);
         int32_t r_val = l_val + r_delta;  /* R = L + delta at full precision */
         out[n * 2]     = (int16_t)(l_val >> extra_shift);
         out[n * 2 + 1] = (int16_t)(r_val >> extra_shift);
@@ -380,3 +378,129 @@ int dwop_decode_stereo(const uint8_t *data, int data_len,
 
     return n;
 }
+
+int dwop_decode_wide(const uint8_t *data, int data_len, int channels,
+                     int32_t *out, int max_frames)
+{
+    dwop_br_t br;
+    br_seek(&br, data, data_len, 0, 0);
+    dwop_ch_t ch[2];
+    sch_init(&ch[0]);
+    sch_init(&ch[1]);
+
+    return decode_frames_wide(&br, ch, channels, out, max_frames);
+}
+
+/* --- Checkpointed decoding --- */
+
+static void cp_save(dwop_checkpoint_t *cp, const dwop_br_t *br,
+                    const dwop_ch_t *ch, int channels)
+{
+    memset(cp, 0, sizeof(*cp));
+    br_tell(br, &cp->byte_pos, &cp->bit_pos, &cp->cur);
+    for (int c = 0; c < channels; c++) {
+        memcpy(cp->S[c], ch[c].S, sizeof(cp->S[c]));
+        memcpy(cp->e[c], ch[c].e, sizeof(cp->e[c]));
+        cp->rv[c] = ch[c].rv;
+        cp->ba[c] = ch[c].ba;
+    }
+}
+
+static void cp_restore(const dwop_checkpoint_t *cp, dwop_br_t *br,
+                       const uint8_t *data, int data_len,
+                       dwop_ch_t *ch, int channels)
+{
+    br_seek(br, data, data_len, cp->byte_pos, cp->bit_pos);
+    for (int c = 0; c < channels; c++) {
+        memcpy(ch[c].S, cp->S[c], sizeof(ch[c].S));
+        memcpy(ch[c].e, cp->e[c], sizeof(ch[c].e));
+        ch[c].rv = cp->rv[c];
+        ch[c].ba = cp->ba[c];
+    }
+}
+
+/* Shared frame loop. Mono stops at a corrupt sample like dwop_decode;
+ * stereo carries on like dwop_decode_stereo. out may be NULL (index pass). */
+static int decode_frames(dwop_br_t *br, dwop_ch_t *ch, int channels,
+                         int16_t *out, int max_frames, int out_shift,
+                         const uint32_t *marks, int mark_count,
+                         dwop_checkpoint_t *checkpoints)
+{
+    int extra_shift = out_shift - 1;
+    int m = 0;
+    int n;
+
+    for (n = 0; n < max_frames; n++) {
+        while (m < mark_count && marks[m] <= (uint32_t)n) {
+            if (marks[m] == (uint32_t)n)
+                cp_save(&checkpoints[m], br, ch, channels);
+            m++;
+        }
+
+        if (channels == 2) {
+            int32_t l_val = stereo_decode_one(&ch[0], br, NULL);
+            int32_t r_delta = stereo_decode_one(&ch[1], br, NULL);
+            if (out) {
+                out[n * 2]     = (int16_t)(l_val >> extra_shift);
+                out[n * 2 + 1] = (int16_t)((l_val + r_delta) >> extra_shift);
+            }
+        } else {
+            int bail = 0;
+            int32_t v = stereo_decode_one(&ch[0], br, &bail);
+            if (bail)
+                break;
+            if (out)
+                out[n] = (int16_t)(v >> extra_shift);
+        }
+    }
+
+    return n;
+}
+
+int dwop_index(const uint8_t *data, int data_len, int channels, int max_frames,
+               const uint32_t *marks, int mark_count,
+               dwop_checkpoint_t *checkpoints)
+{
+    dwop_br_t br;
+    br_seek(&br, data, data_len, 0, 0);
+    dwop_ch_t ch[2];
+    sch_init(&ch[0]);
+    sch_init(&ch[1]);
+
+    int n = decode_frames(&br, ch, channels, NULL, max_frames, 1,
+                          marks, mark_count, checkpoints);
+
+    /* A mark exactly at the end of the stream still gets a checkpoint */
+    for (int m = 0; m < mark_count; m++) {
+        if (marks[m] == (uint32_t)n)
+            cp_save(&checkpoints[m], &br, ch, channels);
+    }
+
+    return n;
+}
+
+int dwop_decode_at(const uint8_t *data, int data_len, int channels,
+                   const dwop_checkpoint_t *cp,
+                   int16_t *out, int max_frames, int out_shift)
+{
+    dwop_br_t br;
+    dwop_ch_t ch[2];
+    cp_restore(cp, &br, data, data_len, ch, channels);
+
+    return decode_frames(&br, ch, channels, out, max_frames, out_shift,
+                         NULL, 0, NULL);
+}
+
+int dwop_decode_resume(const uint8_t *data, int data_len, int channels,
+                       dwop_checkpoint_t *cp, int16_t *out, int32_t *wide,
+                       int max_frames, int out_shift)
+{
+    dwop_br_t br;
+    dwop_ch_t ch[2];
+    cp_restore(cp, &br, data, data_len, ch, channels);
+
+    int n = out ? decode_frames(&br, ch, channels, out, max_frames, out_shift, NULL, 0, NULL)
+                : decode_frames_wide(&br, ch, channels, wide, max_frames);
+    cp_save(cp, &br, ch, channels);
+    return n;
+}
@@ -30,6 +30,19 @@ typedef struct {
     int ba;
 } dwop_state_t;
 
+/* Decoder checkpoint: bit reader position plus full per-channel predictor,
+ * energy and range coder state, enough to resume decoding mid-stream.
+ * Channel 1 is unused for mono streams. */
+typedef struct {
+    int byte_pos;
+    int bit_pos;
+    uint8_t cur;
+    int32_t S[2][5];
+    int32_t e[2][5];
+    uint32_t rv[2];
+    int ba[2];
+} dwop_checkpoint_t;
+
 /* Initialize DWOP decoder state */
 void dwop_init(dwop_state_t *state, const uint8_t *data, int data_len);
 
@@ -48,4 +61,42 @@ int dwop_decode(dwop_state_t *state, int16_t *out, int max_samples, int out_shif
 int dwop_decode_stereo(const uint8_t *data, int data_len,
                        int16_t *out, int max_frames, int out_shift);
 
+/* Decode a whole mono (channels=1) or L/delta stereo (channels=2) stream
+ * at full precision: each sample is S[0] >> 1, so 24-bit streams keep all
+ * 24 bits (dwop_decode's out_shift 9 is this value >> 8). out holds
+ * max_frames * channels values, interleaved for stereo.
+ * Returns number of frames decoded. */
+int dwop_decode_wide(const uint8_t *data, int data_len, int channels,
+                     int32_t *out, int max_frames);
+
+/* Index a mono (channels=1) or L/delta stereo (channels=2) stream in one
+ * pass without storing output. marks[] holds ascending frame positions;
+ * checkpoints[i] receives the decoder state just before frame marks[i].
+ * Marks beyond the decoded length are left untouched.
+ * Returns number of frames decoded (same count dwop_decode /
+ * dwop_decode_stereo would return for max_frames). */
+int dwop_index(const uint8_t *data, int data_len, int channels, int max_frames,
+               const uint32_t *marks, int mark_count,
+               dwop_checkpoint_t *checkpoints);
+
+/* Resume decoding at a checkpoint from dwop_index and decode up to
+ * max_frames frames into out (interleaved for stereo), with the same
+ * out_shift meaning as dwop_decode. Output is bit-identical to the
+ * matching span of a full decode. Returns number of frames decoded. */
+int dwop_decode_at(const uint8_t *data, int data_len, int channels,
+                   const dwop_checkpoint_t *cp,
+                   int16_t *out, int max_frames, int out_shift);
+
+/* Continue a stream in pieces: decode up to max_frames frames from *cp
+ * and leave *cp at the state after them, so the next call carries on
+ * where this one stopped. Start from the checkpoint dwop_index() gives a
+ * mark at frame 0. Output goes to out (int16 with out_shift, as
+ * dwop_decode_at) or, if out is NULL, to wide (full precision, as
+ * dwop_decode_wide), interleaved for stereo. The pieces together are
+ * bit-identical to a single decode. Returns number of frames decoded;
+ * fewer than max_frames means a corrupt mono stream ended. */
+int dwop_decode_resume(const uint8_t *data, int data_len, int channels,
+                       dwop_checkpoint_t *cp, int16_t *out, int32_t *wide,
+                       int max_frames, int out_shift);
+
 #endif /* DWOP_H */
@@ -22,29 +22,72 @@ static const int PRED_MAP[5] = {0, 1, 4, 2, 3};
 
 /* --- Bit writer (MSB first, inverse of decoder's bit reader) --- */
 
-static inline int bw_bit(dwop_enc_state_t *st, int bit)
+/* Current window is full: commit it to the sink and reserve the next.
+ * Returns -1 for a fixed buffer or a failed sink. */
+static int bw_next_window(dwop_enc_state_t *st)
 {
-    st->cur = (st->cur << 1) | (bit & 1);
-    st->bit_pos++;
-    if (st->bit_pos == 8) {
-        if (st->byte_pos >= st->data_cap)
-            return -1;  /* buffer full */
-        st->data[st->byte_pos++] = st->cur;
-        st->cur = 0;
-        st->bit_pos = 0;
+    if (!st->sink) return -1;  /* buffer full */
+    byte_sink_advance(st->sink, (size_t)st->byte_pos);
+    st->flushed += (size_t)st->byte_pos;
+    st->byte_pos = 0;
+
+    size_t avail;
+    st->data = byte_sink_reserve(st->sink, DWOP_ENC_WINDOW, &avail);
+    st->data_cap = st->data ? (int)avail : 0;
+    return st->data ? 0 : -1;
+}
+
+/* Write out whole bytes of pending bits, one window check per byte.
+ * Slow path, for the end of a window and the final flush. */
+static int bw_spill(dwop_enc_state_t *st)
+{
+    while (st->nbits >= 8) {
+        if (st->byte_pos >= st->data_cap && bw_next_window(st) < 0)
+            return -1;
+        st->nbits -= 8;
+        st->data[st->byte_pos++] = (uint8_t)(st->bits >> st->nbits);
     }
     return 0;
 }
 
+/* Append the low n bits of val, MSB first (n <= 32). Pending bits go out
+ * a 32-bit word at a time, so the capacity check is per word, not per bit. */
 static inline int bw_bits(dwop_enc_state_t *st, uint32_t val, int n)
 {
-    for (int i = n - 1; i >= 0; i--) {
-        if (bw_bit(st, (int)((val >> i) & 1)) < 0)
-            return -1;
+    st->bits = (st->bits << n) | (val & (uint32_t)((1ull << n) - 1));
+    st->nbits += n;
+    if (st->nbits >= 32) {
+        if (st->data_cap - st->byte_pos < 4)
+            return bw_spill(st);
+        st->nbits -= 32;
+        uint32_t w = (uint32_t)(st->bits >> st->nbits);
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        w = __builtin_bswap32(w);
+        memcpy(st->data + st->byte_pos, &w, 4);  /* one store, not four */
+#else
+        uint8_t *p = st->data + st->byte_pos;
+        p[0] = (uint8_t)(w >> 24);
+        p[1] = (uint8_t)(w >> 16);
+        p[2] = (uint8_t)(w >> 8);
+        p[3] = (uint8_t)w;
+#endif
+        st->byte_pos += 4;
     }
     return 0;
 }
 
+/* Unary code: zeros zero bits then the terminating 1, at most 32 bits
+ * per write */
+static inline int bw_unary(dwop_enc_state_t *st, int zeros)
+{
+    while (zeros >= 32) {
+        if (bw_bits(st, 0, 32) < 0)
+            return -1;
+        zeros -= 32;
+    }
+    return bw_bits(st, 1, zeros + 1);
+}
+
 /* --- Public API --- */
 
 void dwop_enc_init(dwop_enc_state_t *st, uint8_t *buf, int buf_cap)
@@ -57,16 +100,31 @@ void dwop_enc_init(dwop_enc_state_t *st, uint8_t *buf, int buf_cap)
         st->e[i] = DWOP_ENERGY_INIT;
 }
 
+int dwop_enc_init_sink(dwop_enc_state_t *st, byte_sink_t *sink)
+{
+    dwop_enc_init(st, NULL, 0);
+    st->sink = sink;
+    size_t avail;
+    st->data = byte_sink_reserve(sink, DWOP_ENC_WINDOW, &avail);
+    st->data_cap = st->data ? (int)avail : 0;
+    return st->data ? 0 : -1;
+}
+
 int dwop_enc_flush(dwop_enc_state_t *st)
 {
-    if (st->bit_pos > 0) {
-        /* Pad remaining bits with zeros (shift left to fill byte) */
-        st->cur <<= (8 - st->bit_pos);
-        if (st->byte_pos >= st->data_cap)
-            return 0;
-        st->data[st->byte_pos++] = st->cur;
-        st->cur = 0;
-        st->bit_pos = 0;
+    /* Pad remaining bits with zeros to a whole byte, then write them out */
+    int pad = (8 - (st->nbits & 7)) & 7;
+    st->bits <<= pad;
+    st->nbits += pad;
+    if (bw_spill(st) < 0)
+        return 0;
+    st->bits = 0;
+    if (st->sink) {
+        byte_sink_advance(st->sink, (size_t)st->byte_pos);
+        st->flushed += (size_t)st->byte_pos;
+        st->byte_pos = 0;
+        st->data_cap = 0;  /* window handed back */
+        return byte_sink_error(st->sink) ? 0 : (int)st->flushed;
     }
     return st->byte_pos;
 }
@@ -142,11 +200,7 @@ int dwop_encode(dwop_enc_state_t *st, const int16_t *pcm, int num_samples,
         }
 
         /* Write unary: zeros then terminator */
-        for (int i = 0; i < unary_count; i++) {
-            if (bw_bit(st, 0) < 0)
-                return 0;
-        }
-        if (bw_bit(st, 1) < 0)
+        if (bw_unary(st, unary_count) < 0)
             return 0;
 
         /* 6. Range coder adaptation (identical to decoder) */
@@ -184,11 +238,7 @@ int dwop_encode(dwop_enc_state_t *st, const int16_t *pcm, int num_samples,
             /* Need nb bits + 1 extra bit */
             uint32_t ext = co + ((rem - co) >> 1);
             int x = (int)((rem - co) & 1);
-            if (nb > 0) {
-                if (bw_bits(st, ext, nb) < 0)
-                    return 0;
-            }
-            if (bw_bit(st, x) < 0)
+            if (bw_bits(st, (ext << 1) | (uint32_t)x, nb + 1) < 0)
                 return 0;
         }
 
@@ -248,15 +298,7 @@ int dwop_encode(dwop_enc_state_t *st, const int16_t *pcm, int num_samples,
 
 /* --- Stereo encoder --- */
 
-/* Internal stereo channel state (matches decoder's dwop_ch_t) */
-typedef struct {
-    int32_t S[5];
-    int32_t e[5];
-    uint32_t rv;
-    int ba;
-} enc_ch_t;
-
-static void enc_ch_init(enc_ch_t *c)
+static void enc_ch_init(dwop_enc_ch_t *c)
 {
     memset(c->S, 0, sizeof(c->S));
     for (int i = 0; i < 5; i++)
@@ -267,7 +309,7 @@ static void enc_ch_init(enc_ch_t *c)
 
 /* Encode one sample through a channel state into the shared bit writer.
  * doubled: the pre-doubled value to encode (sample << in_shift). */
-static int stereo_encode_one(enc_ch_t *ch, dwop_enc_state_t *bw, int32_t doubled)
+static int stereo_encode_one(dwop_enc_ch_t *ch, dwop_enc_state_t *bw, int32_t doubled)
 {
     /* 1. Find predictor with minimum energy */
     uint32_t min_e = (uint32_t)ch->e[0];
@@ -314,10 +356,7 @@ static int stereo_encode_one(enc_ch_t *ch, dwop_enc_state_t *bw, int32_t doubled
         }
     }
 
-    for (int i = 0; i < unary_count; i++) {
-        if (bw_bit(bw, 0) < 0) return -1;
-    }
-    if (bw_bit(bw, 1) < 0) return -1;
+    if (bw_unary(bw, unary_count) < 0) return -1;
 
     /* 6. Range coder */
     int nb = ch->ba;
@@ -348,10 +387,7 @@ static int stereo_encode_one(enc_ch_t *ch, dwop_enc_state_t *bw, int32_t doubled
     } else {
         uint32_t ext = co + ((rem - co) >> 1);
         int x = (int)((rem - co) & 1);
-        if (nb > 0) {
-            if (bw_bits(bw, ext, nb) < 0) return -1;
-        }
-        if (bw_bit(bw, x) < 0) return -1;
+        if (bw_bits(bw, (ext << 1) | (uint32_t)x, nb + 1) < 0) return -1;
     }
 
     ch->ba = nb;
@@ -407,16 +443,10 @@ static int stereo_encode_one(enc_ch_t *ch, dwop_enc_state_t *bw, int32_t doubled
     return 0;
 }
 
-int dwop_encode_stereo(const int16_t *pcm, int num_frames,
-                       uint8_t *buf, int buf_cap, int in_shift)
+/* Encode interleaved frames through both channel states */
+static int encode_frames(dwop_enc_state_t *bw, dwop_enc_ch_t *L, dwop_enc_ch_t *R,
+                         const int16_t *pcm, int num_frames, int in_shift)
 {
-    dwop_enc_state_t bw;
-    dwop_enc_init(&bw, buf, buf_cap);
-
-    enc_ch_t L, R;
-    enc_ch_init(&L);
-    enc_ch_init(&R);
-
     /* For stereo, the decoder applies an extra_shift = in_shift - 1 on top of
      * the un-doubling that stereo_decode_one does (S[0] >> 1). To round-trip
      * correctly, the encoder must produce the full-precision doubled value
@@ -440,11 +470,53 @@ int dwop_encode_stereo(const int16_t *pcm, int num_frames,
          * So R.S[0] = r_sample << in_shift - L.S[0] = (r_sample - l_sample) << in_shift */
         int32_t r_delta_doubled = (r_sample - l_sample) << in_shift;
 
-        if (stereo_encode_one(&L, &bw, l_doubled) < 0)
-            return 0;
-        if (stereo_encode_one(&R, &bw, r_delta_doubled) < 0)
-            return 0;
+        if (stereo_encode_one(L, bw, l_doubled) < 0)
+            return -1;
+        if (stereo_encode_one(R, bw, r_delta_doubled) < 0)
+            return -1;
     }
+    return 0;
+}
+
+/* Encode interleaved stereo into an initialized bit writer and flush it */
+static int encode_stereo(dwop_enc_state_t *bw, const int16_t *pcm,
+                         int num_frames, int in_shift)
+{
+    dwop_enc_ch_t L, R;
+    enc_ch_init(&L);
+    enc_ch_init(&R);
+    if (encode_frames(bw, &L, &R, pcm, num_frames, in_shift) < 0)
+        return 0;
+    return dwop_enc_flush(bw);
+}
+
+int dwop_encode_stereo(const int16_t *pcm, int num_frames,
+                       uint8_t *buf, int buf_cap, int in_shift)
+{
+    dwop_enc_state_t bw;
+    dwop_enc_init(&bw, buf, buf_cap);
+    return encode_stereo(&bw, pcm, num_frames, in_shift);
+}
+
+int dwop_encode_stereo_sink(const int16_t *pcm, int num_frames,
+                            byte_sink_t *sink, int in_shift)
+{
+    dwop_enc_state_t bw;
+    if (dwop_enc_init_sink(&bw, sink) != 0) return 0;
+    return encode_stereo(&bw, pcm, num_frames, in_shift);
+}
 
-    return dwop_enc_flush(&bw);
+int dwop_stereo_enc_init_sink(dwop_stereo_enc_t *st, byte_sink_t *sink)
+{
+    enc_ch_init(&st->L);
+    enc_ch_init(&st->R);
+    return dwop_enc_init_sink(&st->bw, sink);
+}
+
+int dwop_stereo_enc_block(dwop_stereo_enc_t *st, const int16_t *pcm,
+                          int num_frames, int in_shift)
+{
+    if (encode_frames(&st->bw, &st->L, &st->R, pcm, num_frames, in_shift) < 0)
+        return 0;
+    return num_frames;
 }
@@ -13,15 +13,20 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "byte_sink.h"
+
+#define DWOP_ENC_WINDOW 4096  /* bytes reserved from a sink at a time */
 
 /* Encoder state */
 typedef struct {
     /* Bit writer */
-    uint8_t *data;       /* output buffer (caller-allocated or growable) */
+    uint8_t *data;       /* output buffer, or the window reserved from sink */
     int data_cap;        /* buffer capacity in bytes */
     int byte_pos;        /* current write position */
-    int bit_pos;         /* bits written in current byte (0-7) */
-    uint8_t cur;         /* byte being assembled */
+    byte_sink_t *sink;   /* NULL when writing to a fixed buffer */
+    size_t flushed;      /* bytes committed to sink before data[0] */
+    uint64_t bits;       /* pending bits, newest in the low end */
+    int nbits;           /* number of pending bits (< 32 between writes) */
 
     /* Predictor state (doubled representation, identical to decoder) */
     int32_t S[5];
@@ -32,17 +37,37 @@ typedef struct {
     int ba;              /* bits accumulated (init 0) */
 } dwop_enc_state_t;
 
+/* Predictor and range coder state of one stereo channel */
+typedef struct {
+    int32_t S[5];
+    int32_t e[5];
+    uint32_t rv;
+    int ba;
+} dwop_enc_ch_t;
+
+/* Stereo encoder: both channels share one bit writer */
+typedef struct {
+    dwop_enc_state_t bw;
+    dwop_enc_ch_t L;
+    dwop_enc_ch_t R;     /* encodes R - L */
+} dwop_stereo_enc_t;
+
 /* Initialize encoder state. buf/buf_cap is the output buffer. */
 void dwop_enc_init(dwop_enc_state_t *st, uint8_t *buf, int buf_cap);
 
+/* Initialize encoder state writing to sink, in windows of DWOP_ENC_WINDOW
+ * bytes. Returns 0, or -1 if the sink is in error. */
+int dwop_enc_init_sink(dwop_enc_state_t *st, byte_sink_t *sink);
+
 /* Encode mono PCM samples into DWOP bitstream.
  * in_shift: left-shift applied to input (1 for 16-bit, 9 for 24-bit).
  * Returns number of samples encoded (== num_samples on success, 0 on error). */
 int dwop_encode(dwop_enc_state_t *st, const int16_t *pcm, int num_samples,
                 int in_shift);
 
-/* Flush any partial byte in the bit writer. Call after encoding is complete.
- * Returns total bytes written. */
+/* Flush any partial byte in the bit writer. Call after encoding is complete;
+ * with a sink this also commits the last window.
+ * Returns total bytes written, 0 on error. */
 int dwop_enc_flush(dwop_enc_state_t *st);
 
 /* Encode stereo PCM (interleaved L/R) into DWOP bitstream.
@@ -52,4 +77,18 @@ int dwop_enc_flush(dwop_enc_state_t *st);
 int dwop_encode_stereo(const int16_t *pcm, int num_frames,
                        uint8_t *buf, int buf_cap, int in_shift);
 
+/* As dwop_encode_stereo(), appending to sink instead of a fixed buffer */
+int dwop_encode_stereo_sink(const int16_t *pcm, int num_frames,
+                            byte_sink_t *sink, int in_shift);
+
+/* Incremental stereo encoding into sink: feed successive blocks of
+ * interleaved frames to dwop_stereo_enc_block(), then finish with
+ * dwop_enc_flush(&st->bw). The output is identical to one
+ * dwop_encode_stereo_sink() call over the concatenated blocks.
+ * init returns 0, or -1 if the sink is in error; block returns num_frames,
+ * or 0 on error. */
+int dwop_stereo_enc_init_sink(dwop_stereo_enc_t *st, byte_sink_t *sink);
+int dwop_stereo_enc_block(dwop_stereo_enc_t *st, const int16_t *pcm,
+                          int num_frames, int in_shift);
+
 #endif /* DWOP_ENCODE_H */
@@ -0,0 +1,85 @@
+/*
+ * Read-only Mapped Files
+ *
+ * License: MIT
+ */
+
+#include "mapped_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Fallback: read the whole file into the heap */
+static int read_all(int fd, mapped_file_t *mf, size_t len, char *err, int err_len)
+{
+    uint8_t *buf = (uint8_t *)malloc(len);
+    if (!buf) {
+        snprintf(err, err_len, "Out of memory");
+        return -1;
+    }
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = read(fd, buf + got, len - got);
+        if (n <= 0) {
+            snprintf(err, err_len, "Read error");
+            free(buf);
+            return -1;
+        }
+        got += (size_t)n;
+    }
+    mf->data = buf;
+    mf->len = len;
+    mf->mapped = 0;
+    return 0;
+}
+
+int mapped_file_open(mapped_file_t *mf, const char *path, size_t max_len,
+                     char *err, int err_len)
+{
+    memset(mf, 0, sizeof(*mf));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        snprintf(err, err_len, "Cannot open file");
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || (size_t)st.st_size > max_len) {
+        snprintf(err, err_len, "File too large or empty");
+        close(fd);
+        return -1;
+    }
+    size_t len = (size_t)st.st_size;
+
+    void *p = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+        int rc = read_all(fd, mf, len, err, err_len);
+        close(fd);
+        return rc;
+    }
+    close(fd);  /* the mapping keeps its own reference */
+
+    /* Parsers walk the file front to back once: read ahead aggressively
+     * and drop pages behind */
+    posix_madvise(p, len, POSIX_MADV_SEQUENTIAL);
+
+    mf->data = (const uint8_t *)p;
+    mf->len = len;
+    mf->mapped = 1;
+    return 0;
+}
+
+void mapped_file_close(mapped_file_t *mf)
+{
+    if (!mf->data) return;
+    if (mf->mapped) munmap((void *)mf->data, mf->len);
+    else free((void *)mf->data);
+    mf->data = NULL;
+    mf->len = 0;
+    mf->mapped = 0;
+}
@@ -0,0 +1,35 @@
+/*
+ * Read-only Mapped Files
+ *
+ * Maps a whole file read-only so parsers can work on the page cache
+ * directly instead of a heap copy. Falls back to reading into the heap
+ * where mmap is not available for the file. Either way the view stays
+ * valid until mapped_file_close().
+ *
+ * A mapped file that is truncated by another process while mapped faults
+ * on access; callers only keep the view for the duration of one parse.
+ *
+ * License: MIT
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    int mapped;        /* 1 = mmap view, 0 = heap copy */
+} mapped_file_t;
+
+/* Open path for sequential reading. Files that are empty or larger than
+ * max_len are rejected. Returns 0 on success, -1 on error (message in err). */
+int mapped_file_open(mapped_file_t *mf, const char *path, size_t max_len,
+                     char *err, int err_len);
+
+/* Release the view (safe on a zeroed or already closed mapped_file_t) */
+void mapped_file_close(mapped_file_t *mf);
+
+#endif /* MAPPED_FILE_H */
@@ -0,0 +1,300 @@
+/*
+ * Minimal Standard MIDI File Reader
+ *
+ * Tracks are read in file order into one event list, which is then put in
+ * tick order (file order within a tick) and walked alongside the tempo
+ * changes to turn ticks into sample frames.
+ *
+ * License: MIT
+ */
+
+#include "midi_file.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#define DEFAULT_TEMPO 500000  /* microseconds per quarter note: 120 BPM */
+
+typedef struct {
+    uint64_t tick;
+    uint32_t seq;            /* file order, for a stable sort */
+    uint32_t tempo;          /* tempo changes only */
+    uint8_t msg[3];
+    uint8_t len;             /* 0 for a tempo change */
+} raw_event_t;
+
+typedef struct {
+    raw_event_t *items;
+    int count;
+    int cap;
+} raw_list_t;
+
+/* Big-endian readers */
+static uint32_t read_u32_be(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint16_t read_u16_be(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static raw_event_t *list_add(raw_list_t *l)
+{
+    if (l->count == l->cap) {
+        int cap = l->cap ? l->cap * 2 : 256;
+        raw_event_t *items = (raw_event_t *)realloc(l->items, (size_t)cap * sizeof(*items));
+        if (!items) return NULL;
+        l->items = items;
+        l->cap = cap;
+    }
+    raw_event_t *e = &l->items[l->count];
+    e->seq = (uint32_t)l->count;
+    l->count++;
+    return e;
+}
+
+/* Variable-length quantity at *p (up to 4 bytes). Returns -1 if it runs
+ * past end. */
+static int read_vlq(const uint8_t **p, const uint8_t *end, uint32_t *out)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        if (*p >= end) return -1;
+        uint8_t b = *(*p)++;
+        v = (v << 7) | (b & 0x7F);
+        if (!(b & 0x80)) {
+            *out = v;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* Data bytes after a channel status byte */
+static int channel_data_len(uint8_t status)
+{
+    uint8_t kind = status & 0xF0;
+    return (kind == 0xC0 || kind == 0xD0) ? 1 : 2;
+}
+
+/* Read one MTrk body into events and tempos. Returns 0, or -1 with a
+ * message in error. */
+static int read_track(const uint8_t *p, const uint8_t *end, int track,
+                      raw_list_t *events, raw_list_t *tempos, uint64_t *end_tick,
+                      char *error, int error_len)
+{
+    uint64_t tick = 0;
+    uint8_t running = 0;
+
+    while (p < end) {
+        uint32_t delta;
+        if (read_vlq(&p, end, &delta) != 0 || p >= end) goto truncated;
+        tick += delta;
+
+        uint8_t status = *p;
+        if (status & 0x80) {
+            p++;
+        } else if (running) {
+            status = running;  /* running status: p is at the first data byte */
+        } else {
+            snprintf(error, error_len, "Track %d: data byte without a status", track);
+            return -1;
+        }
+
+        if (status == 0xFF) {
+            running = 0;
+            uint32_t len;
+            if (p >= end) goto truncated;
+            uint8_t type = *p++;
+            if (read_vlq(&p, end, &len) != 0 || len > (size_t)(end - p)) goto truncated;
+            if (type == 0x51 && len == 3) {
+                raw_event_t *e = list_add(tempos);
+                if (!e) goto no_memory;
+                e->tick = tick;
+                e->tempo = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+                e->len = 0;
+                if (e->tempo == 0) e->tempo = DEFAULT_TEMPO;
+            }
+            p += len;
+            if (type == 0x2F) break;  /* end of track */
+        } else if (status == 0xF0 || status == 0xF7) {
+            running = 0;
+            uint32_t len;
+            if (read_vlq(&p, end, &len) != 0 || len > (size_t)(end - p)) goto truncated;
+            p += len;
+        } else if (status >= 0xF0) {
+            snprintf(error, error_len, "Track %d: unexpected status 0x%02X", track, status);
+            return -1;
+        } else {
+            running = status;
+            int n = channel_data_len(status);
+            if ((size_t)(end - p) < (size_t)n) goto truncated;
+            if (events->count >= MIDI_FILE_MAX_EVENTS) {
+                snprintf(error, error_len, "More than %d events", MIDI_FILE_MAX_EVENTS);
+                return -1;
+            }
+            raw_event_t *e = list_add(events);
+            if (!e) goto no_memory;
+            e->tick = tick;
+            e->msg[0] = status;
+            e->msg[1] = p[0] & 0x7F;
+            e->msg[2] = n == 2 ? (p[1] & 0x7F) : 0;
+            e->len = (uint8_t)(1 + n);
+            p += n;
+        }
+    }
+    if (tick > *end_tick) *end_tick = tick;
+    return 0;
+
+truncated:
+    snprintf(error, error_len, "Track %d is truncated", track);
+    return -1;
+no_memory:
+    snprintf(error, error_len, "Out of memory");
+    return -1;
+}
+
+static int cmp_raw(const void *a, const void *b)
+{
+    const raw_event_t *x = (const raw_event_t *)a, *y = (const raw_event_t *)b;
+    if (x->tick != y->tick) return x->tick < y->tick ? -1 : 1;
+    return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+/* Ticks to seconds, stepped forward through the tempo map */
+typedef struct {
+    const raw_event_t *tempos;
+    int count;
+    int next;                /* first tempo change not yet reached */
+    uint64_t tick;
+    double seconds;
+    double per_tick;         /* seconds per tick at the current tempo */
+    int division;            /* ticks per quarter, 0 if SMPTE */
+} tempo_walk_t;
+
+static double walk_to(tempo_walk_t *w, uint64_t tick)
+{
+    while (w->next < w->count && w->tempos[w->next].tick <= tick) {
+        const raw_event_t *t = &w->tempos[w->next++];
+        w->seconds += (double)(t->tick - w->tick) * w->per_tick;
+        w->tick = t->tick;
+        if (w->division) w->per_tick = t->tempo * 1e-6 / w->division;
+    }
+    w->seconds += (double)(tick - w->tick) * w->per_tick;
+    w->tick = tick;
+    return w->seconds;
+}
+
+static uint32_t to_frame(double seconds, int sample_rate)
+{
+    double f = floor(seconds * sample_rate + 0.5);
+    return f > (double)UINT32_MAX ? UINT32_MAX : (uint32_t)f;
+}
+
+int midi_file_read(midi_file_t *mf, const uint8_t *data, size_t data_len, int sample_rate)
+{
+    memset(mf, 0, sizeof(*mf));
+
+    if (data_len < 14 || memcmp(data, "MThd", 4) != 0) {
+        snprintf(mf->error, sizeof(mf->error), "Not a MIDI file (no MThd header)");
+        return -1;
+    }
+    uint32_t header_len = read_u32_be(data + 4);
+    int format = read_u16_be(data + 8);
+    int tracks = read_u16_be(data + 10);
+    uint16_t division = read_u16_be(data + 12);
+    if (header_len < 6 || header_len > data_len - 8) {
+        snprintf(mf->error, sizeof(mf->error), "Bad MThd length %u", header_len);
+        return -1;
+    }
+    if (format > 1) {
+        snprintf(mf->error, sizeof(mf->error), "Unsupported MIDI file format %d", format);
+        return -1;
+    }
+
+    tempo_walk_t walk = {0};
+    if (division & 0x8000) {
+        /* SMPTE: frames per second (negated; 29 means 29.97) and ticks per frame */
+        int fps = -(int)(int8_t)(division >> 8);
+        int ticks = division & 0xFF;
+        if (fps <= 0 || ticks == 0) {
+            snprintf(mf->error, sizeof(mf->error), "Bad SMPTE time division");
+            return -1;
+        }
+        walk.per_tick = 1.0 / ((fps == 29 ? 29.97 : fps) * ticks);
+    } else {
+        if (division == 0) {
+            snprintf(mf->error, sizeof(mf->error), "Bad time division 0");
+            return -1;
+        }
+        walk.division = division;
+        walk.per_tick = DEFAULT_TEMPO * 1e-6 / division;
+    }
+
+    raw_list_t events = {0}, tempos = {0};
+    uint64_t end_tick = 0;
+    const uint8_t *p = data + 8 + header_len;
+    const uint8_t *end = data + data_len;
+    int found = 0;
+    while (found < tracks && end - p >= 8) {
+        uint32_t len = read_u32_be(p + 4);
+        if (len > (size_t)(end - p - 8)) {
+            snprintf(mf->error, sizeof(mf->error), "Chunk runs past the end of the file");
+            goto fail;
+        }
+        if (memcmp(p, "MTrk", 4) == 0) {
+            if (read_track(p + 8, p + 8 + len, found, &events, &tempos, &end_tick,
+                           mf->error, sizeof(mf->error)) != 0)
+                goto fail;
+            found++;
+        }
+        p += 8 + len;  /* unknown chunks are skipped */
+    }
+    if (found == 0) {
+        snprintf(mf->error, sizeof(mf->error), "No MTrk chunk");
+        goto fail;
+    }
+
+    /* Either list may be empty, with no array to hand qsort */
+    if (events.count > 1) qsort(events.items, events.count, sizeof(raw_event_t), cmp_raw);
+    if (tempos.count > 1) qsort(tempos.items, tempos.count, sizeof(raw_event_t), cmp_raw);
+    walk.tempos = tempos.items;
+    walk.count = tempos.count;
+
+    if (events.count > 0) {
+        mf->events = (midi_file_event_t *)malloc((size_t)events.count * sizeof(midi_file_event_t));
+        if (!mf->events) {
+            snprintf(mf->error, sizeof(mf->error), "Out of memory");
+            goto fail;
+        }
+    }
+    for (int i = 0; i < events.count; i++) {
+        const raw_event_t *r = &events.items[i];
+        midi_file_event_t *e = &mf->events[i];
+        e->frame = to_frame(walk_to(&walk, r->tick), sample_rate);
+        memcpy(e->msg, r->msg, 3);
+        e->len = r->len;
+    }
+    mf->event_count = events.count;
+    mf->end_frame = to_frame(walk_to(&walk, end_tick), sample_rate);
+
+    free(events.items);
+    free(tempos.items);
+    return 0;
+
+fail:
+    free(events.items);
+    free(tempos.items);
+    return -1;
+}
+
+void midi_file_free(midi_file_t *mf)
+{
+    free(mf->events);
+    mf->events = NULL;
+    mf->event_count = 0;
+}
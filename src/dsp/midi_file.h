@@ -0,0 +1,41 @@
+/*
+ * Minimal Standard MIDI File Reader
+ *
+ * Reads format 0 and 1 files (MThd + MTrk chunks) into one list of
+ * channel messages in playing order, timed in sample frames through the
+ * file's tempo map. Meta events other than tempo, and SysEx, are skipped.
+ * Ticks per quarter note and SMPTE time divisions are both understood.
+ *
+ * License: MIT
+ */
+
+#ifndef MIDI_FILE_H
+#define MIDI_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define MIDI_FILE_MAX_EVENTS 1000000
+
+typedef struct {
+    uint32_t frame;          /* from the start of the file */
+    uint8_t msg[3];
+    uint8_t len;             /* 2 or 3 */
+} midi_file_event_t;
+
+typedef struct {
+    midi_file_event_t *events;  /* allocated, caller must free */
+    int event_count;
+    uint32_t end_frame;      /* the last track's end of track */
+    char error[256];
+} midi_file_t;
+
+/* Read a MIDI file from an in-memory buffer, timing events at
+ * sample_rate. Returns 0 on success, -1 on error (check mf->error).
+ * Caller must call midi_file_free() when done. */
+int midi_file_read(midi_file_t *mf, const uint8_t *data, size_t data_len, int sample_rate);
+
+/* Free resources allocated by midi_file_read */
+void midi_file_free(midi_file_t *mf);
+
+#endif /* MIDI_FILE_H */
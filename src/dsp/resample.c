@@ -0,0 +1,102 @@
+/*
+ * Interpolation Kernels for Pitched Playback
+ *
+ * Sinc kernels are Blackman-windowed and built in double precision, with
+ * each row normalised to unit DC gain. At full band the taps of row 0 sit
+ * on the sinc's zero crossings, so unpitched playback reads samples back
+ * exactly. Built kernels are never freed: readers may hold them for as
+ * long as they like.
+ *
+ * License: MIT
+ */
+
+#include "resample.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static resample_kernel_t *g_kernels[2][RESAMPLE_BANDS];  /* [sinc16][band] */
+
+static const char *g_names[] = { "linear", "hermite", "sinc8", "sinc16" };
+
+const char *resample_quality_name(int quality)
+{
+    if (quality < RESAMPLE_LINEAR || quality > RESAMPLE_SINC16) return "linear";
+    return g_names[quality];
+}
+
+int resample_parse_quality(const char *name)
+{
+    for (int i = RESAMPLE_LINEAR; i <= RESAMPLE_SINC16; i++) {
+        if (strcmp(name, g_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+/* Semitone band of rate: 0 up to unity, band b cuts off at 2^(-b/12) */
+static int rate_band(float rate)
+{
+    if (!(rate > 1.0f)) return 0;
+    int band = (int)ceil(12.0 * log2((double)rate) - 1e-3);
+    if (band < 0) band = 0;
+    if (band > RESAMPLE_BANDS - 1) band = RESAMPLE_BANDS - 1;
+    return band;
+}
+
+static resample_kernel_t *build_kernel(int taps, int band)
+{
+    resample_kernel_t *k = (resample_kernel_t *)malloc(sizeof(*k));
+    float *coef = NULL;
+    size_t bytes = (size_t)(RESAMPLE_PHASES + 1) * taps * sizeof(float);
+    if (!k || posix_memalign((void **)&coef, 16, bytes) != 0) {
+        free(k);
+        return NULL;
+    }
+
+    int half = taps / 2;
+    double fc = pow(2.0, -band / 12.0);
+    double gain = 0.0;
+    for (int ph = 0; ph <= RESAMPLE_PHASES; ph++) {
+        double frac = (double)ph / RESAMPLE_PHASES;
+        double h[RESAMPLE_MAX_TAPS];
+        double sum = 0.0;
+        for (int i = 0; i < taps; i++) {
+            double d = (double)(i - (half - 1)) - frac;  /* tap's distance from the read */
+            double x = M_PI * fc * d;
+            double sinc = fabs(x) < 1e-12 ? 1.0 : sin(x) / x;
+            double w = d / half;
+            double win = 0.42 + 0.5 * cos(M_PI * w) + 0.08 * cos(2.0 * M_PI * w);
+            h[i] = fc * sinc * win;
+            if (fabs(h[i]) < 1e-12) h[i] = 0.0;  /* on a zero crossing */
+            sum += h[i];
+        }
+        double row = 0.0;
+        for (int i = 0; i < taps; i++) {
+            coef[ph * taps + i] = (float)(h[i] / sum);
+            row += fabs(coef[ph * taps + i]);
+        }
+        if (row > gain) gain = row;
+    }
+
+    k->taps = taps;
+    k->cutoff = (float)fc;
+    k->coef = coef;
+    k->gain = (float)gain;
+    return k;
+}
+
+const resample_kernel_t *resample_kernel(int quality, float rate)
+{
+    if (quality != RESAMPLE_SINC8 && quality != RESAMPLE_SINC16) return NULL;
+    int wide = quality == RESAMPLE_SINC16;
+    int band = rate_band(rate);
+
+    pthread_mutex_lock(&g_lock);
+    if (!g_kernels[wide][band])
+        g_kernels[wide][band] = build_kernel(wide ? 16 : 8, band);
+    resample_kernel_t *k = g_kernels[wide][band];
+    pthread_mutex_unlock(&g_lock);
+    return k;
+}
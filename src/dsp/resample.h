@@ -0,0 +1,138 @@
+/*
+ * Interpolation Kernels for Pitched Playback
+ *
+ * Read one output sample from a buffer at a fractional position, with
+ * increasing quality and cost:
+ *
+ *   RESAMPLE_LINEAR   2 taps
+ *   RESAMPLE_HERMITE  4-point, 3rd-order Hermite (Catmull-Rom)
+ *   RESAMPLE_SINC8    8-tap polyphase windowed sinc
+ *   RESAMPLE_SINC16   16-tap polyphase windowed sinc
+ *
+ * The sinc kernels come from precomputed tables: RESAMPLE_PHASES + 1 rows
+ * of coefficients per kernel, each row one fractional position (the
+ * nearest is used), 8 or 16 KB in all so a block's reads stay in cache.
+ * The cutoff follows the playback rate: rates up to 1 pass the full band,
+ * and faster rates are low-passed at 1/rate so pitching up doesn't alias.
+ * Kernels are built per semitone band of rate on first use and then kept
+ * for the life of the process.
+ *
+ * The readers below need taps/2 - 1 samples before the read position and
+ * taps/2 after it (at most REX_PLANAR_GUARD, so planar slice buffers can be
+ * read without bounds checks).
+ *
+ * License: MIT
+ */
+
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#include <stdint.h>
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#define RESAMPLE_LINEAR  0
+#define RESAMPLE_HERMITE 1
+#define RESAMPLE_SINC8   2
+#define RESAMPLE_SINC16  3
+
+#define RESAMPLE_PHASES   256  /* fractional positions per kernel */
+#define RESAMPLE_MAX_TAPS 16
+#define RESAMPLE_BANDS    25   /* semitone cutoff bands: up to 2 octaves up */
+
+typedef struct {
+    int taps;                /* 8 or 16 */
+    float cutoff;            /* fraction of the source Nyquist frequency */
+    const float *coef;       /* (RESAMPLE_PHASES + 1) rows of taps, 16-byte aligned */
+    float gain;              /* largest sum of |coefficients| in a row: no read
+                                exceeds the input's peak times this */
+} resample_kernel_t;
+
+/* The same bound for Hermite (at t = 0.5) and linear interpolation */
+#define RESAMPLE_HERMITE_GAIN 1.25f
+#define RESAMPLE_LINEAR_GAIN  1.0f
+
+/* Kernel for a sinc quality at a playback rate, built on first use.
+ * Returns NULL for the other qualities or when out of memory. Thread-safe,
+ * but may allocate: not for the render thread, which should be handed the
+ * kernel it needs. */
+const resample_kernel_t *resample_kernel(int quality, float rate);
+
+/* Quality name ("linear", "hermite", "sinc8", "sinc16") and back; -1 for
+ * an unknown name */
+const char *resample_quality_name(int quality);
+int resample_parse_quality(const char *name);
+
+/* Hermite interpolation between x0 and x1 at t (0..1) */
+static inline float resample_hermite(float xm1, float x0, float x1, float x2, float t)
+{
+    float c1 = 0.5f * (x1 - xm1);
+    float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+    float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+    return ((c3 * t + c2) * t + c1) * t + x0;
+}
+
+/* Coefficient row for fractional position frac (0..1) */
+static inline const float *resample_row(const resample_kernel_t *k, float frac)
+{
+    int phase = (int)(frac * (float)RESAMPLE_PHASES + 0.5f);
+    return k->coef + phase * k->taps;
+}
+
+/* Dot product of taps samples (x: the first, taps/2 - 1 before the read
+ * position) with a coefficient row. taps is a multiple of 4. */
+static inline float resample_dot_f32(const float *x, const float *c, int taps)
+{
+#if defined(__aarch64__)
+    float32x4_t acc = vmulq_f32(vld1q_f32(x), vld1q_f32(c));
+    for (int k = 4; k < taps; k += 4)
+        acc = vfmaq_f32(acc, vld1q_f32(x + k), vld1q_f32(c + k));
+    return vaddvq_f32(acc);
+#else
+    float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int k = 0; k < taps; k += 4) {
+        acc[0] += x[k] * c[k];
+        acc[1] += x[k + 1] * c[k + 1];
+        acc[2] += x[k + 2] * c[k + 2];
+        acc[3] += x[k + 3] * c[k + 3];
+    }
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+#endif
+}
+
+static inline float resample_dot_i16(const int16_t *x, const float *c, int taps)
+{
+#if defined(__aarch64__)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (int k = 0; k < taps; k += 4) {
+        float32x4_t v = vcvtq_f32_s32(vmovl_s16(vld1_s16(x + k)));
+        acc = vfmaq_f32(acc, v, vld1q_f32(c + k));
+    }
+    return vaddvq_f32(acc);
+#else
+    float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int k = 0; k < taps; k += 4) {
+        acc[0] += (float)x[k] * c[k];
+        acc[1] += (float)x[k + 1] * c[k + 1];
+        acc[2] += (float)x[k + 2] * c[k + 2];
+        acc[3] += (float)x[k + 3] * c[k + 3];
+    }
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+#endif
+}
+
+/* Windowed-sinc read of x at integer position p0 plus frac */
+static inline float resample_sinc_f32(const resample_kernel_t *k, const float *x,
+                                      int p0, float frac)
+{
+    return resample_dot_f32(x + p0 - (k->taps / 2 - 1), resample_row(k, frac), k->taps);
+}
+
+static inline float resample_sinc_i16(const resample_kernel_t *k, const int16_t *x,
+                                      int p0, float frac)
+{
+    return resample_dot_i16(x + p0 - (k->taps / 2 - 1), resample_row(k, frac), k->taps);
+}
+
+#endif /* RESAMPLE_H */
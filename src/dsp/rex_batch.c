@@ -0,0 +1,518 @@
+/*
+ * REX2 Batch Encoding
+ *
+ * License: MIT
+ */
+
+#include "rex_batch.h"
+#include "wav_reader.h"
+#include "mapped_file.h"
+#include "rex_writer.h"
+#include "rex_parser.h"
+#include "rex_sidecar.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <pwd.h>
+#include <unistd.h>
+
+#define MAX_SLICES 1024
+#define MAX_SAMPLES (INT32_MAX / 3)         /* keeps the output size in an int */
+#define MAX_REX_SIZE ((size_t)INT32_MAX)
+
+/* --- Output ownership --- */
+
+/* Files are handed to the device user, looked up once (getpwnam is not
+ * thread-safe) */
+static pthread_once_t g_owner_once = PTHREAD_ONCE_INIT;
+static int g_have_owner = 0;
+static uid_t g_owner_uid;
+static gid_t g_owner_gid;
+
+static void lookup_owner(void)
+{
+    struct passwd *pw = getpwnam("ableton");
+    if (pw) {
+        g_owner_uid = pw->pw_uid;
+        g_owner_gid = pw->pw_gid;
+        g_have_owner = 1;
+    }
+}
+
+static void chown_to_ableton(const char *path)
+{
+    pthread_once(&g_owner_once, lookup_owner);
+    if (g_have_owner) chown(path, g_owner_uid, g_owner_gid);
+}
+
+/* --- Single file --- */
+
+/* Parse comma-separated boundaries string into array.
+ * Returns number of boundaries parsed, -1 on error (message in err). */
+static int parse_boundaries(const char *str, uint32_t *out, int max_count,
+                            char *err, int err_len)
+{
+    int count = 0;
+    const char *p = str;
+    while (*p && count < max_count) {
+        char *end;
+        long val = strtol(p, &end, 10);
+        if (end == p) break;
+        if (val < 0) {
+            snprintf(err, err_len, "negative boundary value %ld", val);
+            return -1;
+        }
+        out[count++] = (uint32_t)val;
+        if (*end == ',') end++;
+        p = end;
+    }
+    return count;
+}
+
+/* Audio source for the writer: WAV blocks, teed into the sidecar */
+typedef struct {
+    wav_stream_t *wav;
+    rex_sidecar_writer_t sidecar;
+    int sidecar_ok;
+} pcm_source_t;
+
+static int read_pcm(void *ctx, int16_t *buf, int max_frames)
+{
+    pcm_source_t *src = (pcm_source_t *)ctx;
+    int got = wav_stream_read(src->wav, buf, max_frames);
+    if (got > 0 && src->sidecar_ok &&
+        rex_sidecar_append(&src->sidecar, buf, (size_t)got * src->wav->channels) != 0) {
+        rex_sidecar_abort(&src->sidecar);  /* too long to cache; keep encoding */
+        src->sidecar_ok = 0;
+    }
+    return got;
+}
+
+/* Stream the REX2 file straight to path. Returns bytes written, 0 on
+ * error (a partial file is removed). */
+static int write_rex_file(const char *path, const rex_write_params_t *params)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return 0;
+
+    byte_sink_t sink;
+    int written = 0;
+    if (byte_sink_init_fd(&sink, fd) == 0) {
+        written = rex_write_sink(params, &sink);
+        if (written > 0 && byte_sink_flush(&sink) != 0) written = 0;
+    }
+    byte_sink_free(&sink);
+    if (close(fd) != 0) written = 0;
+
+    if (written <= 0) {
+        unlink(path);
+        return 0;
+    }
+    chown_to_ableton(path);
+    return written;
+}
+
+/* Complete the player's decoded-PCM sidecar from the file just written,
+ * so the first load of the new loop skips decoding. Only the header is
+ * parsed; the PCM was collected while encoding. */
+static void finish_sidecar(const char *path, pcm_source_t *src)
+{
+    if (!src->sidecar_ok) return;
+    src->sidecar_ok = 0;
+
+    mapped_file_t mf;
+    char err[256];
+    if (mapped_file_open(&mf, path, MAX_REX_SIZE, err, sizeof(err)) != 0) {
+        rex_sidecar_abort(&src->sidecar);
+        return;
+    }
+    rex_file_t rex;
+    if (rex_parse_ex(&rex, mf.data, mf.len, REX_PARSE_HEADER) == 0) {
+        rex.pcm_samples = (int)rex.total_sample_length;
+        rex.pcm_channels = rex.channels == 2 ? 2 : 1;
+        if (rex_sidecar_finish(&src->sidecar, path, &rex) == 0) {
+            chown_to_ableton(src->sidecar.path);
+            char *slash = strrchr(src->sidecar.path, '/');
+            if (slash) {
+                *slash = '\0';
+                chown_to_ableton(src->sidecar.path);  /* the .rexcache directory */
+            }
+        }
+        rex_free(&rex);
+    } else {
+        rex_sidecar_abort(&src->sidecar);
+    }
+    mapped_file_close(&mf);
+}
+
+int rex_encode_file(const rex_encode_job_t *job, rex_encode_stats_t *stats,
+                    char *err, int err_len)
+{
+    float tempo = job->tempo;
+    if (tempo <= 0 || tempo > 999) {
+        snprintf(err, err_len, "invalid tempo %.1f", tempo);
+        return -1;
+    }
+
+    /* Parse boundaries (evenly spaced ones are filled in once the length
+     * is known) */
+    uint32_t boundaries[MAX_SLICES + 1];
+    int num_slices;
+    if (job->boundaries) {
+        int num_boundaries = parse_boundaries(job->boundaries, boundaries, MAX_SLICES + 1,
+                                              err, err_len);
+        if (num_boundaries < 0) return -1;
+        num_slices = num_boundaries - 1;
+        if (num_slices < 1) {
+            snprintf(err, err_len, "need at least 2 boundary values for 1 slice");
+            return -1;
+        }
+    } else {
+        num_slices = job->even_slices;
+        if (num_slices < 1 || num_slices > MAX_SLICES) {
+            snprintf(err, err_len, "invalid slice count %d", num_slices);
+            return -1;
+        }
+    }
+
+    /* Open the WAV; only its header is read up front */
+    wav_stream_t wav;
+    if (wav_stream_open(&wav, job->wav_path) != 0) {
+        if (wav.fd < 0)
+            snprintf(err, err_len, "cannot read '%s'", job->wav_path);
+        else
+            snprintf(err, err_len, "%s", wav.error);
+        wav_stream_close(&wav);
+        return -1;
+    }
+    if ((int64_t)wav.num_frames * wav.channels > MAX_SAMPLES) {
+        snprintf(err, err_len, "%d frames is too long to encode", wav.num_frames);
+        wav_stream_close(&wav);
+        return -1;
+    }
+
+    if (!job->boundaries) {
+        if (wav.num_frames < num_slices) {
+            snprintf(err, err_len, "%d frames cannot make %d slices", wav.num_frames, num_slices);
+            wav_stream_close(&wav);
+            return -1;
+        }
+        for (int i = 0; i <= num_slices; i++) {
+            boundaries[i] = (uint32_t)((int64_t)wav.num_frames * i / num_slices);
+        }
+    }
+
+    /* Build slice descriptors */
+    rex_write_slice_t slices[MAX_SLICES];
+    for (int i = 0; i < num_slices; i++) {
+        slices[i].sample_offset = boundaries[i];
+        if (boundaries[i + 1] <= boundaries[i]) {
+            snprintf(err, err_len, "slice %d has zero or negative length (boundaries %u to %u)",
+                     i, boundaries[i], boundaries[i + 1]);
+            wav_stream_close(&wav);
+            return -1;
+        }
+        slices[i].sample_length = boundaries[i + 1] - boundaries[i];
+        if (slices[i].sample_offset + slices[i].sample_length > (uint32_t)wav.num_frames) {
+            snprintf(err, err_len, "slice %d extends past end of audio (%u+%u > %d)",
+                     i, slices[i].sample_offset, slices[i].sample_length, wav.num_frames);
+            wav_stream_close(&wav);
+            return -1;
+        }
+    }
+
+    /* Compute bars and beats from tempo and total length (assumes 4/4) */
+    double total_seconds = (double)wav.num_frames / wav.sample_rate;
+    double total_beats = total_seconds * tempo / 60.0;
+    int bars = (int)(total_beats / 4.0);
+    int beats = (int)(total_beats - bars * 4.0);
+    if (bars < 1) bars = 1;
+
+    /* The audio is pulled from the WAV block by block as it is encoded */
+    pcm_source_t src;
+    memset(&src, 0, sizeof(src));
+    src.wav = &wav;
+    /* Past the parser's decode cap the player would not see all of it */
+    src.sidecar_ok = wav.num_frames <= REX_MAX_FRAMES &&
+                     rex_sidecar_begin(&src.sidecar, job->rx2_path) == 0;
+
+    rex_write_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.tempo_bpm = tempo;
+    params.bars = bars;
+    params.beats = beats;
+    params.time_sig_num = 4;
+    params.time_sig_den = 4;
+    params.sample_rate = wav.sample_rate;
+    params.channels = wav.channels;
+    params.num_frames = wav.num_frames;
+    params.read_pcm = read_pcm;
+    params.read_ctx = &src;
+    params.slice_count = num_slices;
+    params.slices = slices;
+
+    /* Encode straight into the output file */
+    int written = write_rex_file(job->rx2_path, &params);
+    if (written <= 0) {
+        if (wav.error[0])
+            snprintf(err, err_len, "%s: %s", job->wav_path, wav.error);
+        else
+            snprintf(err, err_len, "cannot write '%s'", job->rx2_path);
+        if (src.sidecar_ok) rex_sidecar_abort(&src.sidecar);
+        wav_stream_close(&wav);
+        return -1;
+    }
+    wav_stream_close(&wav);
+
+    finish_sidecar(job->rx2_path, &src);
+
+    if (stats) {
+        stats->slices = num_slices;
+        stats->frames = params.num_frames;
+        stats->bytes = written;
+    }
+    return 0;
+}
+
+/* --- Job lists --- */
+
+static int append_job(rex_encode_job_t **jobs, int *count, int *cap,
+                      const rex_encode_job_t *job)
+{
+    if (*count == *cap) {
+        int new_cap = *cap ? *cap * 2 : 32;
+        rex_encode_job_t *grown =
+            (rex_encode_job_t *)realloc(*jobs, (size_t)new_cap * sizeof(rex_encode_job_t));
+        if (!grown) return -1;
+        *jobs = grown;
+        *cap = new_cap;
+    }
+    (*jobs)[(*count)++] = *job;
+    return 0;
+}
+
+static void free_job(rex_encode_job_t *job)
+{
+    free(job->wav_path);
+    free(job->rx2_path);
+    free(job->boundaries);
+}
+
+void rex_batch_free(rex_encode_job_t *jobs, int count)
+{
+    for (int i = 0; i < count; i++) free_job(&jobs[i]);
+    free(jobs);
+}
+
+int rex_batch_load_manifest(const char *path, rex_encode_job_t **jobs,
+                            char *err, int err_len)
+{
+    *jobs = NULL;
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        snprintf(err, err_len, "cannot read manifest '%s'", path);
+        return -1;
+    }
+
+    char *line = NULL;
+    size_t line_cap = 0;
+    int count = 0, cap = 0, line_no = 0, rc = 0;
+    while (getline(&line, &line_cap, fp) >= 0) {
+        line_no++;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+
+        char *fields[4] = { NULL, NULL, NULL, NULL };
+        int nf = 0;
+        char *save = NULL;
+        for (char *f = strtok_r(line, "\t", &save); f && nf < 4; f = strtok_r(NULL, "\t", &save)) {
+            fields[nf++] = f;
+        }
+        if (nf < 3) {
+            snprintf(err, err_len, "%s:%d: expected input, output and boundaries", path, line_no);
+            rc = -1;
+            break;
+        }
+
+        rex_encode_job_t job;
+        memset(&job, 0, sizeof(job));
+        job.wav_path = strdup(fields[0]);
+        job.rx2_path = strdup(fields[1]);
+        job.boundaries = strdup(fields[2]);
+        job.tempo = nf >= 4 ? (float)atof(fields[3]) : REX_BATCH_DEFAULT_TEMPO;
+        job.line = line_no;
+        if (!job.wav_path || !job.rx2_path || !job.boundaries ||
+            append_job(jobs, &count, &cap, &job) != 0) {
+            free_job(&job);
+            snprintf(err, err_len, "out of memory");
+            rc = -1;
+            break;
+        }
+    }
+    free(line);
+    fclose(fp);
+
+    if (rc != 0) {
+        rex_batch_free(*jobs, count);
+        *jobs = NULL;
+        return -1;
+    }
+    return count;
+}
+
+/* "<dir>/<name><suffix>" in a new string; name_len bytes of name */
+static char *join_path(const char *dir, const char *name, int name_len, const char *suffix)
+{
+    size_t len = strlen(dir) + 1 + (size_t)name_len + strlen(suffix) + 1;
+    char *path = (char *)malloc(len);
+    if (path) snprintf(path, len, "%s/%.*s%s", dir, name_len, name, suffix);
+    return path;
+}
+
+static int job_cmp(const void *a, const void *b)
+{
+    return strcmp(((const rex_encode_job_t *)a)->wav_path,
+                  ((const rex_encode_job_t *)b)->wav_path);
+}
+
+int rex_batch_from_dir(const char *wav_dir, const char *out_dir, int slices,
+                       float tempo, rex_encode_job_t **jobs,
+                       char *err, int err_len)
+{
+    *jobs = NULL;
+    DIR *d = opendir(wav_dir);
+    if (!d) {
+        snprintf(err, err_len, "cannot read directory '%s'", wav_dir);
+        return -1;
+    }
+
+    int count = 0, cap = 0, rc = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        const char *file = entry->d_name;
+        const char *ext = strrchr(file, '.');
+        if (file[0] == '.' || !ext || strcasecmp(ext, ".wav") != 0) continue;
+
+        rex_encode_job_t job;
+        memset(&job, 0, sizeof(job));
+        job.even_slices = slices;
+        job.tempo = tempo;
+        job.wav_path = join_path(wav_dir, file, (int)strlen(file), "");
+        job.rx2_path = join_path(out_dir, file, (int)(ext - file), ".rx2");
+        if (!job.wav_path || !job.rx2_path || append_job(jobs, &count, &cap, &job) != 0) {
+            free_job(&job);
+            snprintf(err, err_len, "out of memory");
+            rc = -1;
+            break;
+        }
+    }
+    closedir(d);
+
+    if (rc != 0) {
+        rex_batch_free(*jobs, count);
+        *jobs = NULL;
+        return -1;
+    }
+    if (count > 1) qsort(*jobs, count, sizeof(rex_encode_job_t), job_cmp);
+    return count;
+}
+
+/* --- Worker pool --- */
+
+typedef struct {
+    const rex_encode_job_t *jobs;
+    int count;
+    int next;                /* next job to take */
+    int failed;
+    size_t budget;
+    size_t in_flight;        /* estimated bytes held by running jobs */
+    rex_batch_report_fn report;
+    void *ctx;
+    pthread_mutex_t lock;
+    pthread_cond_t room;     /* in_flight went down */
+} batch_t;
+
+/* Peak memory of a job: everything is streamed, so only the fixed read,
+ * block and output staging buffers, whatever the file size */
+static size_t job_estimate(const rex_encode_job_t *job)
+{
+    (void)job;
+    return REX_BATCH_JOB_BYTES;
+}
+
+static void *batch_worker(void *arg)
+{
+    batch_t *b = (batch_t *)arg;
+    for (;;) {
+        pthread_mutex_lock(&b->lock);
+        if (b->next >= b->count) {
+            pthread_mutex_unlock(&b->lock);
+            break;
+        }
+        const rex_encode_job_t *job = &b->jobs[b->next++];
+        pthread_mutex_unlock(&b->lock);
+
+        /* Wait for room, unless nothing else is running */
+        size_t need = job_estimate(job);
+        pthread_mutex_lock(&b->lock);
+        while (b->in_flight > 0 && b->in_flight + need > b->budget) {
+            pthread_cond_wait(&b->room, &b->lock);
+        }
+        b->in_flight += need;
+        pthread_mutex_unlock(&b->lock);
+
+        rex_encode_stats_t stats;
+        char err[256];
+        memset(&stats, 0, sizeof(stats));
+        int rc = rex_encode_file(job, &stats, err, sizeof(err));
+
+        pthread_mutex_lock(&b->lock);
+        b->in_flight -= need;
+        if (rc != 0) b->failed++;
+        if (b->report) b->report(job, &stats, rc == 0 ? NULL : err, b->ctx);
+        pthread_cond_broadcast(&b->room);
+        pthread_mutex_unlock(&b->lock);
+    }
+    return NULL;
+}
+
+int rex_batch_run(const rex_encode_job_t *jobs, int count, int threads,
+                  size_t mem_budget, rex_batch_report_fn report, void *ctx)
+{
+    if (count <= 0) return 0;
+    if (threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cores > 0 ? (int)cores : 1;
+    }
+    if (threads > count) threads = count;
+
+    batch_t b;
+    memset(&b, 0, sizeof(b));
+    b.jobs = jobs;
+    b.count = count;
+    b.budget = mem_budget;
+    b.report = report;
+    b.ctx = ctx;
+    pthread_mutex_init(&b.lock, NULL);
+    pthread_cond_init(&b.room, NULL);
+
+    /* The calling thread works too; extra threads that fail to start just
+     * leave more jobs to the rest */
+    pthread_t *tids = (pthread_t *)calloc(threads, sizeof(pthread_t));
+    int started = 0;
+    for (int i = 1; tids && i < threads; i++) {
+        if (pthread_create(&tids[started], NULL, batch_worker, &b) == 0) started++;
+    }
+    batch_worker(&b);
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    free(tids);
+
+    pthread_cond_destroy(&b.room);
+    pthread_mutex_destroy(&b.lock);
+    return b.failed;
+}
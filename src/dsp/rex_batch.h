@@ -0,0 +1,76 @@
+/*
+ * REX2 Batch Encoding
+ *
+ * The rex-encode pipeline for one file (WAV in, REX2 plus decoded-PCM
+ * sidecar out) and a batch runner that converts many files in parallel on
+ * a pool of worker threads. Jobs share nothing, so workers only
+ * coordinate to take the next job and to stay within a budget for the
+ * memory held by files in flight: a job waits while starting it would
+ * exceed the budget, unless nothing else is running.
+ *
+ * Manifest format: one job per line, tab-separated,
+ *   input.wav <TAB> output.rx2 <TAB> boundaries [<TAB> tempo]
+ * with boundaries as for the single-file CLI. Blank lines and lines
+ * starting with '#' are ignored.
+ *
+ * License: MIT
+ */
+
+#ifndef REX_BATCH_H
+#define REX_BATCH_H
+
+#include <stddef.h>
+
+#define REX_BATCH_DEFAULT_TEMPO  120.0f
+#define REX_BATCH_DEFAULT_MEM_MB 256
+#define REX_BATCH_JOB_BYTES      (256 * 1024)  /* per-job peak, any file size */
+
+typedef struct {
+    char *wav_path;
+    char *rx2_path;
+    char *boundaries;      /* comma-separated, or NULL to slice evenly */
+    int even_slices;       /* slice count when boundaries is NULL */
+    float tempo;
+    int line;              /* manifest line, 0 for directory jobs */
+} rex_encode_job_t;
+
+typedef struct {
+    int slices;
+    int frames;
+    int bytes;             /* size of the written .rx2 */
+} rex_encode_stats_t;
+
+/* Encode one job's WAV into its REX2 file and pre-populate the player's
+ * sidecar. The audio is streamed from input to outputs in blocks, so the
+ * memory used is constant, however long the recording.
+ * Returns 0, or -1 with a message in err. */
+int rex_encode_file(const rex_encode_job_t *job, rex_encode_stats_t *stats,
+                    char *err, int err_len);
+
+/* Read a manifest into a new job array. Returns the job count, or -1 with
+ * a message in err. Release with rex_batch_free(). */
+int rex_batch_load_manifest(const char *path, rex_encode_job_t **jobs,
+                            char *err, int err_len);
+
+/* One job per .wav file in wav_dir: out_dir/<name>.rx2, cut into slices
+ * equal slices. Returns the job count (sorted by name), or -1 with a
+ * message in err. Release with rex_batch_free(). */
+int rex_batch_from_dir(const char *wav_dir, const char *out_dir, int slices,
+                       float tempo, rex_encode_job_t **jobs,
+                       char *err, int err_len);
+
+void rex_batch_free(rex_encode_job_t *jobs, int count);
+
+/* Called once per job as it finishes, serialized across workers. err is
+ * NULL on success. */
+typedef void (*rex_batch_report_fn)(const rex_encode_job_t *job,
+                                    const rex_encode_stats_t *stats,
+                                    const char *err, void *ctx);
+
+/* Run the jobs on threads workers (0 = one per online core), keeping the
+ * memory of files in flight within mem_budget bytes where possible.
+ * Returns the number of jobs that failed. */
+int rex_batch_run(const rex_encode_job_t *jobs, int count, int threads,
+                  size_t mem_budget, rex_batch_report_fn report, void *ctx);
+
+#endif /* REX_BATCH_H */
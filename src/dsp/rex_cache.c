@@ -0,0 +1,510 @@
+/*
+ * Decoded Loop Cache
+ *
+ * A short singly-linked list guarded by one mutex. The list stays small
+ * (bounded by the memory budget), so lookups and LRU eviction are linear
+ * scans. Decoding happens outside the lock; if two callers miss on the same
+ * file at once, the first insert wins and the other copy is dropped.
+ *
+ * Prefetched entries (decoded speculatively, never acquired yet) are the
+ * first to be evicted, and a prefetch never evicts anything else.
+ *
+ * Every load draws its buffers from one decode arena, and evicted entries
+ * hand theirs back, so once the cache is full, browsing recycles buffers
+ * instead of going to the heap.
+ *
+ * A progressive load (REX_PARSE_PROGRESSIVE) is listed as soon as its
+ * first step is decoded. The first rex_cache_finish() claims the rest of
+ * the decode; until it is done the entry is neither evicted nor freed,
+ * and acquires that need the whole file wait for it on g_decoded.
+ * rex_cache_finish_step() decodes one step without claiming it, so a
+ * finish arriving between steps takes over from there.
+ *
+ * License: MIT
+ */
+
+#include "rex_cache.h"
+#include "mapped_file.h"
+#include "rex_sidecar.h"
+#include "rex_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define REX_MAX_FILE_SIZE (50 * 1024 * 1024)  /* 50MB max */
+
+typedef struct cache_entry {
+    struct cache_entry *next;
+    rex_file_t *rex;
+    char path[512];
+    time_t mtime;
+    off_t size;
+    int flags;           /* REX_PARSE_* flags used to parse */
+    int refs;
+    int stale;           /* file changed on disk: no longer handed out */
+    int prefetched;      /* decoded speculatively, not acquired since */
+    int decoding;        /* progressive: DECODE_UNCLAIMED or DECODE_RUNNING */
+    int stepping;        /* a rex_cache_finish_step() is decoding (UNCLAIMED) */
+    uint64_t parse_ns;   /* progressive: its parse and decode steps so far */
+    uint64_t last_use;
+    size_t bytes;
+} cache_entry_t;
+
+#define DECODE_UNCLAIMED 1
+#define DECODE_RUNNING   2
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_decoded = PTHREAD_COND_INITIALIZER;  /* a decode finished */
+static cache_entry_t *g_entries = NULL;
+static size_t g_bytes = 0;
+static size_t g_budget = REX_CACHE_DEFAULT_BUDGET;
+static uint64_t g_clock = 0;
+static rex_cache_stats_t g_stats;  /* also under g_lock */
+
+static pthread_once_t g_arena_once = PTHREAD_ONCE_INIT;
+static rex_arena_t *g_arena = NULL;  /* NULL if creation failed: plain heap */
+
+static void create_arena(void)
+{
+    g_arena = rex_arena_create(REX_CACHE_DEFAULT_BUDGET / REX_CACHE_ARENA_SHARE);
+}
+
+static rex_arena_t *decode_arena(void)
+{
+    pthread_once(&g_arena_once, create_arena);
+    return g_arena;
+}
+
+/* ------------------------------------------------------------------ */
+/* Uncached load                                                       */
+/* ------------------------------------------------------------------ */
+
+/* rex_load_file(), also giving the time spent parsing (0 for a sidecar
+ * load; only the first step of a progressive one) */
+static rex_file_t *load_file(const char *path, int flags, char *err, int err_len,
+                             uint64_t *parse_ns)
+{
+    *parse_ns = 0;
+    rex_file_t *rex = (rex_file_t *)malloc(sizeof(rex_file_t));
+    if (!rex) {
+        snprintf(err, err_len, "Out of memory");
+        return NULL;
+    }
+
+    /* Decoded before: take the PCM from the sidecar, skipping the codec */
+    int full = !(flags & REX_PARSE_LAZY);
+    uint64_t t0 = rex_clock_ns();
+    rex_arena_t *arena = decode_arena();
+    int sidecar = full && rex_sidecar_load(path, rex, arena) == 0;
+    if (sidecar && (flags & REX_PARSE_HIRES) && rex->bytes_per_sample == 3) {
+        /* The sidecar holds 16-bit PCM: decode again for the full 24 bits */
+        rex_free(rex);
+        sidecar = 0;
+    }
+    if (sidecar) {
+        int format = rex_planar_format(flags, rex->bytes_per_sample);
+        if (format != REX_PLANAR_NONE) rex_build_planar(rex, format);
+        uint64_t ns = rex_clock_ns() - t0;
+        pthread_mutex_lock(&g_lock);
+        g_stats.sidecar_loads++;
+        g_stats.sidecar_ns += ns;
+        g_stats.sidecar_bytes += (uint64_t)rex->pcm_samples * rex->pcm_channels * sizeof(int16_t);
+        pthread_mutex_unlock(&g_lock);
+        return rex;
+    }
+
+    /* Map the file: the parser reads it in place and copies what it keeps */
+    mapped_file_t mf;
+    if (mapped_file_open(&mf, path, REX_MAX_FILE_SIZE, err, err_len) != 0) {
+        free(rex);
+        return NULL;
+    }
+
+    t0 = rex_clock_ns();
+    int rc = rex_parse_arena(rex, mf.data, mf.len, flags, arena);
+    uint64_t ns = rex_clock_ns() - t0;
+    size_t len = mf.len;
+    mapped_file_close(&mf);
+
+    *parse_ns = ns;
+
+    /* A progressive parse is the last one once its entry has finished */
+    pthread_mutex_lock(&g_lock);
+    g_stats.parses++;
+    g_stats.parse_ns += ns;
+    g_stats.parse_bytes += len;
+    if (rc != 0 || !rex->progress) {
+        g_stats.last_parse_ns = ns;
+        g_stats.last_parse_bytes = len;
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    if (rc != 0) {
+        snprintf(err, err_len, "%s", rex->error);
+        rex_file_destroy(rex);
+        return NULL;
+    }
+
+    /* Best effort: a read-only loops folder just means no sidecar.
+     * A progressive load stores it once the decode has finished. */
+    if (full && !rex->progress) rex_sidecar_store(path, rex);
+
+    return rex;
+}
+
+rex_file_t *rex_load_file(const char *path, int flags, char *err, int err_len)
+{
+    uint64_t ns;
+    return load_file(path, flags, err, err_len, &ns);
+}
+
+void rex_file_destroy(rex_file_t *rex)
+{
+    if (!rex) return;
+    rex_free(rex);
+    free(rex);
+}
+
+/* ------------------------------------------------------------------ */
+/* Cache internals (g_lock held)                                       */
+/* ------------------------------------------------------------------ */
+
+/* Size of one of rex's buffers: arena buffers may be larger than used */
+static size_t buffer_bytes(const rex_file_t *rex, const void *p, size_t used)
+{
+    if (!p) return 0;
+    return rex->arena ? rex_arena_capacity(p) : used;
+}
+
+/* What rex holds now. A lazy parse keeps its SDAT copy for good, a
+ * progressive one (with its decoder state) only until finish_entry. */
+static size_t rex_bytes(const rex_file_t *rex)
+{
+    size_t sdat = buffer_bytes(rex, rex->sdat_data, rex->sdat_len);
+    if (rex->lazy)
+        return sizeof(rex_file_t) + sdat;
+    return sizeof(rex_file_t) + sdat + rex_progress_bytes(rex) +
+           buffer_bytes(rex, rex->planar_data, rex->planar_bytes) +
+           buffer_bytes(rex, rex->pcm_data,
+                        (size_t)rex->pcm_samples * rex->pcm_channels * sizeof(int16_t));
+}
+
+static void unlink_entry(cache_entry_t *e)
+{
+    cache_entry_t **pp = &g_entries;
+    while (*pp && *pp != e) pp = &(*pp)->next;
+    if (*pp) *pp = e->next;
+
+    g_bytes -= e->bytes;
+    rex_file_destroy(e->rex);
+    free(e);
+}
+
+/* Evict idle entries until under budget: unused prefetches first, then
+ * least recently used. prefetch_only leaves acquired-before entries alone. */
+static void evict_to_budget(int prefetch_only)
+{
+    while (g_bytes > g_budget) {
+        cache_entry_t *victim = NULL;
+        for (cache_entry_t *e = g_entries; e; e = e->next) {
+            if (e->refs != 0 || e->decoding) continue;
+            if (prefetch_only && !e->prefetched) continue;
+            if (!victim ||
+                e->prefetched > victim->prefetched ||
+                (e->prefetched == victim->prefetched && e->last_use < victim->last_use))
+                victim = e;
+        }
+        if (!victim) break;  /* everything left is in use */
+        unlink_entry(victim);
+    }
+}
+
+static cache_entry_t *find_entry(const char *path, int flags, const struct stat *st)
+{
+    for (cache_entry_t *e = g_entries; e; e = e->next) {
+        if (e->stale || e->flags != flags || strcmp(e->path, path) != 0) continue;
+        if (e->mtime == st->st_mtime && e->size == st->st_size)
+            return e;
+
+        /* File changed on disk: retire this copy */
+        e->stale = 1;
+        if (e->refs == 0 && !e->decoding) {
+            unlink_entry(e);
+        }
+        return NULL;
+    }
+    return NULL;
+}
+
+static cache_entry_t *find_rex(const rex_file_t *rex)
+{
+    for (cache_entry_t *e = g_entries; e; e = e->next) {
+        if (e->rex == rex) return e;
+    }
+    return NULL;
+}
+
+/* A progressive entry's decode has finished: wake its waiters and let
+ * it go like any other. e may be unlinked on return. */
+static void complete_entry(cache_entry_t *e)
+{
+    g_stats.last_parse_ns = e->parse_ns;
+    g_stats.last_parse_bytes = (size_t)e->size;
+    e->decoding = 0;
+    pthread_cond_broadcast(&g_decoded);
+
+    /* The SDAT copy and decoder state are gone now */
+    g_bytes -= e->bytes;
+    e->bytes = rex_bytes(e->rex);
+    g_bytes += e->bytes;
+
+    /* What a release or a change on disk put off meanwhile */
+    if (e->refs == 0) {
+        if (e->stale) unlink_entry(e);
+        else evict_to_budget(0);
+    }
+}
+
+/* Decode the rest of a progressive entry if nobody has claimed it yet
+ * (after any step under way), else wait for whoever has if wait is set.
+ * Called and returns with g_lock held, dropping it meanwhile; the caller
+ * must hold a reference to keep e listed while it waits. */
+static void finish_entry(cache_entry_t *e, int wait)
+{
+    while (e->stepping)
+        pthread_cond_wait(&g_decoded, &g_lock);
+
+    if (e->decoding == DECODE_UNCLAIMED) {
+        e->decoding = DECODE_RUNNING;
+        pthread_mutex_unlock(&g_lock);
+
+        uint64_t t0 = rex_clock_ns();
+        while (rex_decode_step(e->rex, REX_DECODE_STEP)) {}
+        uint64_t ns = rex_clock_ns() - t0;
+        rex_sidecar_store(e->path, e->rex);
+
+        pthread_mutex_lock(&g_lock);
+        g_stats.parse_ns += ns;
+        e->parse_ns += ns;
+        complete_entry(e);
+        return;
+    }
+    while (wait && e->decoding)
+        pthread_cond_wait(&g_decoded, &g_lock);
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+/* Find or decode path. With prefetch set, no reference is taken and the
+ * result is only kept if it fits next to the non-prefetched entries. */
+static const rex_file_t *lookup_or_load(const char *path, int flags, int prefetch,
+                                        char *err, int err_len)
+{
+    /* A progressive copy is the same file sooner: one entry serves both */
+    int progressive = flags & REX_PARSE_PROGRESSIVE;
+    int key = flags & ~REX_PARSE_PROGRESSIVE;
+
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        snprintf(err, err_len, "Cannot open file");
+        return NULL;
+    }
+    if (strlen(path) >= sizeof(((cache_entry_t *)0)->path)) {
+        snprintf(err, err_len, "Path too long");
+        return NULL;
+    }
+
+    pthread_mutex_lock(&g_lock);
+    cache_entry_t *hit = find_entry(path, key, &st);
+    if (hit) {
+        g_stats.hits++;
+        if (!prefetch) {
+            hit->refs++;
+            hit->prefetched = 0;
+            hit->last_use = ++g_clock;
+            if (!progressive) finish_entry(hit, 1);
+        }
+        pthread_mutex_unlock(&g_lock);
+        return hit->rex;
+    }
+    g_stats.misses++;
+    pthread_mutex_unlock(&g_lock);
+
+    /* Miss: decode without holding the lock */
+    uint64_t parse_ns;
+    rex_file_t *rex = load_file(path, flags, err, err_len, &parse_ns);
+    if (!rex) return NULL;
+
+    cache_entry_t *e = (cache_entry_t *)calloc(1, sizeof(cache_entry_t));
+    if (!e) {
+        snprintf(err, err_len, "Out of memory");
+        rex_file_destroy(rex);
+        return NULL;
+    }
+    snprintf(e->path, sizeof(e->path), "%s", path);
+    e->rex = rex;
+    e->mtime = st.st_mtime;
+    e->size = st.st_size;
+    e->flags = key;
+    e->refs = prefetch ? 0 : 1;
+    e->prefetched = prefetch;
+    e->decoding = rex->progress ? DECODE_UNCLAIMED : 0;
+    e->parse_ns = parse_ns;
+    e->bytes = rex_bytes(rex);
+
+    pthread_mutex_lock(&g_lock);
+    hit = find_entry(path, key, &st);
+    if (hit) {
+        /* Someone else decoded it meanwhile: share theirs */
+        if (!prefetch) {
+            hit->refs++;
+            hit->prefetched = 0;
+            hit->last_use = ++g_clock;
+            if (!progressive) finish_entry(hit, 1);
+        }
+        pthread_mutex_unlock(&g_lock);
+        rex_file_destroy(rex);
+        free(e);
+        return hit->rex;
+    }
+    e->last_use = ++g_clock;
+    e->next = g_entries;
+    g_entries = e;
+    g_bytes += e->bytes;
+    evict_to_budget(prefetch);
+
+    /* The new prefetch itself may have been evicted: check before use */
+    const rex_file_t *result = NULL;
+    for (cache_entry_t *p = g_entries; p; p = p->next) {
+        if (p == e) {
+            result = rex;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    if (!result) {
+        snprintf(err, err_len, "Does not fit in cache budget");
+    }
+    return result;
+}
+
+const rex_file_t *rex_cache_acquire(const char *path, int flags,
+                                    char *err, int err_len)
+{
+    return lookup_or_load(path, flags, 0, err, err_len);
+}
+
+int rex_cache_prefetch(const char *path, int flags)
+{
+    char err[256];
+    flags &= ~REX_PARSE_PROGRESSIVE;  /* nobody would be there to finish it */
+    return lookup_or_load(path, flags, 1, err, sizeof(err)) ? 0 : -1;
+}
+
+void rex_cache_finish(const rex_file_t *rex)
+{
+    if (!rex) return;
+
+    pthread_mutex_lock(&g_lock);
+    cache_entry_t *e = find_rex(rex);
+    if (e) finish_entry(e, 0);
+    pthread_mutex_unlock(&g_lock);
+}
+
+int rex_cache_finish_step(const rex_file_t *rex)
+{
+    if (!rex) return 0;
+
+    /* Looked up again after every wait: without a reference, the entry
+     * may be finished and evicted meanwhile */
+    pthread_mutex_lock(&g_lock);
+    cache_entry_t *e;
+    while ((e = find_rex(rex)) && e->decoding == DECODE_UNCLAIMED && e->stepping)
+        pthread_cond_wait(&g_decoded, &g_lock);
+    if (!e || e->decoding != DECODE_UNCLAIMED) {
+        pthread_mutex_unlock(&g_lock);
+        return 0;
+    }
+    e->stepping = 1;
+    pthread_mutex_unlock(&g_lock);
+
+    uint64_t t0 = rex_clock_ns();
+    int more = rex_decode_step(e->rex, REX_DECODE_STEP);
+    if (!more) rex_sidecar_store(e->path, e->rex);
+    uint64_t ns = rex_clock_ns() - t0;
+
+    pthread_mutex_lock(&g_lock);
+    e->stepping = 0;
+    g_stats.parse_ns += ns;
+    e->parse_ns += ns;
+    if (more) pthread_cond_broadcast(&g_decoded);  /* for a finish_entry() */
+    else complete_entry(e);
+    pthread_mutex_unlock(&g_lock);
+    return more;
+}
+
+void rex_cache_release(const rex_file_t *rex)
+{
+    if (!rex) return;
+
+    pthread_mutex_lock(&g_lock);
+    for (cache_entry_t *e = g_entries; e; e = e->next) {
+        if (e->rex != rex) continue;
+        if (--e->refs == 0 && !e->decoding) {
+            if (e->stale) {
+                unlink_entry(e);
+            } else {
+                evict_to_budget(0);
+            }
+        }
+        break;
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+void rex_cache_set_budget(size_t bytes)
+{
+    pthread_mutex_lock(&g_lock);
+    g_budget = bytes;
+    evict_to_budget(0);
+    pthread_mutex_unlock(&g_lock);
+
+    rex_arena_t *arena = decode_arena();
+    if (arena) rex_arena_trim(arena, bytes / REX_CACHE_ARENA_SHARE);
+}
+
+size_t rex_cache_get_budget(void)
+{
+    pthread_mutex_lock(&g_lock);
+    size_t b = g_budget;
+    pthread_mutex_unlock(&g_lock);
+    return b;
+}
+
+size_t rex_cache_bytes(void)
+{
+    pthread_mutex_lock(&g_lock);
+    size_t b = g_bytes;
+    pthread_mutex_unlock(&g_lock);
+    return b;
+}
+
+void rex_cache_stats(rex_cache_stats_t *out)
+{
+    pthread_mutex_lock(&g_lock);
+    *out = g_stats;
+    pthread_mutex_unlock(&g_lock);
+
+    rex_arena_stats_t as = {0};
+    rex_arena_t *arena = decode_arena();
+    if (arena) rex_arena_stats(arena, &as);
+    out->buffer_reuses = as.reuses;
+    out->buffer_allocs = as.allocs;
+    out->buffer_idle_bytes = as.idle_bytes;
+}
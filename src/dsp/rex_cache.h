@@ -0,0 +1,103 @@
+/*
+ * Decoded Loop Cache
+ *
+ * Process-wide, reference-counted cache of parsed REX files, shared by all
+ * plugin instances. Entries are keyed by path + mtime + size (and the
+ * REX_PARSE_* flags they were parsed with), so an edited
+ * file is decoded again while the old copy stays valid for anyone still
+ * holding it. Unreferenced entries are kept for fast preset switches and
+ * evicted least-recently-used first once the memory budget is exceeded.
+ *
+ * Decode buffers are recycled through a shared arena (see rex_parser.h)
+ * holding up to a quarter of the budget on top of it.
+ *
+ * Cached rex_file_t data is immutable: holders must only read it.
+ * None of these functions may be called on the render thread.
+ *
+ * License: MIT
+ */
+
+#ifndef REX_CACHE_H
+#define REX_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "rex_parser.h"
+
+#define REX_CACHE_DEFAULT_BUDGET (64u * 1024 * 1024)
+
+/* Released decode buffers kept for reuse: budget / REX_CACHE_ARENA_SHARE */
+#define REX_CACHE_ARENA_SHARE 4
+
+/* Read and parse a REX file without caching, with REX_PARSE_* flags,
+ * into buffers from the cache's arena.
+ * Full (non-lazy) loads read and refresh the decoded-PCM sidecar when
+ * sidecars are enabled (see rex_sidecar.h); a progressive one that was
+ * not served from the sidecar is returned unfinished and without storing
+ * it, for the caller to complete with rex_decode_step().
+ * Returns a heap-allocated rex_file_t, or NULL on error (message in err).
+ * Release with rex_file_destroy(). */
+rex_file_t *rex_load_file(const char *path, int flags, char *err, int err_len);
+
+/* Free a rex_file_t returned by rex_load_file() (NULL is ignored) */
+void rex_file_destroy(rex_file_t *rex);
+
+/* Return a referenced, shared copy of path, decoding it on a miss.
+ * Returns NULL on error (message in err). Pair with rex_cache_release().
+ * With REX_PARSE_PROGRESSIVE the copy may still be decoding (see
+ * rex_decoded_frames()): call rex_cache_finish() or rex_cache_finish_step()
+ * next. Without it, a
+ * copy still decoding for someone else is waited for. */
+const rex_file_t *rex_cache_acquire(const char *path, int flags,
+                                    char *err, int err_len);
+
+/* Decode path into the cache speculatively without taking a reference.
+ * Prefetched entries are evicted before any other, and a prefetch is
+ * dropped rather than evicting a loop that has been used.
+ * Returns 0 if path is now cached, -1 otherwise. */
+int rex_cache_prefetch(const char *path, int flags);
+
+/* Decode the rest of a progressive copy from rex_cache_acquire() on the
+ * calling thread, then store its sidecar. Returns at once if the copy is
+ * complete or another caller is already finishing it. */
+void rex_cache_finish(const rex_file_t *rex);
+
+/* rex_cache_finish() one REX_DECODE_STEP at a time, for a caller with
+ * other work between steps. Needs no reference: returns 1 while frames
+ * remain, 0 once the copy is complete (sidecar stored), finished by
+ * someone else or no longer cached. A step under way elsewhere is
+ * waited for first. */
+int rex_cache_finish_step(const rex_file_t *rex);
+
+/* Drop a reference taken by rex_cache_acquire() (NULL is ignored) */
+void rex_cache_release(const rex_file_t *rex);
+
+/* Memory budget in bytes for decoded audio, including entries in use.
+ * Lowering it evicts idle entries right away and trims the arena. */
+void rex_cache_set_budget(size_t bytes);
+size_t rex_cache_get_budget(void);
+
+/* Bytes currently held by the cache (entries in use and idle) */
+size_t rex_cache_bytes(void);
+
+/* Counters since process start, for performance monitoring. A parse is a
+ * rex_load_file() that ran the parser; sidecar loads are counted apart. */
+typedef struct {
+    unsigned hits;             /* acquires and prefetches served from memory */
+    unsigned misses;
+    unsigned parses;
+    unsigned sidecar_loads;
+    uint64_t parse_ns;         /* all parses */
+    uint64_t parse_bytes;      /* REX bytes they read */
+    uint64_t last_parse_ns;    /* latest parse to finish, all of its */
+    size_t last_parse_bytes;   /* progressive steps included */
+    uint64_t sidecar_ns;       /* all sidecar loads */
+    uint64_t sidecar_bytes;    /* PCM bytes they restored */
+    unsigned buffer_reuses;    /* decode buffers recycled from the arena */
+    unsigned buffer_allocs;    /* decode buffers taken from the heap */
+    size_t buffer_idle_bytes;  /* held by the arena for reuse */
+} rex_cache_stats_t;
+
+void rex_cache_stats(rex_cache_stats_t *out);
+
+#endif /* REX_CACHE_H */
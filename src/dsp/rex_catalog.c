@@ -0,0 +1,244 @@
+/*
+ * Shared Loop Catalog
+ *
+ * A view is one allocation: the header, the item array and the string
+ * arena ("path\0name\0" per item), so a folder of any size costs one
+ * block sized to its actual names instead of fixed-width slots. Superseded
+ * views stay on the catalog's list until its last close.
+ *
+ * License: MIT
+ */
+
+#include "rex_catalog.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+typedef struct {
+    uint32_t path_off;         /* into the view's strings */
+    uint32_t name_off;
+    int64_t mtime;
+    int64_t size;
+    rex_loop_info_t info;
+} catalog_item_t;
+
+struct rex_catalog_view {
+    int count;
+    const catalog_item_t *items;
+    const char *strings;
+    rex_catalog_view_t *older;   /* superseded views, newest first */
+};
+
+struct rex_catalog {
+    char dir[512];
+    int refs;
+    rex_catalog_t *next;
+
+    pthread_mutex_t lock;        /* guards everything below */
+    rex_catalog_view_t *current;
+    int64_t dir_mtime;           /* folder mtime the current view matches */
+    int64_t scanned_at;          /* when it was checked against the folder */
+};
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static rex_catalog_t *g_catalogs = NULL;
+
+/* Stands in when even an empty view cannot be allocated; never freed */
+static rex_catalog_view_t g_empty_view = { 0, NULL, "", NULL };
+
+/* Pack a library listing into a view; NULL if out of memory */
+static rex_catalog_view_t *view_build(const rex_library_entry_t *entries, int count)
+{
+    size_t string_bytes = 0;
+    for (int i = 0; i < count; i++) {
+        string_bytes += strlen(entries[i].path) + 1 + strlen(entries[i].name) + 1;
+    }
+
+    size_t items_off = (sizeof(rex_catalog_view_t) + 7) & ~(size_t)7;
+    size_t strings_off = items_off + (size_t)count * sizeof(catalog_item_t);
+    char *block = (char *)malloc(strings_off + string_bytes + 1);
+    if (!block) return NULL;
+
+    rex_catalog_view_t *view = (rex_catalog_view_t *)block;
+    catalog_item_t *items = (catalog_item_t *)(block + items_off);
+    char *strings = block + strings_off;
+    size_t pos = 0;
+    for (int i = 0; i < count; i++) {
+        size_t path_len = strlen(entries[i].path) + 1;
+        size_t name_len = strlen(entries[i].name) + 1;
+        items[i].path_off = (uint32_t)pos;
+        memcpy(strings + pos, entries[i].path, path_len);
+        pos += path_len;
+        items[i].name_off = (uint32_t)pos;
+        memcpy(strings + pos, entries[i].name, name_len);
+        pos += name_len;
+        items[i].mtime = entries[i].mtime;
+        items[i].size = entries[i].size;
+        items[i].info = entries[i].info;
+    }
+    strings[pos] = '\0';
+
+    view->count = count;
+    view->items = items;
+    view->strings = strings;
+    view->older = NULL;
+    return view;
+}
+
+/* Does the view list exactly these files, unchanged? */
+static int view_matches(const rex_catalog_view_t *view,
+                        const rex_library_entry_t *entries, int count)
+{
+    if (view->count != count) return 0;
+    for (int i = 0; i < count; i++) {
+        const catalog_item_t *it = &view->items[i];
+        if (it->mtime != entries[i].mtime || it->size != entries[i].size ||
+            strcmp(view->strings + it->path_off, entries[i].path) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+/* Scan the folder and publish a view if the listing changed.
+ * Called with catalog->lock held. */
+static void catalog_scan(rex_catalog_t *catalog)
+{
+    rex_library_entry_t *entries = NULL;
+    int64_t dir_mtime = 0;
+    int64_t now = (int64_t)time(NULL);
+    int count = rex_library_scan(catalog->dir, &entries, &dir_mtime);
+
+    if (!catalog->current || !view_matches(catalog->current, entries, count)) {
+        rex_catalog_view_t *view = view_build(entries, count);
+        if (view) {
+            view->older = catalog->current;
+            catalog->current = view;
+        } else if (!catalog->current) {
+            catalog->current = &g_empty_view;
+        }
+    }
+    catalog->dir_mtime = dir_mtime;
+    catalog->scanned_at = now;
+    free(entries);
+}
+
+rex_catalog_t *rex_catalog_open(const char *dir)
+{
+    pthread_mutex_lock(&g_lock);
+    rex_catalog_t *catalog;
+    for (catalog = g_catalogs; catalog; catalog = catalog->next) {
+        if (strcmp(catalog->dir, dir) == 0) {
+            catalog->refs++;
+            pthread_mutex_unlock(&g_lock);
+            return catalog;
+        }
+    }
+
+    catalog = (rex_catalog_t *)calloc(1, sizeof(rex_catalog_t));
+    if (!catalog) {
+        pthread_mutex_unlock(&g_lock);
+        return NULL;
+    }
+    strncpy(catalog->dir, dir, sizeof(catalog->dir) - 1);
+    catalog->refs = 1;
+    pthread_mutex_init(&catalog->lock, NULL);
+
+    /* First scan under the catalog lock only, so other folders can open */
+    pthread_mutex_lock(&catalog->lock);
+    catalog->next = g_catalogs;
+    g_catalogs = catalog;
+    pthread_mutex_unlock(&g_lock);
+
+    catalog_scan(catalog);
+    pthread_mutex_unlock(&catalog->lock);
+    return catalog;
+}
+
+void rex_catalog_close(rex_catalog_t *catalog)
+{
+    if (!catalog) return;
+    pthread_mutex_lock(&g_lock);
+    if (--catalog->refs > 0) {
+        pthread_mutex_unlock(&g_lock);
+        return;
+    }
+    for (rex_catalog_t **p = &g_catalogs; *p; p = &(*p)->next) {
+        if (*p == catalog) {
+            *p = catalog->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    rex_catalog_view_t *view = catalog->current;
+    while (view) {
+        rex_catalog_view_t *older = view->older;
+        if (view != &g_empty_view) free(view);
+        view = older;
+    }
+    pthread_mutex_destroy(&catalog->lock);
+    free(catalog);
+}
+
+const rex_catalog_view_t *rex_catalog_current(rex_catalog_t *catalog)
+{
+    pthread_mutex_lock(&catalog->lock);
+    const rex_catalog_view_t *view = catalog->current;
+    pthread_mutex_unlock(&catalog->lock);
+    return view;
+}
+
+const rex_catalog_view_t *rex_catalog_refresh(rex_catalog_t *catalog)
+{
+    struct stat st;
+    pthread_mutex_lock(&catalog->lock);
+
+    /* Unchanged since a check made after its last change: nothing to do
+     * (mtimes have one-second resolution, as for the library index) */
+    if (stat(catalog->dir, &st) != 0 ||
+        (int64_t)st.st_mtime != catalog->dir_mtime ||
+        catalog->scanned_at <= catalog->dir_mtime) {
+        catalog_scan(catalog);
+    }
+    const rex_catalog_view_t *view = catalog->current;
+    pthread_mutex_unlock(&catalog->lock);
+    return view;
+}
+
+int rex_catalog_count(const rex_catalog_view_t *view)
+{
+    return view->count;
+}
+
+const char *rex_catalog_path(const rex_catalog_view_t *view, int i)
+{
+    return view->strings + view->items[i].path_off;
+}
+
+const char *rex_catalog_name(const rex_catalog_view_t *view, int i)
+{
+    return view->strings + view->items[i].name_off;
+}
+
+const rex_loop_info_t *rex_catalog_info(const rex_catalog_view_t *view, int i)
+{
+    return &view->items[i].info;
+}
+
+int rex_catalog_find_name(const rex_catalog_view_t *view, const char *name)
+{
+    for (int i = 0; i < view->count; i++) {
+        if (strcmp(view->strings + view->items[i].name_off, name) == 0) return i;
+    }
+    return -1;
+}
+
+int rex_catalog_find_path(const rex_catalog_view_t *view, const char *path)
+{
+    for (int i = 0; i < view->count; i++) {
+        if (strcmp(view->strings + view->items[i].path_off, path) == 0) return i;
+    }
+    return -1;
+}
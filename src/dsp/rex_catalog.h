@@ -0,0 +1,54 @@
+/*
+ * Shared Loop Catalog
+ *
+ * Process-wide, reference-counted list of the loops in a folder, shared by
+ * all plugin instances browsing the same folder, so each instance no longer
+ * carries its own fixed-size copy. A catalog publishes immutable views:
+ * one offset array plus one string arena holding every path and display
+ * name, sized to the folder with no entry limit. Refreshing checks the
+ * folder mtime and, if it changed, rescans it incrementally through the
+ * library index (rex_library.h) and publishes a new view.
+ *
+ * Views are never freed while the catalog is open, so path and name
+ * pointers taken from any view stay valid until the holder's
+ * rex_catalog_close() (the loader and prefetcher keep such pointers).
+ *
+ * Not for the render thread.
+ *
+ * License: MIT
+ */
+
+#ifndef REX_CATALOG_H
+#define REX_CATALOG_H
+
+#include "rex_library.h"
+
+typedef struct rex_catalog rex_catalog_t;
+typedef struct rex_catalog_view rex_catalog_view_t;
+
+/* Return a referenced catalog for dir, scanning it on first open.
+ * Returns NULL if out of memory. Pair with rex_catalog_close(). */
+rex_catalog_t *rex_catalog_open(const char *dir);
+
+/* Drop a reference taken by rex_catalog_open() (NULL is ignored).
+ * The last close frees all of the catalog's views. */
+void rex_catalog_close(rex_catalog_t *catalog);
+
+/* Latest published view (never NULL for an open catalog) */
+const rex_catalog_view_t *rex_catalog_current(rex_catalog_t *catalog);
+
+/* Rescan if the folder changed since the latest view was taken.
+ * Returns the latest view, which is new if the listing changed. */
+const rex_catalog_view_t *rex_catalog_refresh(rex_catalog_t *catalog);
+
+/* View accessors; i must be in 0..count-1 */
+int rex_catalog_count(const rex_catalog_view_t *view);
+const char *rex_catalog_path(const rex_catalog_view_t *view, int i);
+const char *rex_catalog_name(const rex_catalog_view_t *view, int i);
+const rex_loop_info_t *rex_catalog_info(const rex_catalog_view_t *view, int i);
+
+/* Index of the entry with this display name or path, or -1 */
+int rex_catalog_find_name(const rex_catalog_view_t *view, const char *name);
+int rex_catalog_find_path(const rex_catalog_view_t *view, const char *path);
+
+#endif /* REX_CATALOG_H */
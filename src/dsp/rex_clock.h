@@ -0,0 +1,24 @@
+/*
+ * Monotonic Clock for Performance Counters
+ *
+ * One vDSO call, no system call: cheap enough to bracket every render
+ * block and file load.
+ *
+ * License: MIT
+ */
+
+#ifndef REX_CLOCK_H
+#define REX_CLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+
+/* Nanoseconds on CLOCK_MONOTONIC */
+static inline uint64_t rex_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+#endif /* REX_CLOCK_H */
@@ -2,12 +2,20 @@
  * rex-encode: CLI tool to create REX2 files from WAV + slice boundaries.
  *
  * Usage: rex-encode <input.wav> <output.rx2> <boundaries> [tempo]
+ *        rex-encode --batch <manifest> [-j jobs] [-m mem_mb]
+ *        rex-encode --batch-dir <wav_dir> <out_dir> [-s slices] [-t tempo]
+ *                   [-j jobs] [-m mem_mb]
  *
  *   boundaries: comma-separated sample positions (N+1 values for N slices)
  *               e.g. "0,44100,88200" for 2 slices
  *   tempo:      BPM (default 120)
+ *   manifest:   one "input<TAB>output<TAB>boundaries[<TAB>tempo]" per line
+ *   slices:     equal slices per file in directory mode (default 1)
+ *   jobs:       worker threads (default: one per core)
+ *   mem_mb:     budget for files in flight (default 256)
  *
- * Exit code: 0 = success, 1 = error
+ * Batch modes report OK/FAIL per file on stderr.
+ * Exit code: 0 = success, 1 = error (in batch mode: any file failed)
  *
  * License: MIT
  */
@@ -15,181 +23,109 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
-#include <pwd.h>
-#include "wav_reader.h"
-#include "rex_writer.h"
+#include "rex_batch.h"
 
-#define MAX_SLICES 1024
-#define MAX_FILE_SIZE (100 * 1024 * 1024)  /* 100 MB */
-
-static uint8_t *read_file(const char *path, long *size)
+static void usage(void)
 {
-    FILE *f = fopen(path, "rb");
-    if (!f) return NULL;
-    fseek(f, 0, SEEK_END);
-    *size = ftell(f);
-    fseek(f, 0, SEEK_SET);
-    if (*size <= 0 || *size > MAX_FILE_SIZE) { fclose(f); return NULL; }
-    uint8_t *buf = (uint8_t *)malloc(*size);
-    if (!buf) { fclose(f); return NULL; }
-    if (fread(buf, 1, *size, f) != (size_t)*size) { free(buf); fclose(f); return NULL; }
-    fclose(f);
-    return buf;
-}
-
-static void chown_to_ableton(const char *path) {
-    struct passwd *pw = getpwnam("ableton");
-    if (pw) chown(path, pw->pw_uid, pw->pw_gid);
+    fprintf(stderr, "Usage: rex-encode <input.wav> <output.rx2> <boundaries> [tempo]\n");
+    fprintf(stderr, "       rex-encode --batch <manifest> [-j jobs] [-m mem_mb]\n");
+    fprintf(stderr, "       rex-encode --batch-dir <wav_dir> <out_dir> [-s slices] [-t tempo]"
+                    " [-j jobs] [-m mem_mb]\n");
+    fprintf(stderr, "  boundaries: comma-separated sample positions (N+1 for N slices)\n");
+    fprintf(stderr, "  tempo: BPM (default 120)\n");
+    fprintf(stderr, "  manifest: input<TAB>output<TAB>boundaries[<TAB>tempo] per line\n");
 }
 
-static int write_file(const char *path, const uint8_t *data, size_t len)
+static void report_job(const rex_encode_job_t *job, const rex_encode_stats_t *stats,
+                       const char *err, void *ctx)
 {
-    FILE *f = fopen(path, "wb");
-    if (!f) return -1;
-    if (fwrite(data, 1, len, f) != len) { fclose(f); return -1; }
-    fclose(f);
-    chown_to_ableton(path);
-    return 0;
-}
-
-/* Parse comma-separated boundaries string into array.
- * Returns number of boundaries parsed. */
-static int parse_boundaries(const char *str, uint32_t *out, int max_count)
-{
-    int count = 0;
-    const char *p = str;
-    while (*p && count < max_count) {
-        char *end;
-        long val = strtol(p, &end, 10);
-        if (end == p) break;
-        if (val < 0) {
-            fprintf(stderr, "Error: negative boundary value %ld\n", val);
-            return -1;
-        }
-        out[count++] = (uint32_t)val;
-        if (*end == ',') end++;
-        p = end;
+    (void)ctx;
+    if (err) {
+        if (job->line > 0)
+            fprintf(stderr, "FAIL: line %d: %s: %s\n", job->line, job->wav_path, err);
+        else
+            fprintf(stderr, "FAIL: %s: %s\n", job->wav_path, err);
+    } else {
+        fprintf(stderr, "OK: %s -> %s (%d slices, %d frames, %d bytes)\n",
+                job->wav_path, job->rx2_path, stats->slices, stats->frames, stats->bytes);
     }
-    return count;
 }
 
-int main(int argc, char **argv)
+static int run_batch(int argc, char **argv)
 {
-    if (argc < 4) {
-        fprintf(stderr, "Usage: rex-encode <input.wav> <output.rx2> <boundaries> [tempo]\n");
-        fprintf(stderr, "  boundaries: comma-separated sample positions (N+1 for N slices)\n");
-        fprintf(stderr, "  tempo: BPM (default 120)\n");
-        return 1;
-    }
-
-    const char *wav_path = argv[1];
-    const char *rx2_path = argv[2];
-    const char *boundaries_str = argv[3];
-    float tempo = (argc >= 5) ? (float)atof(argv[4]) : 120.0f;
-
-    if (tempo <= 0 || tempo > 999) {
-        fprintf(stderr, "Error: invalid tempo %.1f\n", tempo);
-        return 1;
-    }
-
-    /* Parse boundaries */
-    uint32_t boundaries[MAX_SLICES + 1];
-    int num_boundaries = parse_boundaries(boundaries_str, boundaries, MAX_SLICES + 1);
-    if (num_boundaries < 0) return 1;  /* parse error (e.g. negative value) */
-    int num_slices = num_boundaries - 1;
-
-    if (num_slices < 1) {
-        fprintf(stderr, "Error: need at least 2 boundary values for 1 slice\n");
-        return 1;
+    int dir_mode = strcmp(argv[1], "--batch-dir") == 0;
+    const char *positional[2] = { NULL, NULL };
+    int npos = 0;
+    int threads = 0, slices = 1;
+    float tempo = REX_BATCH_DEFAULT_TEMPO;
+    int mem_mb = REX_BATCH_DEFAULT_MEM_MB;
+
+    for (int i = 2; i < argc; i++) {
+        const char *opt = argv[i];
+        if (opt[0] == '-' && opt[1] && !opt[2] && i + 1 < argc &&
+            strchr(dir_mode ? "jmst" : "jm", opt[1])) {
+            const char *val = argv[++i];
+            switch (opt[1]) {
+            case 'j': threads = atoi(val); break;
+            case 'm': mem_mb = atoi(val); break;
+            case 's': slices = atoi(val); break;
+            case 't': tempo = (float)atof(val); break;
+            }
+        } else if (npos < (dir_mode ? 2 : 1)) {
+            positional[npos++] = opt;
+        } else {
+            usage();
+            return 1;
+        }
     }
-
-    /* Read WAV file */
-    long wav_size;
-    uint8_t *wav_raw = read_file(wav_path, &wav_size);
-    if (!wav_raw) {
-        fprintf(stderr, "Error: cannot read '%s'\n", wav_path);
+    if (npos < (dir_mode ? 2 : 1) || threads < 0 || mem_mb <= 0) {
+        usage();
         return 1;
     }
 
-    wav_file_t wav;
-    if (wav_read(&wav, wav_raw, (size_t)wav_size) != 0) {
-        fprintf(stderr, "Error: %s\n", wav.error);
-        free(wav_raw);
+    rex_encode_job_t *jobs = NULL;
+    char err[256];
+    int count = dir_mode
+        ? rex_batch_from_dir(positional[0], positional[1], slices, tempo, &jobs, err, sizeof(err))
+        : rex_batch_load_manifest(positional[0], &jobs, err, sizeof(err));
+    if (count < 0) {
+        fprintf(stderr, "Error: %s\n", err);
         return 1;
     }
-    free(wav_raw);
 
-    /* Build slice descriptors */
-    rex_write_slice_t slices[MAX_SLICES];
-    for (int i = 0; i < num_slices; i++) {
-        slices[i].sample_offset = boundaries[i];
-        if (boundaries[i + 1] <= boundaries[i]) {
-            fprintf(stderr, "Error: slice %d has zero or negative length (boundaries %u to %u)\n",
-                    i, boundaries[i], boundaries[i + 1]);
-            wav_free(&wav);
-            return 1;
-        }
-        slices[i].sample_length = boundaries[i + 1] - boundaries[i];
-        if (slices[i].sample_offset + slices[i].sample_length > (uint32_t)wav.num_frames) {
-            fprintf(stderr, "Error: slice %d extends past end of audio (%u+%u > %d)\n",
-                    i, slices[i].sample_offset, slices[i].sample_length, wav.num_frames);
-            wav_free(&wav);
-            return 1;
-        }
-    }
-
-    /* Compute bars and beats from tempo and total length (assumes 4/4) */
-    double total_seconds = (double)wav.num_frames / wav.sample_rate;
-    double total_beats = total_seconds * tempo / 60.0;
-    int bars = (int)(total_beats / 4.0);
-    int beats = (int)(total_beats - bars * 4.0);
-    if (bars < 1) bars = 1;
+    int failed = rex_batch_run(jobs, count, threads, (size_t)mem_mb * 1024 * 1024,
+                               report_job, NULL);
+    fprintf(stderr, "Batch: %d encoded, %d failed\n", count - failed, failed);
+    rex_batch_free(jobs, count);
+    return failed ? 1 : 0;
+}
 
-    /* Allocate output buffer */
-    int out_cap = wav.num_frames * wav.channels * 3 + num_slices * 32 + 4096;
-    uint8_t *out_buf = (uint8_t *)malloc(out_cap);
-    if (!out_buf) {
-        fprintf(stderr, "Error: failed to allocate output buffer\n");
-        wav_free(&wav);
-        return 1;
+int main(int argc, char **argv)
+{
+    if (argc >= 2 && (strcmp(argv[1], "--batch") == 0 || strcmp(argv[1], "--batch-dir") == 0)) {
+        return run_batch(argc, argv);
     }
 
-    /* Write REX2 file */
-    rex_write_params_t params;
-    memset(&params, 0, sizeof(params));
-    params.tempo_bpm = tempo;
-    params.bars = bars;
-    params.beats = beats;
-    params.time_sig_num = 4;
-    params.time_sig_den = 4;
-    params.sample_rate = wav.sample_rate;
-    params.channels = wav.channels;
-    params.pcm_data = wav.pcm_data;
-    params.num_frames = wav.num_frames;
-    params.slice_count = num_slices;
-    params.slices = slices;
-
-    int written = rex_write(&params, out_buf, out_cap);
-    if (written <= 0) {
-        fprintf(stderr, "Error: rex_write failed\n");
-        free(out_buf);
-        wav_free(&wav);
+    if (argc < 4) {
+        usage();
         return 1;
     }
 
-    /* Write output file */
-    if (write_file(rx2_path, out_buf, (size_t)written) != 0) {
-        fprintf(stderr, "Error: cannot write '%s'\n", rx2_path);
-        free(out_buf);
-        wav_free(&wav);
+    rex_encode_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.wav_path = argv[1];
+    job.rx2_path = argv[2];
+    job.boundaries = argv[3];
+    job.tempo = (argc >= 5) ? (float)atof(argv[4]) : REX_BATCH_DEFAULT_TEMPO;
+
+    rex_encode_stats_t stats;
+    char err[256];
+    if (rex_encode_file(&job, &stats, err, sizeof(err)) != 0) {
+        fprintf(stderr, "Error: %s\n", err);
         return 1;
     }
 
     fprintf(stderr, "OK: %d slices, %d frames, %.1f BPM, %d bytes\n",
-            num_slices, wav.num_frames, tempo, written);
-
-    free(out_buf);
-    wav_free(&wav);
+            stats.slices, stats.frames, job.tempo, stats.bytes);
     return 0;
 }
@@ -0,0 +1,296 @@
+/*
+ * Multi-Loop Kits
+ *
+ * Every zone's loop is taken from the shared cache, its slices copied
+ * one after another into the kit's PCM pool and entered in the note
+ * table, and the loops released again: the kit owns its audio outright.
+ *
+ * License: MIT
+ */
+
+#include "rex_kit.h"
+#include "rex_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/* ------------------------------------------------------------------ */
+/* Kit text                                                            */
+/* ------------------------------------------------------------------ */
+
+/* Last c in [a, b), or NULL */
+static const char *find_last(const char *a, const char *b, char c)
+{
+    while (b > a) {
+        if (*--b == c) return b;
+    }
+    return NULL;
+}
+
+/* Read [a, b) as a non-negative decimal number (at most 9 digits).
+ * Returns 0, or -1 if it is empty or not all digits. */
+static int read_number(const char *a, const char *b, int *out)
+{
+    if (a == b || b - a > 9) return -1;
+    int v = 0;
+    for (; a < b; a++) {
+        if (!isdigit((unsigned char)*a)) return -1;
+        v = v * 10 + (*a - '0');
+    }
+    *out = v;
+    return 0;
+}
+
+/* "first", "first-" or "first-last" in [a, b) */
+static int read_range(const char *a, const char *b, int *first, int *last)
+{
+    const char *dash = find_last(a, b, '-');
+    if (!dash) {
+        if (read_number(a, b, first) != 0) return -1;
+        *last = *first;
+        return 0;
+    }
+    if (read_number(a, dash, first) != 0) return -1;
+    if (dash + 1 == b) {
+        *last = -1;
+        return 0;
+    }
+    return read_number(dash + 1, b, last);
+}
+
+int rex_kit_parse(rex_kit_spec_t *spec, const char *text, int first_note,
+                  char *err, int err_len)
+{
+    memset(spec, 0, sizeof(*spec));
+    spec->first_note = first_note;
+
+    const char *p = text;
+    while (*p) {
+        const char *end = strchr(p, ';');
+        if (!end) end = p + strlen(p);
+        const char *a = p, *b = end;
+        p = *end ? end + 1 : end;
+        while (a < b && isspace((unsigned char)*a)) a++;
+        while (b > a && isspace((unsigned char)b[-1])) b--;
+        if (a == b) continue;
+
+        if (spec->zone_count == REX_KIT_MAX_ZONES) {
+            snprintf(err, err_len, "More than %d zones", REX_KIT_MAX_ZONES);
+            return -1;
+        }
+        rex_kit_zone_t *z = &spec->zones[spec->zone_count];
+        z->first = 0;
+        z->last = -1;
+        z->note = -1;
+
+        /* Suffixes come off the end only if they read as one, so a name
+         * may itself hold '@' or ':' */
+        const char *at = find_last(a, b, '@');
+        if (at && read_number(at + 1, b, &z->note) == 0) {
+            if (z->note >= REX_KIT_NOTES) {
+                snprintf(err, err_len, "Zone %d: note %d is past 127",
+                         spec->zone_count + 1, z->note);
+                return -1;
+            }
+            b = at;
+        } else {
+            z->note = -1;
+        }
+        const char *colon = find_last(a, b, ':');
+        if (colon && read_range(colon + 1, b, &z->first, &z->last) == 0) {
+            if (z->last >= 0 && z->last < z->first) {
+                snprintf(err, err_len, "Zone %d: slice range %d-%d is backwards",
+                         spec->zone_count + 1, z->first, z->last);
+                return -1;
+            }
+            b = colon;
+        } else {
+            z->first = 0;
+            z->last = -1;
+        }
+
+        while (b > a && isspace((unsigned char)b[-1])) b--;
+        if (a == b || b - a >= (int)sizeof(z->name)) {
+            snprintf(err, err_len, "Zone %d: %s loop name", spec->zone_count + 1,
+                     a == b ? "missing" : "overlong");
+            return -1;
+        }
+        memcpy(z->name, a, b - a);
+        z->name[b - a] = '\0';
+        spec->zone_count++;
+    }
+
+    if (spec->zone_count == 0) {
+        snprintf(err, err_len, "Kit has no zones");
+        return -1;
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* Packing                                                             */
+/* ------------------------------------------------------------------ */
+
+/* frames of src (src_ch channels) into dst (dst_ch >= src_ch): a mono
+ * source plays on both sides of a stereo kit */
+static void copy_frames(int16_t *dst, int dst_ch, const int16_t *src, int src_ch,
+                        uint32_t frames)
+{
+    if (dst_ch == src_ch) {
+        memcpy(dst, src, (size_t)frames * dst_ch * sizeof(int16_t));
+        return;
+    }
+    for (uint32_t i = 0; i < frames; i++) {
+        dst[i * 2] = src[i];
+        dst[i * 2 + 1] = src[i];
+    }
+}
+
+/* Only a 24-bit loop's planes hold more than its pcm_data: copy them
+ * over the kit's, guard frames and all */
+static void copy_planes(rex_slice_t *dst, const rex_slice_t *src, int format, int dst_ch)
+{
+    size_t elem = format == REX_PLANAR_F32 ? sizeof(float) : 3;
+    size_t bytes = (src->sample_length + 2 * REX_PLANAR_GUARD) * elem;
+    for (int c = 0; c < dst_ch; c++) {
+        memcpy((uint8_t *)dst->plane[c] - REX_PLANAR_GUARD * elem,
+               (const uint8_t *)src->plane[c] - REX_PLANAR_GUARD * elem, bytes);
+    }
+}
+
+rex_file_t *rex_kit_build(const rex_kit_spec_t *spec, int flags, char *err, int err_len)
+{
+    const rex_file_t *loops[REX_KIT_MAX_ZONES] = {0};
+    int first[REX_KIT_MAX_ZONES], count[REX_KIT_MAX_ZONES], base[REX_KIT_MAX_ZONES];
+    uint8_t taken[REX_KIT_NOTES] = {0};
+    rex_file_t *kit = NULL;
+    int loop_flags = flags & ~(REX_PARSE_LAZY | REX_PARSE_PROGRESSIVE | REX_PARSE_HEADER);
+    int zones = spec->zone_count;
+
+    if (zones <= 0) {
+        snprintf(err, err_len, "Kit has no zones");
+        return NULL;
+    }
+
+    /* Load every loop and place its zone */
+    int next_note = spec->first_note;
+    int channels = 1, bytes_per_sample = 2, i24 = 0;
+    uint64_t frames = 0;
+    for (int i = 0; i < zones; i++) {
+        const rex_kit_zone_t *z = &spec->zones[i];
+        char msg[256];
+        loops[i] = z->path ? rex_cache_acquire(z->path, loop_flags, msg, sizeof(msg)) : NULL;
+        if (!loops[i]) {
+            snprintf(err, err_len, "%s: %s", z->name, z->path ? msg : "no such loop");
+            goto fail;
+        }
+        const rex_file_t *r = loops[i];
+        int last = z->last < 0 ? r->slice_count - 1 : z->last;
+        if (!r->pcm_data || z->first >= r->slice_count || last >= r->slice_count) {
+            snprintf(err, err_len, "%s: %s", z->name,
+                     r->pcm_data ? "slice range past the loop's last slice" : "no audio");
+            goto fail;
+        }
+
+        first[i] = z->first;
+        count[i] = last - z->first + 1;
+        base[i] = z->note >= 0 ? z->note : next_note;
+        if (base[i] < 0 || base[i] + count[i] > REX_KIT_NOTES) {
+            snprintf(err, err_len, "%s: slices run past note 127", z->name);
+            goto fail;
+        }
+        for (int k = 0; k < count[i]; k++) {
+            if (taken[base[i] + k]) {
+                snprintf(err, err_len, "%s: note %d is already in a zone", z->name, base[i] + k);
+                goto fail;
+            }
+            taken[base[i] + k] = 1;
+            frames += r->slices[first[i] + k].sample_length;
+        }
+        next_note = base[i] + count[i];
+
+        if (r->pcm_channels > channels) channels = r->pcm_channels;
+        if (r->bytes_per_sample > bytes_per_sample) bytes_per_sample = r->bytes_per_sample;
+        if (r->planar == REX_PLANAR_I24) i24 = 1;
+    }
+    if (frames > REX_MAX_FRAMES) {
+        snprintf(err, err_len, "Kit holds more than %d frames", REX_MAX_FRAMES);
+        goto fail;
+    }
+
+    kit = (rex_file_t *)calloc(1, sizeof(rex_file_t));
+    if (kit) {
+        kit->pcm_data = (int16_t *)rex_arena_alloc(NULL, (size_t)(frames ? frames : 1) *
+                                                   channels * sizeof(int16_t));
+    }
+    if (!kit || !kit->pcm_data) {
+        snprintf(err, err_len, "Out of memory");
+        goto fail;
+    }
+
+    const rex_file_t *lead = loops[0];
+    kit->tempo_bpm = lead->tempo_bpm;
+    kit->bars = lead->bars;
+    kit->beats = lead->beats;
+    kit->time_sig_num = lead->time_sig_num;
+    kit->time_sig_den = lead->time_sig_den;
+    kit->sample_rate = lead->sample_rate;
+    kit->channels = channels;
+    kit->bytes_per_sample = bytes_per_sample;
+    kit->slice_count = REX_KIT_NOTES;
+    kit->pcm_samples = (int)frames;
+    kit->pcm_channels = channels;
+    kit->total_sample_length = (uint32_t)frames;
+
+    /* Slices back to back in zone order */
+    uint32_t at = 0;
+    for (int i = 0; i < zones; i++) {
+        const rex_file_t *r = loops[i];
+        for (int k = 0; k < count[i]; k++) {
+            const rex_slice_t *s = &r->slices[first[i] + k];
+            rex_slice_t *d = &kit->slices[base[i] + k];
+            d->sample_offset = at;
+            d->sample_length = s->sample_length;
+            d->stats = s->stats;  /* the same for a mono loop played on both sides */
+            copy_frames(kit->pcm_data + (size_t)at * channels, channels,
+                        r->pcm_data + (size_t)s->sample_offset * r->pcm_channels,
+                        r->pcm_channels, s->sample_length);
+            at += s->sample_length;
+            if (s->sample_length > 0) kit->kit++;
+        }
+    }
+    if (kit->kit == 0) {
+        snprintf(err, err_len, "Kit slices hold no audio");
+        goto fail;
+    }
+
+    int format = (flags & REX_PARSE_PLANAR_F32) ? REX_PLANAR_F32
+               : (flags & REX_PARSE_PLANAR_I16) ? (i24 ? REX_PLANAR_I24 : REX_PLANAR_I16)
+               : REX_PLANAR_NONE;
+    if (format != REX_PLANAR_NONE && rex_build_planar(kit, format) == 0) {
+        for (int i = 0; i < zones; i++) {
+            const rex_file_t *r = loops[i];
+            if (r->planar != format || r->bytes_per_sample != 3) continue;
+            for (int k = 0; k < count[i]; k++)
+                copy_planes(&kit->slices[base[i] + k], &r->slices[first[i] + k],
+                            format, channels);
+        }
+    }
+    atomic_store_explicit(&kit->decoded, kit->pcm_samples, memory_order_release);
+
+    for (int i = 0; i < zones; i++)
+        rex_cache_release(loops[i]);
+    return kit;
+
+fail:
+    for (int i = 0; i < zones; i++)
+        rex_cache_release(loops[i]);
+    rex_kit_free(kit);
+    return NULL;
+}
+
+void rex_kit_free(const rex_file_t *kit)
+{
+    rex_file_destroy((rex_file_t *)kit);
+}
@@ -0,0 +1,65 @@
+/*
+ * Multi-Loop Kits
+ *
+ * A kit maps slice ranges from several loops onto zones of MIDI notes, so
+ * one plugin instance (one voice pool, one render pass) plays them all.
+ * The slices are copied into a single rex_file_t: its PCM is one
+ * contiguous, 16-byte aligned pool, planar buffers (if any) one more, and
+ * slices[] is a flat table indexed by MIDI note giving each note's pool
+ * offset and length (0 for notes outside every zone).
+ *
+ * Zones are written as text, one per ';'-separated entry:
+ *
+ *   name[:first[-last]][@note]
+ *
+ * name is the loop as the folder lists it; first and last are slice
+ * numbers from 0 (all slices if omitted, just first without "-last",
+ * first to the end with "first-"); note is the MIDI note for the first
+ * slice, by default the note after the previous zone's last, or the
+ * first_note given for the first zone. Example: "Amen:0-7@36; Think@48; Funky:4".
+ *
+ * License: MIT
+ */
+
+#ifndef REX_KIT_H
+#define REX_KIT_H
+
+#include "rex_parser.h"
+
+#define REX_KIT_MAX_ZONES 32
+#define REX_KIT_NOTES 128
+
+typedef struct {
+    char name[128];     /* loop as written in the text */
+    const char *path;   /* loop file, filled in by the caller */
+    int first;          /* first slice */
+    int last;           /* last slice, or -1 for the loop's last */
+    int note;           /* MIDI note of the first slice, or -1 to follow on */
+} rex_kit_zone_t;
+
+typedef struct {
+    rex_kit_zone_t zones[REX_KIT_MAX_ZONES];
+    int zone_count;
+    int first_note;     /* where a first zone without a note starts */
+} rex_kit_spec_t;
+
+/* Parse kit text into spec (paths left NULL).
+ * Returns 0, or -1 with a message in err. */
+int rex_kit_parse(rex_kit_spec_t *spec, const char *text, int first_note,
+                  char *err, int err_len);
+
+/* Pack the zones of spec (paths filled in) into a new kit, loading the
+ * loops through the shared cache with REX_PARSE_* flags (lazy and
+ * progressive decoding do not apply: a kit holds all of its audio).
+ * Channels are those of the widest loop, mono loops playing on both
+ * sides; tempo and sample rate are the first zone's loop's. Planar
+ * buffers keep a 24-bit loop's precision as its own would. A zone
+ * running past note 127 or onto a note already taken is an error.
+ * Returns a kit with kit set to the number of notes with audio, or NULL
+ * with a message in err. Free with rex_kit_free(). */
+rex_file_t *rex_kit_build(const rex_kit_spec_t *spec, int flags, char *err, int err_len);
+
+/* Free a kit from rex_kit_build() (NULL is ignored) */
+void rex_kit_free(const rex_file_t *kit);
+
+#endif /* REX_KIT_H */
@@ -0,0 +1,264 @@
+/*
+ * Loop Library Index
+ *
+ * Index file: <dir>/.rexcache/library.idx, plain text. A header line
+ *   REXLIB <version> <dir mtime> <time written>
+ * then one tab-separated line per loop, the file name last:
+ *   mtime size tempo bars beats slices channels frames scanned name
+ * The index is trusted only if it was written after the folder's last
+ * change (mtimes have one-second resolution).
+ *
+ * License: MIT
+ */
+
+#include "rex_library.h"
+#include "rex_parser.h"
+#include "rex_sidecar.h"
+#include "mapped_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define INDEX_VERSION 1
+#define INDEX_NAME    "library.idx"
+#define REX_MAX_FILE_SIZE (50 * 1024 * 1024)  /* as for loading */
+
+static const char *base_name(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+/* Extension of a playable loop file name, or NULL */
+static const char *rex_extension(const char *file)
+{
+    if (file[0] == '.') return NULL;
+    const char *ext = strrchr(file, '.');
+    if (!ext) return NULL;
+    if (strcasecmp(ext, ".rx2") != 0 &&
+        strcasecmp(ext, ".rex") != 0 &&
+        strcasecmp(ext, ".rcy") != 0) return NULL;
+    return ext;
+}
+
+/* Fill path and display name; -1 if the path does not fit */
+static int set_names(rex_library_entry_t *e, const char *dir, const char *file)
+{
+    const char *ext = rex_extension(file);
+    if (!ext) return -1;
+    int n = snprintf(e->path, sizeof(e->path), "%s/%s", dir, file);
+    if (n < 0 || n >= (int)sizeof(e->path)) return -1;
+
+    /* Strip extension for display name */
+    int name_len = (int)(ext - file);
+    if (name_len >= (int)sizeof(e->name)) name_len = sizeof(e->name) - 1;
+    memcpy(e->name, file, name_len);
+    e->name[name_len] = '\0';
+    return 0;
+}
+
+static int entry_cmp(const void *a, const void *b)
+{
+    return strcasecmp(((const rex_library_entry_t *)a)->name,
+                      ((const rex_library_entry_t *)b)->name);
+}
+
+/* Make room for one more entry in a growing array; -1 when out of memory */
+static int reserve(rex_library_entry_t **list, int count, int *cap)
+{
+    if (count < *cap) return 0;
+    int new_cap = *cap ? *cap * 2 : 64;
+    rex_library_entry_t *grown =
+        (rex_library_entry_t *)realloc(*list, (size_t)new_cap * sizeof(rex_library_entry_t));
+    if (!grown) return -1;
+    *list = grown;
+    *cap = new_cap;
+    return 0;
+}
+
+/* Header-only parse; leaves scanned at 0 if the file is unreadable */
+static void scan_header(rex_library_entry_t *e, rex_file_t *rex)
+{
+    mapped_file_t mf;
+    char err[256];
+    rex_loop_info_t *info = &e->info;
+    info->scanned = 0;
+    if (mapped_file_open(&mf, e->path, REX_MAX_FILE_SIZE, err, sizeof(err)) != 0) return;
+    if (rex_parse_ex(rex, mf.data, mf.len, REX_PARSE_HEADER) == 0) {
+        info->scanned = 1;
+        info->tempo_bpm = rex->tempo_bpm;
+        info->bars = rex->bars;
+        info->beats = rex->beats;
+        info->slice_count = rex->slice_count;
+        info->channels = rex->channels;
+        info->frames = rex->total_sample_length;
+    }
+    mapped_file_close(&mf);
+}
+
+static void index_path(const char *dir, char *out, int out_len)
+{
+    snprintf(out, out_len, "%s/" REX_SIDECAR_DIR "/" INDEX_NAME, dir);
+}
+
+/* Read dir's index into a new array *idx. Returns the entry count, or -1
+ * if there is no usable index. */
+static int load_index(const char *dir, rex_library_entry_t **idx,
+                      int64_t *dir_mtime, int64_t *written)
+{
+    char path[1024], line[1024];
+    index_path(dir, path, sizeof(path));
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+
+    int version = 0;
+    long long dm = 0, wt = 0;
+    if (!fgets(line, sizeof(line), fp) ||
+        sscanf(line, "REXLIB %d %lld %lld", &version, &dm, &wt) != 3 ||
+        version != INDEX_VERSION) {
+        fclose(fp);
+        return -1;
+    }
+    *dir_mtime = dm;
+    *written = wt;
+
+    int count = 0, cap = 0;
+    *idx = NULL;
+    while (fgets(line, sizeof(line), fp)) {
+        if (reserve(idx, count, &cap) != 0) break;
+        rex_library_entry_t *e = &(*idx)[count];
+        rex_loop_info_t *info = &e->info;
+        long long mtime, size;
+        int consumed = 0;
+        memset(e, 0, sizeof(*e));
+        if (sscanf(line, "%lld\t%lld\t%f\t%d\t%d\t%d\t%d\t%u\t%d\t%n",
+                   &mtime, &size, &info->tempo_bpm, &info->bars, &info->beats,
+                   &info->slice_count, &info->channels, &info->frames, &info->scanned,
+                   &consumed) != 9 || consumed == 0)
+            continue;
+        char *file = line + consumed;
+        file[strcspn(file, "\n")] = '\0';
+        e->mtime = mtime;
+        e->size = size;
+        if (set_names(e, dir, file) == 0) count++;
+    }
+    fclose(fp);
+    return count;
+}
+
+static void save_index(const char *dir, const rex_library_entry_t *entries, int count,
+                       int64_t dir_mtime)
+{
+    char path[1024], tmp[1100];
+    index_path(dir, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path);
+
+    int fd = mkstemp(tmp);
+    if (fd < 0) return;  /* read-only folder: scan again next time */
+    fchmod(fd, 0644);
+    FILE *fp = fdopen(fd, "w");
+    if (!fp) {
+        close(fd);
+        unlink(tmp);
+        return;
+    }
+
+    fprintf(fp, "REXLIB %d %lld %lld\n", INDEX_VERSION,
+            (long long)dir_mtime, (long long)time(NULL));
+    for (int i = 0; i < count; i++) {
+        const rex_library_entry_t *e = &entries[i];
+        const rex_loop_info_t *info = &e->info;
+        const char *file = base_name(e->path);
+        if (strchr(file, '\n')) continue;  /* not representable: rescanned */
+        fprintf(fp, "%lld\t%lld\t%.3f\t%d\t%d\t%d\t%d\t%u\t%d\t%s\n",
+                (long long)e->mtime, (long long)e->size, info->tempo_bpm,
+                info->bars, info->beats, info->slice_count, info->channels,
+                info->frames, info->scanned, file);
+    }
+
+    if (fclose(fp) != 0 || rename(tmp, path) != 0) unlink(tmp);
+}
+
+int rex_library_scan(const char *dir, rex_library_entry_t **out, int64_t *dir_mtime)
+{
+    *out = NULL;
+
+    /* Create the index directory first, so doing so does not count as
+     * a change to the folder below */
+    char cache_dir[600];
+    snprintf(cache_dir, sizeof(cache_dir), "%s/" REX_SIDECAR_DIR, dir);
+    mkdir(cache_dir, 0755);
+
+    struct stat dst;
+    if (stat(dir, &dst) != 0) return 0;
+    if (dir_mtime) *dir_mtime = (int64_t)dst.st_mtime;
+
+    rex_library_entry_t *idx = NULL;
+    int64_t idx_dir_mtime = 0, idx_written = 0;
+    int idx_count = load_index(dir, &idx, &idx_dir_mtime, &idx_written);
+
+    /* Folder unchanged since the index was written: no directory walk */
+    if (idx_count >= 0 && idx_dir_mtime == (int64_t)dst.st_mtime &&
+        idx_written > idx_dir_mtime) {
+        if (idx_count == 0) {
+            free(idx);
+            idx = NULL;
+        }
+        *out = idx;
+        return idx_count;
+    }
+
+    DIR *d = opendir(dir);
+    if (!d) {
+        free(idx);
+        return 0;
+    }
+
+    rex_file_t *rex = (rex_file_t *)malloc(sizeof(rex_file_t));
+    rex_library_entry_t *list = NULL;
+    int count = 0, cap = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (!rex_extension(entry->d_name)) continue;
+        if (reserve(&list, count, &cap) != 0) break;
+        rex_library_entry_t *e = &list[count];
+        struct stat st;
+        memset(e, 0, sizeof(*e));
+        if (set_names(e, dir, entry->d_name) != 0) continue;
+        if (stat(e->path, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        e->mtime = (int64_t)st.st_mtime;
+        e->size = (int64_t)st.st_size;
+
+        /* Reuse the indexed metadata if the file is unchanged */
+        int found = 0;
+        for (int i = 0; i < idx_count; i++) {
+            if (idx[i].mtime == e->mtime && idx[i].size == e->size &&
+                strcmp(idx[i].path, e->path) == 0) {
+                *e = idx[i];
+                found = 1;
+                break;
+            }
+        }
+        if (!found && rex) scan_header(e, rex);
+        count++;
+    }
+    closedir(d);
+    free(rex);
+    free(idx);
+
+    if (count > 1) {
+        qsort(list, count, sizeof(rex_library_entry_t), entry_cmp);
+    }
+    save_index(dir, list, count, (int64_t)dst.st_mtime);
+    if (count == 0) {
+        free(list);
+        list = NULL;
+    }
+    *out = list;
+    return count;
+}
@@ -0,0 +1,51 @@
+/*
+ * Loop Library Index
+ *
+ * Lists the REX files in a folder together with their header metadata
+ * (tempo, bars, slices, channels, length), read with a header-only parse
+ * so no audio is decoded. Results are persisted to an index in the
+ * folder's .rexcache directory: while the folder's mtime is unchanged the
+ * index is used as is, without reading the directory, and when it changes
+ * only files that are new or have a new size or mtime are scanned again.
+ *
+ * An in-place rewrite of an existing file does not touch the folder mtime,
+ * so its metadata can lag until the next change to the folder; loading is
+ * unaffected, as the loop cache checks each file itself.
+ *
+ * Not for the render thread.
+ *
+ * License: MIT
+ */
+
+#ifndef REX_LIBRARY_H
+#define REX_LIBRARY_H
+
+#include <stdint.h>
+
+/* Header metadata, valid when scanned is set */
+typedef struct {
+    int scanned;             /* 0 = header could not be parsed */
+    float tempo_bpm;
+    int bars;
+    int beats;
+    int slice_count;
+    int channels;
+    uint32_t frames;         /* total length in per-channel frames */
+} rex_loop_info_t;
+
+typedef struct {
+    char path[512];
+    char name[128];          /* file name without extension, for display */
+    int64_t mtime;
+    int64_t size;
+    rex_loop_info_t info;
+} rex_library_entry_t;
+
+/* List the loops in dir, sorted by name, using and refreshing dir's
+ * index. Returns the number of entries and sets *out to a malloc'd array
+ * (release with free()); returns 0 with *out NULL if dir is empty or
+ * cannot be read. dir_mtime, if not NULL, receives the folder mtime the
+ * listing corresponds to. */
+int rex_library_scan(const char *dir, rex_library_entry_t **out, int64_t *dir_mtime);
+
+#endif /* REX_LIBRARY_H */
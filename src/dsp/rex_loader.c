@@ -0,0 +1,533 @@
+/*
+ * Background REX Loader
+ *
+ * One worker thread per loader. Handoff between threads:
+ *
+ *   request  - render thread stores the wanted path in an atomic slot and
+ *              posts the semaphore; the worker picks up only the newest.
+ *   ready    - worker publishes a cached rex_file_t with an atomic
+ *              exchange; the render thread claims it in rex_loader_swap().
+ *              A progressive load is published after its first decode
+ *              step; the worker decodes the rest one step at a time,
+ *              the newest load first, taking requests and draining the
+ *              rings between steps. Requesting the loader's kit path builds
+ *              the kit set by rex_loader_set_kit() instead.
+ *   retired  - render thread pushes the loop it just replaced into a
+ *              single-producer/single-consumer ring; the worker drops
+ *              its cache reference (or frees the kit).
+ *
+ *   slices   - lazily parsed loops (REX_PARSE_LAZY) decode single slices on
+ *              request: render thread -> worker request ring, worker ->
+ *              render delivery ring, and a ring of buffers to free.
+ *
+ * Nothing on the render side blocks, allocates or frees.
+ *
+ * A second, idle-priority thread walks the prefetch list set by the control
+ * thread and decodes those files into the shared cache, so landing on a
+ * neighbouring loop while browsing is a cache hit.
+ *
+ * License: MIT
+ */
+
+#include "rex_loader.h"
+#include "rex_cache.h"
+#include "rex_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+
+#define RETIRE_SLOTS 8                        /* power of two */
+#define SLICE_SLOTS 256                       /* power of two, >= REX_MAX_SLICES */
+#define FINISH_SLOTS 8                        /* progressive loads still decoding */
+
+typedef struct {
+    const rex_file_t *rex;
+    unsigned gen;
+    int slice;
+    int16_t *pcm;
+} slice_job_t;
+
+/* Single-producer/single-consumer ring of slice jobs */
+typedef struct {
+    slice_job_t jobs[SLICE_SLOTS];
+    atomic_uint head;
+    atomic_uint tail;
+} slice_ring_t;
+
+struct rex_loader {
+    pthread_t thread;
+    sem_t wake;
+    atomic_int quit;
+
+    _Atomic(const char *) pending;   /* newest requested path, or NULL */
+    char kit_path[8];                /* requested to build kit */
+    pthread_mutex_t kit_lock;        /* guards kit */
+    rex_kit_spec_t kit;
+    _Atomic(const rex_file_t *) ready;  /* loaded, not yet claimed */
+    atomic_int flags;                /* REX_PARSE_* flags for new loads */
+
+    /* Retire ring: render thread writes head, worker writes tail */
+    const rex_file_t *retired[RETIRE_SLOTS];
+    atomic_uint retire_head;
+    atomic_uint retire_tail;
+
+    slice_ring_t slice_req;          /* render -> worker */
+    slice_ring_t slice_done;         /* worker -> render */
+    slice_ring_t slice_free;         /* render -> worker, buffers to free */
+
+    /* Progressive loads the worker is finishing, oldest first, and when
+     * the newest was picked up (worker only) */
+    const rex_file_t *finishing[FINISH_SLOTS];
+    int finishing_count;
+    const rex_file_t *last_loaded;
+    uint64_t last_t0;
+
+    pthread_mutex_t error_lock;      /* guards error and stats */
+    char error[256];
+    rex_loader_stats_t stats;
+
+    /* Prefetch list (control thread writes, prefetch thread reads) */
+    pthread_t prefetch_thread;
+    pthread_mutex_t prefetch_lock;
+    pthread_cond_t prefetch_cond;
+    const char *prefetch[REX_LOADER_PREFETCH_MAX];
+    int prefetch_count;
+    unsigned prefetch_gen;
+
+    void (*log)(const char *msg);
+};
+
+/* ------------------------------------------------------------------ */
+/* Worker thread                                                       */
+/* ------------------------------------------------------------------ */
+
+static void set_error(rex_loader_t *ld, const char *msg)
+{
+    pthread_mutex_lock(&ld->error_lock);
+    snprintf(ld->error, sizeof(ld->error), "%s", msg);
+    pthread_mutex_unlock(&ld->error_lock);
+}
+
+static int ring_push(slice_ring_t *r, const slice_job_t *job)
+{
+    unsigned head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (head - tail >= SLICE_SLOTS) return -1;
+    r->jobs[head & (SLICE_SLOTS - 1)] = *job;
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    return 0;
+}
+
+static int ring_pop(slice_ring_t *r, slice_job_t *job)
+{
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&r->head, memory_order_acquire);
+    if (tail == head) return 0;
+    *job = r->jobs[tail & (SLICE_SLOTS - 1)];
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+/* Release retired loops up to head, a snapshot of retire_head */
+static void drain_retired(rex_loader_t *ld, unsigned head)
+{
+    unsigned tail = atomic_load_explicit(&ld->retire_tail, memory_order_relaxed);
+    while (tail != head) {
+        rex_loader_release(ld->retired[tail & (RETIRE_SLOTS - 1)]);
+        tail++;
+        atomic_store_explicit(&ld->retire_tail, tail, memory_order_release);
+    }
+}
+
+static void free_slices(rex_loader_t *ld)
+{
+    slice_job_t job;
+    while (ring_pop(&ld->slice_free, &job))
+        free(job.pcm);
+}
+
+/* Decode requested slices. A request's loop is still held by the render
+ * thread, or sits in the retire ring behind the snapshot taken before this
+ * call, so it cannot be released underneath us. */
+static void decode_slices(rex_loader_t *ld)
+{
+    slice_job_t job;
+    while (!atomic_load(&ld->quit) && ring_pop(&ld->slice_req, &job)) {
+        free_slices(ld);
+        const rex_slice_t *sl = &job.rex->slices[job.slice];
+        size_t n = (size_t)sl->sample_length * job.rex->pcm_channels;
+        uint64_t t0 = rex_clock_ns();
+        job.pcm = (int16_t *)malloc((n ? n : 1) * sizeof(int16_t));
+        if (job.pcm && rex_decode_slice(job.rex, job.slice, job.pcm) < 0) {
+            free(job.pcm);
+            job.pcm = NULL;
+        }
+        if (job.pcm) {
+            uint64_t ns = rex_clock_ns() - t0;
+            pthread_mutex_lock(&ld->error_lock);
+            ld->stats.slices++;
+            ld->stats.slice_ns += ns;
+            ld->stats.slice_bytes += n * sizeof(int16_t);
+            pthread_mutex_unlock(&ld->error_lock);
+        }
+
+        /* Delivered even on failure (pcm NULL) so the slot can retry;
+         * wait for the render thread to make room */
+        while (ring_push(&ld->slice_done, &job) != 0) {
+            if (atomic_load(&ld->quit)) {
+                free(job.pcm);
+                return;
+            }
+            free_slices(ld);
+            sched_yield();
+        }
+    }
+}
+
+/* Worker: one decode step of the newest unfinished load */
+static void finish_step(rex_loader_t *ld)
+{
+    const rex_file_t *rex = ld->finishing[ld->finishing_count - 1];
+    if (rex_cache_finish_step(rex)) return;
+
+    ld->finishing_count--;
+    if (rex == ld->last_loaded) {
+        uint64_t ns = rex_clock_ns() - ld->last_t0;
+        pthread_mutex_lock(&ld->error_lock);
+        ld->stats.last_decoded_ns = ns;
+        pthread_mutex_unlock(&ld->error_lock);
+        ld->last_loaded = NULL;
+    }
+}
+
+/* Publish path. now finishes a progressive load before returning, else
+ * the worker queues it for finish_step(). */
+static int load_pending(rex_loader_t *ld, const char *path, int now)
+{
+    char err[256];
+    int flags = atomic_load(&ld->flags);
+    uint64_t t0 = rex_clock_ns();
+    const rex_file_t *rex;
+    if (path == ld->kit_path) {
+        rex_kit_spec_t spec;
+        pthread_mutex_lock(&ld->kit_lock);
+        spec = ld->kit;
+        pthread_mutex_unlock(&ld->kit_lock);
+        rex = rex_kit_build(&spec, flags, err, sizeof(err));
+    } else {
+        rex = rex_cache_acquire(path, flags, err, sizeof(err));
+    }
+    if (!rex) {
+        set_error(ld, err);
+        if (ld->log) ld->log(err);
+        return -1;
+    }
+    set_error(ld, "");
+
+    if (ld->log) {
+        const char *fname = strrchr(path, '/');
+        char msg[256];
+        if (rex->kit) {
+            snprintf(msg, sizeof(msg), "Loaded kit (%d notes, %d samples)",
+                     rex->kit, rex->pcm_samples);
+        } else {
+            snprintf(msg, sizeof(msg), "Loaded: %s (%d slices, %d samples, %.1f BPM)",
+                     fname ? fname + 1 : path, rex->slice_count, rex->pcm_samples,
+                     rex->tempo_bpm);
+        }
+        ld->log(msg);
+    }
+
+    /* Superseded before the render thread claimed it: never seen there.
+     * Once published, rex may be retired and a kit freed. */
+    int kit = rex->kit;
+    const rex_file_t *stale = atomic_exchange_explicit(&ld->ready, rex, memory_order_acq_rel);
+    rex_loader_release(stale);
+    uint64_t ns = rex_clock_ns() - t0;
+
+    pthread_mutex_lock(&ld->error_lock);
+    ld->stats.loads++;
+    ld->stats.last_load_ns = ns;
+    pthread_mutex_unlock(&ld->error_lock);
+
+    /* Published first, so the render thread can play slices as they
+     * complete; the cache keeps the loop while it decodes */
+    if (now || kit) {
+        while (rex_cache_finish_step(rex)) {}
+        uint64_t decoded_ns = rex_clock_ns() - t0;
+        pthread_mutex_lock(&ld->error_lock);
+        ld->stats.last_decoded_ns = decoded_ns;
+        pthread_mutex_unlock(&ld->error_lock);
+        return 0;
+    }
+    if (ld->finishing_count == FINISH_SLOTS) {
+        /* Browsed past too many at once: the oldest is finished here */
+        while (rex_cache_finish_step(ld->finishing[0])) {}
+        memmove(ld->finishing, ld->finishing + 1,
+                (FINISH_SLOTS - 1) * sizeof(ld->finishing[0]));
+        ld->finishing_count--;
+    }
+    ld->finishing[ld->finishing_count++] = rex;
+    ld->last_loaded = rex;
+    ld->last_t0 = t0;
+    return 0;
+}
+
+/* Decode the prefetch list, restarting whenever the list is replaced */
+static void *prefetch_main(void *arg)
+{
+    rex_loader_t *ld = (rex_loader_t *)arg;
+
+#ifdef SCHED_IDLE
+    /* Only run when the cores are otherwise idle */
+    struct sched_param sp = {0};
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &sp);
+#endif
+
+    unsigned done_gen = 0;
+    pthread_mutex_lock(&ld->prefetch_lock);
+    while (!atomic_load(&ld->quit)) {
+        if (ld->prefetch_gen == done_gen) {
+            pthread_cond_wait(&ld->prefetch_cond, &ld->prefetch_lock);
+            continue;
+        }
+
+        unsigned gen = ld->prefetch_gen;
+        for (int i = 0; i < ld->prefetch_count; i++) {
+            const char *path = ld->prefetch[i];
+            pthread_mutex_unlock(&ld->prefetch_lock);
+
+            /* Let a pending foreground load go first */
+            while (atomic_load(&ld->pending) && !atomic_load(&ld->quit))
+                sched_yield();
+            if (!atomic_load(&ld->quit))
+                rex_cache_prefetch(path, atomic_load(&ld->flags));
+
+            pthread_mutex_lock(&ld->prefetch_lock);
+            if (ld->prefetch_gen != gen || atomic_load(&ld->quit)) break;
+        }
+        if (ld->prefetch_gen == gen) done_gen = gen;
+    }
+    pthread_mutex_unlock(&ld->prefetch_lock);
+
+    return NULL;
+}
+
+static void *loader_main(void *arg)
+{
+    rex_loader_t *ld = (rex_loader_t *)arg;
+
+    while (!atomic_load(&ld->quit)) {
+        /* Between finishing steps, take what was posted without waiting */
+        if (ld->finishing_count == 0) sem_wait(&ld->wake);
+        else while (sem_trywait(&ld->wake) == 0) {}
+        unsigned retire_head = atomic_load_explicit(&ld->retire_head, memory_order_acquire);
+        decode_slices(ld);
+        free_slices(ld);
+        drain_retired(ld, retire_head);
+
+        const char *path = atomic_exchange(&ld->pending, NULL);
+        if (path && !atomic_load(&ld->quit)) {
+            load_pending(ld, path, 0);
+        } else if (ld->finishing_count > 0) {
+            finish_step(ld);
+        }
+    }
+
+    /* Nobody else may step these: left unfinished, they would stay cached */
+    while (ld->finishing_count > 0)
+        while (rex_cache_finish_step(ld->finishing[--ld->finishing_count])) {}
+    return NULL;
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+rex_loader_t *rex_loader_create(void (*log)(const char *msg))
+{
+    rex_loader_t *ld = (rex_loader_t *)calloc(1, sizeof(rex_loader_t));
+    if (!ld) return NULL;
+
+    ld->log = log;
+    atomic_init(&ld->quit, 0);
+    atomic_init(&ld->pending, NULL);
+    snprintf(ld->kit_path, sizeof(ld->kit_path), "kit");
+    atomic_init(&ld->ready, NULL);
+    atomic_init(&ld->flags, 0);
+    atomic_init(&ld->retire_head, 0);
+    atomic_init(&ld->retire_tail, 0);
+    pthread_mutex_init(&ld->error_lock, NULL);
+    pthread_mutex_init(&ld->kit_lock, NULL);
+    pthread_mutex_init(&ld->prefetch_lock, NULL);
+    pthread_cond_init(&ld->prefetch_cond, NULL);
+
+    if (sem_init(&ld->wake, 0, 0) != 0) {
+        goto fail_sem;
+    }
+    if (pthread_create(&ld->thread, NULL, loader_main, ld) != 0) {
+        goto fail_thread;
+    }
+    if (pthread_create(&ld->prefetch_thread, NULL, prefetch_main, ld) != 0) {
+        atomic_store(&ld->quit, 1);
+        sem_post(&ld->wake);
+        pthread_join(ld->thread, NULL);
+        goto fail_thread;
+    }
+
+    return ld;
+
+fail_thread:
+    sem_destroy(&ld->wake);
+fail_sem:
+    pthread_cond_destroy(&ld->prefetch_cond);
+    pthread_mutex_destroy(&ld->prefetch_lock);
+    pthread_mutex_destroy(&ld->kit_lock);
+    pthread_mutex_destroy(&ld->error_lock);
+    free(ld);
+    return NULL;
+}
+
+void rex_loader_destroy(rex_loader_t *ld)
+{
+    if (!ld) return;
+
+    atomic_store(&ld->quit, 1);
+    sem_post(&ld->wake);
+    pthread_mutex_lock(&ld->prefetch_lock);
+    pthread_cond_signal(&ld->prefetch_cond);
+    pthread_mutex_unlock(&ld->prefetch_lock);
+    pthread_join(ld->thread, NULL);
+    pthread_join(ld->prefetch_thread, NULL);
+
+    slice_job_t job;
+    while (ring_pop(&ld->slice_done, &job))
+        free(job.pcm);
+    free_slices(ld);
+    drain_retired(ld, atomic_load(&ld->retire_head));
+    rex_loader_release(atomic_load(&ld->ready));
+
+    sem_destroy(&ld->wake);
+    pthread_cond_destroy(&ld->prefetch_cond);
+    pthread_mutex_destroy(&ld->prefetch_lock);
+    pthread_mutex_destroy(&ld->kit_lock);
+    pthread_mutex_destroy(&ld->error_lock);
+    free(ld);
+}
+
+int rex_loader_load_now(rex_loader_t *ld, const char *path)
+{
+    return load_pending(ld, path, 1);
+}
+
+void rex_loader_request(rex_loader_t *ld, const char *path)
+{
+    atomic_store_explicit(&ld->pending, path, memory_order_release);
+    sem_post(&ld->wake);
+}
+
+const char *rex_loader_set_kit(rex_loader_t *ld, const rex_kit_spec_t *spec)
+{
+    pthread_mutex_lock(&ld->kit_lock);
+    ld->kit = *spec;
+    pthread_mutex_unlock(&ld->kit_lock);
+    return ld->kit_path;
+}
+
+void rex_loader_set_flags(rex_loader_t *ld, int flags)
+{
+    atomic_store(&ld->flags, flags);
+}
+
+int rex_loader_request_slice(rex_loader_t *ld, const rex_file_t *rex,
+                             unsigned gen, int slice_index)
+{
+    slice_job_t job = { rex, gen, slice_index, NULL };
+    if (ring_push(&ld->slice_req, &job) != 0) return -1;
+    sem_post(&ld->wake);
+    return 0;
+}
+
+int rex_loader_take_slice(rex_loader_t *ld, unsigned *gen, int *slice_index,
+                          int16_t **pcm)
+{
+    slice_job_t job;
+    if (!ring_pop(&ld->slice_done, &job)) return 0;
+    *gen = job.gen;
+    *slice_index = job.slice;
+    *pcm = job.pcm;
+    return 1;
+}
+
+int rex_loader_free_slice(rex_loader_t *ld, int16_t *pcm)
+{
+    if (!pcm) return 0;
+    slice_job_t job = { NULL, 0, 0, pcm };
+    if (ring_push(&ld->slice_free, &job) != 0) return -1;
+    sem_post(&ld->wake);
+    return 0;
+}
+
+void rex_loader_prefetch(rex_loader_t *ld, const char *const *paths, int count)
+{
+    if (count > REX_LOADER_PREFETCH_MAX) count = REX_LOADER_PREFETCH_MAX;
+    if (count < 0) count = 0;
+
+    pthread_mutex_lock(&ld->prefetch_lock);
+    for (int i = 0; i < count; i++)
+        ld->prefetch[i] = paths[i];
+    ld->prefetch_count = count;
+    ld->prefetch_gen++;
+    pthread_cond_signal(&ld->prefetch_cond);
+    pthread_mutex_unlock(&ld->prefetch_lock);
+}
+
+const rex_file_t *rex_loader_swap(rex_loader_t *ld, const rex_file_t *current)
+{
+    if (!atomic_load_explicit(&ld->ready, memory_order_relaxed))
+        return NULL;
+
+    /* Claim only if the outgoing loop has somewhere to go */
+    unsigned head = atomic_load_explicit(&ld->retire_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&ld->retire_tail, memory_order_acquire);
+    if (current && head - tail >= RETIRE_SLOTS)
+        return NULL;
+
+    const rex_file_t *next = atomic_exchange_explicit(&ld->ready, NULL, memory_order_acq_rel);
+    if (!next)
+        return NULL;
+
+    if (current) {
+        ld->retired[head & (RETIRE_SLOTS - 1)] = current;
+        atomic_store_explicit(&ld->retire_head, head + 1, memory_order_release);
+        sem_post(&ld->wake);
+    }
+
+    return next;
+}
+
+void rex_loader_release(const rex_file_t *rex)
+{
+    if (rex && rex->kit) rex_kit_free(rex);
+    else rex_cache_release(rex);
+}
+
+void rex_loader_stats(rex_loader_t *ld, rex_loader_stats_t *out)
+{
+    pthread_mutex_lock(&ld->error_lock);
+    *out = ld->stats;
+    pthread_mutex_unlock(&ld->error_lock);
+}
+
+int rex_loader_error(rex_loader_t *ld, char *buf, int buf_len)
+{
+    if (buf_len <= 0) return 0;
+    pthread_mutex_lock(&ld->error_lock);
+    snprintf(buf, buf_len, "%s", ld->error);
+    pthread_mutex_unlock(&ld->error_lock);
+    return (int)strlen(buf);
+}
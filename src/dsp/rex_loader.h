@@ -0,0 +1,104 @@
+/*
+ * Background REX Loader
+ *
+ * Reads and parses REX files on a worker thread so the audio thread never
+ * does file I/O, allocation or DWOP decoding. A loaded loop is handed to
+ * the render thread through a lock-free pointer swap; the loop it replaces
+ * is passed back to the worker, which releases it to the shared cache
+ * (rex_cache.h). With REX_PARSE_PROGRESSIVE the loop is handed over after
+ * its first decode step and finished on the worker a step at a time, so
+ * a newer request is not held up; slices become playable as
+ * rex_decoded_frames() passes their end.
+ *
+ * License: MIT
+ */
+
+#ifndef REX_LOADER_H
+#define REX_LOADER_H
+
+#include "rex_parser.h"
+#include "rex_kit.h"
+
+#define REX_LOADER_PREFETCH_MAX 8
+
+typedef struct rex_loader rex_loader_t;
+
+/* Start a loader worker thread. log may be NULL.
+ * Returns NULL if the thread cannot be started. */
+rex_loader_t *rex_loader_create(void (*log)(const char *msg));
+
+/* Stop the worker and free any loops it still owns */
+void rex_loader_destroy(rex_loader_t *ld);
+
+/* Load path on the calling thread (not the render thread) and publish it
+ * exactly like a worker load, for use before the worker has any requests.
+ * The loop is fully decoded on return.
+ * Returns 0 on success, -1 on error (see rex_loader_error). */
+int rex_loader_load_now(rex_loader_t *ld, const char *path);
+
+/* Ask the worker to load path. The latest request wins; path must stay
+ * valid until the load completes. Lock-free, safe on the render thread. */
+void rex_loader_request(rex_loader_t *ld, const char *path);
+
+/* Control thread: make a copy of spec the kit to build when the returned
+ * path is requested with rex_loader_request(). Its zone paths must stay
+ * valid until it is replaced. The kit is built from the spec as it
+ * stands when the worker picks up the request, with the loader's flags. */
+const char *rex_loader_set_kit(rex_loader_t *ld, const rex_kit_spec_t *spec);
+
+/* REX_PARSE_* flags for subsequent loads and prefetches. A changed flag
+ * only affects files requested after the call. */
+void rex_loader_set_flags(rex_loader_t *ld, int flags);
+
+/* Render thread, lazily parsed loops only: ask the worker to decode one
+ * slice of rex (a loop the caller holds) into a new buffer. gen is passed
+ * back untouched so the caller can discard deliveries for an older loop.
+ * Returns -1 if the request queue is full. */
+int rex_loader_request_slice(rex_loader_t *ld, const rex_file_t *rex,
+                             unsigned gen, int slice_index);
+
+/* Render thread: collect one decoded slice (pcm is NULL if decoding
+ * failed). The caller owns pcm until it hands it to rex_loader_free_slice().
+ * Returns 1 if a slice was collected, 0 if none is waiting. */
+int rex_loader_take_slice(rex_loader_t *ld, unsigned *gen, int *slice_index,
+                          int16_t **pcm);
+
+/* Render thread: queue a slice buffer to be freed on the worker.
+ * Returns -1 if the queue is full (keep it and try again later). */
+int rex_loader_free_slice(rex_loader_t *ld, int16_t *pcm);
+
+/* Replace the list of files to decode into the cache at idle priority,
+ * in order, ahead of being asked for (at most REX_LOADER_PREFETCH_MAX).
+ * Paths must stay valid until replaced. Control thread only. */
+void rex_loader_prefetch(rex_loader_t *ld, const char *const *paths, int count);
+
+/* Render thread: if a newly loaded file is ready, return it and queue
+ * current (may be NULL) for release on the worker thread. Returns NULL when
+ * nothing new is ready, in which case current stays with the caller.
+ * The returned file is a shared cache reference, or a kit owned by the
+ * loader: read it, never modify it. */
+const rex_file_t *rex_loader_swap(rex_loader_t *ld, const rex_file_t *current);
+
+/* Drop a file from rex_loader_swap() that the caller no longer passes
+ * back to the loader: a kit is freed, a cached loop's reference
+ * released. Not for use on the render thread. */
+void rex_loader_release(const rex_file_t *rex);
+
+/* Worker counters, for performance monitoring */
+typedef struct {
+    unsigned loads;            /* files published (cache hits included) */
+    uint64_t last_load_ns;     /* worker pick-up to publish, last load */
+    uint64_t last_decoded_ns;  /* worker pick-up to fully decoded, last load */
+    unsigned slices;           /* lazy slices decoded */
+    uint64_t slice_ns;         /* all slice decodes */
+    uint64_t slice_bytes;      /* PCM bytes they produced */
+} rex_loader_stats_t;
+
+/* Copy the counters into out. Not for use on the render thread. */
+void rex_loader_stats(rex_loader_t *ld, rex_loader_stats_t *out);
+
+/* Copy the most recent load error into buf (empty after a successful load).
+ * Returns the string length. Not for use on the render thread. */
+int rex_loader_error(rex_loader_t *ld, char *buf, int buf_len);
+
+#endif /* REX_LOADER_H */
@@ -23,6 +23,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <pthread.h>
 
 /* Big-endian readers */
 static uint32_t read_u32_be(const uint8_t *p)
@@ -123,33 +124,47 @@ static void parse_slce(rex_file_t *rex, const uint8_t *data, uint32_t len)
     rex->slice_count++;
 }
 
+/* Frames (per-channel sample count) to decode from an SDAT chunk of len
+ * bytes. The stream has no end marker: a decoder runs on through the
+ * padding until told to stop, so SINF's length is what makes the buffer
+ * exact. Without one, the end of the last slice (SLCE chunks come first)
+ * is the last frame anyone plays; a bound on the chunk size is the last
+ * resort, and can cut short audio that compressed well. */
+static int sdat_frames(const rex_file_t *rex, uint32_t len)
+{
+    int64_t frames = rex->total_sample_length;
+    if (frames == 0) {
+        for (int i = 0; i < rex->slice_count; i++) {
+            int64_t end = (int64_t)rex->slices[i].sample_offset + rex->slices[i].sample_length;
+            if (end > frames) frames = end;
+        }
+    }
+    if (frames == 0) {
+        frames = (int64_t)len * 2 + 1024;
+    }
+    /* Hard cap */
+    if (frames > REX_MAX_FRAMES) {
+        frames = REX_MAX_FRAMES;
+    }
+    return (int)frames;
+}
+
 /* Decode SDAT chunk: DWOP compressed audio.
  * Uses a 5-predictor adaptive lossless codec with energy-based selection.
  * Stereo files use L/delta encoding (R = L + delta). */
-static int decode_sdat(rex_file_t *rex, const uint8_t *data, uint32_t len)
+static int decode_sdat(rex_file_t *rex, const uint8_t *data, uint32_t len, int32_t **wide)
 {
     if (len < 1) {
         snprintf(rex->error, sizeof(rex->error), "SDAT chunk empty");
         return -1;
     }
 
-    /* Max frames (per-channel sample count) */
-    int max_frames;
-    if (rex->total_sample_length > 0) {
-        max_frames = (int)rex->total_sample_length;
-    } else {
-        max_frames = (int)(len * 2) + 1024;
-    }
-    /* Hard cap: no REX file should have more than 10M frames (~3.8 min @ 44.1kHz) */
-    if (max_frames > 10000000) {
-        max_frames = 10000000;
-    }
-
+    int max_frames = sdat_frames(rex, len);
     int is_stereo = (rex->channels == 2);
 
     /* Allocate output: stereo needs 2x for interleaved L/R */
     size_t alloc_samples = (size_t)max_frames * (is_stereo ? 2 : 1);
-    rex->pcm_data = (int16_t *)malloc(alloc_samples * sizeof(int16_t));
+    rex->pcm_data = (int16_t *)rex_arena_alloc(rex->arena, alloc_samples * sizeof(int16_t));
     if (!rex->pcm_data) {
         snprintf(rex->error, sizeof(rex->error), "Failed to allocate %zu samples", alloc_samples);
         return -1;
@@ -158,7 +173,23 @@ static int decode_sdat(rex_file_t *rex, const uint8_t *data, uint32_t len)
     /* 24-bit files (bytes_per_sample==3) need extra shift to convert to 16-bit */
     int out_shift = (rex->bytes_per_sample == 3) ? 9 : 1;
 
-    if (is_stereo) {
+    if (wide) {
+        /* Full precision for the planar buffers; pcm_data is the same
+         * samples cut to 16 bits, as the shifted decode gives them */
+        *wide = (int32_t *)rex_arena_alloc(rex->arena, alloc_samples * sizeof(int32_t));
+        if (!*wide) {
+            snprintf(rex->error, sizeof(rex->error), "Failed to allocate %zu samples", alloc_samples);
+            rex_arena_release(rex->arena, rex->pcm_data);
+            rex->pcm_data = NULL;
+            return -1;
+        }
+        rex->pcm_channels = is_stereo ? 2 : 1;
+        rex->pcm_samples = dwop_decode_wide(data, (int)len, rex->pcm_channels,
+                                            *wide, max_frames);
+        size_t n = (size_t)(rex->pcm_samples > 0 ? rex->pcm_samples : 0) * rex->pcm_channels;
+        for (size_t i = 0; i < n; i++)
+            rex->pcm_data[i] = (int16_t)((*wide)[i] >> (out_shift - 1));
+    } else if (is_stereo) {
         rex->pcm_samples = dwop_decode_stereo(data, (int)len,
                                                rex->pcm_data, max_frames,
                                                out_shift);
@@ -173,19 +204,153 @@ static int decode_sdat(rex_file_t *rex, const uint8_t *data, uint32_t len)
 
     if (rex->pcm_samples <= 0) {
         snprintf(rex->error, sizeof(rex->error), "DWOP decode produced no samples");
-        free(rex->pcm_data);
+        rex_arena_release(rex->arena, rex->pcm_data);
+        rex->pcm_data = NULL;
+        if (wide) {
+            rex_arena_release(rex->arena, *wide);
+            *wide = NULL;
+        }
+        return -1;
+    }
+
+    /* A corrupt mono stream stops early: give the tail back. Arena
+     * buffers keep their size, ready for reuse. */
+    if (!rex->arena && rex->pcm_samples < max_frames) {
+        size_t used = (size_t)rex->pcm_samples * rex->pcm_channels * sizeof(int16_t);
+        int16_t *trimmed = (int16_t *)realloc(rex->pcm_data, used);
+        if (trimmed) rex->pcm_data = trimmed;
+    }
+
+    return 0;
+}
+
+/* Lazy SDAT: keep the compressed chunk and index it at slice starts.
+ * SLCE chunks precede SDAT in every REX2 file, so slices are known here. */
+static int index_sdat(rex_file_t *rex, const uint8_t *data, uint32_t len)
+{
+    if (len < 1) {
+        snprintf(rex->error, sizeof(rex->error), "SDAT chunk empty");
+        return -1;
+    }
+
+    int max_frames = sdat_frames(rex, len);
+
+    rex->sdat_data = (uint8_t *)rex_arena_alloc(rex->arena, len);
+    if (!rex->sdat_data) {
+        snprintf(rex->error, sizeof(rex->error), "Failed to allocate %u bytes", len);
+        return -1;
+    }
+    memcpy(rex->sdat_data, data, len);
+    rex->sdat_len = len;
+
+    /* Slices in ascending offset order (insertion sort, n <= 256) */
+    int order[REX_MAX_SLICES];
+    uint32_t marks[REX_MAX_SLICES] = {0};
+    dwop_checkpoint_t *cps = NULL;
+    int n = rex->slice_count;
+    for (int i = 0; i < n; i++) {
+        int j = i;
+        while (j > 0 && rex->slices[order[j - 1]].sample_offset > rex->slices[i].sample_offset) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    for (int i = 0; i < n; i++)
+        marks[i] = rex->slices[order[i]].sample_offset;
+
+    if (n > 0) {
+        cps = (dwop_checkpoint_t *)calloc(n, sizeof(dwop_checkpoint_t));
+        if (!cps) {
+            snprintf(rex->error, sizeof(rex->error), "Failed to allocate slice index");
+            rex_arena_release(rex->arena, rex->sdat_data);
+            rex->sdat_data = NULL;
+            return -1;
+        }
+    }
+
+    rex->pcm_channels = (rex->channels == 2) ? 2 : 1;
+    rex->pcm_samples = dwop_index(data, (int)len, rex->pcm_channels, max_frames,
+                                  marks, n, cps);
+    for (int i = 0; i < n; i++)
+        rex->slices[order[i]].checkpoint = cps[i];
+    free(cps);
+
+    if (rex->pcm_samples <= 0) {
+        snprintf(rex->error, sizeof(rex->error), "DWOP decode produced no samples");
+        rex_arena_release(rex->arena, rex->sdat_data);
+        rex->sdat_data = NULL;
+        return -1;
+    }
+
+    rex->lazy = 1;
+    return 0;
+}
+
+struct rex_progress {
+    dwop_checkpoint_t cp;       /* decoder state at rex->decoded */
+    int32_t *wide;              /* REX_PARSE_HIRES: every full-precision sample */
+    int out_shift;
+    int order[REX_MAX_SLICES];  /* slices by end frame */
+    int next;                   /* first in order without planar buffers yet */
+};
+
+/* Progressive SDAT: set up the output and keep a copy of the chunk to
+ * decode from in steps. The buffers are sized for the expected length,
+ * as the decode will not say how long the stream really is until it
+ * gets there. */
+static int start_sdat(rex_file_t *rex, const uint8_t *data, uint32_t len, int wide)
+{
+    if (len < 1) {
+        snprintf(rex->error, sizeof(rex->error), "SDAT chunk empty");
+        return -1;
+    }
+
+    int max_frames = sdat_frames(rex, len);
+    int ch = (rex->channels == 2) ? 2 : 1;
+    size_t alloc_samples = (size_t)max_frames * ch;
+
+    rex_progress_t *pr = (rex_progress_t *)calloc(1, sizeof(rex_progress_t));
+    rex->pcm_data = (int16_t *)rex_arena_alloc(rex->arena, alloc_samples * sizeof(int16_t));
+    rex->sdat_data = (uint8_t *)rex_arena_alloc(rex->arena, len);
+    if (pr && wide)
+        pr->wide = (int32_t *)rex_arena_alloc(rex->arena, alloc_samples * sizeof(int32_t));
+    if (!pr || !rex->pcm_data || !rex->sdat_data || (wide && !pr->wide)) {
+        snprintf(rex->error, sizeof(rex->error), "Failed to allocate %zu samples", alloc_samples);
+        if (pr) rex_arena_release(rex->arena, pr->wide);
+        free(pr);
+        rex_arena_release(rex->arena, rex->pcm_data);
+        rex_arena_release(rex->arena, rex->sdat_data);
         rex->pcm_data = NULL;
+        rex->sdat_data = NULL;
         return -1;
     }
+    memcpy(rex->sdat_data, data, len);
+    rex->sdat_len = len;
+
+    /* Decoder state at frame 0 */
+    uint32_t mark = 0;
+    dwop_index(data, (int)len, ch, 0, &mark, 1, &pr->cp);
+    pr->out_shift = (rex->bytes_per_sample == 3) ? 9 : 1;
 
+    rex->pcm_samples = max_frames;
+    rex->pcm_channels = ch;
+    rex->progress = pr;
     return 0;
 }
 
 /* Recursive IFF chunk parser.
  * boundary limits how far we parse (prevents reading past CAT containers). */
+typedef struct {
+    int flags;
+    int sdat_decoded;
+    int32_t *wide;       /* REX_PARSE_HIRES: full-precision samples */
+} parse_ctx_t;
+
 static int parse_chunks(rex_file_t *rex, const uint8_t *data, size_t boundary,
-                        size_t offset, int *sdat_decoded)
+                        size_t offset, parse_ctx_t *ctx)
 {
+    int flags = ctx->flags;
     while (offset + 8 <= boundary) {
         const uint8_t *tag = data + offset;
         uint32_t chunk_len = read_u32_be(data + offset + 4);
@@ -205,7 +370,7 @@ static int parse_chunks(rex_file_t *rex, const uint8_t *data, size_t boundary,
              * Limit recursion to within this CAT's boundary. */
             if (chunk_len >= 4) {
                 size_t cat_boundary = offset + 8 + chunk_len;
-                parse_chunks(rex, data, cat_boundary, offset + 12, sdat_decoded);
+                parse_chunks(rex, data, cat_boundary, offset + 12, ctx);
             }
         } else if (tag_match(tag, "GLOB")) {
             parse_glob(rex, chunk_data, chunk_len);
@@ -216,9 +381,18 @@ static int parse_chunks(rex_file_t *rex, const uint8_t *data, size_t boundary,
         } else if (tag_match(tag, "SLCE")) {
             parse_slce(rex, chunk_data, chunk_len);
         } else if (tag_match(tag, "SDAT")) {
-            if (!*sdat_decoded) {
-                if (decode_sdat(rex, chunk_data, chunk_len) == 0) {
-                    *sdat_decoded = 1;
+            if (flags & REX_PARSE_HEADER) {
+                /* Metadata scan: the audio is not needed */
+            } else if (!ctx->sdat_decoded) {
+                int wide = (flags & REX_PARSE_HIRES) && rex->bytes_per_sample == 3 &&
+                           rex_planar_format(flags, 3) != REX_PLANAR_NONE;
+                int rc = (flags & REX_PARSE_LAZY)
+                    ? index_sdat(rex, chunk_data, chunk_len)
+                    : (flags & REX_PARSE_PROGRESSIVE)
+                    ? start_sdat(rex, chunk_data, chunk_len, wide)
+                    : decode_sdat(rex, chunk_data, chunk_len, wide ? &ctx->wide : NULL);
+                if (rc == 0) {
+                    ctx->sdat_decoded = 1;
                 }
             }
         }
@@ -244,9 +418,287 @@ static void clamp_slice_lengths(rex_file_t *rex)
     }
 }
 
+static void free_progress(rex_file_t *rex)
+{
+    if (!rex->progress) return;
+    rex_arena_release(rex->arena, rex->progress->wide);
+    free(rex->progress);
+    rex->progress = NULL;
+}
+
+static void fill_slice_planes(rex_file_t *rex, int i, const int32_t *wide);
+
+/* One progressive step (rex->progress set). Returns the frames the
+ * decoder produced. */
+static int decode_step(rex_file_t *rex, int max_frames)
+{
+    rex_progress_t *pr = rex->progress;
+    int ch = rex->pcm_channels;
+    int at = atomic_load_explicit(&rex->decoded, memory_order_relaxed);
+    int n = rex->pcm_samples - at;
+    if (n > max_frames) n = max_frames;
+
+    size_t from = (size_t)at * ch;
+    int got = dwop_decode_resume(rex->sdat_data, (int)rex->sdat_len, ch, &pr->cp,
+                                 pr->wide ? NULL : rex->pcm_data + from,
+                                 pr->wide ? pr->wide + from : NULL, n, pr->out_shift);
+    size_t to = (size_t)(at + got) * ch;
+    if (pr->wide) {
+        for (size_t i = from; i < to; i++)
+            rex->pcm_data[i] = (int16_t)(pr->wide[i] >> (pr->out_shift - 1));
+    }
+
+    int end = at + got;
+    if (got < n) {
+        /* A corrupt stream ended early: the rest stays silent */
+        size_t all = (size_t)rex->pcm_samples * ch;
+        memset(rex->pcm_data + to, 0, (all - to) * sizeof(int16_t));
+        if (pr->wide) memset(pr->wide + to, 0, (all - to) * sizeof(int32_t));
+        end = rex->pcm_samples;
+    }
+
+    /* Planar buffers of the slices now complete, before they are shown */
+    while (pr->next < rex->slice_count) {
+        const rex_slice_t *s = &rex->slices[pr->order[pr->next]];
+        if (s->sample_offset + s->sample_length > (uint32_t)end) break;
+        if (rex->planar_data) fill_slice_planes(rex, pr->order[pr->next], pr->wide);
+        rex_analyze_pcm(rex->pcm_data + (size_t)s->sample_offset * ch, ch,
+                        s->sample_length, &rex->slices[pr->order[pr->next]].stats);
+        pr->next++;
+    }
+    atomic_store_explicit(&rex->decoded, end, memory_order_release);
+
+    if (end == rex->pcm_samples) {
+        free_progress(rex);
+        rex_arena_release(rex->arena, rex->sdat_data);
+        rex->sdat_data = NULL;
+        rex->sdat_len = 0;
+    }
+    return got;
+}
+
+/* floor(sqrt(v)) */
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t r = 0, bit = (uint64_t)1 << 62;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+/* Loudest channel of frame i */
+static int frame_level(const int16_t *pcm, int ch, uint32_t i)
+{
+    int v = abs(pcm[(size_t)i * ch]);
+    int r = abs(pcm[(size_t)i * ch + ch - 1]);
+    return r > v ? r : v;
+}
+
+void rex_analyze_pcm(const int16_t *pcm, int channels, uint32_t frames,
+                     rex_slice_stats_t *st)
+{
+    memset(st, 0, sizeof(*st));
+    st->analyzed = 1;
+
+    size_t n = (size_t)frames * channels;
+    uint64_t energy = 0;
+    int peak = 0;
+    size_t last_loud = 0;  /* one past the last sample above the silence level */
+    for (size_t i = 0; i < n; i++) {
+        int v = abs(pcm[i]);
+        if (v > peak) peak = v;
+        if (v > REX_SILENCE_LEVEL) last_loud = i + 1;
+        energy += (uint64_t)((int32_t)pcm[i] * pcm[i]);
+    }
+    st->peak = (uint16_t)peak;
+    st->rms = n ? (uint16_t)isqrt64(energy / n) : 0;
+    st->audible = (uint32_t)((last_loud + channels - 1) / channels);
+    if (st->audible == 0) return;
+
+    /* Earliest quietest frame at the start, latest at the end */
+    uint32_t win = st->audible < REX_ZERO_WINDOW ? st->audible : REX_ZERO_WINDOW;
+    uint32_t best = 0;
+    for (uint32_t i = 1; i < win; i++) {
+        if (frame_level(pcm, channels, i) < frame_level(pcm, channels, best)) best = i;
+    }
+    st->zero_start = (uint16_t)best;
+    best = st->audible - 1;
+    for (uint32_t i = st->audible - 1; i-- > st->audible - win;) {
+        if (frame_level(pcm, channels, i) < frame_level(pcm, channels, best)) best = i;
+    }
+    st->zero_end = best + 1;
+    if (st->zero_end <= st->zero_start) {
+        /* Too short for two edges */
+        st->zero_start = 0;
+        st->zero_end = st->audible;
+    }
+}
+
+void rex_analyze_slices(rex_file_t *rex)
+{
+    if (!rex->pcm_data) return;
+    for (int i = 0; i < rex->slice_count; i++) {
+        rex_slice_t *s = &rex->slices[i];
+        rex_analyze_pcm(rex->pcm_data + (size_t)s->sample_offset * rex->pcm_channels,
+                        rex->pcm_channels, s->sample_length, &s->stats);
+    }
+}
+
+int rex_planar_format(int flags, int bytes_per_sample)
+{
+    if (flags & REX_PARSE_PLANAR_F32) return REX_PLANAR_F32;
+    if (flags & REX_PARSE_PLANAR_I16) {
+        return (flags & REX_PARSE_HIRES) && bytes_per_sample == 3 ? REX_PLANAR_I24
+                                                                 : REX_PLANAR_I16;
+    }
+    return REX_PLANAR_NONE;
+}
+
+static void put_i24(uint8_t *d, int k, int32_t v)
+{
+    uint8_t *b = d + k * 3;
+    b[0] = (uint8_t)v;
+    b[1] = (uint8_t)(v >> 8);
+    b[2] = (uint8_t)(v >> 16);
+}
+
+/* One channel of a slice from full-precision samples (src[k * ch]),
+ * len of them, into d[-REX_PLANAR_GUARD, end) as float or int24 */
+static void fill_plane_wide(void *d, int format, const int32_t *src, int ch, int len, int end)
+{
+    for (int k = -REX_PLANAR_GUARD; k < end; k++) {
+        /* Guard frames repeat the edge samples */
+        int from = k < 0 ? 0 : (k >= len ? len - 1 : k);
+        int32_t v = len > 0 ? src[(size_t)from * ch] : 0;
+        if (format == REX_PLANAR_F32)
+            ((float *)d)[k] = (float)v * (1.0f / 256.0f);  /* exact, at 16-bit scale */
+        else
+            put_i24((uint8_t *)d, k, v);
+    }
+}
+
+static size_t planar_elem(int format)
+{
+    return format == REX_PLANAR_F32 ? sizeof(float)
+         : format == REX_PLANAR_I24 ? 3 : sizeof(int16_t);
+}
+
+/* Per-channel stride in elements, rounded up to a 16-byte multiple
+ * (REX_PLANAR_GUARD * elem is itself a multiple of 16 for float and
+ * int16; int24 rounds to 16 elements, 48 bytes) */
+static size_t plane_stride(int format, uint32_t sample_length)
+{
+    size_t round = planar_elem(format) == 3 ? 16 : 16 / planar_elem(format);
+    size_t n = sample_length + 2 * REX_PLANAR_GUARD;
+    return (n + round - 1) / round * round;
+}
+
+/* Everything sits in one allocation; each channel and its guard frames
+ * take a 16-byte multiple, so every channel start stays aligned. Sets
+ * the plane pointers without filling them. */
+static int layout_planar(rex_file_t *rex, int format)
+{
+    size_t elem = planar_elem(format);
+    int ch = rex->pcm_channels;
+
+    size_t total = 0;
+    for (int i = 0; i < rex->slice_count; i++)
+        total += plane_stride(format, rex->slices[i].sample_length) * ch;
+
+    void *block = total ? rex_arena_alloc(rex->arena, total * elem) : NULL;
+    if (!block) return -1;
+
+    size_t at = 0;
+    for (int i = 0; i < rex->slice_count; i++) {
+        rex_slice_t *s = &rex->slices[i];
+        size_t stride = plane_stride(format, s->sample_length);
+        for (int c = 0; c < ch; c++) {
+            s->plane[c] = (uint8_t *)block + (at + REX_PLANAR_GUARD) * elem;
+            at += stride;
+        }
+        if (ch == 1) s->plane[1] = s->plane[0];
+    }
+
+    rex->planar = format;
+    rex->planar_data = block;
+    rex->planar_bytes = total * elem;
+    return 0;
+}
+
+/* Fill slice i's planes from wide (24-bit scale, F32 or I24 only) if
+ * given, else from pcm_data */
+static void fill_slice_planes(rex_file_t *rex, int i, const int32_t *wide)
+{
+    int format = rex->planar;
+    int ch = rex->pcm_channels;
+    rex_slice_t *s = &rex->slices[i];
+    int end = (int)plane_stride(format, s->sample_length) - REX_PLANAR_GUARD;
+    const int16_t *src = rex->pcm_data + (size_t)s->sample_offset * ch;
+    int len = (int)s->sample_length;
+
+    for (int c = 0; c < ch; c++) {
+        if (wide) {
+            fill_plane_wide(s->plane[c], format, wide + (size_t)s->sample_offset * ch + c,
+                            ch, len, end);
+            continue;
+        }
+        int16_t first = len > 0 ? src[c] : 0;
+        int16_t last = len > 0 ? src[(size_t)(len - 1) * ch + c] : 0;
+        if (format == REX_PLANAR_F32) {
+            float *d = (float *)s->plane[c];
+            for (int k = -REX_PLANAR_GUARD; k < 0; k++) d[k] = (float)first;
+            for (int k = 0; k < len; k++) d[k] = (float)src[(size_t)k * ch + c];
+            for (int k = len; k < end; k++) d[k] = (float)last;
+        } else if (format == REX_PLANAR_I24) {
+            uint8_t *d = (uint8_t *)s->plane[c];
+            for (int k = -REX_PLANAR_GUARD; k < 0; k++) put_i24(d, k, first * 256);
+            for (int k = 0; k < len; k++) put_i24(d, k, src[(size_t)k * ch + c] * 256);
+            for (int k = len; k < end; k++) put_i24(d, k, last * 256);
+        } else {
+            int16_t *d = (int16_t *)s->plane[c];
+            for (int k = -REX_PLANAR_GUARD; k < 0; k++) d[k] = first;
+            for (int k = 0; k < len; k++) d[k] = src[(size_t)k * ch + c];
+            for (int k = len; k < end; k++) d[k] = last;
+        }
+    }
+}
+
+static int build_planar(rex_file_t *rex, int format, const int32_t *wide)
+{
+    if (layout_planar(rex, format) != 0) return -1;
+    for (int i = 0; i < rex->slice_count; i++)
+        fill_slice_planes(rex, i, wide);
+    return 0;
+}
+
+int rex_build_planar(rex_file_t *rex, int format)
+{
+    return build_planar(rex, format, NULL);
+}
+
 int rex_parse(rex_file_t *rex, const uint8_t *data, size_t data_len)
+{
+    return rex_parse_ex(rex, data, data_len, 0);
+}
+
+int rex_parse_ex(rex_file_t *rex, const uint8_t *data, size_t data_len, int flags)
+{
+    return rex_parse_arena(rex, data, data_len, flags, NULL);
+}
+
+int rex_parse_arena(rex_file_t *rex, const uint8_t *data, size_t data_len,
+                    int flags, rex_arena_t *arena)
 {
     memset(rex, 0, sizeof(*rex));
+    rex->arena = arena;
 
     rex->sample_rate = 44100;
     rex->channels = 1;
@@ -262,10 +714,20 @@ int rex_parse(rex_file_t *rex, const uint8_t *data, size_t data_len)
         return -1;
     }
 
-    int sdat_decoded = 0;
-    parse_chunks(rex, data, data_len, 0, &sdat_decoded);
+    parse_ctx_t ctx = { flags, 0, NULL };
+    parse_chunks(rex, data, data_len, 0, &ctx);
+
+    if (flags & REX_PARSE_HEADER) {
+        /* Same single-slice fallback as below, sized from SINF */
+        if (rex->slice_count == 0 && rex->total_sample_length > 0) {
+            rex->slices[0].sample_offset = 0;
+            rex->slices[0].sample_length = rex->total_sample_length;
+            rex->slice_count = 1;
+        }
+        return 0;
+    }
 
-    if (!sdat_decoded || !rex->pcm_data) {
+    if (!ctx.sdat_decoded || (!rex->pcm_data && !rex->lazy)) {
         if (!rex->error[0]) {
             snprintf(rex->error, sizeof(rex->error), "No audio data found in file");
         }
@@ -279,8 +741,15 @@ int rex_parse(rex_file_t *rex, const uint8_t *data, size_t data_len)
             rex->slices[0].sample_offset = 0;
             rex->slices[0].sample_length = (uint32_t)rex->pcm_samples;
             rex->slice_count = 1;
+            if (rex->lazy) {
+                /* Fresh decoder state for a slice starting at frame 0 */
+                uint32_t mark = 0;
+                dwop_index(rex->sdat_data, (int)rex->sdat_len, rex->pcm_channels,
+                           0, &mark, 1, &rex->slices[0].checkpoint);
+            }
         } else {
             snprintf(rex->error, sizeof(rex->error), "No slices found in file");
+            rex_arena_release(arena, ctx.wide);
             rex_free(rex);
             return -1;
         }
@@ -289,15 +758,239 @@ int rex_parse(rex_file_t *rex, const uint8_t *data, size_t data_len)
     /* Clamp slice lengths to decoded PCM buffer bounds */
     clamp_slice_lengths(rex);
 
+    /* Render-ready copies; without them callers fall back to pcm_data.
+     * A progressive parse fills them in as the slices are decoded. */
+    int format = rex_planar_format(flags, rex->bytes_per_sample);
+    if (!rex->lazy && format != REX_PLANAR_NONE) {
+        if (rex->progress) layout_planar(rex, format);
+        else build_planar(rex, format, ctx.wide);
+    }
+    rex_arena_release(arena, ctx.wide);
+
+    if (!rex->progress) {
+        if (!rex->lazy) rex_analyze_slices(rex);
+        atomic_store_explicit(&rex->decoded, rex->pcm_samples, memory_order_release);
+        return 0;
+    }
+
+    /* Slices in ascending end order (insertion sort, n <= 256) */
+    rex_progress_t *pr = rex->progress;
+    for (int i = 0; i < rex->slice_count; i++) {
+        uint32_t end = rex->slices[i].sample_offset + rex->slices[i].sample_length;
+        int j = i;
+        while (j > 0 && rex->slices[pr->order[j - 1]].sample_offset +
+                        rex->slices[pr->order[j - 1]].sample_length > end) {
+            pr->order[j] = pr->order[j - 1];
+            j--;
+        }
+        pr->order[j] = i;
+    }
+
+    /* The first step here, so a stream without a single sample still
+     * fails the parse */
+    if (decode_step(rex, REX_DECODE_STEP) == 0) {
+        snprintf(rex->error, sizeof(rex->error), "DWOP decode produced no samples");
+        rex_free(rex);
+        return -1;
+    }
     return 0;
 }
 
+int rex_decode_step(rex_file_t *rex, int max_frames)
+{
+    if (!rex->progress) return 0;
+    decode_step(rex, max_frames);
+    return rex->progress != NULL;
+}
+
+int rex_decoded_frames(const rex_file_t *rex)
+{
+    return atomic_load_explicit(&rex->decoded, memory_order_acquire);
+}
+
+size_t rex_progress_bytes(const rex_file_t *rex)
+{
+    const rex_progress_t *pr = rex->progress;
+    if (!pr) return 0;
+    size_t n = sizeof(rex_progress_t);
+    if (pr->wide) {
+        n += rex->arena ? rex_arena_capacity(pr->wide)
+                        : (size_t)rex->pcm_samples * rex->pcm_channels * sizeof(int32_t);
+    }
+    return n;
+}
+
+int rex_decode_slice(const rex_file_t *rex, int slice_index, int16_t *out)
+{
+    if (slice_index < 0 || slice_index >= rex->slice_count) return -1;
+
+    const rex_slice_t *s = &rex->slices[slice_index];
+    int ch = rex->pcm_channels;
+
+    if (!rex->lazy) {
+        if (!rex->pcm_data) return -1;
+        memcpy(out, rex->pcm_data + (size_t)s->sample_offset * ch,
+               (size_t)s->sample_length * ch * sizeof(int16_t));
+        return (int)s->sample_length;
+    }
+
+    int out_shift = (rex->bytes_per_sample == 3) ? 9 : 1;
+    return dwop_decode_at(rex->sdat_data, (int)rex->sdat_len, ch, &s->checkpoint,
+                          out, (int)s->sample_length, out_shift);
+}
+
 void rex_free(rex_file_t *rex)
 {
-    if (rex->pcm_data) {
-        free(rex->pcm_data);
-        rex->pcm_data = NULL;
+    free_progress(rex);
+    rex_arena_release(rex->arena, rex->pcm_data);
+    rex_arena_release(rex->arena, rex->sdat_data);
+    rex_arena_release(rex->arena, rex->planar_data);
+    rex->pcm_data = NULL;
+    rex->sdat_data = NULL;
+    rex->planar_data = NULL;
+    for (int i = 0; i < rex->slice_count; i++) {
+        rex->slices[i].plane[0] = rex->slices[i].plane[1] = NULL;
     }
+    rex->planar = REX_PLANAR_NONE;
+    rex->planar_bytes = 0;
+    rex->sdat_len = 0;
+    rex->lazy = 0;
     rex->pcm_samples = 0;
+    atomic_store_explicit(&rex->decoded, 0, memory_order_relaxed);
     rex->slice_count = 0;
 }
+
+/* ------------------------------------------------------------------ */
+/* Decode buffer pool                                                  */
+/* ------------------------------------------------------------------ */
+
+#define ARENA_SLOTS 16
+#define ARENA_HEADER 16  /* capacity, padded to keep buffers 16-byte aligned */
+
+struct rex_arena {
+    pthread_mutex_t lock;
+    size_t limit;
+    void *idle[ARENA_SLOTS];  /* released buffers, oldest first */
+    int idle_count;
+    size_t idle_bytes;
+    unsigned reuses;
+    unsigned allocs;
+};
+
+static void *arena_block(void *p)
+{
+    return (uint8_t *)p - ARENA_HEADER;
+}
+
+size_t rex_arena_capacity(const void *p)
+{
+    return *(const size_t *)((const uint8_t *)p - ARENA_HEADER);
+}
+
+/* Take idle buffer i out of the pool (lock held) */
+static void *arena_take(rex_arena_t *a, int i)
+{
+    void *p = a->idle[i];
+    a->idle_bytes -= rex_arena_capacity(p);
+    a->idle_count--;
+    memmove(&a->idle[i], &a->idle[i + 1], (size_t)(a->idle_count - i) * sizeof(void *));
+    return p;
+}
+
+/* Free the oldest idle buffers until bytes more would fit within the
+ * limit and slots more within the table (lock held) */
+static void arena_shrink(rex_arena_t *a, size_t bytes, int slots)
+{
+    while (a->idle_count > 0 &&
+           (a->idle_bytes + bytes > a->limit || a->idle_count + slots > ARENA_SLOTS))
+        free(arena_block(arena_take(a, 0)));
+}
+
+rex_arena_t *rex_arena_create(size_t limit)
+{
+    rex_arena_t *a = (rex_arena_t *)calloc(1, sizeof(rex_arena_t));
+    if (!a) return NULL;
+    pthread_mutex_init(&a->lock, NULL);
+    a->limit = limit;
+    return a;
+}
+
+void rex_arena_destroy(rex_arena_t *arena)
+{
+    if (!arena) return;
+    rex_arena_trim(arena, 0);
+    pthread_mutex_destroy(&arena->lock);
+    free(arena);
+}
+
+void *rex_arena_alloc(rex_arena_t *arena, size_t bytes)
+{
+    void *p = NULL;
+    if (!arena) {
+        if (posix_memalign(&p, 16, bytes ? bytes : 1) != 0) return NULL;
+        return p;
+    }
+
+    /* Best fit among buffers no more than twice the request */
+    pthread_mutex_lock(&arena->lock);
+    int best = -1;
+    size_t best_cap = 0;
+    for (int i = 0; i < arena->idle_count; i++) {
+        size_t cap = rex_arena_capacity(arena->idle[i]);
+        if (cap >= bytes && cap / 2 <= bytes && (best < 0 || cap < best_cap)) {
+            best = i;
+            best_cap = cap;
+        }
+    }
+    if (best >= 0) {
+        p = arena_take(arena, best);
+        arena->reuses++;
+    } else {
+        arena->allocs++;
+    }
+    pthread_mutex_unlock(&arena->lock);
+    if (p) return p;
+
+    void *block = NULL;
+    if (posix_memalign(&block, 16, ARENA_HEADER + bytes) != 0) return NULL;
+    *(size_t *)block = bytes;
+    return (uint8_t *)block + ARENA_HEADER;
+}
+
+void rex_arena_release(rex_arena_t *arena, void *p)
+{
+    if (!p) return;
+    if (!arena) {
+        free(p);
+        return;
+    }
+
+    size_t cap = rex_arena_capacity(p);
+    pthread_mutex_lock(&arena->lock);
+    int keep = cap <= arena->limit;
+    if (keep) {
+        arena_shrink(arena, cap, 1);
+        arena->idle[arena->idle_count++] = p;
+        arena->idle_bytes += cap;
+    }
+    pthread_mutex_unlock(&arena->lock);
+    if (!keep) free(arena_block(p));
+}
+
+void rex_arena_trim(rex_arena_t *arena, size_t limit)
+{
+    pthread_mutex_lock(&arena->lock);
+    arena->limit = limit;
+    arena_shrink(arena, 0, 0);
+    pthread_mutex_unlock(&arena->lock);
+}
+
+void rex_arena_stats(rex_arena_t *arena, rex_arena_stats_t *out)
+{
+    pthread_mutex_lock(&arena->lock);
+    out->reuses = arena->reuses;
+    out->allocs = arena->allocs;
+    out->idle_bytes = arena->idle_bytes;
+    out->idle_count = arena->idle_count;
+    pthread_mutex_unlock(&arena->lock);
+}
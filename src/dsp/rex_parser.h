@@ -13,13 +13,70 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdatomic.h>
+#include "dwop.h"
 
 #define REX_MAX_SLICES 256
 
+/* Hard cap on decoded length: no REX file should have more than 10M
+ * frames (~3.8 min @ 44.1kHz) */
+#define REX_MAX_FRAMES 10000000
+
+/* rex_parse_ex flags */
+#define REX_PARSE_LAZY  0x01  /* index SDAT, decode slices on demand */
+#define REX_PARSE_PLANAR_F32 0x02  /* also build planar float slice buffers */
+#define REX_PARSE_PLANAR_I16 0x04  /* also build planar int16 slice buffers */
+#define REX_PARSE_HEADER 0x08  /* metadata and slice table only, no audio */
+#define REX_PARSE_HIRES  0x10  /* 24-bit files: full-precision planar buffers */
+#define REX_PARSE_PROGRESSIVE 0x20  /* decode SDAT in steps (rex_decode_step) */
+
+/* Frames per progressive decode step: the first is decoded by the parse,
+ * the rest by rex_decode_step() calls */
+#define REX_DECODE_STEP 8192
+
+/* Planar slice buffers: frames of padding before and after each slice,
+ * holding copies of its first and last sample */
+#define REX_PLANAR_GUARD 8
+
+/* rex_file_t.planar */
+#define REX_PLANAR_NONE 0
+#define REX_PLANAR_F32  1
+#define REX_PLANAR_I16  2
+#define REX_PLANAR_I24  3  /* packed little-endian, 3 bytes per sample */
+
+/* Pool of recycled decode buffers (see rex_parse_arena) */
+typedef struct rex_arena rex_arena_t;
+
+/* Decoder state of an unfinished progressive parse */
+typedef struct rex_progress rex_progress_t;
+
+/* Slice analysis: trailing samples at or below REX_SILENCE_LEVEL (16-bit
+ * scale, about -84 dBFS) count as silence, and quiet edges are looked for
+ * within REX_ZERO_WINDOW frames of either end */
+#define REX_SILENCE_LEVEL 2
+#define REX_ZERO_WINDOW 128
+
+/* Levels of one slice's audio at 16-bit scale, over all its channels,
+ * taken once as the slice is decoded (or read back from a sidecar). The
+ * quietest frame near an edge stands in for its nearest zero crossing.
+ * Only valid if analyzed: lazy and header-only parses leave it unset. */
+typedef struct {
+    uint16_t peak;           /* largest |sample| */
+    uint16_t rms;            /* root mean square */
+    uint16_t zero_start;     /* quietest of the first REX_ZERO_WINDOW frames */
+    uint16_t analyzed;
+    uint32_t audible;        /* frames before the trailing silence */
+    uint32_t zero_end;       /* one past the quietest of the last
+                                REX_ZERO_WINDOW audible frames */
+} rex_slice_stats_t;
+
 /* Slice descriptor */
 typedef struct {
     uint32_t sample_offset;  /* offset in decoded samples from start of SDAT */
     uint32_t sample_length;  /* length in samples */
+    dwop_checkpoint_t checkpoint;  /* decoder state at sample_offset (lazy only) */
+    void *plane[2];          /* planar L, R (R == L for mono), or NULL */
+    rex_slice_stats_t stats;
 } rex_slice_t;
 
 /* Parsed REX file */
@@ -41,13 +98,45 @@ typedef struct {
     rex_slice_t slices[REX_MAX_SLICES];
 
     /* Decoded PCM audio (from SDAT chunk, DWOP decoded) */
-    int16_t *pcm_data;       /* allocated, caller must free */
+    int16_t *pcm_data;       /* allocated, caller must free; NULL when lazy */
     int pcm_samples;         /* total frames (per-channel sample count) */
     int pcm_channels;        /* 1=mono, 2=stereo (interleaved L/R in pcm_data) */
 
+    /* Planar slice buffers (REX_PARSE_PLANAR_*): one allocation holding
+     * every slice's channels, each 16-byte aligned with REX_PLANAR_GUARD
+     * guard frames either side, as float, int16 or packed int24 per
+     * planar; missing if lazy or if the allocation failed. Float planes
+     * and int16 are at 16-bit scale; a 24-bit file parsed with
+     * REX_PARSE_HIRES keeps its low 8 bits as the float's fraction, or in
+     * int24 planes (24-bit scale) in place of int16. */
+    int planar;
+    void *planar_data;
+    size_t planar_bytes;
+
+    /* Lazy mode: copy of the compressed SDAT chunk, decoded per slice
+     * (also held by a progressive parse until it finishes) */
+    int lazy;
+    uint8_t *sdat_data;      /* allocated, caller must free */
+    uint32_t sdat_len;
+
+    /* Frames of pcm_data decoded so far, stored with release order: every
+     * slice ending at or before it is complete, planar buffers included.
+     * pcm_samples unless a progressive decode is under way. Read it with
+     * rex_decoded_frames(). */
+    atomic_int decoded;
+    rex_progress_t *progress;  /* until a progressive decode finishes */
+
     /* Total sound length from SINF */
     uint32_t total_sample_length;
 
+    /* Kits (rex_kit.h): notes with audio, slices[] being indexed by MIDI
+     * note. 0 for a loop file. */
+    int kit;
+
+    /* Pool pcm_data, planar_data and sdat_data came from and go back to
+     * on rex_free(), or NULL for the plain heap */
+    rex_arena_t *arena;
+
     /* Error info */
     char error[256];
 } rex_file_t;
@@ -57,7 +146,102 @@ typedef struct {
  * Caller must call rex_free() when done. */
 int rex_parse(rex_file_t *rex, const uint8_t *data, size_t data_len);
 
-/* Free resources allocated by rex_parse */
+/* Parse with REX_PARSE_* flags. With REX_PARSE_LAZY the SDAT chunk is
+ * scanned once to record a decoder checkpoint at every slice start and kept
+ * compressed; pcm_data stays NULL and slices are decoded with
+ * rex_decode_slice(). All other fields are filled in as for rex_parse.
+ * REX_PARSE_PLANAR_F32/I16 (ignored when lazy) additionally fill in
+ * slice plane pointers; pcm_data is kept either way. With
+ * REX_PARSE_HIRES a 24-bit file is decoded at full precision for its
+ * planar buffers (pcm_data stays 16-bit); it has no effect on lazy
+ * parses, files without planar buffers, or 16-bit files.
+ * REX_PARSE_HEADER skips SDAT entirely: only the GLOB/HEAD/SINF/SLCE
+ * fields are filled in, slice lengths are not clamped to the audio, and
+ * pcm_samples and pcm_channels stay 0.
+ * REX_PARSE_PROGRESSIVE (ignored when lazy) allocates every buffer but
+ * decodes only the first REX_DECODE_STEP frames; rex_decode_step() does
+ * the rest. pcm_samples is the expected length from the start, so a
+ * corrupt mono stream that ends early leaves silence rather than being
+ * cut short. */
+int rex_parse_ex(rex_file_t *rex, const uint8_t *data, size_t data_len, int flags);
+
+/* rex_parse_ex drawing every buffer from arena (NULL: plain heap). A
+ * released buffer that fits is reused in place of a fresh allocation;
+ * new ones are sized exactly. Several threads may share one arena. */
+int rex_parse_arena(rex_file_t *rex, const uint8_t *data, size_t data_len,
+                    int flags, rex_arena_t *arena);
+
+/* Progressive parse: decode up to max_frames more frames, complete the
+ * planar buffers of the slices they finish, then advance rex->decoded.
+ * One thread steps a file; any number may read the complete slices
+ * meanwhile. Returns 1 while frames remain, 0 once finished (the SDAT
+ * copy is released then), and 0 for files not parsed progressively. */
+int rex_decode_step(rex_file_t *rex, int max_frames);
+
+/* rex->decoded, for reading on another thread than rex_decode_step's */
+int rex_decoded_frames(const rex_file_t *rex);
+
+/* Memory an unfinished progressive decode holds besides the SDAT copy
+ * (its decoder state and, for REX_PARSE_HIRES, the full-precision
+ * samples); 0 once it is done. */
+size_t rex_progress_bytes(const rex_file_t *rex);
+
+/* Decode one slice into out (sample_length frames, interleaved if stereo).
+ * Works in both modes; only reads rex, so it is safe to call from several
+ * threads at once. Returns frames written, or -1 for a bad index. */
+int rex_decode_slice(const rex_file_t *rex, int slice_index, int16_t *out);
+
+/* Copy each slice of a fully decoded file into planar buffers (format
+ * REX_PLANAR_F32, REX_PLANAR_I16 or REX_PLANAR_I24), padded with REX_PLANAR_GUARD copies
+ * of the edge samples so an interpolator can read one frame past either
+ * end without bounds checks. rex_parse_ex() does this for the
+ * REX_PARSE_PLANAR_* flags. Returns 0, or -1 (leaving the file without
+ * planar buffers) when out of memory. */
+int rex_build_planar(rex_file_t *rex, int format);
+
+/* Analyze frames of pcm (channels interleaved) into st */
+void rex_analyze_pcm(const int16_t *pcm, int channels, uint32_t frames,
+                     rex_slice_stats_t *st);
+
+/* Analyze every slice of a fully decoded file. rex_parse_ex() does this
+ * for every parse with audio (a progressive one as slices complete), and
+ * for files built by hand there is this. */
+void rex_analyze_slices(rex_file_t *rex);
+
+/* REX_PLANAR_* format that REX_PARSE_* flags give a file of
+ * bytes_per_sample (REX_PLANAR_NONE without a planar flag) */
+int rex_planar_format(int flags, int bytes_per_sample);
+
+/* Free resources allocated by rex_parse (buffers return to rex->arena) */
 void rex_free(rex_file_t *rex);
 
+/* Decode buffer pool. Released buffers are kept, oldest dropped first,
+ * while they total no more than limit bytes; one is reused for a request
+ * it covers with at most 2x to spare. */
+rex_arena_t *rex_arena_create(size_t limit);
+
+/* Free the pool and its idle buffers. Every buffer taken from it must
+ * have been released. */
+void rex_arena_destroy(rex_arena_t *arena);
+
+/* 16-byte aligned buffer of at least bytes, or NULL. With a NULL arena
+ * this is the plain heap and rex_arena_release() is free(). */
+void *rex_arena_alloc(rex_arena_t *arena, size_t bytes);
+void rex_arena_release(rex_arena_t *arena, void *p);
+
+/* Usable size of a buffer from a (non-NULL) arena */
+size_t rex_arena_capacity(const void *p);
+
+/* Change the limit, freeing idle buffers down to it (0 empties the pool) */
+void rex_arena_trim(rex_arena_t *arena, size_t limit);
+
+typedef struct {
+    unsigned reuses;     /* allocations served from a released buffer */
+    unsigned allocs;     /* allocations that went to the heap */
+    size_t idle_bytes;   /* held for reuse */
+    int idle_count;
+} rex_arena_stats_t;
+
+void rex_arena_stats(rex_arena_t *arena, rex_arena_stats_t *out);
+
 #endif /* REX_PARSER_H */
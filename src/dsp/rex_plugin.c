@@ -3,7 +3,21 @@
  *
  * Parses .rx2/.rex files on-device, decodes DWOP compressed slices
  * (mono or L/delta stereo), and maps them across MIDI notes starting
- * at note 36 (C2). One-shot polyphonic playback with 16 voices.
+ * at note 36 (C2). One-shot polyphonic playback with 16 voices by default
+ * (polyphony param, 8-64).
+ * Files are loaded on a background thread (rex_loader.c) and swapped in
+ * at the start of a render block. Parameter changes and MIDI reach the
+ * render thread only through lock-free rings drained at the same point,
+ * so a block always renders from one consistent set of settings. In lazy
+ * mode only a checkpoint index is kept per file and slices are decoded on
+ * first use into a bounded per-instance slice cache. In kit mode (the
+ * "kit" param, rex_kit.h) slice ranges of several loops are packed into
+ * one file whose slices are indexed by note, played by the same voices.
+ * Slice levels analyzed at load let the mix skip saturation when the
+ * playing voices can't clip, and voices stop at a slice's trailing silence.
+ *
+ * The same engine runs without a host through rex_render.h, for offline
+ * rendering on the caller's thread.
  *
  * V2 API - instance-based for Signal Chain integration.
  *
@@ -13,12 +27,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <strings.h>
-#include <dirent.h>
 #include <stdint.h>
 #include <math.h>
+#include <stdatomic.h>
 
 #include "rex_parser.h"
+#include "rex_loader.h"
+#include "rex_kit.h"
+#include "rex_cache.h"
+#include "rex_sidecar.h"
+#include "rex_catalog.h"
+#include "resample.h"
+#include "rex_clock.h"
+#include "rex_render.h"
 
 /* ------------------------------------------------------------------ */
 /* Plugin API definitions (inline to avoid path issues)               */
@@ -49,16 +70,30 @@ typedef struct plugin_api_v2 {
     int (*get_param)(void *instance, const char *key, char *buf, int buf_len);
     int (*get_error)(void *instance, char *buf, int buf_len);
     void (*render_block)(void *instance, int16_t *out_interleaved_lr, int frames);
+    /* Extension past the v2 table, ignored by hosts that don't know it:
+     * on_midi for a message that takes effect frame_offset frames into
+     * the next render_block */
+    void (*on_midi_at)(void *instance, const uint8_t *msg, int len, int source,
+                       int frame_offset);
 } plugin_api_v2_t;
 
 /* ------------------------------------------------------------------ */
 /* Constants                                                           */
 /* ------------------------------------------------------------------ */
 
-#define MAX_REX_FILES    512
-#define MAX_VOICES       16
+#define MAX_VOICES       64   /* pool size: upper bound of the polyphony param */
+#define MIN_POLYPHONY    8
+#define DEFAULT_POLYPHONY 16
+#define NO_VOICE         0xFF
 #define FIRST_NOTE       36   /* C2 - first slice mapped here */
 #define LOAD_DEBOUNCE_BLOCKS 3 /* ~9ms debounce at 128 frames/block */
+#define DEFAULT_PREFETCH 1     /* files on each side decoded while browsing */
+#define MAX_PREFETCH     4
+#define DEFAULT_SLICE_CACHE_MB 8  /* decoded slices kept per instance (lazy) */
+#define MAX_SLICE_CACHE_MB 256
+#define MIDI_QUEUE_SIZE  256  /* events waiting for their frame */
+#define CTL_RING_SIZE    256  /* messages per ring (power of two) */
+#define PERF_WINDOW      1024 /* render blocks timed for perf_stats (~3s) */
 
 static const host_api_v1_t *g_host = NULL;
 
@@ -74,33 +109,44 @@ static void plugin_log(const char *msg) {
     }
 }
 
-static int json_get_number(const char *json, const char *key, float *out) {
-    char search[64];
-    snprintf(search, sizeof(search), "\"%s\":", key);
-    const char *pos = strstr(json, search);
-    if (!pos) return -1;
-    pos += strlen(search);
-    while (*pos == ' ') pos++;
-    *out = (float)atof(pos);
-    return 0;
+/* Copy a JSON string body starting after its opening quote into out
+ * (truncated to fit), undoing \" and \\ escapes. Returns the position
+ * after the closing quote. */
+static const char *json_read_string(const char *p, char *out, int out_len) {
+    int n = 0;
+    while (*p && *p != '"') {
+        if (*p == '\\' && p[1]) p++;
+        if (n < out_len - 1) out[n++] = *p;
+        p++;
+    }
+    out[n] = '\0';
+    return *p ? p + 1 : p;
 }
 
-static int json_get_string(const char *json, const char *key, char *out, int out_len) {
-    char search[64];
-    snprintf(search, sizeof(search), "\"%s\":", key);
-    const char *pos = strstr(json, search);
-    if (!pos) return -1;
-    pos += strlen(search);
-    while (*pos == ' ') pos++;
-    if (*pos != '"') return -1;
-    pos++;
-    const char *end = strchr(pos, '"');
-    if (!end) return -1;
-    int len = (int)(end - pos);
-    if (len >= out_len) len = out_len - 1;
-    memcpy(out, pos, len);
-    out[len] = '\0';
-    return len;
+/* Step through a flat JSON object one member at a time: "key": value at
+ * or after *p. Strings come back unescaped, anything else as its text.
+ * Returns 1 and moves *p past the member, or 0 at the end. */
+static int json_next_member(const char **p, char *key, int key_len, char *val, int val_len) {
+    const char *q = *p;
+    while (*q && *q != '"' && *q != '}') q++;
+    if (*q != '"') return 0;
+    q = json_read_string(q + 1, key, key_len);
+    while (*q == ' ') q++;
+    if (*q != ':') return 0;
+    q++;
+    while (*q == ' ') q++;
+    if (*q == '"') {
+        q = json_read_string(q + 1, val, val_len);
+    } else {
+        int n = 0;
+        while (*q && *q != ',' && *q != '}' && *q != ' ') {
+            if (n < val_len - 1) val[n++] = *q;
+            q++;
+        }
+        val[n] = '\0';
+    }
+    *p = q;
+    return 1;
 }
 
 /* Escape a string for JSON output (handles " and \) */
@@ -132,6 +178,7 @@ static int json_escape(char *dst, int dst_len, const char *src) {
 #define ADSR_RELEASE 4
 
 #define ADSR_MIN_TIME 0.001f  /* minimum segment time to avoid clicks */
+#define ADSR_FLOOR    0.0001f /* release below this level ends the voice */
 
 typedef struct {
     float value;      /* current envelope level 0.0-1.0 */
@@ -140,94 +187,358 @@ typedef struct {
     float decay;      /* seconds */
     float sustain;    /* level 0.0-1.0 */
     float release;    /* seconds */
+
+    /* Per-sample steps, computed once in adsr_trigger() */
+    float attack_inc;   /* added per sample while attacking */
+    float decay_inc;    /* subtracted per sample while decaying */
+    float release_coef; /* fraction of the level lost per sample */
 } adsr_t;
 
+static float adsr_segment_samples(float seconds) {
+    float t = (seconds > ADSR_MIN_TIME) ? seconds : ADSR_MIN_TIME;
+    return t * (float)MOVE_SAMPLE_RATE;
+}
+
 static void adsr_trigger(adsr_t *e) {
+    e->attack_inc = 1.0f / adsr_segment_samples(e->attack);
+    e->decay_inc = (1.0f - e->sustain) / adsr_segment_samples(e->decay);
+    e->release_coef = 1.0f / adsr_segment_samples(e->release);
     e->stage = ADSR_ATTACK;
     /* Start from current value to avoid clicks on retrigger */
 }
 
+/* Begin at full level: for a voice starting on a quiet frame, which has
+ * no click for the shortest attack to hide */
+static void adsr_skip_attack(adsr_t *e) {
+    e->value = 1.0f;
+    e->stage = ADSR_DECAY;
+}
+
 static void adsr_release(adsr_t *e) {
     if (e->stage != ADSR_IDLE) {
         e->stage = ADSR_RELEASE;
     }
 }
 
-static float adsr_process(adsr_t *e, float sample_rate) {
-    float rate;
-    switch (e->stage) {
-        case ADSR_ATTACK:
-            rate = (e->attack > ADSR_MIN_TIME) ? e->attack : ADSR_MIN_TIME;
-            e->value += 1.0f / (rate * sample_rate);
-            if (e->value >= 1.0f) {
-                e->value = 1.0f;
-                e->stage = ADSR_DECAY;
-            }
-            break;
-        case ADSR_DECAY:
-            rate = (e->decay > ADSR_MIN_TIME) ? e->decay : ADSR_MIN_TIME;
-            e->value -= (1.0f - e->sustain) / (rate * sample_rate);
-            if (e->value <= e->sustain) {
-                e->value = e->sustain;
-                e->stage = ADSR_SUSTAIN;
-            }
-            break;
-        case ADSR_SUSTAIN:
-            e->value = e->sustain;
-            break;
-        case ADSR_RELEASE:
-            rate = (e->release > ADSR_MIN_TIME) ? e->release : ADSR_MIN_TIME;
-            e->value -= e->value / (rate * sample_rate);
-            if (e->value < 0.0001f) {
-                e->value = 0.0f;
-                e->stage = ADSR_IDLE;
-            }
-            break;
-        default: /* ADSR_IDLE */
-            e->value = 0.0f;
-            break;
+/* Generate n envelope values into out. Returns n, or 0 if the envelope
+ * is idle. A release that falls under ADSR_FLOOR goes idle at the end of
+ * the call rather than on the exact sample, so voices retire per block.
+ *
+ * When the envelope holds one level for the whole call (sustain), out is
+ * not written and *level receives the level; otherwise *level is -1. */
+static int adsr_block(adsr_t *e, float *out, int n, float *level) {
+    *level = -1.0f;
+    if (e->stage == ADSR_IDLE) return 0;
+    if (e->stage == ADSR_SUSTAIN) {
+        e->value = e->sustain;
+        *level = e->sustain;
+        return n;
+    }
+
+    /* Work on a local copy: out may alias e as far as the compiler knows */
+    float v = e->value;
+    int i = 0;
+    while (i < n) {
+        switch (e->stage) {
+            case ADSR_ATTACK:
+                while (i < n) {
+                    v += e->attack_inc;
+                    if (v >= 1.0f) {
+                        v = 1.0f;
+                        e->stage = ADSR_DECAY;
+                        out[i++] = v;
+                        break;
+                    }
+                    out[i++] = v;
+                }
+                break;
+            case ADSR_DECAY:
+                while (i < n) {
+                    v -= e->decay_inc;
+                    if (v <= e->sustain) {
+                        v = e->sustain;
+                        e->stage = ADSR_SUSTAIN;
+                        out[i++] = v;
+                        break;
+                    }
+                    out[i++] = v;
+                }
+                break;
+            case ADSR_SUSTAIN:
+                for (; i < n; i++) out[i] = v;
+                break;
+            default: /* ADSR_RELEASE */
+                for (; i < n; i++) {
+                    v -= v * e->release_coef;
+                    out[i] = v;
+                }
+                if (v < ADSR_FLOOR) {
+                    v = 0.0f;
+                    e->stage = ADSR_IDLE;
+                }
+                break;
+        }
     }
-    return e->value;
+    e->value = v;
+    return n;
 }
 
+/* Voice pool, one struct of arrays indexed by voice id. Playing voices
+ * are kept in a compact, unordered active list for rendering; idle ids sit
+ * on a free list, and each note heads a chain of the voices it triggered,
+ * so allocation, note-off and retiring a voice don't scan the pool.
+ * Render thread only. */
 typedef struct {
-    int active;
-    int slice_index;
-    float position;     /* current playback position in slice (fractional samples) */
-    uint32_t age;       /* for voice stealing (oldest first) */
-    uint8_t note;       /* MIDI note that triggered this voice */
-    uint8_t velocity;   /* 0-127, for velocity scaling */
-    int gate;           /* 1 = key held, 0 = key released */
-    adsr_t env;         /* amplitude envelope */
-} voice_t;
+    int slice_index[MAX_VOICES];
+    float position[MAX_VOICES];   /* playback position in slice (fractional samples) */
+    uint32_t age[MAX_VOICES];     /* for voice stealing (oldest first) */
+    uint8_t note[MAX_VOICES];     /* MIDI note that triggered this voice */
+    uint8_t velocity[MAX_VOICES]; /* 0-127, for velocity scaling */
+    uint8_t gate[MAX_VOICES];     /* 1 = key held, 0 = key released */
+    uint8_t started[MAX_VOICES];  /* 0 until first rendered */
+    adsr_t env[MAX_VOICES];       /* amplitude envelope */
+
+    uint8_t active[MAX_VOICES];   /* ids of playing voices */
+    uint8_t active_slot[MAX_VOICES]; /* id -> index in active[] */
+    int active_count;
+    uint8_t free_ids[MAX_VOICES];
+    int free_count;
+
+    uint8_t note_head[128];       /* first voice on each note, or NO_VOICE */
+    uint8_t note_next[MAX_VOICES];
+    uint8_t note_prev[MAX_VOICES];
+
+    int polyphony;
+    uint32_t counter;
+    uint32_t steals;              /* voices taken from a playing note */
+    int peak;                     /* most voices playing at once */
+} voice_pool_t;
+
+/* Stop every voice and size the pool to polyphony voices */
+static void pool_reset(voice_pool_t *vp, int polyphony)
+{
+    vp->polyphony = polyphony;
+    vp->active_count = 0;
+    vp->free_count = 0;
+    for (int id = polyphony - 1; id >= 0; id--)
+        vp->free_ids[vp->free_count++] = (uint8_t)id;
+    memset(vp->note_head, NO_VOICE, sizeof(vp->note_head));
+}
 
-/* ------------------------------------------------------------------ */
-/* REX file entry                                                      */
-/* ------------------------------------------------------------------ */
+static void pool_unlink_note(voice_pool_t *vp, int id)
+{
+    uint8_t prev = vp->note_prev[id], next = vp->note_next[id];
+    if (prev != NO_VOICE) vp->note_next[prev] = next;
+    else vp->note_head[vp->note[id]] = next;
+    if (next != NO_VOICE) vp->note_prev[next] = prev;
+}
+
+static void pool_link_note(voice_pool_t *vp, int id, uint8_t note)
+{
+    vp->note[id] = note;
+    vp->note_prev[id] = NO_VOICE;
+    vp->note_next[id] = vp->note_head[note];
+    if (vp->note_head[note] != NO_VOICE) vp->note_prev[vp->note_head[note]] = (uint8_t)id;
+    vp->note_head[note] = (uint8_t)id;
+}
+
+/* Take a voice for note: a free one, or else steal the oldest playing */
+static int pool_start(voice_pool_t *vp, uint8_t note)
+{
+    int id;
+    if (vp->free_count > 0) {
+        id = vp->free_ids[--vp->free_count];
+        vp->active_slot[id] = (uint8_t)vp->active_count;
+        vp->active[vp->active_count++] = (uint8_t)id;
+    } else {
+        int best = 0;
+        for (int i = 1; i < vp->active_count; i++) {
+            if (vp->age[vp->active[i]] < vp->age[vp->active[best]]) best = i;
+        }
+        id = vp->active[best];
+        pool_unlink_note(vp, id);
+        vp->steals++;
+    }
+    if (vp->active_count > vp->peak) vp->peak = vp->active_count;
+    vp->age[id] = ++vp->counter;
+    pool_link_note(vp, id, note);
+    return id;
+}
+
+/* Retire a playing voice. Swaps the last active entry into its slot, so
+ * callers walking active[] should walk it backwards. */
+static void pool_stop(voice_pool_t *vp, int id)
+{
+    int slot = vp->active_slot[id];
+    uint8_t last = vp->active[--vp->active_count];
+    vp->active[slot] = last;
+    vp->active_slot[last] = (uint8_t)slot;
+    pool_unlink_note(vp, id);
+    vp->free_ids[vp->free_count++] = (uint8_t)id;
+}
+
+/* Lazy mode: one decoded slice, owned by the render thread */
+typedef struct {
+    int16_t *pcm;       /* decoded audio, NULL until delivered */
+    size_t bytes;
+    uint32_t last_use;  /* for eviction (least recently triggered first) */
+    int requested;      /* decode in flight on the loader worker */
+    int failed;         /* decode failed: don't ask again for this file */
+} slice_slot_t;
+
+/* MIDI message waiting for its frame in the next render_block */
+typedef struct {
+    int offset;         /* frames into the next block */
+    uint8_t msg[3];
+    uint8_t len;
+} midi_event_t;
 
+/* Settings the render thread works from: published whole by the control
+ * thread and adopted between blocks */
 typedef struct {
-    char path[512];
-    char name[128];
-} rex_entry_t;
+    float gain;
+    int start_note;
+    float attack;
+    float decay;
+    float sustain;
+    float release;
+    int mode;
+    int choke;
+    int snap;
+    float rate;                      /* playback rate for the transpose */
+    int interpolation;               /* RESAMPLE_* */
+    const resample_kernel_t *kernel; /* sinc kernel for rate, or NULL */
+    float overshoot;                 /* interpolation's bound over the peak */
+    int polyphony;
+    size_t slot_budget;
+} render_params_t;
+
+enum {
+    CTL_PARAMS,     /* new render_params_t */
+    CTL_LOAD,       /* start the load debounce for path */
+    CTL_PANIC,      /* all notes off */
+    CTL_PERF_RESET, /* restart the perf_stats counters */
+    CTL_MIDI        /* queue a MIDI event */
+};
+
+typedef struct {
+    int type;
+    const char *path;
+    render_params_t params;
+    midi_event_t midi;
+} ctl_msg_t;
+
+/* Single-producer/single-consumer ring to the render thread */
+typedef struct {
+    ctl_msg_t msgs[CTL_RING_SIZE];
+    atomic_uint head;
+    atomic_uint tail;
+} ctl_ring_t;
+
+/* Producer side. Returns -1 (message dropped) if the ring is full, which
+ * only happens if the render thread has stopped pulling. */
+static int ctl_push(ctl_ring_t *r, const ctl_msg_t *msg)
+{
+    unsigned head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (head - tail >= CTL_RING_SIZE) return -1;
+    r->msgs[head % CTL_RING_SIZE] = *msg;
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    return 0;
+}
+
+/* Render thread side. Returns 0 when the ring is empty. */
+static int ctl_pop(ctl_ring_t *r, ctl_msg_t *msg)
+{
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&r->head, memory_order_acquire);
+    if (tail == head) return 0;
+    *msg = r->msgs[tail % CTL_RING_SIZE];
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+/* Render thread counters for get_param("perf_stats"). The render thread
+ * is the only writer; readers may see a window a block out of date. */
+typedef struct {
+    atomic_uint block_ns[PERF_WINDOW];  /* latest render_block times */
+    atomic_uint blocks;                 /* render_block calls timed */
+    atomic_uint overruns;               /* blocks slower than real time */
+    atomic_uint frames;                 /* frames in the last block */
+    atomic_int voices;                  /* playing after the last block */
+    atomic_int voices_peak;
+    atomic_uint steals;
+    atomic_size_t pcm_bytes;            /* audio of the loaded file */
+    atomic_size_t slice_bytes;          /* lazy slice cache */
+} perf_counters_t;
+
+/* A get_param value the UI polls every tick, formatted again only when
+ * the number behind it changes */
+typedef struct {
+    double value;
+    int len;            /* 0 until first formatted */
+    char text[24];
+} cached_value_t;
 
 /* ------------------------------------------------------------------ */
 /* Per-Instance State                                                  */
 /* ------------------------------------------------------------------ */
 
 typedef struct {
-    /* Loaded REX file */
-    rex_file_t rex;
-    int rex_loaded;
+    /* Loaded REX file: a shared, read-only cache reference held by the
+     * render thread and swapped in by the loader */
+    const rex_file_t *rex;
+    rex_loader_t *loader;
+    uint32_t decoded;   /* rex_decoded_frames(rex), read once per block */
+
+    /* Loaded-file info for the control thread, which must not dereference
+     * rex while the loader may be retiring it: stored by the render thread
+     * in swap_loaded_file, relaxed since each is read on its own */
+    atomic_int slice_count;
+    _Atomic float tempo_bpm;
+
+    /* Lazy slice cache (render thread). rex_gen counts swaps so that
+     * deliveries for a replaced file are recognised and dropped. */
+    slice_slot_t slots[REX_MAX_SLICES];
+    unsigned rex_gen;
+    uint32_t slot_clock;
+    size_t slot_bytes;
+    int16_t *free_backlog[REX_MAX_SLICES * 2];  /* waiting for room to retire */
+    int free_backlog_count;
 
     /* Voice engine */
-    voice_t voices[MAX_VOICES];
-    uint32_t voice_counter;
-
-    /* File browser */
-    rex_entry_t files[MAX_REX_FILES];
+    voice_pool_t voices;
+    float mix_peak;     /* bound on |bus| over the sub-block being rendered */
+
+    /* MIDI in frame order, applied by render_block at each event's frame
+     * (render thread) */
+    midi_event_t midi_queue[MIDI_QUEUE_SIZE];
+    int midi_count;
+
+    /* Channels into the render thread: one per producer, since set_param
+     * and on_midi may be called from different threads */
+    ctl_ring_t ctl_ring;           /* set_param -> render */
+    ctl_ring_t midi_ring;          /* on_midi -> render */
+    render_params_t rt;            /* render thread's settings */
+    render_params_t published;     /* last snapshot sent (control thread) */
+
+    perf_counters_t perf;
+
+    /* File browser: the folder's shared catalog and the listing that
+     * file_count and file_index refer to */
+    rex_catalog_t *catalog;
+    const rex_catalog_view_t *view;
     int file_count;
     int file_index;
     char file_name[128];
+    int file_name_len;
+
+    /* get_param text kept for polling; state is rebuilt after a set */
+    cached_value_t slice_count_text;
+    cached_value_t tempo_text;
+    char state_text[1024];
+    int state_len;
+    int state_dirty;
 
     /* Parameters */
     float gain;
@@ -240,348 +551,1220 @@ typedef struct {
     float release;      /* 0.0 - 2.0 seconds */
     int mode;           /* 0 = trigger (one-shot), 1 = gate */
     int choke;          /* 0 = off (polyphonic), 1 = on (monophonic choke) */
+    int snap;           /* 1 = slices start and end on their quietest edge frames */
     int transpose;      /* -12 to +12 semitones, default 0 */
-
-    /* Deferred file loading (debounce for scrolling) */
-    int deferred_file_index;      /* file index waiting for debounce */
+    int interpolation;  /* RESAMPLE_* quality for pitched playback */
+    int prefetch;       /* neighbouring files decoded ahead, each direction */
+    int polyphony;      /* MIN_POLYPHONY - MAX_VOICES, applied by render */
+    size_t slot_budget; /* lazy slice cache size, applied by render */
+    int lazy;           /* 1 = decode slices on demand (REX_PARSE_LAZY) */
+    int planar;         /* REX_PLANAR_* slice buffers for non-lazy loads (opt-in) */
+    int depth;          /* 24 = keep 24-bit files' full precision (REX_PARSE_HIRES) */
+
+    /* Kit text (rex_kit.h), "" for the browsed file. kit_gen counts
+     * changes for v2_set_param; kit_on is set while a kit is what was
+     * last asked for, browsing to a file ending it. */
+    char kit[256];
+    unsigned kit_gen;
+    int kit_on;
+
+    /* Deferred file loading (debounce for scrolling, render thread) */
+    const char *deferred_path;    /* file waiting for debounce (catalog string) */
     int deferred_load_countdown;  /* render blocks remaining before loading */
 
     /* Module info */
     char module_dir[512];
-    char load_error[256];
 } rex_instance_t;
 
 /* ------------------------------------------------------------------ */
 /* File scanning                                                       */
 /* ------------------------------------------------------------------ */
 
-static int rex_entry_cmp(const void *a, const void *b) {
-    return strcasecmp(((const rex_entry_t *)a)->name, ((const rex_entry_t *)b)->name);
+/* Browse dir_path through its shared catalog (loops with their header
+ * metadata, listed through the folder's index) */
+static void scan_rex_files(rex_instance_t *inst, const char *dir_path)
+{
+    rex_catalog_close(inst->catalog);
+    inst->catalog = rex_catalog_open(dir_path);
+    inst->view = inst->catalog ? rex_catalog_current(inst->catalog) : NULL;
+    inst->file_count = inst->view ? rex_catalog_count(inst->view) : 0;
+    inst->file_index = 0;
+
+    char msg[64];
+    snprintf(msg, sizeof(msg), "Found %d REX files", inst->file_count);
+    plugin_log(msg);
 }
 
-static void scan_rex_files(rex_instance_t *inst, const char *dir_path)
+/* Control thread, before browsing: pick up files added or removed since
+ * the listing was taken. The selection follows its file to its new index,
+ * or stays at the same position if that file is gone. */
+static void refresh_rex_files(rex_instance_t *inst)
 {
-    inst->file_count = 0;
+    if (!inst->catalog) return;
+    const rex_catalog_view_t *view = rex_catalog_refresh(inst->catalog);
+    if (view == inst->view) return;
 
-    DIR *dir = opendir(dir_path);
-    if (!dir) {
-        plugin_log("Cannot open rex directory");
-        return;
+    int idx = -1;
+    if (inst->file_count > 0) {
+        idx = rex_catalog_find_path(view, rex_catalog_path(inst->view, inst->file_index));
     }
+    inst->view = view;
+    inst->file_count = rex_catalog_count(view);
+    if (idx < 0) idx = inst->file_index < inst->file_count ? inst->file_index : 0;
+    inst->file_index = idx;
+}
 
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL && inst->file_count < MAX_REX_FILES) {
-        if (entry->d_name[0] == '.') continue;
+/* ------------------------------------------------------------------ */
+/* Load REX file                                                       */
+/* ------------------------------------------------------------------ */
 
-        const char *ext = strrchr(entry->d_name, '.');
-        if (!ext) continue;
+/* Render thread: hand a decoded slice back to the loader to be freed */
+static void retire_slice_pcm(rex_instance_t *inst, int16_t *pcm)
+{
+    if (!pcm) return;
+    if (rex_loader_free_slice(inst->loader, pcm) != 0)
+        inst->free_backlog[inst->free_backlog_count++] = pcm;
+}
 
-        if (strcasecmp(ext, ".rx2") != 0 &&
-            strcasecmp(ext, ".rex") != 0 &&
-            strcasecmp(ext, ".rcy") != 0) continue;
+/* Render thread: drop every decoded slice (file replaced) */
+static void flush_slices(rex_instance_t *inst)
+{
+    for (int i = 0; i < REX_MAX_SLICES; i++) {
+        slice_slot_t *s = &inst->slots[i];
+        retire_slice_pcm(inst, s->pcm);
+        memset(s, 0, sizeof(*s));
+    }
+    inst->slot_bytes = 0;
+}
 
-        rex_entry_t *f = &inst->files[inst->file_count];
-        snprintf(f->path, sizeof(f->path), "%s/%s", dir_path, entry->d_name);
+static void request_slice(rex_instance_t *inst, int idx)
+{
+    slice_slot_t *s = &inst->slots[idx];
+    if (s->pcm || s->requested || s->failed) return;
+    if (rex_loader_request_slice(inst->loader, inst->rex, inst->rex_gen, idx) == 0)
+        s->requested = 1;
+    /* Queue full: the waiting voice asks again next block */
+}
 
-        /* Strip extension for display name */
-        int name_len = (int)(ext - entry->d_name);
-        if (name_len >= (int)sizeof(f->name)) name_len = sizeof(f->name) - 1;
-        memcpy(f->name, entry->d_name, name_len);
-        f->name[name_len] = '\0';
+/* Render thread: install decoded slices, then evict least recently
+ * triggered idle slices until the slice cache is back under budget. */
+static void collect_slices(rex_instance_t *inst)
+{
+    while (inst->free_backlog_count > 0 &&
+           rex_loader_free_slice(inst->loader,
+                                 inst->free_backlog[inst->free_backlog_count - 1]) == 0) {
+        inst->free_backlog_count--;
+    }
 
-        inst->file_count++;
+    unsigned gen;
+    int idx;
+    int16_t *pcm;
+    while (inst->free_backlog_count < REX_MAX_SLICES &&
+           rex_loader_take_slice(inst->loader, &gen, &idx, &pcm)) {
+        slice_slot_t *s = &inst->slots[idx];
+        if (gen != inst->rex_gen || s->pcm) {
+            retire_slice_pcm(inst, pcm);
+            continue;
+        }
+        s->requested = 0;
+        if (!pcm) {
+            s->failed = 1;
+            continue;
+        }
+        s->pcm = pcm;
+        s->bytes = (size_t)inst->rex->slices[idx].sample_length *
+                   inst->rex->pcm_channels * sizeof(int16_t);
+        inst->slot_bytes += s->bytes;
     }
 
-    closedir(dir);
+    if (inst->slot_bytes <= inst->rt.slot_budget) return;
 
-    if (inst->file_count > 1) {
-        qsort(inst->files, inst->file_count, sizeof(rex_entry_t), rex_entry_cmp);
+    uint8_t busy[REX_MAX_SLICES] = {0};
+    for (int i = 0; i < inst->voices.active_count; i++) {
+        busy[inst->voices.slice_index[inst->voices.active[i]]] = 1;
+    }
+    while (inst->slot_bytes > inst->rt.slot_budget) {
+        int victim = -1;
+        for (int i = 0; i < inst->rex->slice_count; i++) {
+            const slice_slot_t *s = &inst->slots[i];
+            if (!s->pcm || busy[i]) continue;
+            if (victim < 0 || s->last_use < inst->slots[victim].last_use) victim = i;
+        }
+        if (victim < 0) break;  /* everything resident is playing */
+        slice_slot_t *s = &inst->slots[victim];
+        retire_slice_pcm(inst, s->pcm);
+        inst->slot_bytes -= s->bytes;
+        s->pcm = NULL;
+        s->bytes = 0;
     }
-
-    char msg[64];
-    snprintf(msg, sizeof(msg), "Found %d REX files", inst->file_count);
-    plugin_log(msg);
 }
 
-/* ------------------------------------------------------------------ */
-/* Load REX file                                                       */
-/* ------------------------------------------------------------------ */
+/* Render thread: adopt a newly loaded file if the loader has one ready.
+ * The outgoing file goes back to the loader to be freed off this thread. */
+static void swap_loaded_file(rex_instance_t *inst)
+{
+    const rex_file_t *next = rex_loader_swap(inst->loader, inst->rex);
+    if (!next) return;
+
+    inst->rex = next;
+    inst->rex_gen++;
+    flush_slices(inst);
+
+    /* Stop all voices (slice layout changed) */
+    pool_reset(&inst->voices, inst->voices.polyphony);
 
-static int load_rex_file(rex_instance_t *inst, const char *path)
+    atomic_store_explicit(&inst->slice_count, next->kit ? next->kit : next->slice_count,
+                          memory_order_relaxed);
+    atomic_store_explicit(&inst->tempo_bpm, next->tempo_bpm, memory_order_relaxed);
+
+    size_t bytes = next->lazy ? next->sdat_len
+                 : (size_t)next->pcm_samples * next->pcm_channels * sizeof(int16_t) +
+                   next->planar_bytes;
+    atomic_store_explicit(&inst->perf.pcm_bytes, bytes, memory_order_relaxed);
+}
+
+/* Queue the files around file_index for idle-priority decoding:
+ * +1, -1, +2, -2, ... out to inst->prefetch steps in each direction. */
+static void update_prefetch(rex_instance_t *inst)
 {
-    /* Read file into memory */
-    FILE *fp = fopen(path, "rb");
-    if (!fp) {
-        snprintf(inst->load_error, sizeof(inst->load_error), "Cannot open file");
-        plugin_log(inst->load_error);
-        return -1;
+    const char *paths[REX_LOADER_PREFETCH_MAX];
+    int count = 0;
+
+    for (int d = 1; d <= inst->prefetch && count + 2 <= REX_LOADER_PREFETCH_MAX; d++) {
+        if (2 * d >= inst->file_count + 1) break;  /* wrapped onto itself */
+        paths[count++] = rex_catalog_path(inst->view, (inst->file_index + d) % inst->file_count);
+        if (2 * d == inst->file_count) break;      /* +d and -d coincide */
+        paths[count++] = rex_catalog_path(inst->view,
+                                          (inst->file_index - d + inst->file_count) % inst->file_count);
     }
 
-    fseek(fp, 0, SEEK_END);
-    long file_size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
+    rex_loader_prefetch(inst->loader, paths, count);
+}
 
-    if (file_size <= 0 || file_size > 50 * 1024 * 1024) {  /* 50MB max */
-        snprintf(inst->load_error, sizeof(inst->load_error), "File too large or empty");
-        fclose(fp);
-        return -1;
-    }
+/* Control thread: pass msg to the render thread */
+static void send_control(rex_instance_t *inst, const ctl_msg_t *msg)
+{
+    if (ctl_push(&inst->ctl_ring, msg) != 0)
+        plugin_log("control ring full, change dropped");
+}
 
-    uint8_t *buf = (uint8_t *)malloc(file_size);
-    if (!buf) {
-        snprintf(inst->load_error, sizeof(inst->load_error), "Out of memory");
-        fclose(fp);
-        return -1;
-    }
+/* The render settings as the control thread currently has them */
+static void snapshot_params(const rex_instance_t *inst, render_params_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->gain = inst->gain;
+    p->start_note = inst->start_note;
+    p->attack = inst->attack;
+    p->decay = inst->decay;
+    p->sustain = inst->sustain;
+    p->release = inst->release;
+    p->mode = inst->mode;
+    p->choke = inst->choke;
+    p->snap = inst->snap;
+    p->rate = powf(2.0f, inst->transpose / 12.0f);
+    p->interpolation = inst->interpolation;
+    p->kernel = resample_kernel(inst->interpolation, p->rate);
+    if (p->interpolation >= RESAMPLE_SINC8 && !p->kernel)
+        p->interpolation = RESAMPLE_HERMITE;  /* no memory for the table */
+    p->overshoot = p->kernel ? p->kernel->gain
+                 : p->interpolation == RESAMPLE_HERMITE ? RESAMPLE_HERMITE_GAIN
+                 : RESAMPLE_LINEAR_GAIN;
+    p->polyphony = inst->polyphony;
+    p->slot_budget = inst->slot_budget;
+}
+
+/* Control thread, after a set_param: send the settings if they changed */
+static void publish_params(rex_instance_t *inst)
+{
+    ctl_msg_t msg = { .type = CTL_PARAMS };
+    snapshot_params(inst, &msg.params);
+    if (memcmp(&msg.params, &inst->published, sizeof(msg.params)) == 0) return;
+    inst->published = msg.params;
+    send_control(inst, &msg);
+}
+
+static void set_file_name(rex_instance_t *inst, const char *name)
+{
+    inst->file_name_len = snprintf(inst->file_name, sizeof(inst->file_name), "%s", name);
+    if (inst->file_name_len >= (int)sizeof(inst->file_name))
+        inst->file_name_len = sizeof(inst->file_name) - 1;
+    inst->state_dirty = 1;
+}
 
-    size_t read_bytes = fread(buf, 1, file_size, fp);
-    fclose(fp);
+/* Control thread: select a file for the browser. The index and display
+ * name update immediately for a responsive UI; the load itself waits for
+ * the debounce in render_block so fast scrolling doesn't load every file. */
+static void select_file(rex_instance_t *inst, int idx)
+{
+    inst->kit[0] = '\0';
+    inst->kit_on = 0;
+    inst->file_index = idx;
+    set_file_name(inst, rex_catalog_name(inst->view, idx));
+    ctl_msg_t msg = { .type = CTL_LOAD, .path = rex_catalog_path(inst->view, idx) };
+    send_control(inst, &msg);
+    update_prefetch(inst);
+}
 
-    if ((long)read_bytes != file_size) {
-        snprintf(inst->load_error, sizeof(inst->load_error), "Read error");
-        free(buf);
-        return -1;
+/* Control thread: resolve the kit's loop names in the folder and hand
+ * it to the loader. Returns the path to request it with, or NULL (the
+ * reason logged) if the text does not describe a kit. */
+static const char *prepare_kit(rex_instance_t *inst)
+{
+    char err[256];
+    rex_kit_spec_t spec;
+    if (rex_kit_parse(&spec, inst->kit, inst->start_note, err, sizeof(err)) != 0)
+        goto bad;
+
+    refresh_rex_files(inst);
+    for (int i = 0; i < spec.zone_count; i++) {
+        rex_kit_zone_t *z = &spec.zones[i];
+        int idx = inst->file_count > 0 ? rex_catalog_find_name(inst->view, z->name) : -1;
+        if (idx < 0) {
+            snprintf(err, sizeof(err), "No loop named %s", z->name);
+            goto bad;
+        }
+        z->path = rex_catalog_path(inst->view, idx);
     }
 
-    /* Parse into temporary struct so we don't destroy current audio on failure */
-    rex_file_t new_rex;
-    int rc = rex_parse(&new_rex, buf, file_size);
-    free(buf);  /* parser copies what it needs */
+    char name[64];
+    snprintf(name, sizeof(name), "Kit (%d zone%s)", spec.zone_count,
+             spec.zone_count == 1 ? "" : "s");
+    set_file_name(inst, name);
+    return rex_loader_set_kit(inst->loader, &spec);
 
-    if (rc != 0) {
-        snprintf(inst->load_error, sizeof(inst->load_error), "%s", new_rex.error);
-        plugin_log(inst->load_error);
-        rex_free(&new_rex);
-        return -1;
+bad: {
+        char msg[250];  /* what plugin_log has room for after "[rex] " */
+        snprintf(msg, sizeof(msg), "Kit not loaded: %.*s", (int)(sizeof(msg) - 17), err);
+        plugin_log(msg);
     }
+    return NULL;
+}
 
-    /* Success — now swap: free old data and replace */
-    if (inst->rex_loaded) {
-        rex_free(&inst->rex);
+/* Control thread, after the kit text changed: load the kit through the
+ * normal deferred path, or go back to the browsed file when it is
+ * cleared. A kit that fails to resolve leaves what is playing. */
+static void apply_kit(rex_instance_t *inst)
+{
+    if (!inst->kit[0]) {
+        if (inst->kit_on && inst->file_count > 0) select_file(inst, inst->file_index);
+        inst->kit_on = 0;
+        return;
     }
-    inst->rex = new_rex;
+    const char *path = prepare_kit(inst);
+    if (!path) return;
+    inst->kit_on = 1;
+    ctl_msg_t msg = { .type = CTL_LOAD, .path = path };
+    send_control(inst, &msg);
+}
 
-    /* Stop all voices (slice layout changed) */
-    for (int i = 0; i < MAX_VOICES; i++) {
-        inst->voices[i].active = 0;
-    }
-
-    inst->rex_loaded = 1;
-    inst->load_error[0] = '\0';
-
-    /* Extract display name */
-    const char *fname = strrchr(path, '/');
-    fname = fname ? fname + 1 : path;
-    const char *ext = strrchr(fname, '.');
-    int name_len = ext ? (int)(ext - fname) : (int)strlen(fname);
-    if (name_len >= (int)sizeof(inst->file_name)) name_len = sizeof(inst->file_name) - 1;
-    memcpy(inst->file_name, fname, name_len);
-    inst->file_name[name_len] = '\0';
-
-    char msg[256];
-    snprintf(msg, sizeof(msg), "Loaded: %s (%d slices, %d samples, %.1f BPM)",
-             inst->file_name, inst->rex.slice_count, inst->rex.pcm_samples,
-             inst->rex.tempo_bpm);
-    plugin_log(msg);
+/* Decoded-loop cache budget is shared by all instances in the process */
+static void set_cache_budget_mb(float mb)
+{
+    if (mb < 0.0f) mb = 0.0f;
+    if (mb > 1024.0f) mb = 1024.0f;
+    rex_cache_set_budget((size_t)(mb * 1024.0f * 1024.0f));
+}
 
-    return 0;
+static void set_slice_cache_mb(rex_instance_t *inst, float mb)
+{
+    if (mb < 0.0f) mb = 0.0f;
+    if (mb > MAX_SLICE_CACHE_MB) mb = MAX_SLICE_CACHE_MB;
+    inst->slot_budget = (size_t)(mb * 1024.0f * 1024.0f);
+}
+
+static int clamp_polyphony(int n)
+{
+    if (n < MIN_POLYPHONY) n = MIN_POLYPHONY;
+    if (n > MAX_VOICES) n = MAX_VOICES;
+    return n;
+}
+
+/* REX_PARSE_* flags for the current lazy/planar/depth settings. Only
+ * planar slice buffers hold more than 16 bits, so depth needs one. Full
+ * loads are progressive: the first slices play while the rest decode. */
+static int load_flags(const rex_instance_t *inst)
+{
+    if (inst->lazy) return REX_PARSE_LAZY;
+    int hires = inst->depth == 24 ? REX_PARSE_HIRES : 0;
+    if (inst->planar == REX_PLANAR_F32) return REX_PARSE_PROGRESSIVE | REX_PARSE_PLANAR_F32 | hires;
+    if (inst->planar == REX_PLANAR_I16) return REX_PARSE_PROGRESSIVE | REX_PARSE_PLANAR_I16 | hires;
+    return REX_PARSE_PROGRESSIVE;
+}
+
+/* Control thread, after lazy, planar or depth changed: switch between full and
+ * lazy decoding, or between slice buffer formats. The current file or kit
+ * is loaded again in the new mode through the normal deferred path. */
+static void apply_load_mode(rex_instance_t *inst)
+{
+    rex_loader_set_flags(inst->loader, load_flags(inst));
+    if (inst->kit_on) apply_kit(inst);
+    else if (inst->file_count > 0) select_file(inst, inst->file_index);
+}
+
+static int parse_planar(const char *val)
+{
+    if (strcmp(val, "float") == 0) return REX_PLANAR_F32;
+    if (strcmp(val, "int16") == 0) return REX_PLANAR_I16;
+    if (strcmp(val, "off") == 0) return REX_PLANAR_NONE;
+    return -1;
+}
+
+static const char *planar_name(int planar)
+{
+    return planar == REX_PLANAR_F32 ? "float" : planar == REX_PLANAR_I16 ? "int16" : "off";
 }
 
 /* ------------------------------------------------------------------ */
-/* V2 API: create_instance                                             */
+/* Parameters                                                          */
 /* ------------------------------------------------------------------ */
 
-static void* v2_create_instance(const char *module_dir, const char *json_defaults)
-{
-    rex_instance_t *inst = (rex_instance_t *)calloc(1, sizeof(rex_instance_t));
-    if (!inst) return NULL;
+/* Each key has a setter taking the value as text and a getter
+ * formatting it, either of which may be missing. Setters only store the
+ * new value: v2_set_param carries out whatever a change needs on a live
+ * instance, so module defaults and state restore share them. */
 
-    strncpy(inst->module_dir, module_dir, sizeof(inst->module_dir) - 1);
-    inst->gain = 1.0f;
-    inst->start_note = FIRST_NOTE;
-    inst->file_index = 0;
-    strcpy(inst->file_name, "No REX loaded");
+static float clamp_float(float v, float lo, float hi)
+{
+    if (v < lo) v = lo;
+    if (v > hi) v = hi;
+    return v;
+}
 
-    /* Envelope defaults: transparent (instant attack, full sustain, no release) */
-    inst->attack = 0.0f;
-    inst->decay = 0.0f;
-    inst->sustain = 1.0f;
-    inst->release = 0.0f;
-    inst->mode = 0;   /* trigger (one-shot) */
-    inst->choke = 0;  /* off (polyphonic) */
-    inst->transpose = 0;
+static int clamp_int(int v, int lo, int hi)
+{
+    if (v < lo) v = lo;
+    if (v > hi) v = hi;
+    return v;
+}
 
-    /* Scan for REX files */
-    char rex_dir[512];
-    snprintf(rex_dir, sizeof(rex_dir), "%s/loops", module_dir);
-    scan_rex_files(inst, rex_dir);
+/* Copy text of length len that is already formatted, truncated to fit.
+ * Returns the length copied. */
+static int put_text(char *buf, int buf_len, const char *text, int len)
+{
+    if (buf_len <= 0) return 0;
+    int n = len < buf_len - 1 ? len : buf_len - 1;
+    memcpy(buf, text, n);
+    buf[n] = '\0';
+    return n;
+}
 
-    /* If no files in loops/, try module dir itself */
-    if (inst->file_count == 0) {
-        scan_rex_files(inst, module_dir);
+/* Like snprintf(buf, buf_len, fmt, value), formatting only when value
+ * differs from last time */
+static int put_cached(cached_value_t *c, double value, const char *fmt,
+                      char *buf, int buf_len)
+{
+    if (c->len == 0 || c->value != value) {
+        c->value = value;
+        c->len = snprintf(c->text, sizeof(c->text), fmt, value);
     }
+    put_text(buf, buf_len, c->text, c->len);
+    return c->len;
+}
 
-    /* Restore state from defaults if provided */
-    if (json_defaults && json_defaults[0]) {
-        char name[128];
-        float f;
-
-        if (json_get_string(json_defaults, "file_name", name, sizeof(name)) > 0) {
-            /* Find file by name */
-            for (int i = 0; i < inst->file_count; i++) {
-                if (strcmp(inst->files[i].name, name) == 0) {
-                    inst->file_index = i;
-                    break;
-                }
-            }
-        }
+/* --- File browser --- */
 
-        if (json_get_number(json_defaults, "gain", &f) == 0) {
-            inst->gain = f;
-            if (inst->gain < 0.0f) inst->gain = 0.0f;
-            if (inst->gain > 2.0f) inst->gain = 2.0f;
-        }
-        if (json_get_number(json_defaults, "start_note", &f) == 0) {
-            inst->start_note = (int)f;
-            if (inst->start_note < 0) inst->start_note = 0;
-            if (inst->start_note > 127) inst->start_note = 127;
-        }
-        if (json_get_number(json_defaults, "attack", &f) == 0) {
-            inst->attack = f;
-            if (inst->attack < 0.0f) inst->attack = 0.0f;
-            if (inst->attack > 2.0f) inst->attack = 2.0f;
-        }
-        if (json_get_number(json_defaults, "decay", &f) == 0) {
-            inst->decay = f;
-            if (inst->decay < 0.0f) inst->decay = 0.0f;
-            if (inst->decay > 2.0f) inst->decay = 2.0f;
-        }
-        if (json_get_number(json_defaults, "sustain", &f) == 0) {
-            inst->sustain = f;
-            if (inst->sustain < 0.0f) inst->sustain = 0.0f;
-            if (inst->sustain > 1.0f) inst->sustain = 1.0f;
-        }
-        if (json_get_number(json_defaults, "release", &f) == 0) {
-            inst->release = f;
-            if (inst->release < 0.0f) inst->release = 0.0f;
-            if (inst->release > 2.0f) inst->release = 2.0f;
-        }
-        if (json_get_number(json_defaults, "transpose", &f) == 0) {
-            inst->transpose = (int)f;
-            if (inst->transpose < -12) inst->transpose = -12;
-            if (inst->transpose > 12) inst->transpose = 12;
-        }
-        {
-            char str[16];
-            if (json_get_string(json_defaults, "mode", str, sizeof(str)) > 0) {
-                if (strcmp(str, "trigger") == 0) inst->mode = 0;
-                else if (strcmp(str, "gate") == 0) inst->mode = 1;
-            }
-            if (json_get_string(json_defaults, "choke", str, sizeof(str)) > 0) {
-                if (strcmp(str, "off") == 0) inst->choke = 0;
-                else if (strcmp(str, "on") == 0) inst->choke = 1;
-            }
-        }
+static void set_file_index(rex_instance_t *inst, const char *val)
+{
+    int idx = atoi(val);
+    refresh_rex_files(inst);
+    if (idx >= 0 && idx < inst->file_count && idx != inst->file_index) {
+        select_file(inst, idx);
     }
+}
 
-    /* Load first/selected file */
+static void set_next_file(rex_instance_t *inst, const char *val)
+{
+    refresh_rex_files(inst);
     if (inst->file_count > 0) {
-        load_rex_file(inst, inst->files[inst->file_index].path);
+        select_file(inst, (inst->file_index + 1) % inst->file_count);
     }
+}
 
-    plugin_log("REX Player initialized");
-    return inst;
+static void set_prev_file(rex_instance_t *inst, const char *val)
+{
+    refresh_rex_files(inst);
+    if (inst->file_count > 0) {
+        select_file(inst, (inst->file_index - 1 + inst->file_count) % inst->file_count);
+    }
 }
 
-/* ------------------------------------------------------------------ */
-/* V2 API: destroy_instance                                            */
-/* ------------------------------------------------------------------ */
+static int get_file_index(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%d", inst->file_index);
+}
 
-static void v2_destroy_instance(void *instance)
+static int get_file_name(rex_instance_t *inst, char *buf, int buf_len)
 {
-    rex_instance_t *inst = (rex_instance_t *)instance;
-    if (!inst) return;
+    return put_text(buf, buf_len, inst->file_name, inst->file_name_len);
+}
 
-    if (inst->rex_loaded) {
-        rex_free(&inst->rex);
-    }
+static int get_file_count(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%d", inst->file_count);
+}
 
-    free(inst);
-    plugin_log("REX Player destroyed");
+/* Header metadata of the selected file, available before it loads */
+static int get_preset_info(rex_instance_t *inst, char *buf, int buf_len)
+{
+    if (inst->file_count == 0) return -1;
+    const rex_loop_info_t *e = rex_catalog_info(inst->view, inst->file_index);
+    if (!e->scanned) return snprintf(buf, buf_len, "{\"scanned\":false}");
+    return snprintf(buf, buf_len,
+        "{\"scanned\":true,\"tempo\":%.2f,\"bars\":%d,\"beats\":%d,"
+        "\"slices\":%d,\"channels\":%d,\"frames\":%u}",
+        e->tempo_bpm, e->bars, e->beats, e->slice_count, e->channels, e->frames);
 }
 
-/* ------------------------------------------------------------------ */
-/* V2 API: on_midi                                                     */
-/* ------------------------------------------------------------------ */
+/* For chain compatibility: bank = folder */
+static int get_bank_name(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return put_text(buf, buf_len, "REX Loops", 9);
+}
 
-static void v2_on_midi(void *instance, const uint8_t *msg, int len, int source)
+static int get_patch_in_bank(rex_instance_t *inst, char *buf, int buf_len)
 {
-    rex_instance_t *inst = (rex_instance_t *)instance;
-    if (!inst || !inst->rex_loaded || len < 2) return;
+    return snprintf(buf, buf_len, "%d", inst->file_index + 1);
+}
 
-    uint8_t status = msg[0] & 0xF0;
-    uint8_t note = msg[1];
-    uint8_t velocity = (len > 2) ? msg[2] : 0;
+static int get_bank_count(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "1");
+}
 
-    if (status == 0x90 && velocity > 0) {
-        /* Note On - trigger slice */
-        int slice_index = (int)note - inst->start_note;
-        if (slice_index < 0 || slice_index >= inst->rex.slice_count) return;
+/* --- Loaded file (polled by the UI on every draw) --- */
 
-        /* Check slice has audio */
-        rex_slice_t *slice = &inst->rex.slices[slice_index];
-        if (slice->sample_length == 0) return;
+static int get_slice_count(rex_instance_t *inst, char *buf, int buf_len)
+{
+    int count = atomic_load_explicit(&inst->slice_count, memory_order_relaxed);
+    return put_cached(&inst->slice_count_text, count, "%.0f", buf, buf_len);
+}
 
-        /* Choke: silence all other active voices */
-        if (inst->choke) {
-            for (int i = 0; i < MAX_VOICES; i++) {
-                inst->voices[i].active = 0;
-            }
-        }
+static int get_tempo(rex_instance_t *inst, char *buf, int buf_len)
+{
+    if (atomic_load_explicit(&inst->slice_count, memory_order_relaxed) > 0) {
+        float tempo = atomic_load_explicit(&inst->tempo_bpm, memory_order_relaxed);
+        return put_cached(&inst->tempo_text, tempo, "%.1f", buf, buf_len);
+    }
+    return snprintf(buf, buf_len, "0");
+}
 
-        /* Find a free voice, or steal the oldest */
-        int best = -1;
-        uint32_t oldest_age = UINT32_MAX;
+/* --- Playback --- */
 
-        for (int i = 0; i < MAX_VOICES; i++) {
-            if (!inst->voices[i].active) {
-                best = i;
-                break;
-            }
-            if (inst->voices[i].age < oldest_age) {
-                oldest_age = inst->voices[i].age;
-                best = i;
-            }
-        }
+static void set_gain(rex_instance_t *inst, const char *val)
+{
+    inst->gain = clamp_float((float)atof(val), 0.0f, 2.0f);
+}
 
-        if (best < 0) best = 0;  /* shouldn't happen */
+static int get_gain(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%.2f", inst->gain);
+}
 
-        voice_t *v = &inst->voices[best];
-        v->active = 1;
-        v->slice_index = slice_index;
-        v->position = 0;
-        v->age = ++inst->voice_counter;
-        v->note = note;
-        v->velocity = velocity;
-        v->gate = 1;
+static void set_start_note(rex_instance_t *inst, const char *val)
+{
+    inst->start_note = clamp_int(atoi(val), 0, 127);
+}
 
-        /* Initialize and trigger envelope */
-        v->env.attack = inst->attack;
-        v->env.decay = inst->decay;
-        v->env.sustain = inst->sustain;
-        v->env.release = inst->release;
-        v->env.value = 0.0f;
-        adsr_trigger(&v->env);
-    }
+static int get_start_note(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%d", inst->start_note);
+}
+
+static void set_attack(rex_instance_t *inst, const char *val)
+{
+    inst->attack = clamp_float((float)atof(val), 0.0f, 2.0f);
+}
+
+static int get_attack(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%.3f", inst->attack);
+}
+
+static void set_decay(rex_instance_t *inst, const char *val)
+{
+    inst->decay = clamp_float((float)atof(val), 0.0f, 2.0f);
+}
+
+static int get_decay(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%.3f", inst->decay);
+}
+
+static void set_sustain(rex_instance_t *inst, const char *val)
+{
+    inst->sustain = clamp_float((float)atof(val), 0.0f, 1.0f);
+}
+
+static int get_sustain(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%.3f", inst->sustain);
+}
+
+static void set_release(rex_instance_t *inst, const char *val)
+{
+    inst->release = clamp_float((float)atof(val), 0.0f, 2.0f);
+}
+
+static int get_release(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%.3f", inst->release);
+}
+
+static void set_mode(rex_instance_t *inst, const char *val)
+{
+    if (strcmp(val, "trigger") == 0) inst->mode = 0;
+    else if (strcmp(val, "gate") == 0) inst->mode = 1;
+}
+
+static int get_mode(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%s", inst->mode ? "gate" : "trigger");
+}
+
+static void set_choke(rex_instance_t *inst, const char *val)
+{
+    if (strcmp(val, "off") == 0) inst->choke = 0;
+    else if (strcmp(val, "on") == 0) inst->choke = 1;
+}
+
+static int get_choke(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%s", inst->choke ? "on" : "off");
+}
+
+static void set_snap(rex_instance_t *inst, const char *val)
+{
+    if (strcmp(val, "off") == 0) inst->snap = 0;
+    else if (strcmp(val, "on") == 0) inst->snap = 1;
+}
+
+static int get_snap(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%s", inst->snap ? "on" : "off");
+}
+
+static void set_transpose(rex_instance_t *inst, const char *val)
+{
+    inst->transpose = clamp_int(atoi(val), -12, 12);
+}
+
+static int get_transpose(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%d", inst->transpose);
+}
+
+static void set_polyphony(rex_instance_t *inst, const char *val)
+{
+    inst->polyphony = clamp_polyphony(atoi(val));
+}
+
+static int get_polyphony(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%d", inst->polyphony);
+}
+
+static void set_interpolation(rex_instance_t *inst, const char *val)
+{
+    int q = resample_parse_quality(val);
+    if (q >= 0) inst->interpolation = q;
+}
+
+static int get_interpolation(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%s", resample_quality_name(inst->interpolation));
+}
+
+static void set_panic(rex_instance_t *inst, const char *val)
+{
+    ctl_msg_t msg = { .type = CTL_PANIC };  /* the render thread owns the voices */
+    send_control(inst, &msg);
+}
+
+/* --- Loading and memory --- */
+
+/* Process-wide, like disk_cache */
+static void set_cache_mb(rex_instance_t *inst, const char *val)
+{
+    set_cache_budget_mb((float)atof(val));
+}
+
+static int get_cache_mb(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%d", (int)(rex_cache_get_budget() / (1024 * 1024)));
+}
+
+static void set_disk_cache(rex_instance_t *inst, const char *val)
+{
+    if (strcmp(val, "off") == 0) rex_sidecar_set_enabled(0);
+    else if (strcmp(val, "on") == 0) rex_sidecar_set_enabled(1);
+}
+
+static int get_disk_cache(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%s", rex_sidecar_enabled() ? "on" : "off");
+}
+
+static void set_prefetch(rex_instance_t *inst, const char *val)
+{
+    inst->prefetch = clamp_int(atoi(val), 0, MAX_PREFETCH);
+}
+
+static int get_prefetch(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%d", inst->prefetch);
+}
+
+static void set_lazy(rex_instance_t *inst, const char *val)
+{
+    if (strcmp(val, "off") == 0) inst->lazy = 0;
+    else if (strcmp(val, "on") == 0) inst->lazy = 1;
+}
+
+static int get_lazy(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%s", inst->lazy ? "on" : "off");
+}
+
+static void set_planar(rex_instance_t *inst, const char *val)
+{
+    int planar = parse_planar(val);
+    if (planar >= 0) inst->planar = planar;
+}
+
+static int get_planar(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%s", planar_name(inst->planar));
+}
+
+static void set_depth(rex_instance_t *inst, const char *val)
+{
+    if (strcmp(val, "16") == 0) inst->depth = 16;
+    else if (strcmp(val, "24") == 0) inst->depth = 24;
+}
+
+static int get_depth(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%d", inst->depth);
+}
+
+static void set_slice_cache(rex_instance_t *inst, const char *val)
+{
+    set_slice_cache_mb(inst, (float)atof(val));
+}
+
+static int get_slice_cache(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%d", (int)(inst->slot_budget / (1024 * 1024)));
+}
+
+static int get_load_error(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return rex_loader_error(inst->loader, buf, buf_len);
+}
+
+/* --- Kit --- */
+
+static void set_kit(rex_instance_t *inst, const char *val)
+{
+    if (strcmp(val, inst->kit) == 0) return;
+    snprintf(inst->kit, sizeof(inst->kit), "%s", val);
+    inst->kit_gen++;
+}
+
+static int get_kit(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return snprintf(buf, buf_len, "%s", inst->kit);
+}
+
+/* --- Monitoring --- */
+
+static void set_perf_reset(rex_instance_t *inst, const char *val)
+{
+    ctl_msg_t msg = { .type = CTL_PERF_RESET };
+    send_control(inst, &msg);
+}
+
+static int cmp_unsigned(const void *a, const void *b)
+{
+    unsigned x = *(const unsigned *)a, y = *(const unsigned *)b;
+    return (x > y) - (x < y);
+}
+
+/* MB/s for bytes processed in ns (0 if nothing was timed) */
+static double mb_per_s(uint64_t bytes, uint64_t ns)
+{
+    return ns ? (double)bytes * 1000.0 / (double)ns : 0.0;
+}
+
+/* Render timing over the last PERF_WINDOW blocks, voice use, file load,
+ * parse and slice decode rates, and audio memory, as JSON */
+static int perf_stats_json(rex_instance_t *inst, char *buf, int buf_len)
+{
+    perf_counters_t *pc = &inst->perf;
+    unsigned blocks = atomic_load_explicit(&pc->blocks, memory_order_acquire);
+    unsigned count = blocks < PERF_WINDOW ? blocks : PERF_WINDOW;
+    unsigned times[PERF_WINDOW];
+    uint64_t sum = 0;
+    for (unsigned i = 0; i < count; i++) {
+        times[i] = atomic_load_explicit(&pc->block_ns[i], memory_order_relaxed);
+        sum += times[i];
+    }
+    qsort(times, count, sizeof(times[0]), cmp_unsigned);
+    double min_us = count ? times[0] / 1000.0 : 0.0;
+    double max_us = count ? times[count - 1] / 1000.0 : 0.0;
+    double avg_us = count ? (double)sum / count / 1000.0 : 0.0;
+    double p99_us = count ? times[(count * 99 + 99) / 100 - 1] / 1000.0 : 0.0;
+    unsigned frames = atomic_load_explicit(&pc->frames, memory_order_relaxed);
+    double budget_us = frames * 1e6 / MOVE_SAMPLE_RATE;
+
+    rex_loader_stats_t ls;
+    rex_cache_stats_t cs;
+    rex_loader_stats(inst->loader, &ls);
+    rex_cache_stats(&cs);
+
+    int len = snprintf(buf, buf_len,
+        "{\"render\":{\"blocks\":%u,\"window\":%u,\"min_us\":%.1f,\"avg_us\":%.1f,"
+        "\"max_us\":%.1f,\"p99_us\":%.1f,\"budget_us\":%.1f,\"load_pct\":%.1f,\"overruns\":%u},"
+        "\"voices\":{\"active\":%d,\"peak\":%d,\"steals\":%u},"
+        "\"load\":{\"count\":%u,\"last_ms\":%.2f,\"last_decoded_ms\":%.2f},"
+        "\"parse\":{\"count\":%u,\"last_ms\":%.2f,\"last_bytes\":%zu,\"mb_per_s\":%.1f,"
+        "\"sidecar_loads\":%u,\"sidecar_mb_per_s\":%.1f,\"cache_hits\":%u,\"cache_misses\":%u},"
+        "\"decode\":{\"slices\":%u,\"total_ms\":%.2f,\"mb_per_s\":%.1f},"
+        "\"memory\":{\"pcm_bytes\":%zu,\"slice_cache_bytes\":%zu,\"cache_bytes\":%zu,"
+        "\"arena_idle_bytes\":%zu,\"buffer_reuses\":%u,\"buffer_allocs\":%u}}",
+        blocks, count, min_us, avg_us, max_us, p99_us, budget_us,
+        budget_us > 0.0 ? avg_us * 100.0 / budget_us : 0.0,
+        atomic_load_explicit(&pc->overruns, memory_order_relaxed),
+        atomic_load_explicit(&pc->voices, memory_order_relaxed),
+        atomic_load_explicit(&pc->voices_peak, memory_order_relaxed),
+        atomic_load_explicit(&pc->steals, memory_order_relaxed),
+        ls.loads, ls.last_load_ns / 1e6, ls.last_decoded_ns / 1e6,
+        cs.parses, cs.last_parse_ns / 1e6, cs.last_parse_bytes,
+        mb_per_s(cs.parse_bytes, cs.parse_ns),
+        cs.sidecar_loads, mb_per_s(cs.sidecar_bytes, cs.sidecar_ns), cs.hits, cs.misses,
+        ls.slices, ls.slice_ns / 1e6, mb_per_s(ls.slice_bytes, ls.slice_ns),
+        atomic_load_explicit(&pc->pcm_bytes, memory_order_relaxed),
+        atomic_load_explicit(&pc->slice_bytes, memory_order_relaxed),
+        rex_cache_bytes(), cs.buffer_idle_bytes, cs.buffer_reuses, cs.buffer_allocs);
+    return len < buf_len ? len : -1;
+}
+
+static int get_perf_stats(rex_instance_t *inst, char *buf, int buf_len)
+{
+    return perf_stats_json(inst, buf, buf_len);
+}
+
+/* --- UI description --- */
+
+static int get_ui_hierarchy(rex_instance_t *inst, char *buf, int buf_len)
+{
+    const char *hierarchy =
+        "{"
+            "\"modes\":null,"
+            "\"levels\":{"
+                "\"root\":{"
+                    "\"label\":\"REX\","
+                    "\"list_param\":\"preset\","
+                    "\"count_param\":\"preset_count\","
+                    "\"name_param\":\"preset_name\","
+                    "\"children\":null,"
+                    "\"knobs\":[\"gain\",\"start_note\",\"transpose\",\"attack\",\"decay\",\"sustain\",\"release\",\"mode\",\"choke\"],"
+                    "\"params\":["
+                        "{\"key\":\"gain\",\"label\":\"Gain\"},"
+                        "{\"key\":\"start_note\",\"label\":\"Start Note\"},"
+                        "{\"key\":\"transpose\",\"label\":\"Transpose\"},"
+                        "{\"key\":\"attack\",\"label\":\"Attack\"},"
+                        "{\"key\":\"decay\",\"label\":\"Decay\"},"
+                        "{\"key\":\"sustain\",\"label\":\"Sustain\"},"
+                        "{\"key\":\"release\",\"label\":\"Release\"},"
+                        "{\"key\":\"mode\",\"label\":\"Mode\"},"
+                        "{\"key\":\"choke\",\"label\":\"Choke\"}"
+                    "]"
+                "}"
+            "}"
+        "}";
+    int len = strlen(hierarchy);
+    if (len < buf_len) {
+        strcpy(buf, hierarchy);
+        return len;
+    }
+    return -1;
+}
+
+static int get_chain_params(rex_instance_t *inst, char *buf, int buf_len)
+{
+    const char *params =
+        "["
+            "{\"key\":\"preset\",\"name\":\"File\",\"type\":\"int\",\"min\":0,\"max\":9999},"
+            "{\"key\":\"gain\",\"name\":\"Gain\",\"type\":\"float\",\"min\":0,\"max\":2,\"step\":0.01},"
+            "{\"key\":\"start_note\",\"name\":\"Start Note\",\"type\":\"int\",\"min\":0,\"max\":127,\"step\":1},"
+            "{\"key\":\"attack\",\"name\":\"Attack\",\"type\":\"float\",\"min\":0,\"max\":2,\"step\":0.001},"
+            "{\"key\":\"decay\",\"name\":\"Decay\",\"type\":\"float\",\"min\":0,\"max\":2,\"step\":0.001},"
+            "{\"key\":\"sustain\",\"name\":\"Sustain\",\"type\":\"float\",\"min\":0,\"max\":1,\"step\":0.01},"
+            "{\"key\":\"release\",\"name\":\"Release\",\"type\":\"float\",\"min\":0,\"max\":2,\"step\":0.001},"
+            "{\"key\":\"mode\",\"name\":\"Mode\",\"type\":\"enum\",\"options\":[\"trigger\",\"gate\"]},"
+            "{\"key\":\"choke\",\"name\":\"Choke\",\"type\":\"enum\",\"options\":[\"off\",\"on\"]},"
+            "{\"key\":\"snap\",\"name\":\"Zero Snap\",\"type\":\"enum\",\"options\":[\"off\",\"on\"]},"
+            "{\"key\":\"transpose\",\"name\":\"Transpose\",\"type\":\"int\",\"min\":-12,\"max\":12,\"step\":1},"
+            "{\"key\":\"polyphony\",\"name\":\"Voices\",\"type\":\"int\",\"min\":8,\"max\":64,\"step\":1},"
+            "{\"key\":\"interpolation\",\"name\":\"Interpolation\",\"type\":\"enum\",\"options\":[\"linear\",\"hermite\",\"sinc8\",\"sinc16\"]}"
+        "]";
+    int len = strlen(params);
+    if (len < buf_len) {
+        strcpy(buf, params);
+        return len;
+    }
+    return -1;
+}
+
+/* --- Saved state --- */
+
+#define PARAM_STATE   0x01  /* restored from "state" */
+#define PARAM_DEFAULT 0x02  /* accepted in the module defaults */
+
+typedef struct {
+    const char *key;
+    void (*set)(rex_instance_t *inst, const char *val);
+    int (*get)(rex_instance_t *inst, char *buf, int buf_len);
+    int flags;
+} param_def_t;
+
+static const param_def_t *find_param(const char *key);
+
+/* One pass over the saved object; the file is picked by name if it has
+ * one (indexes shift as the folder changes), else by index. A saved kit
+ * takes the place of the file. */
+static void set_state(rex_instance_t *inst, const char *val)
+{
+    char key[32], text[256], name[256] = "";
+    int index = -1;
+    const char *p = val;
+    while (json_next_member(&p, key, sizeof(key), text, sizeof(text))) {
+        if (strcmp(key, "file_name") == 0) {
+            snprintf(name, sizeof(name), "%s", text);
+        } else if (strcmp(key, "file_index") == 0) {
+            index = atoi(text);
+        } else {
+            const param_def_t *d = find_param(key);
+            if (d && (d->flags & PARAM_STATE)) d->set(inst, text);
+        }
+    }
+
+    if (inst->kit[0]) return;
+    if (name[0]) {
+        refresh_rex_files(inst);
+        int i = inst->file_count > 0 ? rex_catalog_find_name(inst->view, name) : -1;
+        if (i >= 0 && i != inst->file_index) {
+            select_file(inst, i);
+        }
+    } else if (index >= 0 && index < inst->file_count && index != inst->file_index) {
+        select_file(inst, index);
+    }
+}
+
+static int get_state(rex_instance_t *inst, char *buf, int buf_len)
+{
+    if (inst->state_dirty) {
+        char escaped_name[256], escaped_kit[512];
+        json_escape(escaped_name, sizeof(escaped_name), inst->file_name);
+        json_escape(escaped_kit, sizeof(escaped_kit), inst->kit);
+        inst->state_len = snprintf(inst->state_text, sizeof(inst->state_text),
+            "{\"file_name\":\"%s\",\"file_index\":%d,\"gain\":%.2f,\"start_note\":%d,"
+            "\"attack\":%.3f,\"decay\":%.3f,\"sustain\":%.3f,\"release\":%.3f,"
+            "\"mode\":\"%s\",\"choke\":\"%s\",\"transpose\":%d,\"polyphony\":%d,"
+            "\"interpolation\":\"%s\",\"snap\":\"%s\",\"kit\":\"%s\"}",
+            escaped_name, inst->file_index, inst->gain, inst->start_note,
+            inst->attack, inst->decay, inst->sustain, inst->release,
+            inst->mode ? "gate" : "trigger", inst->choke ? "on" : "off",
+            inst->transpose, inst->polyphony, resample_quality_name(inst->interpolation),
+            inst->snap ? "on" : "off", escaped_kit);
+        if (inst->state_len >= (int)sizeof(inst->state_text))
+            inst->state_len = sizeof(inst->state_text) - 1;
+        inst->state_dirty = 0;
+    }
+    put_text(buf, buf_len, inst->state_text, inst->state_len);
+    return inst->state_len;  /* the full length if truncated, as snprintf */
+}
+
+/* --- Dispatch --- */
+
+#define S PARAM_STATE
+#define D PARAM_DEFAULT
+
+/* Sorted by key in strcmp order, for bsearch */
+static const param_def_t g_params[] = {
+    { "all_notes_off",  set_panic,         NULL,              0 },
+    { "attack",         set_attack,        get_attack,        S | D },
+    { "bank_count",     NULL,              get_bank_count,    0 },
+    { "bank_name",      NULL,              get_bank_name,     0 },
+    { "cache_mb",       set_cache_mb,      get_cache_mb,      D },
+    { "chain_params",   NULL,              get_chain_params,  0 },
+    { "choke",          set_choke,         get_choke,         S | D },
+    { "decay",          set_decay,         get_decay,         S | D },
+    { "depth",          set_depth,         get_depth,         D },
+    { "disk_cache",     set_disk_cache,    get_disk_cache,    D },
+    { "file_count",     NULL,              get_file_count,    0 },
+    { "file_index",     set_file_index,    get_file_index,    0 },
+    { "file_name",      NULL,              get_file_name,     0 },
+    { "gain",           set_gain,          get_gain,          S | D },
+    { "interpolation",  set_interpolation, get_interpolation, S | D },
+    { "kit",            set_kit,           get_kit,           S | D },
+    { "lazy",           set_lazy,          get_lazy,          D },
+    { "load_error",     NULL,              get_load_error,    0 },
+    { "mode",           set_mode,          get_mode,          S | D },
+    { "next_file",      set_next_file,     NULL,              0 },
+    { "next_preset",    set_next_file,     NULL,              0 },
+    { "panic",          set_panic,         NULL,              0 },
+    { "patch_in_bank",  NULL,              get_patch_in_bank, 0 },
+    { "perf_reset",     set_perf_reset,    NULL,              0 },
+    { "perf_stats",     NULL,              get_perf_stats,    0 },
+    { "planar",         set_planar,        get_planar,        D },
+    { "polyphony",      set_polyphony,     get_polyphony,     S | D },
+    { "prefetch",       set_prefetch,      get_prefetch,      D },
+    { "preset",         set_file_index,    get_file_index,    0 },
+    { "preset_count",   NULL,              get_file_count,    0 },
+    { "preset_info",    NULL,              get_preset_info,   0 },
+    { "preset_name",    NULL,              get_file_name,     0 },
+    { "prev_file",      set_prev_file,     NULL,              0 },
+    { "prev_preset",    set_prev_file,     NULL,              0 },
+    { "release",        set_release,       get_release,       S | D },
+    { "slice_cache_mb", set_slice_cache,   get_slice_cache,   D },
+    { "slice_count",    NULL,              get_slice_count,   0 },
+    { "snap",           set_snap,          get_snap,          S | D },
+    { "start_note",     set_start_note,    get_start_note,    S | D },
+    { "state",          set_state,         get_state,         0 },
+    { "sustain",        set_sustain,       get_sustain,       S | D },
+    { "tempo",          NULL,              get_tempo,         0 },
+    { "transpose",      set_transpose,     get_transpose,     S | D },
+    { "ui_hierarchy",   NULL,              get_ui_hierarchy,  0 },
+};
+
+#undef S
+#undef D
+
+#define PARAM_COUNT ((int)(sizeof(g_params) / sizeof(g_params[0])))
+
+static int cmp_param(const void *key, const void *def)
+{
+    return strcmp((const char *)key, ((const param_def_t *)def)->key);
+}
+
+static const param_def_t *find_param(const char *key)
+{
+    return (const param_def_t *)bsearch(key, g_params, PARAM_COUNT, sizeof(g_params[0]),
+                                        cmp_param);
+}
+
+/* bsearch misses keys past the first one out of order */
+static int params_sorted(void)
+{
+    for (int i = 1; i < PARAM_COUNT; i++) {
+        if (strcmp(g_params[i - 1].key, g_params[i].key) >= 0) return 0;
+    }
+    return 1;
+}
+
+/* create_instance: the module's defaults, before any file is loaded */
+static void apply_defaults(rex_instance_t *inst, const char *json)
+{
+    char key[32], val[256];
+    const char *p = json;
+    while (json_next_member(&p, key, sizeof(key), val, sizeof(val))) {
+        if (strcmp(key, "file_name") == 0) {
+            int i = inst->file_count > 0 ? rex_catalog_find_name(inst->view, val) : -1;
+            if (i >= 0) inst->file_index = i;
+        } else {
+            const param_def_t *d = find_param(key);
+            if (d && (d->flags & PARAM_DEFAULT)) d->set(inst, val);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* V2 API: create_instance                                             */
+/* ------------------------------------------------------------------ */
+
+/* A new instance with the built-in defaults, nothing loaded */
+static rex_instance_t *instance_alloc(void)
+{
+    rex_instance_t *inst = (rex_instance_t *)calloc(1, sizeof(rex_instance_t));
+    if (!inst) return NULL;
+    if (!params_sorted()) plugin_log("parameter table out of order");
+
+    inst->loader = rex_loader_create(plugin_log);
+    if (!inst->loader) {
+        free(inst);
+        return NULL;
+    }
+
+    inst->gain = 1.0f;
+    inst->start_note = FIRST_NOTE;
+    inst->file_index = 0;
+    set_file_name(inst, "No REX loaded");
+
+    /* Envelope defaults: transparent (instant attack, full sustain, no release) */
+    inst->attack = 0.0f;
+    inst->decay = 0.0f;
+    inst->sustain = 1.0f;
+    inst->release = 0.0f;
+    inst->mode = 0;   /* trigger (one-shot) */
+    inst->choke = 0;  /* off (polyphonic) */
+    inst->snap = 0;   /* off (slices play from their first frame) */
+    inst->transpose = 0;
+    inst->prefetch = DEFAULT_PREFETCH;
+    inst->polyphony = DEFAULT_POLYPHONY;
+    inst->planar = REX_PLANAR_NONE;  /* off: planes would hold the PCM twice */
+    inst->depth = 16;
+    inst->slot_budget = (size_t)DEFAULT_SLICE_CACHE_MB * 1024 * 1024;
+    return inst;
+}
+
+/* Hand the settings to the render side, before it starts running */
+static void instance_ready(rex_instance_t *inst)
+{
+    pool_reset(&inst->voices, inst->polyphony);
+    snapshot_params(inst, &inst->rt);
+    inst->published = inst->rt;
+    atomic_init(&inst->ctl_ring.head, 0);
+    atomic_init(&inst->ctl_ring.tail, 0);
+    atomic_init(&inst->midi_ring.head, 0);
+    atomic_init(&inst->midi_ring.tail, 0);
+    atomic_init(&inst->slice_count, 0);
+    atomic_init(&inst->tempo_bpm, 0.0f);
+    rex_loader_set_flags(inst->loader, load_flags(inst));
+}
+
+static void* v2_create_instance(const char *module_dir, const char *json_defaults)
+{
+    rex_instance_t *inst = instance_alloc();
+    if (!inst) return NULL;
+    strncpy(inst->module_dir, module_dir, sizeof(inst->module_dir) - 1);
+
+    /* Scan for REX files */
+    char rex_dir[512];
+    snprintf(rex_dir, sizeof(rex_dir), "%s/loops", module_dir);
+    scan_rex_files(inst, rex_dir);
+
+    /* If no files in loops/, try module dir itself */
+    if (inst->file_count == 0) {
+        scan_rex_files(inst, module_dir);
+    }
+
+    /* Module defaults, applied before anything runs */
+    if (json_defaults && json_defaults[0]) {
+        apply_defaults(inst, json_defaults);
+    }
+
+    instance_ready(inst);
+
+    /* Load the kit or first/selected file (synchronously: not on the
+     * audio thread yet) */
+    const char *kit = inst->kit[0] ? prepare_kit(inst) : NULL;
+    if (kit && rex_loader_load_now(inst->loader, kit) == 0) {
+        swap_loaded_file(inst);
+        inst->kit_on = 1;
+    } else if (inst->file_count > 0 &&
+               rex_loader_load_now(inst->loader,
+                                   rex_catalog_path(inst->view, inst->file_index)) == 0) {
+        swap_loaded_file(inst);
+        set_file_name(inst, rex_catalog_name(inst->view, inst->file_index));
+    }
+    if (inst->file_count > 0) {
+        update_prefetch(inst);
+    }
+
+    plugin_log("REX Player initialized");
+    return inst;
+}
+
+/* ------------------------------------------------------------------ */
+/* V2 API: destroy_instance                                            */
+/* ------------------------------------------------------------------ */
+
+static void v2_destroy_instance(void *instance)
+{
+    rex_instance_t *inst = (rex_instance_t *)instance;
+    if (!inst) return;
+
+    rex_loader_destroy(inst->loader);
+    rex_catalog_close(inst->catalog);  /* after the loader: it holds catalog paths */
+    for (int i = 0; i < REX_MAX_SLICES; i++) {
+        free(inst->slots[i].pcm);
+    }
+    for (int i = 0; i < inst->free_backlog_count; i++) {
+        free(inst->free_backlog[i]);
+    }
+    rex_loader_release(inst->rex);
+
+    free(inst);
+    plugin_log("REX Player destroyed");
+}
+
+/* ------------------------------------------------------------------ */
+/* V2 API: on_midi                                                     */
+/* ------------------------------------------------------------------ */
+
+/* Act on one message: voice state changes here, at the frame the render
+ * loop has reached */
+static void apply_midi(rex_instance_t *inst, const uint8_t *msg, int len)
+{
+    if (!inst->rex || len < 2) return;
+
+    uint8_t status = msg[0] & 0xF0;
+    uint8_t note = msg[1];
+    uint8_t velocity = (len > 2) ? msg[2] : 0;
+
+    /* Data bytes are 7-bit: anything else is malformed, and note indexes
+     * the 128-entry note chains */
+    if (note > 127 || velocity > 127) return;
+
+    if (status == 0x90 && velocity > 0) {
+        /* Note On - trigger slice (a kit's slices are indexed by note) */
+        int slice_index = inst->rex->kit ? (int)note : (int)note - inst->rt.start_note;
+        if (slice_index < 0 || slice_index >= inst->rex->slice_count) return;
+
+        /* Check slice has audio */
+        const rex_slice_t *slice = &inst->rex->slices[slice_index];
+        if (slice->sample_length == 0) return;
+
+        if (inst->rex->lazy) {
+            inst->slots[slice_index].last_use = ++inst->slot_clock;
+            request_slice(inst, slice_index);
+        }
+
+        voice_pool_t *vp = &inst->voices;
+
+        /* Choke: silence all other active voices */
+        if (inst->rt.choke) {
+            pool_reset(vp, vp->polyphony);
+        }
+
+        /* Take a free voice, or steal the oldest */
+        int id = pool_start(vp, note);
+        vp->slice_index[id] = slice_index;
+        vp->position[id] = 0;
+        vp->velocity[id] = velocity;
+        vp->gate[id] = 1;
+        vp->started[id] = 0;
+
+        /* Initialize and trigger envelope */
+        adsr_t *env = &vp->env[id];
+        env->attack = inst->rt.attack;
+        env->decay = inst->rt.decay;
+        env->sustain = inst->rt.sustain;
+        env->release = inst->rt.release;
+        env->value = 0.0f;
+        adsr_trigger(env);
+    }
     else if ((status == 0x80) || (status == 0x90 && velocity == 0)) {
         /* Note Off - release matching voices */
-        for (int i = 0; i < MAX_VOICES; i++) {
-            voice_t *v = &inst->voices[i];
-            if (v->active && v->note == note && v->gate) {
-                v->gate = 0;
-                if (inst->mode == 1) {
+        voice_pool_t *vp = &inst->voices;
+        for (int id = vp->note_head[note]; id != NO_VOICE; id = vp->note_next[id]) {
+            if (vp->gate[id]) {
+                vp->gate[id] = 0;
+                if (inst->rt.mode == 1) {
                     /* Gate mode: enter release stage */
-                    adsr_release(&v->env);
+                    adsr_release(&vp->env[id]);
                 }
                 /* Trigger mode: do nothing, let slice play out */
             }
@@ -591,13 +1774,59 @@ static void v2_on_midi(void *instance, const uint8_t *msg, int len, int source)
         /* Control Change */
         if (note == 123) {
             /* All notes off */
-            for (int i = 0; i < MAX_VOICES; i++) {
-                inst->voices[i].active = 0;
-            }
+            pool_reset(&inst->voices, inst->voices.polyphony);
         }
     }
 }
 
+/* Queue msg to take effect frame_offset frames into the next render
+ * block, keeping the queue in frame order (arrival order within a frame).
+ * If it is full, everything queued is applied now: late rather than lost,
+ * so no note-off goes missing. */
+static void queue_midi(rex_instance_t *inst, const uint8_t *msg, int len, int frame_offset)
+{
+    if (len > 3) len = 3;
+    if (frame_offset < 0) frame_offset = 0;
+    if (inst->midi_count == MIDI_QUEUE_SIZE) {
+        for (int i = 0; i < inst->midi_count; i++)
+            apply_midi(inst, inst->midi_queue[i].msg, inst->midi_queue[i].len);
+        inst->midi_count = 0;
+    }
+
+    int i = inst->midi_count++;
+    while (i > 0 && inst->midi_queue[i - 1].offset > frame_offset) {
+        inst->midi_queue[i] = inst->midi_queue[i - 1];
+        i--;
+    }
+    midi_event_t *ev = &inst->midi_queue[i];
+    ev->offset = frame_offset;
+    ev->len = (uint8_t)len;
+    memcpy(ev->msg, msg, len);
+}
+
+/* MIDI thread: hand the event to the render thread, which queues it at
+ * frame_offset into the next block */
+static void v2_on_midi_at(void *instance, const uint8_t *msg, int len, int source,
+                          int frame_offset)
+{
+    rex_instance_t *inst = (rex_instance_t *)instance;
+    if (!inst || len < 2) return;
+    if (len > 3) len = 3;
+
+    ctl_msg_t m = { .type = CTL_MIDI };
+    m.midi.offset = frame_offset;
+    m.midi.len = (uint8_t)len;
+    memcpy(m.midi.msg, msg, len);
+    ctl_push(&inst->midi_ring, &m);  /* a full ring drops the event */
+}
+
+/* The host gives no timestamp: the message applies at the start of the
+ * next block, as soon as it would have without the queue */
+static void v2_on_midi(void *instance, const uint8_t *msg, int len, int source)
+{
+    v2_on_midi_at(instance, msg, len, source, 0);
+}
+
 /* ------------------------------------------------------------------ */
 /* V2 API: set_param                                                   */
 /* ------------------------------------------------------------------ */
@@ -607,160 +1836,22 @@ static void v2_set_param(void *instance, const char *key, const char *val)
     rex_instance_t *inst = (rex_instance_t *)instance;
     if (!inst) return;
 
-    if (strcmp(key, "preset") == 0 || strcmp(key, "file_index") == 0) {
-        int idx = atoi(val);
-        if (idx >= 0 && idx < inst->file_count && idx != inst->file_index) {
-            /* Update index and display name immediately for responsive UI */
-            inst->file_index = idx;
-            strncpy(inst->file_name, inst->files[idx].name, sizeof(inst->file_name) - 1);
-            inst->file_name[sizeof(inst->file_name) - 1] = '\0';
-            /* Defer actual file load (debounce for fast scrolling) */
-            inst->deferred_file_index = idx;
-            inst->deferred_load_countdown = LOAD_DEBOUNCE_BLOCKS;
-        }
-    }
-    else if (strcmp(key, "next_file") == 0 || strcmp(key, "next_preset") == 0) {
-        if (inst->file_count > 0) {
-            inst->file_index = (inst->file_index + 1) % inst->file_count;
-            strncpy(inst->file_name, inst->files[inst->file_index].name, sizeof(inst->file_name) - 1);
-            inst->file_name[sizeof(inst->file_name) - 1] = '\0';
-            inst->deferred_file_index = inst->file_index;
-            inst->deferred_load_countdown = LOAD_DEBOUNCE_BLOCKS;
-        }
-    }
-    else if (strcmp(key, "prev_file") == 0 || strcmp(key, "prev_preset") == 0) {
-        if (inst->file_count > 0) {
-            inst->file_index = (inst->file_index - 1 + inst->file_count) % inst->file_count;
-            strncpy(inst->file_name, inst->files[inst->file_index].name, sizeof(inst->file_name) - 1);
-            inst->file_name[sizeof(inst->file_name) - 1] = '\0';
-            inst->deferred_file_index = inst->file_index;
-            inst->deferred_load_countdown = LOAD_DEBOUNCE_BLOCKS;
-        }
-    }
-    else if (strcmp(key, "gain") == 0) {
-        inst->gain = (float)atof(val);
-        if (inst->gain < 0.0f) inst->gain = 0.0f;
-        if (inst->gain > 2.0f) inst->gain = 2.0f;
-    }
-    else if (strcmp(key, "start_note") == 0) {
-        inst->start_note = atoi(val);
-        if (inst->start_note < 0) inst->start_note = 0;
-        if (inst->start_note > 127) inst->start_note = 127;
-    }
-    else if (strcmp(key, "attack") == 0) {
-        inst->attack = (float)atof(val);
-        if (inst->attack < 0.0f) inst->attack = 0.0f;
-        if (inst->attack > 2.0f) inst->attack = 2.0f;
-    }
-    else if (strcmp(key, "decay") == 0) {
-        inst->decay = (float)atof(val);
-        if (inst->decay < 0.0f) inst->decay = 0.0f;
-        if (inst->decay > 2.0f) inst->decay = 2.0f;
-    }
-    else if (strcmp(key, "sustain") == 0) {
-        inst->sustain = (float)atof(val);
-        if (inst->sustain < 0.0f) inst->sustain = 0.0f;
-        if (inst->sustain > 1.0f) inst->sustain = 1.0f;
-    }
-    else if (strcmp(key, "release") == 0) {
-        inst->release = (float)atof(val);
-        if (inst->release < 0.0f) inst->release = 0.0f;
-        if (inst->release > 2.0f) inst->release = 2.0f;
-    }
-    else if (strcmp(key, "mode") == 0) {
-        if (strcmp(val, "trigger") == 0) inst->mode = 0;
-        else if (strcmp(val, "gate") == 0) inst->mode = 1;
-    }
-    else if (strcmp(key, "choke") == 0) {
-        if (strcmp(val, "off") == 0) inst->choke = 0;
-        else if (strcmp(val, "on") == 0) inst->choke = 1;
-    }
-    else if (strcmp(key, "transpose") == 0) {
-        inst->transpose = atoi(val);
-        if (inst->transpose < -12) inst->transpose = -12;
-        if (inst->transpose > 12) inst->transpose = 12;
-    }
-    else if (strcmp(key, "all_notes_off") == 0 || strcmp(key, "panic") == 0) {
-        for (int i = 0; i < MAX_VOICES; i++) {
-            inst->voices[i].active = 0;
-        }
-    }
-    else if (strcmp(key, "state") == 0) {
-        /* Restore state from JSON */
-        float f;
-        char name[128];
-
-        if (json_get_string(val, "file_name", name, sizeof(name)) > 0) {
-            for (int i = 0; i < inst->file_count; i++) {
-                if (strcmp(inst->files[i].name, name) == 0) {
-                    if (i != inst->file_index) {
-                        inst->file_index = i;
-                        strncpy(inst->file_name, inst->files[i].name, sizeof(inst->file_name) - 1);
-                        inst->file_name[sizeof(inst->file_name) - 1] = '\0';
-                        inst->deferred_file_index = i;
-                        inst->deferred_load_countdown = LOAD_DEBOUNCE_BLOCKS;
-                    }
-                    break;
-                }
-            }
-        } else if (json_get_number(val, "file_index", &f) == 0) {
-            int idx = (int)f;
-            if (idx >= 0 && idx < inst->file_count && idx != inst->file_index) {
-                inst->file_index = idx;
-                strncpy(inst->file_name, inst->files[idx].name, sizeof(inst->file_name) - 1);
-                inst->file_name[sizeof(inst->file_name) - 1] = '\0';
-                inst->deferred_file_index = idx;
-                inst->deferred_load_countdown = LOAD_DEBOUNCE_BLOCKS;
-            }
-        }
+    const param_def_t *d = find_param(key);
+    if (!d || !d->set) return;
 
-        if (json_get_number(val, "gain", &f) == 0) {
-            inst->gain = f;
-            if (inst->gain < 0.0f) inst->gain = 0.0f;
-            if (inst->gain > 2.0f) inst->gain = 2.0f;
-        }
-        if (json_get_number(val, "start_note", &f) == 0) {
-            inst->start_note = (int)f;
-            if (inst->start_note < 0) inst->start_note = 0;
-            if (inst->start_note > 127) inst->start_note = 127;
-        }
-        if (json_get_number(val, "attack", &f) == 0) {
-            inst->attack = f;
-            if (inst->attack < 0.0f) inst->attack = 0.0f;
-            if (inst->attack > 2.0f) inst->attack = 2.0f;
-        }
-        if (json_get_number(val, "decay", &f) == 0) {
-            inst->decay = f;
-            if (inst->decay < 0.0f) inst->decay = 0.0f;
-            if (inst->decay > 2.0f) inst->decay = 2.0f;
-        }
-        if (json_get_number(val, "sustain", &f) == 0) {
-            inst->sustain = f;
-            if (inst->sustain < 0.0f) inst->sustain = 0.0f;
-            if (inst->sustain > 1.0f) inst->sustain = 1.0f;
-        }
-        if (json_get_number(val, "release", &f) == 0) {
-            inst->release = f;
-            if (inst->release < 0.0f) inst->release = 0.0f;
-            if (inst->release > 2.0f) inst->release = 2.0f;
-        }
-        if (json_get_number(val, "transpose", &f) == 0) {
-            inst->transpose = (int)f;
-            if (inst->transpose < -12) inst->transpose = -12;
-            if (inst->transpose > 12) inst->transpose = 12;
-        }
-        {
-            char str[16];
-            if (json_get_string(val, "mode", str, sizeof(str)) > 0) {
-                if (strcmp(str, "trigger") == 0) inst->mode = 0;
-                else if (strcmp(str, "gate") == 0) inst->mode = 1;
-            }
-            if (json_get_string(val, "choke", str, sizeof(str)) > 0) {
-                if (strcmp(str, "off") == 0) inst->choke = 0;
-                else if (strcmp(str, "on") == 0) inst->choke = 1;
-            }
-        }
-    }
+    int lazy = inst->lazy, planar = inst->planar, depth = inst->depth;
+    int prefetch = inst->prefetch;
+    unsigned kit_gen = inst->kit_gen;
+    d->set(inst, val);
+    inst->state_dirty = 1;
+
+    /* Changes that take more than the new value */
+    if (inst->lazy != lazy || inst->planar != planar || inst->depth != depth)
+        apply_load_mode(inst);
+    if (inst->kit_gen != kit_gen) apply_kit(inst);
+    if (inst->prefetch != prefetch && inst->file_count > 0) update_prefetch(inst);
+
+    publish_params(inst);
 }
 
 /* ------------------------------------------------------------------ */
@@ -772,264 +1863,570 @@ static int v2_get_param(void *instance, const char *key, char *buf, int buf_len)
     rex_instance_t *inst = (rex_instance_t *)instance;
     if (!inst) return -1;
 
-    if (strcmp(key, "preset") == 0 || strcmp(key, "file_index") == 0) {
-        return snprintf(buf, buf_len, "%d", inst->file_index);
+    const param_def_t *d = find_param(key);
+    if (!d || !d->get) return -1;
+    return d->get(inst, buf, buf_len);
+}
+
+/* ------------------------------------------------------------------ */
+/* V2 API: get_error                                                   */
+/* ------------------------------------------------------------------ */
+
+static int v2_get_error(void *instance, char *buf, int buf_len)
+{
+    rex_instance_t *inst = (rex_instance_t *)instance;
+    if (!inst) return 0;
+
+    return rex_loader_error(inst->loader, buf, buf_len);
+}
+
+/* ------------------------------------------------------------------ */
+/* V2 API: render_block                                                */
+/* ------------------------------------------------------------------ */
+
+/* Interpolate from planar slice buffers. The guard frames either side of
+ * each slice repeat its edge samples, so every quality can read all its
+ * taps without bounds checks and gets what the clamped reads on
+ * interleaved data do. Called with a constant stereo and quality so each
+ * use compiles to its own straight-line loop; mono passes r == l. */
+static inline __attribute__((always_inline))
+void mix_planar_f32(const float *l, const float *r, int stereo, int quality,
+                    const resample_kernel_t *kern, const float *pos,
+                    const float *envp, float amp, int n, float *bus_l, float *bus_r)
+{
+    for (int i = 0; i < n; i++) {
+        int p0 = (int)pos[i];
+        float frac = pos[i] - (float)p0;
+        float g = envp ? envp[i] * amp : amp;
+        float vl, vr;
+        if (quality == RESAMPLE_LINEAR) {
+            vl = (l[p0] + frac * (l[p0 + 1] - l[p0])) * g;
+            vr = stereo ? (r[p0] + frac * (r[p0 + 1] - r[p0])) * g : vl;
+        } else if (quality == RESAMPLE_HERMITE) {
+            vl = resample_hermite(l[p0 - 1], l[p0], l[p0 + 1], l[p0 + 2], frac) * g;
+            vr = stereo ? resample_hermite(r[p0 - 1], r[p0], r[p0 + 1], r[p0 + 2], frac) * g : vl;
+        } else {
+            vl = resample_sinc_f32(kern, l, p0, frac) * g;
+            vr = stereo ? resample_sinc_f32(kern, r, p0, frac) * g : vl;
+        }
+        bus_l[i] += vl;
+        bus_r[i] += vr;
+    }
+}
+
+static inline __attribute__((always_inline))
+void mix_planar_i16(const int16_t *l, const int16_t *r, int stereo, int quality,
+                    const resample_kernel_t *kern, const float *pos,
+                    const float *envp, float amp, int n, float *bus_l, float *bus_r)
+{
+    for (int i = 0; i < n; i++) {
+        int p0 = (int)pos[i];
+        float frac = pos[i] - (float)p0;
+        float g = envp ? envp[i] * amp : amp;
+        float vl, vr = 0.0f;
+        if (quality == RESAMPLE_LINEAR) {
+            float l0 = (float)l[p0], l1 = (float)l[p0 + 1];
+            vl = (l0 + frac * (l1 - l0)) * g;
+            if (stereo) {
+                float r0 = (float)r[p0], r1 = (float)r[p0 + 1];
+                vr = (r0 + frac * (r1 - r0)) * g;
+            }
+        } else if (quality == RESAMPLE_HERMITE) {
+            vl = resample_hermite(l[p0 - 1], l[p0], l[p0 + 1], l[p0 + 2], frac) * g;
+            if (stereo) vr = resample_hermite(r[p0 - 1], r[p0], r[p0 + 1], r[p0 + 2], frac) * g;
+        } else {
+            vl = resample_sinc_i16(kern, l, p0, frac) * g;
+            if (stereo) vr = resample_sinc_i16(kern, r, p0, frac) * g;
+        }
+        bus_l[i] += vl;
+        bus_r[i] += stereo ? vr : vl;
     }
-    else if (strcmp(key, "preset_name") == 0 || strcmp(key, "file_name") == 0) {
-        strncpy(buf, inst->file_name, buf_len - 1);
-        buf[buf_len - 1] = '\0';
-        return strlen(buf);
+}
+
+/* Packed little-endian int24 sample i, at 16-bit scale */
+static inline float i24_at(const uint8_t *p, int i)
+{
+    const uint8_t *b = p + i * 3;
+    int32_t v = (int32_t)((uint32_t)b[0] << 8 | (uint32_t)b[1] << 16 | (uint32_t)b[2] << 24) >> 8;
+    return (float)v * (1.0f / 256.0f);
+}
+
+/* Three-byte samples have no vector load: sinc gathers its taps into a
+ * float window, as mix_interleaved does */
+static inline __attribute__((always_inline))
+void mix_planar_i24(const uint8_t *l, const uint8_t *r, int stereo, int quality,
+                    const resample_kernel_t *kern, const float *pos,
+                    const float *envp, float amp, int n, float *bus_l, float *bus_r)
+{
+    for (int i = 0; i < n; i++) {
+        int p0 = (int)pos[i];
+        float frac = pos[i] - (float)p0;
+        float g = envp ? envp[i] * amp : amp;
+        float vl, vr = 0.0f;
+        if (quality == RESAMPLE_LINEAR) {
+            float l0 = i24_at(l, p0), l1 = i24_at(l, p0 + 1);
+            vl = (l0 + frac * (l1 - l0)) * g;
+            if (stereo) {
+                float r0 = i24_at(r, p0), r1 = i24_at(r, p0 + 1);
+                vr = (r0 + frac * (r1 - r0)) * g;
+            }
+        } else if (quality == RESAMPLE_HERMITE) {
+            vl = resample_hermite(i24_at(l, p0 - 1), i24_at(l, p0), i24_at(l, p0 + 1),
+                                  i24_at(l, p0 + 2), frac) * g;
+            if (stereo)
+                vr = resample_hermite(i24_at(r, p0 - 1), i24_at(r, p0), i24_at(r, p0 + 1),
+                                      i24_at(r, p0 + 2), frac) * g;
+        } else {
+            float w[RESAMPLE_MAX_TAPS];
+            int before = kern->taps / 2 - 1;
+            for (int k = 0; k < kern->taps; k++) w[k] = i24_at(l, p0 - before + k);
+            vl = resample_sinc_f32(kern, w, before, frac) * g;
+            if (stereo) {
+                for (int k = 0; k < kern->taps; k++) w[k] = i24_at(r, p0 - before + k);
+                vr = resample_sinc_f32(kern, w, before, frac) * g;
+            }
+        }
+        bus_l[i] += vl;
+        bus_r[i] += stereo ? vr : vl;
     }
-    else if (strcmp(key, "preset_count") == 0 || strcmp(key, "file_count") == 0) {
-        return snprintf(buf, buf_len, "%d", inst->file_count);
+}
+
+/* One specialised loop per buffer format, channel count and quality (the
+ * two sinc sizes share one, reading the tap count from the kernel) */
+#define MIX_PLANAR(fn, type, stereo, quality) \
+    fn((const type *)slice->plane[0], \
+       (const type *)slice->plane[(stereo) ? 1 : 0], (stereo), (quality), \
+       kern, pos, envp, amp, n, bus_l, bus_r)
+
+#define MIX_PLANAR_QUALITY(fn, type, stereo) \
+    do { \
+        if (quality == RESAMPLE_LINEAR) MIX_PLANAR(fn, type, stereo, RESAMPLE_LINEAR); \
+        else if (quality == RESAMPLE_HERMITE) MIX_PLANAR(fn, type, stereo, RESAMPLE_HERMITE); \
+        else MIX_PLANAR(fn, type, stereo, RESAMPLE_SINC8); \
+    } while (0)
+
+static void mix_planar(const rex_file_t *rex, const rex_slice_t *slice, int quality,
+                       const resample_kernel_t *kern, const float *pos,
+                       const float *envp, float amp, int n, float *bus_l, float *bus_r)
+{
+    int stereo = rex->pcm_channels == 2;
+    if (rex->planar == REX_PLANAR_F32) {
+        if (stereo) MIX_PLANAR_QUALITY(mix_planar_f32, float, 1);
+        else MIX_PLANAR_QUALITY(mix_planar_f32, float, 0);
+    } else if (rex->planar == REX_PLANAR_I24) {
+        if (stereo) MIX_PLANAR_QUALITY(mix_planar_i24, uint8_t, 1);
+        else MIX_PLANAR_QUALITY(mix_planar_i24, uint8_t, 0);
+    } else {
+        if (stereo) MIX_PLANAR_QUALITY(mix_planar_i16, int16_t, 1);
+        else MIX_PLANAR_QUALITY(mix_planar_i16, int16_t, 0);
     }
-    else if (strcmp(key, "slice_count") == 0) {
-        if (inst->rex_loaded) {
-            return snprintf(buf, buf_len, "%d", inst->rex.slice_count);
+}
+
+#undef MIX_PLANAR_QUALITY
+#undef MIX_PLANAR
+
+/* Interpolate from interleaved PCM (lazy slices, planar off), where reads
+ * are clamped to the slice's samples [start, end). Linear keeps its two
+ * taps inline; the other qualities gather their taps into a window first
+ * and then share the planar readers. */
+static void mix_interleaved(const int16_t *pcm, int stereo, int start, int end,
+                            int quality, const resample_kernel_t *kern,
+                            const float *pos, const float *envp, float amp, int n,
+                            float *bus_l, float *bus_r)
+{
+    if (quality == RESAMPLE_LINEAR && stereo) {
+        for (int i = 0; i < n; i++) {
+            int p0 = start + (int)pos[i];
+            float frac = pos[i] - (float)(int)pos[i];
+            int p1 = (p0 + 1 < end) ? p0 + 1 : p0;
+            float g = envp ? envp[i] * amp : amp;
+            float s0_l = (float)pcm[p0 * 2];
+            float s0_r = (float)pcm[p0 * 2 + 1];
+            float s1_l = (float)pcm[p1 * 2];
+            float s1_r = (float)pcm[p1 * 2 + 1];
+            bus_l[i] += (s0_l + frac * (s1_l - s0_l)) * g;
+            bus_r[i] += (s0_r + frac * (s1_r - s0_r)) * g;
         }
-        return snprintf(buf, buf_len, "0");
+        return;
     }
-    else if (strcmp(key, "tempo") == 0) {
-        if (inst->rex_loaded) {
-            return snprintf(buf, buf_len, "%.1f", inst->rex.tempo_bpm);
+    if (quality == RESAMPLE_LINEAR) {
+        for (int i = 0; i < n; i++) {
+            int p0 = start + (int)pos[i];
+            float frac = pos[i] - (float)(int)pos[i];
+            int p1 = (p0 + 1 < end) ? p0 + 1 : p0;
+            float g = envp ? envp[i] * amp : amp;
+            float s0 = (float)pcm[p0];
+            float s1 = (float)pcm[p1];
+            float v = (s0 + frac * (s1 - s0)) * g;
+            bus_l[i] += v;
+            bus_r[i] += v;
         }
-        return snprintf(buf, buf_len, "0");
+        return;
     }
-    else if (strcmp(key, "gain") == 0) {
-        return snprintf(buf, buf_len, "%.2f", inst->gain);
+
+    int width = quality == RESAMPLE_HERMITE ? 4 : kern->taps;
+    int before = width / 2 - 1;
+    int ch = stereo ? 2 : 1;
+    for (int i = 0; i < n; i++) {
+        int p0 = start + (int)pos[i];
+        float frac = pos[i] - (float)(int)pos[i];
+        float g = envp ? envp[i] * amp : amp;
+        float wl[RESAMPLE_MAX_TAPS], wr[RESAMPLE_MAX_TAPS];
+        for (int k = 0; k < width; k++) {
+            int at = p0 - before + k;
+            at = at < start ? start : (at >= end ? end - 1 : at);
+            wl[k] = (float)pcm[at * ch];
+            wr[k] = (float)pcm[at * ch + ch - 1];
+        }
+        float vl, vr;
+        if (quality == RESAMPLE_HERMITE) {
+            vl = resample_hermite(wl[0], wl[1], wl[2], wl[3], frac);
+            vr = stereo ? resample_hermite(wr[0], wr[1], wr[2], wr[3], frac) : vl;
+        } else {
+            vl = resample_sinc_f32(kern, wl, before, frac);
+            vr = stereo ? resample_sinc_f32(kern, wr, before, frac) : vl;
+        }
+        bus_l[i] += vl * g;
+        bus_r[i] += vr * g;
     }
-    else if (strcmp(key, "start_note") == 0) {
-        return snprintf(buf, buf_len, "%d", inst->start_note);
+}
+
+/* Mix one voice into the float stereo bus for up to MOVE_FRAMES_PER_BLOCK
+ * frames. Read positions are stepped first to find where the slice ends
+ * within the block; the envelope is then generated in up to two spans
+ * (before and after the slice-end release), and the sample loop after that
+ * is free of control flow: planar buffers need no interpolation guard, and
+ * interleaved data (lazy slices, planar off) only clamps its reads.
+ * Returns 0 once the voice has finished and should be retired. */
+static int render_voice(rex_instance_t *inst, int id,
+                        float *bus_l, float *bus_r, int frames, float rate)
+{
+    float env[MOVE_FRAMES_PER_BLOCK];
+    float pos[MOVE_FRAMES_PER_BLOCK];
+
+    voice_pool_t *vp = &inst->voices;
+    adsr_t *venv = &vp->env[id];
+    const rex_slice_t *slice = &inst->rex->slices[vp->slice_index[id]];
+    const rex_slice_stats_t *st = &slice->stats;
+    const int16_t *pcm = inst->rex->pcm_data;
+
+    /* Trailing silence is not played. Snap also ends the slice on the
+     * quietest of its last frames, and starts it on the quietest of its
+     * first in place of the shortest attack's fade-in. */
+    uint32_t length = !st->analyzed ? slice->sample_length
+                    : inst->rt.snap ? st->zero_end : st->audible;
+    if (!vp->started[id]) {
+        vp->started[id] = 1;
+        if (inst->rt.snap && st->analyzed) {
+            vp->position[id] = (float)st->zero_start;
+            if (venv->attack <= ADSR_MIN_TIME) adsr_skip_attack(venv);
+        }
     }
-    else if (strcmp(key, "attack") == 0) {
-        return snprintf(buf, buf_len, "%.3f", inst->attack);
+
+    int slice_start = (int)slice->sample_offset;
+    int slice_end = slice_start + (int)length;
+    int pcm_limit = inst->rex->pcm_samples;
+
+    if (inst->rex->lazy) {
+        /* Slice buffers hold just the slice (resident: checked by caller) */
+        pcm = inst->slots[vp->slice_index[id]].pcm;
+        slice_start = 0;
+        slice_end = (int)length;
+        pcm_limit = (int)slice->sample_length;
     }
-    else if (strcmp(key, "decay") == 0) {
-        return snprintf(buf, buf_len, "%.3f", inst->decay);
+    if (pcm_limit < slice_end) slice_end = pcm_limit;
+
+    /* Positions with audio left; frames past the slice end only release */
+    int playing = 0;
+    float p = vp->position[id];
+    while (playing < frames && slice_start + (int)p < slice_end) {
+        pos[playing++] = p;
+        p += rate;
     }
-    else if (strcmp(key, "sustain") == 0) {
-        return snprintf(buf, buf_len, "%.3f", inst->sustain);
+    vp->position[id] = p;
+
+    /* Envelope up to and including the frame that finds the slice end
+     * (the release starts after it), then the rest of the block */
+    int span = (playing < frames) ? playing + 1 : frames;
+    float level;
+    const float *envp = env;
+    if (adsr_block(venv, env, span, &level) == 0) return 0;
+    if (level >= 0.0f) {
+        if (span == frames) envp = NULL;  /* constant all block */
+        else for (int i = 0; i < span; i++) env[i] = level;
     }
-    else if (strcmp(key, "release") == 0) {
-        return snprintf(buf, buf_len, "%.3f", inst->release);
+    if (span < frames) {
+        /* Slice audio finished - force envelope into release */
+        adsr_release(venv);
+        float rel;
+        adsr_block(venv, env + span, frames - span, &rel);
     }
-    else if (strcmp(key, "mode") == 0) {
-        return snprintf(buf, buf_len, "%s", inst->mode ? "gate" : "trigger");
+    int alive = venv->stage != ADSR_IDLE;
+
+    float amp = inst->rt.gain * (vp->velocity[id] / 127.0f);
+
+    /* Most this voice can add to the bus, the envelope being at most 1
+     * (a step more than the peak for 24-bit planes; unknown levels are
+     * sure to count as a possible clip) */
+    if (playing > 0) {
+        inst->mix_peak += st->analyzed
+            ? (float)(st->peak + 1) * inst->rt.overshoot * amp : 65536.0f;
     }
-    else if (strcmp(key, "choke") == 0) {
-        return snprintf(buf, buf_len, "%s", inst->choke ? "on" : "off");
+    if (!envp) amp *= level;
+
+    /* envp == NULL: steady level, one multiply per sample (the branch is
+     * loop-invariant and gets hoisted) */
+    int quality = inst->rt.interpolation;
+    const resample_kernel_t *kern = inst->rt.kernel;
+    if (slice->plane[0]) {
+        mix_planar(inst->rex, slice, quality, kern, pos, envp, amp, playing, bus_l, bus_r);
+    } else {
+        mix_interleaved(pcm, inst->rex->pcm_channels == 2, slice_start, slice_end,
+                        quality, kern, pos, envp, amp, playing, bus_l, bus_r);
     }
-    else if (strcmp(key, "transpose") == 0) {
-        return snprintf(buf, buf_len, "%d", inst->transpose);
+    return alive;
+}
+
+/* Mix every active voice into n frames of the bus */
+static void render_voices(rex_instance_t *inst, float *bus_l, float *bus_r, int n, float rate)
+{
+    /* Backwards, as retiring a voice moves the last entry into its slot */
+    voice_pool_t *vp = &inst->voices;
+    for (int a = vp->active_count - 1; a >= 0; a--) {
+        int id = vp->active[a];
+
+        if (inst->rex->lazy) {
+            /* Wait until the slice has been decoded */
+            slice_slot_t *s = &inst->slots[vp->slice_index[id]];
+            if (!s->pcm) {
+                if (s->failed) pool_stop(vp, id);
+                else request_slice(inst, vp->slice_index[id]);
+                continue;
+            }
+        } else {
+            /* Progressive load: wait until decoding has passed the slice */
+            const rex_slice_t *sl = &inst->rex->slices[vp->slice_index[id]];
+            if (sl->sample_offset + sl->sample_length > inst->decoded) continue;
+        }
+
+        if (!render_voice(inst, id, bus_l, bus_r, n, rate)) pool_stop(vp, id);
     }
-    else if (strcmp(key, "bank_name") == 0) {
-        /* For chain compatibility: bank = folder */
-        strncpy(buf, "REX Loops", buf_len - 1);
-        buf[buf_len - 1] = '\0';
-        return strlen(buf);
+}
+
+/* Render thread: act on a message from the control thread */
+static void apply_control(rex_instance_t *inst, const ctl_msg_t *msg)
+{
+    switch (msg->type) {
+    case CTL_PARAMS:
+        if (msg->params.polyphony != inst->rt.polyphony)
+            pool_reset(&inst->voices, msg->params.polyphony);
+        inst->rt = msg->params;
+        break;
+    case CTL_LOAD:
+        inst->deferred_path = msg->path;
+        inst->deferred_load_countdown = LOAD_DEBOUNCE_BLOCKS;
+        break;
+    case CTL_PANIC:
+        pool_reset(&inst->voices, inst->rt.polyphony);
+        break;
+    case CTL_PERF_RESET:
+        inst->voices.steals = 0;
+        inst->voices.peak = inst->voices.active_count;
+        atomic_store_explicit(&inst->perf.blocks, 0, memory_order_relaxed);
+        atomic_store_explicit(&inst->perf.overruns, 0, memory_order_relaxed);
+        break;
     }
-    else if (strcmp(key, "patch_in_bank") == 0) {
-        return snprintf(buf, buf_len, "%d", inst->file_index + 1);
+}
+
+static void render_block(rex_instance_t *inst, int16_t *out_interleaved_lr, int frames)
+{
+    /* Adopt what the control thread sent, then handle the deferred file
+     * load (debounce for scrolling). The loader worker does the I/O and
+     * decode; we only pick up the result. */
+    ctl_msg_t msg;
+    while (ctl_pop(&inst->ctl_ring, &msg))
+        apply_control(inst, &msg);
+
+    if (inst->deferred_load_countdown > 0) {
+        inst->deferred_load_countdown--;
+        if (inst->deferred_load_countdown == 0) {
+            rex_loader_request(inst->loader, inst->deferred_path);
+        }
     }
-    else if (strcmp(key, "bank_count") == 0) {
-        return snprintf(buf, buf_len, "1");
+    swap_loaded_file(inst);
+    if (inst->rex && inst->rex->lazy) collect_slices(inst);
+    if (inst->rex) inst->decoded = (uint32_t)rex_decoded_frames(inst->rex);
+
+    while (ctl_pop(&inst->midi_ring, &msg))
+        queue_midi(inst, msg.midi.msg, msg.midi.len, msg.midi.offset);
+
+    if (!inst->rex || (!inst->rex->pcm_data && !inst->rex->lazy)) {
+        inst->midi_count = 0;  /* nothing to play them on */
+        memset(out_interleaved_lr, 0, frames * 2 * sizeof(int16_t));
+        return;
     }
-    else if (strcmp(key, "state") == 0) {
-        char escaped_name[256];
-        json_escape(escaped_name, sizeof(escaped_name), inst->file_name);
-        return snprintf(buf, buf_len,
-            "{\"file_name\":\"%s\",\"file_index\":%d,\"gain\":%.2f,\"start_note\":%d,"
-            "\"attack\":%.3f,\"decay\":%.3f,\"sustain\":%.3f,\"release\":%.3f,"
-            "\"mode\":\"%s\",\"choke\":\"%s\",\"transpose\":%d}",
-            escaped_name, inst->file_index, inst->gain, inst->start_note,
-            inst->attack, inst->decay, inst->sustain, inst->release,
-            inst->mode ? "gate" : "trigger", inst->choke ? "on" : "off",
-            inst->transpose);
-    }
-    else if (strcmp(key, "ui_hierarchy") == 0) {
-        const char *hierarchy =
-            "{"
-                "\"modes\":null,"
-                "\"levels\":{"
-                    "\"root\":{"
-                        "\"label\":\"REX\","
-                        "\"list_param\":\"preset\","
-                        "\"count_param\":\"preset_count\","
-                        "\"name_param\":\"preset_name\","
-                        "\"children\":null,"
-                        "\"knobs\":[\"gain\",\"start_note\",\"transpose\",\"attack\",\"decay\",\"sustain\",\"release\",\"mode\",\"choke\"],"
-                        "\"params\":["
-                            "{\"key\":\"gain\",\"label\":\"Gain\"},"
-                            "{\"key\":\"start_note\",\"label\":\"Start Note\"},"
-                            "{\"key\":\"transpose\",\"label\":\"Transpose\"},"
-                            "{\"key\":\"attack\",\"label\":\"Attack\"},"
-                            "{\"key\":\"decay\",\"label\":\"Decay\"},"
-                            "{\"key\":\"sustain\",\"label\":\"Sustain\"},"
-                            "{\"key\":\"release\",\"label\":\"Release\"},"
-                            "{\"key\":\"mode\",\"label\":\"Mode\"},"
-                            "{\"key\":\"choke\",\"label\":\"Choke\"}"
-                        "]"
-                    "}"
-                "}"
-            "}";
-        int len = strlen(hierarchy);
-        if (len < buf_len) {
-            strcpy(buf, hierarchy);
-            return len;
-        }
-        return -1;
-    }
-    else if (strcmp(key, "chain_params") == 0) {
-        const char *params =
-            "["
-                "{\"key\":\"preset\",\"name\":\"File\",\"type\":\"int\",\"min\":0,\"max\":9999},"
-                "{\"key\":\"gain\",\"name\":\"Gain\",\"type\":\"float\",\"min\":0,\"max\":2,\"step\":0.01},"
-                "{\"key\":\"start_note\",\"name\":\"Start Note\",\"type\":\"int\",\"min\":0,\"max\":127,\"step\":1},"
-                "{\"key\":\"attack\",\"name\":\"Attack\",\"type\":\"float\",\"min\":0,\"max\":2,\"step\":0.001},"
-                "{\"key\":\"decay\",\"name\":\"Decay\",\"type\":\"float\",\"min\":0,\"max\":2,\"step\":0.001},"
-                "{\"key\":\"sustain\",\"name\":\"Sustain\",\"type\":\"float\",\"min\":0,\"max\":1,\"step\":0.01},"
-                "{\"key\":\"release\",\"name\":\"Release\",\"type\":\"float\",\"min\":0,\"max\":2,\"step\":0.001},"
-                "{\"key\":\"mode\",\"name\":\"Mode\",\"type\":\"enum\",\"options\":[\"trigger\",\"gate\"]},"
-                "{\"key\":\"choke\",\"name\":\"Choke\",\"type\":\"enum\",\"options\":[\"off\",\"on\"]},"
-                "{\"key\":\"transpose\",\"name\":\"Transpose\",\"type\":\"int\",\"min\":-12,\"max\":12,\"step\":1}"
-            "]";
-        int len = strlen(params);
-        if (len < buf_len) {
-            strcpy(buf, params);
-            return len;
+
+    float rate = inst->rt.rate;
+
+    /* Voices accumulate into a float bus at full precision; the only
+     * saturation is the final conversion to int16, skipped for sub-blocks
+     * whose voices' analyzed peaks can't reach full scale together. */
+    int q = 0;  /* next queued MIDI event */
+    for (int base = 0; base < frames; base += MOVE_FRAMES_PER_BLOCK) {
+        int n = frames - base;
+        if (n > MOVE_FRAMES_PER_BLOCK) n = MOVE_FRAMES_PER_BLOCK;
+
+        float bus_l[MOVE_FRAMES_PER_BLOCK];
+        float bus_r[MOVE_FRAMES_PER_BLOCK];
+        memset(bus_l, 0, n * sizeof(float));
+        memset(bus_r, 0, n * sizeof(float));
+        inst->mix_peak = 0.0f;
+
+        /* Render in spans between MIDI events, applying each at its frame */
+        int done = 0;
+        while (done < n) {
+            while (q < inst->midi_count && inst->midi_queue[q].offset <= base + done) {
+                apply_midi(inst, inst->midi_queue[q].msg, inst->midi_queue[q].len);
+                q++;
+            }
+            int end = n;
+            if (q < inst->midi_count && inst->midi_queue[q].offset < base + n)
+                end = inst->midi_queue[q].offset - base;
+            render_voices(inst, bus_l + done, bus_r + done, end - done, rate);
+            done = end;
         }
-        return -1;
-    }
-    else if (strcmp(key, "load_error") == 0) {
-        if (inst->load_error[0]) {
-            strncpy(buf, inst->load_error, buf_len - 1);
-            buf[buf_len - 1] = '\0';
-            return strlen(buf);
+
+        int16_t *out = out_interleaved_lr + base * 2;
+        if (inst->mix_peak < 32767.0f) {
+            /* The voices' peaks can't add up to a clip: convert as is */
+            for (int i = 0; i < n; i++) {
+                out[i * 2] = (int16_t)bus_l[i];
+                out[i * 2 + 1] = (int16_t)bus_r[i];
+            }
+        } else {
+            for (int i = 0; i < n; i++) {
+                float l = bus_l[i], r = bus_r[i];
+                l = l > 32767.0f ? 32767.0f : (l < -32768.0f ? -32768.0f : l);
+                r = r > 32767.0f ? 32767.0f : (r < -32768.0f ? -32768.0f : r);
+                out[i * 2] = (int16_t)l;
+                out[i * 2 + 1] = (int16_t)r;
+            }
         }
-        return 0;
     }
 
-    return -1;
+    /* Events for later blocks move up, their offsets now relative to the next */
+    int kept = 0;
+    for (; q < inst->midi_count; q++) {
+        inst->midi_queue[kept] = inst->midi_queue[q];
+        inst->midi_queue[kept++].offset -= frames;
+    }
+    inst->midi_count = kept;
 }
 
-/* ------------------------------------------------------------------ */
-/* V2 API: get_error                                                   */
-/* ------------------------------------------------------------------ */
-
-static int v2_get_error(void *instance, char *buf, int buf_len)
+/* Publish the block's time and the voice counters */
+static void perf_record(rex_instance_t *inst, uint64_t ns, int frames)
 {
-    rex_instance_t *inst = (rex_instance_t *)instance;
-    if (!inst || !inst->load_error[0]) return 0;
-
-    int len = strlen(inst->load_error);
-    if (len >= buf_len) len = buf_len - 1;
-    memcpy(buf, inst->load_error, len);
-    buf[len] = '\0';
-    return len;
+    perf_counters_t *pc = &inst->perf;
+    unsigned n = atomic_load_explicit(&pc->blocks, memory_order_relaxed);
+    unsigned t = ns > UINT32_MAX ? UINT32_MAX : (unsigned)ns;
+    atomic_store_explicit(&pc->block_ns[n % PERF_WINDOW], t, memory_order_relaxed);
+    if (ns * MOVE_SAMPLE_RATE > (uint64_t)frames * 1000000000u) {
+        unsigned o = atomic_load_explicit(&pc->overruns, memory_order_relaxed);
+        atomic_store_explicit(&pc->overruns, o + 1, memory_order_relaxed);
+    }
+    atomic_store_explicit(&pc->frames, (unsigned)frames, memory_order_relaxed);
+    atomic_store_explicit(&pc->voices, inst->voices.active_count, memory_order_relaxed);
+    atomic_store_explicit(&pc->voices_peak, inst->voices.peak, memory_order_relaxed);
+    atomic_store_explicit(&pc->steals, inst->voices.steals, memory_order_relaxed);
+    atomic_store_explicit(&pc->slice_bytes, inst->slot_bytes, memory_order_relaxed);
+    atomic_store_explicit(&pc->blocks, n + 1, memory_order_release);
 }
 
-/* ------------------------------------------------------------------ */
-/* V2 API: render_block                                                */
-/* ------------------------------------------------------------------ */
-
 static void v2_render_block(void *instance, int16_t *out_interleaved_lr, int frames)
 {
     rex_instance_t *inst = (rex_instance_t *)instance;
-
-    /* Handle deferred file load (debounce for scrolling) */
-    if (inst && inst->deferred_load_countdown > 0) {
-        inst->deferred_load_countdown--;
-        if (inst->deferred_load_countdown == 0) {
-            load_rex_file(inst, inst->files[inst->deferred_file_index].path);
-        }
+    if (!inst) {
+        memset(out_interleaved_lr, 0, frames * 2 * sizeof(int16_t));
+        return;
     }
 
-    /* Clear output */
-    memset(out_interleaved_lr, 0, frames * 2 * sizeof(int16_t));
-
-    if (!inst || !inst->rex_loaded || !inst->rex.pcm_data) return;
-
-    float gain = inst->gain;
-    float rate = powf(2.0f, inst->transpose / 12.0f);
-
-    /* Mix all active voices */
-    int is_stereo = (inst->rex.pcm_channels == 2);
+    uint64_t t0 = rex_clock_ns();
+    render_block(inst, out_interleaved_lr, frames);
+    perf_record(inst, rex_clock_ns() - t0, frames);
+}
 
-    for (int v = 0; v < MAX_VOICES; v++) {
-        voice_t *voice = &inst->voices[v];
-        if (!voice->active) continue;
+/* ------------------------------------------------------------------ */
+/* Headless rendering (rex_render.h)                                   */
+/* ------------------------------------------------------------------ */
 
-        rex_slice_t *slice = &inst->rex.slices[voice->slice_index];
-        const int16_t *pcm = inst->rex.pcm_data;
-        int slice_start = (int)slice->sample_offset;
-        int slice_end = slice_start + (int)slice->sample_length;
-        int pcm_limit = inst->rex.pcm_samples;
-        float vel_scale = voice->velocity / 127.0f;
-        int slice_done = 0;
+struct rex_render {
+    rex_instance_t *inst;
+};
 
-        for (int i = 0; i < frames; i++) {
-            /* Process envelope */
-            float env_val = adsr_process(&voice->env, (float)MOVE_SAMPLE_RATE);
+rex_render_t *rex_render_open(const char *path, const char *settings,
+                              char *err, int err_len)
+{
+    rex_render_t *r = (rex_render_t *)calloc(1, sizeof(*r));
+    rex_instance_t *inst = r ? instance_alloc() : NULL;
+    if (!inst) {
+        free(r);
+        snprintf(err, err_len, "out of memory");
+        return NULL;
+    }
+    r->inst = inst;
 
-            /* Check if envelope has finished (release complete) */
-            if (voice->env.stage == ADSR_IDLE) {
-                voice->active = 0;
-                break;
-            }
+    if (settings && settings[0]) apply_defaults(inst, settings);
+    inst->lazy = 0;  /* every slice decoded before the first note */
+    instance_ready(inst);
 
-            int ipos = (int)voice->position;
-            int pos = slice_start + ipos;
+    if (rex_loader_load_now(inst->loader, path) != 0) {
+        if (rex_loader_error(inst->loader, err, err_len) <= 0)
+            snprintf(err, err_len, "cannot load %s", path);
+        rex_render_close(r);
+        return NULL;
+    }
+    swap_loaded_file(inst);
+    if (!inst->rex->pcm_data) {
+        snprintf(err, err_len, "%s: no audio", path);
+        rex_render_close(r);
+        return NULL;
+    }
+    const char *name = strrchr(path, '/');
+    set_file_name(inst, name ? name + 1 : path);
+    return r;
+}
 
-            if (!slice_done && (pos >= slice_end || pos >= pcm_limit)) {
-                /* Slice audio finished - force envelope into release */
-                slice_done = 1;
-                adsr_release(&voice->env);
-            }
+const rex_file_t *rex_render_file(const rex_render_t *r)
+{
+    return r->inst->rex;
+}
 
-            float sample_l, sample_r;
-            if (slice_done) {
-                /* No more audio data - envelope is releasing to zero */
-                sample_l = sample_r = 0.0f;
-            } else {
-                float frac = voice->position - (float)ipos;
-                int pos1 = pos + 1;
-                int pos1_valid = (pos1 < slice_end && pos1 < pcm_limit);
-
-                if (is_stereo) {
-                    float s0_l = (float)pcm[pos * 2];
-                    float s0_r = (float)pcm[pos * 2 + 1];
-                    float s1_l = pos1_valid ? (float)pcm[pos1 * 2] : s0_l;
-                    float s1_r = pos1_valid ? (float)pcm[pos1 * 2 + 1] : s0_r;
-                    sample_l = (s0_l + frac * (s1_l - s0_l)) * gain * env_val * vel_scale;
-                    sample_r = (s0_r + frac * (s1_r - s0_r)) * gain * env_val * vel_scale;
-                } else {
-                    float s0 = (float)pcm[pos];
-                    float s1 = pos1_valid ? (float)pcm[pos1] : s0;
-                    sample_l = sample_r = (s0 + frac * (s1 - s0)) * gain * env_val * vel_scale;
-                }
-                voice->position += rate;
-            }
+int rex_render_start_note(const rex_render_t *r)
+{
+    return r->inst->rt.start_note;
+}
 
-            /* Soft clip */
-            if (sample_l > 32767.0f) sample_l = 32767.0f;
-            if (sample_l < -32768.0f) sample_l = -32768.0f;
-            if (sample_r > 32767.0f) sample_r = 32767.0f;
-            if (sample_r < -32768.0f) sample_r = -32768.0f;
+void rex_render_midi(rex_render_t *r, const uint8_t *msg, int len, int frame_offset)
+{
+    if (len < 2) return;
+    queue_midi(r->inst, msg, len, frame_offset);
+}
 
-            /* Mix into stereo output */
-            int32_t left = (int32_t)out_interleaved_lr[i * 2] + (int16_t)sample_l;
-            int32_t right = (int32_t)out_interleaved_lr[i * 2 + 1] + (int16_t)sample_r;
+void rex_render_run(rex_render_t *r, int16_t *out, int frames)
+{
+    render_block(r->inst, out, frames);
+}
 
-            /* Clamp after mixing */
-            if (left > 32767) left = 32767;
-            if (left < -32768) left = -32768;
-            if (right > 32767) right = 32767;
-            if (right < -32768) right = -32768;
+int rex_render_voices(const rex_render_t *r)
+{
+    return r->inst->voices.active_count;
+}
 
-            out_interleaved_lr[i * 2] = (int16_t)left;
-            out_interleaved_lr[i * 2 + 1] = (int16_t)right;
-        }
-    }
+void rex_render_close(rex_render_t *r)
+{
+    if (!r) return;
+    v2_destroy_instance(r->inst);
+    free(r);
 }
 
 /* ------------------------------------------------------------------ */
@@ -1044,7 +2441,8 @@ static plugin_api_v2_t g_plugin_api_v2 = {
     .set_param = v2_set_param,
     .get_param = v2_get_param,
     .get_error = v2_get_error,
-    .render_block = v2_render_block
+    .render_block = v2_render_block,
+    .on_midi_at = v2_on_midi_at
 };
 
 plugin_api_v2_t* move_plugin_init_v2(const host_api_v1_t *host)
@@ -0,0 +1,51 @@
+/*
+ * Headless Rendering
+ *
+ * Drives the plugin's voice engine (rex_plugin.c) without a host: the
+ * same voice pool, envelopes, interpolation and mix bus as on the device,
+ * run on the caller's thread as fast as it can go. Used by rex-render to
+ * bounce loops and MIDI patterns to WAV, and by the benchmarks as a
+ * realistic render workload.
+ *
+ * The caller is the render thread: queue each block's MIDI, then render
+ * it. The loop is decoded in full when opened (lazy mode is not used
+ * offline, so no note waits for a slice to decode).
+ *
+ * License: MIT
+ */
+
+#ifndef REX_RENDER_H
+#define REX_RENDER_H
+
+#include <stdint.h>
+#include "rex_parser.h"
+
+#define REX_RENDER_SAMPLE_RATE 44100  /* output rate, as on the device */
+
+typedef struct rex_render rex_render_t;
+
+/* Load path for rendering. settings is a flat JSON object of module
+ * default keys ("transpose", "interpolation", "attack", ...) or NULL.
+ * Returns NULL on error (message in err). */
+rex_render_t *rex_render_open(const char *path, const char *settings,
+                              char *err, int err_len);
+
+/* The loaded loop (slice table, tempo), valid until rex_render_close() */
+const rex_file_t *rex_render_file(const rex_render_t *r);
+
+/* MIDI note mapped to slice 0 */
+int rex_render_start_note(const rex_render_t *r);
+
+/* Queue msg (up to 3 bytes) to apply frame_offset frames into the next
+ * rex_render_run(). Within a frame, events apply in the order queued. */
+void rex_render_midi(rex_render_t *r, const uint8_t *msg, int len, int frame_offset);
+
+/* Render frames of interleaved stereo int16 */
+void rex_render_run(rex_render_t *r, int16_t *out, int frames);
+
+/* Voices still sounding, for rendering a release tail to silence */
+int rex_render_voices(const rex_render_t *r);
+
+void rex_render_close(rex_render_t *r);
+
+#endif /* REX_RENDER_H */
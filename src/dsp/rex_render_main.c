@@ -0,0 +1,371 @@
+/*
+ * rex-render: CLI tool to render a REX2 loop to WAV offline, through the
+ * plugin's own voice engine (rex_render.h), as fast as the CPU allows.
+ *
+ * Usage: rex-render <input.rx2> <output.wav> [-m file.mid] [-s steps]
+ *                   [-t tempo] [-n repeats] [-p key=value ...] [-T seconds]
+ *
+ *   (default)   the loop as authored: each slice at its own position
+ *   file.mid:   play a Standard MIDI File (notes from start_note, 36 =
+ *               slice 0, as on the device)
+ *   steps:      slice sequence on a 16th-note grid, comma-separated slice
+ *               numbers (0 = first) or '-' for a rest, e.g. "0,1,-,3"
+ *   tempo:      BPM of the step grid (default: the loop's tempo)
+ *   repeats:    times through the pattern (default 1)
+ *   key=value:  plugin parameter, as in module defaults, e.g.
+ *               -p transpose=7 -p interpolation=sinc16
+ *   seconds:    longest tail rendered after the last event while voices
+ *               still sound (default 10)
+ *
+ * Output is 16-bit stereo at 44100 Hz. Notes play at velocity 127 unless
+ * the MIDI file says otherwise, so an authored render returns the loop at
+ * unity gain.
+ * Exit code: 0 = success, 1 = error
+ *
+ * License: MIT
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include "rex_render.h"
+#include "midi_file.h"
+#include "mapped_file.h"
+#include "byte_sink.h"
+
+#define RENDER_CHUNK    1024                 /* frames per rex_render_run() */
+#define TAIL_CHUNK      128                  /* after the pattern: voices retire per block */
+#define DEFAULT_TAIL_S  10.0
+#define MAX_MIDI_BYTES  (64 * 1024 * 1024)
+#define MAX_SETTINGS    4096
+#define WAV_HEADER_BYTES 44
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: rex-render <input.rx2> <output.wav> [-m file.mid] [-s steps]\n"
+                    "                  [-t tempo] [-n repeats] [-p key=value ...] [-T seconds]\n");
+    fprintf(stderr, "  default: the loop as authored; file.mid: MIDI notes from start_note\n");
+    fprintf(stderr, "  steps: 16th-note slice sequence, e.g. \"0,1,-,3\" ('-' = rest)\n");
+    fprintf(stderr, "  key=value: plugin parameter, e.g. transpose=7\n");
+}
+
+/* A pattern: timed messages in frame order, and where it repeats from */
+typedef struct {
+    midi_file_event_t *events;
+    int count;
+    int cap;
+    uint32_t length;         /* frames before the next repeat */
+} pattern_t;
+
+static int pattern_add(pattern_t *pat, uint32_t frame, uint8_t status, uint8_t note, uint8_t vel)
+{
+    if (pat->count == pat->cap) {
+        int cap = pat->cap ? pat->cap * 2 : 64;
+        midi_file_event_t *ev = (midi_file_event_t *)realloc(pat->events,
+                                                             (size_t)cap * sizeof(*ev));
+        if (!ev) return -1;
+        pat->events = ev;
+        pat->cap = cap;
+    }
+    midi_file_event_t *e = &pat->events[pat->count++];
+    e->frame = frame;
+    e->msg[0] = status;
+    e->msg[1] = note;
+    e->msg[2] = vel;
+    e->len = 3;
+    return 0;
+}
+
+static int cmp_event(const void *a, const void *b)
+{
+    const midi_file_event_t *x = (const midi_file_event_t *)a;
+    const midi_file_event_t *y = (const midi_file_event_t *)b;
+    if (x->frame != y->frame) return x->frame < y->frame ? -1 : 1;
+    int x_on = (x->msg[0] & 0xF0) == 0x90, y_on = (y->msg[0] & 0xF0) == 0x90;
+    return x_on - y_on;  /* note-offs first, so a retrigger follows its release */
+}
+
+/* Note on at frame, off len frames later, for slice */
+static int pattern_note(pattern_t *pat, int start_note, int slice, uint32_t frame, uint32_t len)
+{
+    int note = start_note + slice;
+    if (note < 0 || note > 127) return 0;  /* not playable from MIDI either */
+    if (pattern_add(pat, frame, 0x90, (uint8_t)note, 127) != 0) return -1;
+    return pattern_add(pat, frame + (len ? len : 1), 0x80, (uint8_t)note, 0);
+}
+
+/* Every slice at its sample offset, held until the next one starts */
+static int pattern_authored(pattern_t *pat, const rex_file_t *rex, int start_note)
+{
+    for (int i = 0; i < rex->slice_count; i++) {
+        const rex_slice_t *s = &rex->slices[i];
+        if (s->sample_length == 0) continue;
+        uint32_t next = i + 1 < rex->slice_count ? rex->slices[i + 1].sample_offset
+                                                 : s->sample_offset + s->sample_length;
+        if (pattern_note(pat, start_note, i, s->sample_offset, next - s->sample_offset) != 0)
+            return -1;
+    }
+    pat->length = (uint32_t)rex->pcm_samples;
+    return 0;
+}
+
+/* "0,1,-,3": one step per 16th note at tempo */
+static int pattern_steps(pattern_t *pat, const char *steps, double tempo,
+                         const rex_file_t *rex, int start_note, char *err, int err_len)
+{
+    double step = REX_RENDER_SAMPLE_RATE * 60.0 / (tempo * 4.0);
+    int n = 0;
+    const char *p = steps;
+    for (;;) {
+        while (*p == ' ') p++;
+        if (*p == '-') {
+            p++;
+        } else {
+            char *end;
+            long slice = strtol(p, &end, 10);
+            if (end == p || slice < 0 || slice >= rex->slice_count) {
+                snprintf(err, err_len, "step %d: need a slice 0-%d or '-'", n + 1,
+                         rex->slice_count - 1);
+                return -1;
+            }
+            p = end;
+            uint32_t at = (uint32_t)(n * step + 0.5);
+            uint32_t len = (uint32_t)((n + 1) * step + 0.5) - at;
+            if (pattern_note(pat, start_note, (int)slice, at, len) != 0) {
+                snprintf(err, err_len, "out of memory");
+                return -1;
+            }
+        }
+        n++;
+        while (*p == ' ') p++;
+        if (*p == '\0') break;
+        if (*p != ',') {
+            snprintf(err, err_len, "step %d: expected ','", n);
+            return -1;
+        }
+        p++;
+    }
+    pat->length = (uint32_t)(n * step + 0.5);
+    return 0;
+}
+
+static int pattern_midi(pattern_t *pat, const char *path, char *err, int err_len)
+{
+    mapped_file_t file;
+    if (mapped_file_open(&file, path, MAX_MIDI_BYTES, err, err_len) != 0) return -1;
+    midi_file_t mf;
+    int rc = midi_file_read(&mf, file.data, file.len, REX_RENDER_SAMPLE_RATE);
+    mapped_file_close(&file);
+    if (rc != 0) {
+        snprintf(err, err_len, "%s: %s", path, mf.error);
+        return -1;
+    }
+    pat->events = mf.events;  /* handed over: freed with the pattern */
+    pat->count = pat->cap = mf.event_count;
+    pat->length = mf.end_frame;
+    return 0;
+}
+
+/* Append "key":"value" from key=value to the settings object */
+static int add_setting(char *json, size_t cap, const char *kv)
+{
+    const char *eq = strchr(kv, '=');
+    if (!eq || eq == kv) return -1;
+    size_t len = strlen(json);
+    char *out = json + len;
+    size_t room = cap - len;
+    int n = snprintf(out, room, "%s\"%.*s\":\"", len > 1 ? "," : "", (int)(eq - kv), kv);
+    if (n < 0 || (size_t)n >= room) return -1;
+    for (const char *v = eq + 1; *v; v++) {
+        if ((size_t)n + 3 >= room) return -1;
+        if (*v == '"' || *v == '\\') out[n++] = '\\';
+        out[n++] = *v;
+    }
+    if ((size_t)n + 2 >= room) return -1;
+    out[n++] = '"';
+    out[n] = '\0';
+    return 0;
+}
+
+static void put_u32_le(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/* 16-bit stereo WAV header for frames of audio */
+static void wav_header(uint8_t *h, uint32_t frames)
+{
+    uint32_t data_bytes = frames * 4;
+    memcpy(h, "RIFF", 4);
+    put_u32_le(h + 4, 36 + data_bytes);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put_u32_le(h + 16, 16);
+    h[20] = 1; h[21] = 0;                    /* PCM */
+    h[22] = 2; h[23] = 0;                    /* stereo */
+    put_u32_le(h + 24, REX_RENDER_SAMPLE_RATE);
+    put_u32_le(h + 28, REX_RENDER_SAMPLE_RATE * 4);
+    h[32] = 4; h[33] = 0;                    /* block align */
+    h[34] = 16; h[35] = 0;                   /* bits per sample */
+    memcpy(h + 36, "data", 4);
+    put_u32_le(h + 40, data_bytes);
+}
+
+/* Render repeats of pat, then the tail, streaming into sink. Returns the
+ * frames written, or -1 if the sink failed. */
+static long render_pattern(rex_render_t *r, const pattern_t *pat, int repeats,
+                           double tail_s, byte_sink_t *sink)
+{
+    int16_t out[RENDER_CHUNK * 2];
+    uint64_t end = (uint64_t)pat->length * repeats;
+    if (pat->count > 0) {
+        uint64_t last = (uint64_t)pat->length * (repeats - 1) + pat->events[pat->count - 1].frame + 1;
+        if (last > end) end = last;
+    }
+    uint64_t tail_end = end + (uint64_t)(tail_s * REX_RENDER_SAMPLE_RATE);
+    uint64_t pos = 0;
+    int rep = 0, next = 0;
+
+    while (pos < end || (pos < tail_end && rex_render_voices(r) > 0)) {
+        int n = RENDER_CHUNK;
+        if (pos < end && end - pos < (uint64_t)n) n = (int)(end - pos);
+        if (pos >= end) n = tail_end - pos < TAIL_CHUNK ? (int)(tail_end - pos) : TAIL_CHUNK;
+
+        /* This chunk's events, at their offsets into it */
+        while (rep < repeats) {
+            if (next == pat->count) {
+                next = 0;
+                rep++;
+                continue;
+            }
+            uint64_t at = (uint64_t)pat->length * rep + pat->events[next].frame;
+            if (at >= pos + n) break;
+            const midi_file_event_t *e = &pat->events[next++];
+            rex_render_midi(r, e->msg, e->len, (int)(at - pos));
+        }
+
+        rex_render_run(r, out, n);
+        if (byte_sink_write(sink, out, (size_t)n * 4) != 0) return -1;
+        pos += n;
+    }
+    return (long)pos;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+
+    const char *rex_path = argv[1];
+    const char *wav_path = argv[2];
+    const char *midi_path = NULL, *steps = NULL;
+    double tempo = 0.0, tail_s = DEFAULT_TAIL_S;
+    int repeats = 1;
+    char settings[MAX_SETTINGS] = "{";
+
+    for (int i = 3; i < argc; i++) {
+        const char *opt = argv[i];
+        if (opt[0] != '-' || !opt[1] || opt[2] || i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        const char *val = argv[++i];
+        switch (opt[1]) {
+        case 'm': midi_path = val; break;
+        case 's': steps = val; break;
+        case 't': tempo = atof(val); break;
+        case 'n': repeats = atoi(val); break;
+        case 'T': tail_s = atof(val); break;
+        case 'p':
+            if (add_setting(settings, sizeof(settings) - 1, val) != 0) {
+                fprintf(stderr, "Error: bad parameter '%s' (need key=value)\n", val);
+                return 1;
+            }
+            break;
+        default:
+            usage();
+            return 1;
+        }
+    }
+    strcat(settings, "}");
+    if ((midi_path && steps) || repeats < 1 || tempo < 0.0 || tail_s < 0.0) {
+        usage();
+        return 1;
+    }
+
+    char err[512];
+    rex_render_t *r = rex_render_open(rex_path, settings, err, sizeof(err));
+    if (!r) {
+        fprintf(stderr, "Error: %s\n", err);
+        return 1;
+    }
+    const rex_file_t *rex = rex_render_file(r);
+    int start_note = rex_render_start_note(r);
+
+    pattern_t pat;
+    memset(&pat, 0, sizeof(pat));
+    int rc;
+    if (midi_path) {
+        rc = pattern_midi(&pat, midi_path, err, sizeof(err));
+    } else if (steps) {
+        if (tempo == 0.0) tempo = rex->tempo_bpm > 0.0f ? rex->tempo_bpm : 120.0;
+        rc = pattern_steps(&pat, steps, tempo, rex, start_note, err, sizeof(err));
+    } else {
+        rc = pattern_authored(&pat, rex, start_note);
+        if (rc != 0) snprintf(err, sizeof(err), "out of memory");
+    }
+    if (rc == 0 && !midi_path)
+        qsort(pat.events, pat.count, sizeof(pat.events[0]), cmp_event);
+    if (rc != 0) {
+        fprintf(stderr, "Error: %s\n", err);
+        free(pat.events);
+        rex_render_close(r);
+        return 1;
+    }
+
+    int fd = open(wav_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    byte_sink_t sink;
+    if (fd < 0 || byte_sink_init_fd(&sink, fd) != 0) {
+        fprintf(stderr, "Error: cannot write %s\n", wav_path);
+        if (fd >= 0) close(fd);
+        free(pat.events);
+        rex_render_close(r);
+        return 1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    uint8_t header[WAV_HEADER_BYTES];
+    wav_header(header, 0);  /* sizes patched once known */
+    byte_sink_write(&sink, header, sizeof(header));
+    long frames = render_pattern(r, &pat, repeats, tail_s, &sink);
+    if (frames >= 0) {
+        wav_header(header, (uint32_t)frames);
+        byte_sink_patch(&sink, 0, header, sizeof(header));
+    }
+    int failed = frames < 0 || byte_sink_flush(&sink) != 0 || byte_sink_error(&sink);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    byte_sink_free(&sink);
+    failed |= close(fd) != 0;
+    free(pat.events);
+    rex_render_close(r);
+    if (failed) {
+        fprintf(stderr, "Error: writing %s failed\n", wav_path);
+        unlink(wav_path);
+        return 1;
+    }
+
+    double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    double audio = (double)frames / REX_RENDER_SAMPLE_RATE;
+    fprintf(stderr, "OK: %ld frames (%.2f s) in %.1f ms, %.0fx real time\n",
+            frames, audio, secs * 1e3, secs > 0.0 ? audio / secs : 0.0);
+    return 0;
+}
@@ -0,0 +1,295 @@
+/*
+ * Decoded PCM Sidecar Files
+ *
+ * Layout: a fixed sidecar_header_t, zero padded to header_bytes, followed
+ * by pcm_samples * pcm_channels interleaved int16 samples. The header
+ * carries the slice analysis too, so a hit skips that pass as well. Fields are in
+ * host byte order; the magic doubles as a byte order check, and sidecars
+ * from another machine or format version are simply rebuilt.
+ *
+ * License: MIT
+ */
+
+#include "rex_sidecar.h"
+#include "mapped_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define SIDECAR_MAGIC   0x43505852u  /* "RXPC" */
+#define SIDECAR_VERSION 2
+#define SIDECAR_ALIGN   64           /* PCM start within the file */
+#define SIDECAR_MAX_SIZE (64u * 1024 * 1024)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_bytes;          /* offset of the PCM data */
+    uint32_t reserved;
+
+    /* Source file identity */
+    int64_t src_size;
+    int64_t src_mtime;
+
+    /* rex_file_t fields */
+    float tempo_bpm;
+    int32_t bars;
+    int32_t beats;
+    int32_t time_sig_num;
+    int32_t time_sig_den;
+    int32_t sample_rate;
+    int32_t channels;
+    int32_t bytes_per_sample;
+    int32_t pcm_samples;
+    int32_t pcm_channels;
+    uint32_t total_sample_length;
+    int32_t slice_count;
+    uint32_t slice_offset[REX_MAX_SLICES];
+    uint32_t slice_length[REX_MAX_SLICES];
+
+    /* Slice analysis, if the writer had it (else redone on load) */
+    int32_t analyzed;
+    rex_slice_stats_t slice_stats[REX_MAX_SLICES];
+} sidecar_header_t;
+
+static atomic_int g_enabled = 1;
+
+void rex_sidecar_set_enabled(int enabled)
+{
+    atomic_store(&g_enabled, enabled ? 1 : 0);
+}
+
+int rex_sidecar_enabled(void)
+{
+    return atomic_load(&g_enabled);
+}
+
+/* Directory part of src_path (without the slash) and its file name */
+static int split_path(const char *src_path, char *dir, int dir_len, const char **name)
+{
+    const char *slash = strrchr(src_path, '/');
+    int n;
+    if (slash) {
+        n = snprintf(dir, dir_len, "%.*s", (int)(slash - src_path), src_path);
+        *name = slash + 1;
+    } else {
+        n = snprintf(dir, dir_len, ".");
+        *name = src_path;
+    }
+    return (n < 0 || n >= dir_len) ? -1 : 0;
+}
+
+int rex_sidecar_path(const char *src_path, char *out, int out_len)
+{
+    char dir[512];
+    const char *name;
+    if (split_path(src_path, dir, sizeof(dir), &name) != 0) return -1;
+    int n = snprintf(out, out_len, "%s/" REX_SIDECAR_DIR "/%s.pcm", dir, name);
+    return (n < 0 || n >= out_len) ? -1 : 0;
+}
+
+static size_t header_bytes(void)
+{
+    return (sizeof(sidecar_header_t) + SIDECAR_ALIGN - 1) / SIDECAR_ALIGN * SIDECAR_ALIGN;
+}
+
+int rex_sidecar_load(const char *src_path, rex_file_t *rex, rex_arena_t *arena)
+{
+    memset(rex, 0, sizeof(*rex));
+    if (!rex_sidecar_enabled()) return -1;
+
+    struct stat st;
+    char path[1024], err[256];
+    if (stat(src_path, &st) != 0 || rex_sidecar_path(src_path, path, sizeof(path)) != 0)
+        return -1;
+
+    mapped_file_t mf;
+    if (mapped_file_open(&mf, path, SIDECAR_MAX_SIZE, err, sizeof(err)) != 0) return -1;
+
+    /* Validate before trusting any field */
+    const sidecar_header_t *h = (const sidecar_header_t *)mf.data;
+    int ok = mf.len >= sizeof(*h) &&
+             h->magic == SIDECAR_MAGIC && h->version == SIDECAR_VERSION &&
+             h->header_bytes == header_bytes() &&
+             h->src_size == (int64_t)st.st_size && h->src_mtime == (int64_t)st.st_mtime &&
+             (h->pcm_channels == 1 || h->pcm_channels == 2) &&
+             h->pcm_samples > 0 &&
+             h->slice_count > 0 && h->slice_count <= REX_MAX_SLICES &&
+             mf.len == h->header_bytes +
+                        (size_t)h->pcm_samples * h->pcm_channels * sizeof(int16_t);
+    for (int i = 0; ok && i < h->slice_count; i++) {
+        ok = (uint64_t)h->slice_offset[i] + h->slice_length[i] <= (uint64_t)h->pcm_samples;
+        const rex_slice_stats_t *st = &h->slice_stats[i];
+        if (ok && h->analyzed) {
+            ok = st->analyzed && st->audible <= h->slice_length[i] &&
+                 st->zero_end <= st->audible && st->zero_start <= st->zero_end;
+        }
+    }
+    /* Copied out rather than played from the mapping: file pages can be
+     * reclaimed, and the render thread must never fault on disk I/O */
+    int16_t *pcm = NULL;
+    if (ok) {
+        size_t pcm_bytes = mf.len - h->header_bytes;
+        pcm = (int16_t *)rex_arena_alloc(arena, pcm_bytes);
+        if (pcm) memcpy(pcm, mf.data + h->header_bytes, pcm_bytes);
+    }
+    if (!pcm) {
+        mapped_file_close(&mf);
+        return -1;
+    }
+
+    rex->tempo_bpm = h->tempo_bpm;
+    rex->bars = h->bars;
+    rex->beats = h->beats;
+    rex->time_sig_num = h->time_sig_num;
+    rex->time_sig_den = h->time_sig_den;
+    rex->sample_rate = h->sample_rate;
+    rex->channels = h->channels;
+    rex->bytes_per_sample = h->bytes_per_sample;
+    rex->total_sample_length = h->total_sample_length;
+    rex->slice_count = h->slice_count;
+    for (int i = 0; i < h->slice_count; i++) {
+        rex->slices[i].sample_offset = h->slice_offset[i];
+        rex->slices[i].sample_length = h->slice_length[i];
+        if (h->analyzed) rex->slices[i].stats = h->slice_stats[i];
+    }
+    rex->pcm_samples = h->pcm_samples;
+    atomic_store_explicit(&rex->decoded, h->pcm_samples, memory_order_release);
+    rex->pcm_channels = h->pcm_channels;
+    rex->pcm_data = pcm;
+    rex->arena = arena;
+    if (!h->analyzed) rex_analyze_slices(rex);
+    mapped_file_close(&mf);
+    return 0;
+}
+
+/* Write all of len bytes at offset. Returns 0, or -1 on error. */
+static int pwrite_full(int fd, const void *buf, size_t len, off_t offset)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+    while (len > 0) {
+        ssize_t n = pwrite(fd, p, len, offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+        offset += n;
+    }
+    return 0;
+}
+
+int rex_sidecar_begin(rex_sidecar_writer_t *w, const char *src_path)
+{
+    memset(w, 0, sizeof(*w));
+    w->fd = -1;
+    if (!rex_sidecar_enabled()) return -1;
+
+    char dir[512];
+    const char *name;
+    if (split_path(src_path, dir, sizeof(dir), &name) != 0 ||
+        rex_sidecar_path(src_path, w->path, sizeof(w->path)) != 0)
+        return -1;
+
+    /* Write beside the final name, then rename over it */
+    char cache_dir[600];
+    snprintf(cache_dir, sizeof(cache_dir), "%s/" REX_SIDECAR_DIR, dir);
+    mkdir(cache_dir, 0755);  /* usually exists already */
+    snprintf(w->tmp, sizeof(w->tmp), "%s.XXXXXX", w->path);
+
+    /* Unique name: several loader threads may store the same loop */
+    w->fd = mkstemp(w->tmp);
+    if (w->fd < 0) return -1;
+    fchmod(w->fd, 0644);
+    return 0;
+}
+
+int rex_sidecar_append(rex_sidecar_writer_t *w, const int16_t *pcm, size_t samples)
+{
+    size_t bytes = samples * sizeof(int16_t);
+    if (w->fd < 0 || header_bytes() + w->pcm_bytes + bytes > SIDECAR_MAX_SIZE) return -1;
+    if (pwrite_full(w->fd, pcm, bytes, (off_t)(header_bytes() + w->pcm_bytes)) != 0) return -1;
+    w->pcm_bytes += bytes;
+    return 0;
+}
+
+void rex_sidecar_abort(rex_sidecar_writer_t *w)
+{
+    if (w->fd < 0) return;
+    close(w->fd);
+    unlink(w->tmp);
+    w->fd = -1;
+}
+
+int rex_sidecar_finish(rex_sidecar_writer_t *w, const char *src_path, const rex_file_t *rex)
+{
+    if (w->fd < 0) return -1;
+
+    struct stat st;
+    size_t pcm_bytes = (size_t)rex->pcm_samples * rex->pcm_channels * sizeof(int16_t);
+    if (stat(src_path, &st) != 0 || pcm_bytes != w->pcm_bytes ||
+        rex->slice_count <= 0 || rex->slice_count > REX_MAX_SLICES) {
+        rex_sidecar_abort(w);
+        return -1;
+    }
+
+    /* Header block, zero padded up to the PCM */
+    uint8_t *head = (uint8_t *)calloc(1, header_bytes());
+    if (!head) {
+        rex_sidecar_abort(w);
+        return -1;
+    }
+    sidecar_header_t *h = (sidecar_header_t *)head;
+    h->magic = SIDECAR_MAGIC;
+    h->version = SIDECAR_VERSION;
+    h->header_bytes = (uint32_t)header_bytes();
+    h->src_size = (int64_t)st.st_size;
+    h->src_mtime = (int64_t)st.st_mtime;
+    h->tempo_bpm = rex->tempo_bpm;
+    h->bars = rex->bars;
+    h->beats = rex->beats;
+    h->time_sig_num = rex->time_sig_num;
+    h->time_sig_den = rex->time_sig_den;
+    h->sample_rate = rex->sample_rate;
+    h->channels = rex->channels;
+    h->bytes_per_sample = rex->bytes_per_sample;
+    h->pcm_samples = rex->pcm_samples;
+    h->pcm_channels = rex->pcm_channels;
+    h->total_sample_length = rex->total_sample_length;
+    h->slice_count = rex->slice_count;
+    h->analyzed = 1;
+    for (int i = 0; i < rex->slice_count; i++) {
+        h->slice_offset[i] = rex->slices[i].sample_offset;
+        h->slice_length[i] = rex->slices[i].sample_length;
+        h->slice_stats[i] = rex->slices[i].stats;
+        if (!rex->slices[i].stats.analyzed) h->analyzed = 0;
+    }
+
+    int rc = pwrite_full(w->fd, head, header_bytes(), 0);
+    free(head);
+    if (close(w->fd) != 0) rc = -1;
+    w->fd = -1;
+    if (rc == 0 && rename(w->tmp, w->path) != 0) rc = -1;
+    if (rc != 0) unlink(w->tmp);
+    return rc;
+}
+
+int rex_sidecar_store(const char *src_path, const rex_file_t *rex)
+{
+    if (!rex_sidecar_enabled() || rex->lazy || !rex->pcm_data) return -1;
+
+    size_t samples = (size_t)rex->pcm_samples * rex->pcm_channels;
+    if (header_bytes() + samples * sizeof(int16_t) > SIDECAR_MAX_SIZE) return -1;
+
+    rex_sidecar_writer_t w;
+    if (rex_sidecar_begin(&w, src_path) != 0) return -1;
+    if (rex_sidecar_append(&w, rex->pcm_data, samples) != 0) {
+        rex_sidecar_abort(&w);
+        return -1;
+    }
+    return rex_sidecar_finish(&w, src_path, rex);
+}
@@ -0,0 +1,72 @@
+/*
+ * Decoded PCM Sidecar Files
+ *
+ * On-disk companion to the in-memory loop cache. Next to each loop, in a
+ * hidden .rexcache directory, a sidecar holds the loop's decoded PCM,
+ * parsed header, slice table and slice analysis, so a cold start (new
+ * set, reboot) maps the audio back in instead of running the DWOP
+ * decoder. A sidecar is only used if it was written by this format
+ * version for a source file of the same size and mtime; anything else
+ * counts as a miss and is rewritten.
+ *
+ * Sidecars are written to a temporary file and renamed into place, so a
+ * mapping of an older sidecar stays valid when it is replaced.
+ *
+ * License: MIT
+ */
+
+#ifndef REX_SIDECAR_H
+#define REX_SIDECAR_H
+
+#include "rex_parser.h"
+
+/* Hidden per-folder directory for sidecars (and other derived files) */
+#define REX_SIDECAR_DIR ".rexcache"
+
+/* Sidecar path for a loop: <dir>/.rexcache/<file>.pcm.
+ * Returns 0, or -1 if it does not fit in out. */
+int rex_sidecar_path(const char *src_path, char *out, int out_len);
+
+/* Fill rex from src_path's sidecar: a mapped read and one copy of the PCM
+ * into a buffer from arena (NULL: plain heap), no decoding. Returns 0 on a
+ * hit, -1 if there is no sidecar or it is stale or malformed. Release with
+ * rex_free() as for rex_parse(). */
+int rex_sidecar_load(const char *src_path, rex_file_t *rex, rex_arena_t *arena);
+
+/* Write the sidecar for src_path from a fully decoded rex (not lazy).
+ * Returns 0 on success, -1 on error. */
+int rex_sidecar_store(const char *src_path, const rex_file_t *rex);
+
+/* Incremental sidecar writing, for a converter that has the audio before
+ * the source file is complete: PCM is appended as it is produced and the
+ * header is written last, from the finished source's metadata. */
+typedef struct {
+    int fd;
+    size_t pcm_bytes;        /* appended so far */
+    char path[1024];
+    char tmp[1100];
+} rex_sidecar_writer_t;
+
+/* Start a sidecar for src_path. Returns 0, or -1 (nothing to clean up) if
+ * sidecars are disabled or the file cannot be created. */
+int rex_sidecar_begin(rex_sidecar_writer_t *w, const char *src_path);
+
+/* Append interleaved 16-bit samples. Returns 0, or -1 on error or once the
+ * sidecar grows too large to be loaded; the writer must still be finished
+ * or aborted. */
+int rex_sidecar_append(rex_sidecar_writer_t *w, const int16_t *pcm, size_t samples);
+
+/* Write the header from rex (its pcm_data is not used; pcm_samples and
+ * pcm_channels must describe what was appended), take the identity of
+ * src_path as it is now, and move the sidecar into place. Returns 0 on
+ * success, -1 on error. The writer is released either way. */
+int rex_sidecar_finish(rex_sidecar_writer_t *w, const char *src_path, const rex_file_t *rex);
+
+/* Discard an unfinished sidecar */
+void rex_sidecar_abort(rex_sidecar_writer_t *w);
+
+/* Process-wide switch for reading and writing sidecars (default on) */
+void rex_sidecar_set_enabled(int enabled);
+int rex_sidecar_enabled(void);
+
+#endif /* REX_SIDECAR_H */
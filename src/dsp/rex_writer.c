@@ -12,6 +12,8 @@
  *     "SDAT" [len] — DWOP compressed audio
  *
  * All values big-endian. IFF alignment: odd-length chunks get 1 pad byte.
+ * Chunks are written in order, with the CAT and SDAT lengths back-patched
+ * once the compressed size is known.
  *
  * License: MIT
  */
@@ -41,169 +43,150 @@ static void write_tag(uint8_t *p, const char *tag)
     p[0] = tag[0]; p[1] = tag[1]; p[2] = tag[2]; p[3] = tag[3];
 }
 
-/* Write a chunk header (tag + length). Returns bytes written (8). */
-static int write_chunk_header(uint8_t *buf, int pos, int cap,
-                               const char *tag, uint32_t data_len)
+/* Append a chunk header (tag + length) */
+static int put_chunk_header(byte_sink_t *sink, const char *tag, uint32_t data_len)
 {
-    if (pos + 8 > cap) return -1;
-    write_tag(buf + pos, tag);
-    write_u32_be(buf + pos + 4, data_len);
-    return 8;
+    uint8_t h[8];
+    write_tag(h, tag);
+    write_u32_be(h + 4, data_len);
+    return byte_sink_write(sink, h, sizeof(h));
 }
 
-int rex_write(const rex_write_params_t *params, uint8_t *buf, int buf_cap)
+/* Append a chunk with its data and IFF pad byte */
+static int put_chunk(byte_sink_t *sink, const char *tag, const uint8_t *data, uint32_t len)
 {
-    if (!params || !params->pcm_data || params->num_frames <= 0)
-        return 0;
-    if (params->slice_count <= 0 || !params->slices)
-        return 0;
-
-    /* --- Phase 1: Compress audio into temporary buffer --- */
-
-    /* Allocate generous compressed buffer */
-    int comp_cap = params->num_frames * params->channels * 3 + 4096;
-    uint8_t *comp_buf = (uint8_t *)malloc(comp_cap);
-    if (!comp_buf) return 0;
+    static const uint8_t pad = 0;
+    if (put_chunk_header(sink, tag, len) != 0) return -1;
+    if (byte_sink_write(sink, data, len) != 0) return -1;
+    if ((len & 1) && byte_sink_write(sink, &pad, 1) != 0) return -1;
+    return 0;
+}
 
-    int comp_bytes;
-    if (params->channels == 2) {
-        comp_bytes = dwop_encode_stereo(params->pcm_data, params->num_frames,
-                                         comp_buf, comp_cap, 1);
-    } else {
-        dwop_enc_state_t enc;
-        dwop_enc_init(&enc, comp_buf, comp_cap);
-        int encoded = dwop_encode(&enc, params->pcm_data, params->num_frames, 1);
-        if (encoded != params->num_frames) {
-            free(comp_buf);
-            return 0;
+/* Encode the SDAT audio from params->read_pcm, one block at a time.
+ * Returns the compressed byte count, or 0 on error. */
+static int encode_streamed(const rex_write_params_t *params, byte_sink_t *sink)
+{
+    int ch = params->channels;
+    int16_t *block = (int16_t *)malloc((size_t)REX_WRITE_BLOCK * ch * sizeof(int16_t));
+    if (!block) return 0;
+
+    dwop_stereo_enc_t enc;  /* enc.bw alone is the mono encoder */
+    int rc = ch == 2 ? dwop_stereo_enc_init_sink(&enc, sink) : dwop_enc_init_sink(&enc.bw, sink);
+    int left = params->num_frames;
+    while (rc == 0 && left > 0) {
+        int want = left < REX_WRITE_BLOCK ? left : REX_WRITE_BLOCK;
+        int got = params->read_pcm(params->read_ctx, block, want);
+        if (got <= 0 || got > want) {
+            rc = -1;
+            break;
         }
-        comp_bytes = dwop_enc_flush(&enc);
-    }
-
-    if (comp_bytes <= 0) {
-        free(comp_buf);
-        return 0;
+        int encoded = ch == 2 ? dwop_stereo_enc_block(&enc, block, got, 1)
+                              : dwop_encode(&enc.bw, block, got, 1);
+        if (encoded != got) rc = -1;
+        left -= got;
     }
+    free(block);
 
-    /* --- Phase 2: Compute sizes --- */
-
-    /* GLOB: 20 bytes data */
-    int glob_data = 20;
-    int glob_chunk = 8 + glob_data;  /* no pad needed, 20 is even */
-
-    /* HEAD: 6 bytes data */
-    int head_data = 6;
-    int head_chunk = 8 + head_data;  /* 6 is even */
-
-    /* SINF: 10 bytes data */
-    int sinf_data = 10;
-    int sinf_chunk = 8 + sinf_data;  /* 10 is even */
-
-    /* SLCE: 11 bytes data each, odd → 1 pad byte each */
-    int slce_data = 11;
-    int slce_padded = slce_data + 1;  /* pad to even */
-    int slce_total = params->slice_count * (8 + slce_padded);
-
-    /* SDAT: variable length */
-    int sdat_data = comp_bytes;
-    int sdat_padded = sdat_data + (sdat_data & 1);  /* pad if odd */
-    int sdat_chunk = 8 + sdat_padded;
-
-    /* CAT contents: "REX " (4 bytes) + all chunks */
-    int cat_content = 4 + glob_chunk + head_chunk + sinf_chunk + slce_total + sdat_chunk;
-
-    /* Total file: "CAT " (4) + length (4) + content */
-    int total = 8 + cat_content;
+    int comp_bytes = dwop_enc_flush(&enc.bw);
+    return rc == 0 ? comp_bytes : 0;
+}
 
-    if (total > buf_cap) {
-        free(comp_buf);
+int rex_write_sink(const rex_write_params_t *params, byte_sink_t *sink)
+{
+    if (!params || (!params->pcm_data && !params->read_pcm) || params->num_frames <= 0)
+        return 0;
+    if (params->slice_count <= 0 || !params->slices)
+        return 0;
+    if (params->channels != 1 && params->channels != 2)
         return 0;
-    }
-
-    /* --- Phase 3: Write the file --- */
-
-    int pos = 0;
 
-    /* CAT header */
-    write_tag(buf + pos, "CAT ");
-    write_u32_be(buf + pos + 4, (uint32_t)cat_content);
-    pos += 8;
+    size_t start = byte_sink_tell(sink);
 
-    /* "REX " type */
-    write_tag(buf + pos, "REX ");
-    pos += 4;
+    /* CAT header; its length is patched in at the end */
+    uint8_t cat[12];
+    write_tag(cat, "CAT ");
+    write_u32_be(cat + 4, 0);
+    write_tag(cat + 8, "REX ");
+    if (byte_sink_write(sink, cat, sizeof(cat)) != 0) return 0;
 
     /* GLOB chunk */
-    write_chunk_header(buf, pos, buf_cap, "GLOB", glob_data);
-    pos += 8;
-    {
-        uint8_t *g = buf + pos;
-        memset(g, 0, glob_data);
-        /* [0:4] reserved */
-        write_u16_be(g + 4, (uint16_t)params->bars);
-        g[6] = (uint8_t)params->beats;
-        g[7] = (uint8_t)params->time_sig_num;
-        g[8] = (uint8_t)params->time_sig_den;
-        g[9] = 0x40;                          /* sensitivity */
-        write_u16_be(g + 10, 0x7FFF);         /* gate */
-        write_u16_be(g + 12, 0x7FFF);         /* gain */
-        write_u16_be(g + 14, 0x4000);         /* pitch (neutral) */
-        uint32_t tempo_milli = (uint32_t)(params->tempo_bpm * 1000.0f + 0.5f);
-        write_u32_be(g + 16, tempo_milli);
-        pos += glob_data;
-    }
+    uint8_t g[20];
+    memset(g, 0, sizeof(g));
+    /* [0:4] reserved */
+    write_u16_be(g + 4, (uint16_t)params->bars);
+    g[6] = (uint8_t)params->beats;
+    g[7] = (uint8_t)params->time_sig_num;
+    g[8] = (uint8_t)params->time_sig_den;
+    g[9] = 0x40;                          /* sensitivity */
+    write_u16_be(g + 10, 0x7FFF);         /* gate */
+    write_u16_be(g + 12, 0x7FFF);         /* gain */
+    write_u16_be(g + 14, 0x4000);         /* pitch (neutral) */
+    uint32_t tempo_milli = (uint32_t)(params->tempo_bpm * 1000.0f + 0.5f);
+    write_u32_be(g + 16, tempo_milli);
+    if (put_chunk(sink, "GLOB", g, sizeof(g)) != 0) return 0;
 
     /* HEAD chunk */
-    write_chunk_header(buf, pos, buf_cap, "HEAD", head_data);
-    pos += 8;
-    {
-        uint8_t *h = buf + pos;
-        memset(h, 0, head_data);
-        h[5] = 2;  /* bytes_per_sample = 2 (16-bit) */
-        pos += head_data;
-    }
+    uint8_t h[6];
+    memset(h, 0, sizeof(h));
+    h[5] = 2;  /* bytes_per_sample = 2 (16-bit) */
+    if (put_chunk(sink, "HEAD", h, sizeof(h)) != 0) return 0;
 
     /* SINF chunk */
-    write_chunk_header(buf, pos, buf_cap, "SINF", sinf_data);
-    pos += 8;
-    {
-        uint8_t *s = buf + pos;
-        memset(s, 0, sinf_data);
-        s[0] = (uint8_t)params->channels;
-        s[1] = 3;  /* bit depth indicator: 3 = 16-bit */
-        /* [2:4] unknown, zero */
-        write_u16_be(s + 4, (uint16_t)params->sample_rate);
-        write_u32_be(s + 6, (uint32_t)params->num_frames);
-        pos += sinf_data;
-    }
-
-    /* SLCE chunks */
+    uint8_t si[10];
+    memset(si, 0, sizeof(si));
+    si[0] = (uint8_t)params->channels;
+    si[1] = 3;  /* bit depth indicator: 3 = 16-bit */
+    /* [2:4] unknown, zero */
+    write_u16_be(si + 4, (uint16_t)params->sample_rate);
+    write_u32_be(si + 6, (uint32_t)params->num_frames);
+    if (put_chunk(sink, "SINF", si, sizeof(si)) != 0) return 0;
+
+    /* SLCE chunks (11 bytes, so each gets a pad byte) */
     for (int i = 0; i < params->slice_count; i++) {
-        write_chunk_header(buf, pos, buf_cap, "SLCE", slce_data);
-        pos += 8;
-        {
-            uint8_t *sl = buf + pos;
-            write_u32_be(sl, params->slices[i].sample_offset);
-            write_u32_be(sl + 4, params->slices[i].sample_length);
-            write_u16_be(sl + 8, 0x7FFF);  /* amplitude */
-            sl[10] = 0;                     /* zero byte */
-            pos += slce_data;
-        }
-        /* IFF pad byte for odd-length chunk */
-        buf[pos] = 0;
-        pos++;
+        uint8_t sl[11];
+        write_u32_be(sl, params->slices[i].sample_offset);
+        write_u32_be(sl + 4, params->slices[i].sample_length);
+        write_u16_be(sl + 8, 0x7FFF);  /* amplitude */
+        sl[10] = 0;                     /* zero byte */
+        if (put_chunk(sink, "SLCE", sl, sizeof(sl)) != 0) return 0;
     }
 
-    /* SDAT chunk */
-    write_chunk_header(buf, pos, buf_cap, "SDAT", sdat_data);
-    pos += 8;
-    memcpy(buf + pos, comp_buf, comp_bytes);
-    pos += comp_bytes;
-    if (comp_bytes & 1) {
-        buf[pos] = 0;  /* IFF pad byte */
-        pos++;
+    /* SDAT chunk: audio is encoded straight into the sink, and the chunk
+     * length patched in once known */
+    size_t sdat_header = byte_sink_tell(sink);
+    if (put_chunk_header(sink, "SDAT", 0) != 0) return 0;
+
+    int comp_bytes;
+    if (!params->pcm_data) {
+        comp_bytes = encode_streamed(params, sink);
+    } else if (params->channels == 2) {
+        comp_bytes = dwop_encode_stereo_sink(params->pcm_data, params->num_frames, sink, 1);
+    } else {
+        dwop_enc_state_t enc;
+        if (dwop_enc_init_sink(&enc, sink) != 0) return 0;
+        int encoded = dwop_encode(&enc, params->pcm_data, params->num_frames, 1);
+        comp_bytes = dwop_enc_flush(&enc);
+        if (encoded != params->num_frames) comp_bytes = 0;
     }
+    if (comp_bytes <= 0) return 0;
 
-    free(comp_buf);
-    return pos;
+    static const uint8_t pad = 0;
+    if ((comp_bytes & 1) && byte_sink_write(sink, &pad, 1) != 0) return 0;
+
+    /* Back-patch the lengths */
+    size_t total = byte_sink_tell(sink) - start;
+    uint8_t len[4];
+    write_u32_be(len, (uint32_t)comp_bytes);
+    if (byte_sink_patch(sink, sdat_header + 4, len, 4) != 0) return 0;
+    write_u32_be(len, (uint32_t)(total - 8));
+    if (byte_sink_patch(sink, start + 4, len, 4) != 0) return 0;
+
+    return (int)total;
+}
+
+int rex_write(const rex_write_params_t *params, uint8_t *buf, int buf_cap)
+{
+    byte_sink_t sink;
+    byte_sink_init_buffer(&sink, buf, buf_cap > 0 ? (size_t)buf_cap : 0);
+    return rex_write_sink(params, &sink);
 }
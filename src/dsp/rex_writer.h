@@ -12,6 +12,9 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "byte_sink.h"
+
+#define REX_WRITE_BLOCK 4096  /* frames per read_pcm call */
 
 /* Slice descriptor for writing */
 typedef struct {
@@ -30,17 +33,31 @@ typedef struct {
     int sample_rate;         /* e.g. 44100 */
     int channels;            /* 1=mono, 2=stereo */
 
-    const int16_t *pcm_data; /* PCM audio (interleaved if stereo) */
+    const int16_t *pcm_data; /* PCM audio (interleaved if stereo), or NULL */
     int num_frames;          /* per-channel frame count */
 
+    /* Streamed input, used when pcm_data is NULL: called for successive
+     * blocks of up to max_frames interleaved frames, num_frames in all.
+     * Returns the frames read into buf, <= 0 on error. */
+    int (*read_pcm)(void *ctx, int16_t *buf, int max_frames);
+    void *read_ctx;
+
     int slice_count;
     const rex_write_slice_t *slices;
 } rex_write_params_t;
 
 /* Write a REX2 file to an output buffer.
  * buf/buf_cap: output buffer (caller-allocated).
- * Returns total bytes written, or 0 on error.
+ * Returns total bytes written, or 0 on error (including a full buffer).
  * Recommended buffer size: num_frames * channels * 3 + 1024 (generous). */
 int rex_write(const rex_write_params_t *params, uint8_t *buf, int buf_cap);
 
+/* Stream a REX2 file into sink, encoding the audio directly into it with
+ * no intermediate buffer. With read_pcm the input is pulled and encoded
+ * REX_WRITE_BLOCK frames at a time, so memory use does not depend on the
+ * length of the audio. File-descriptor sinks must be seekable, for the
+ * chunk lengths patched in at the end.
+ * Returns total bytes written, or 0 on error. */
+int rex_write_sink(const rex_write_params_t *params, byte_sink_t *sink);
+
 #endif /* REX_WRITER_H */
@@ -12,6 +12,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 /* Little-endian readers */
 static uint32_t read_u32_le(const uint8_t *p)
@@ -30,6 +34,52 @@ static int tag_eq(const uint8_t *p, const char *tag)
     return p[0] == tag[0] && p[1] == tag[1] && p[2] == tag[2] && p[3] == tag[3];
 }
 
+/* Check the fmt fields against what can be converted. Returns 0, or -1
+ * with a message in error. */
+static int check_format(uint16_t fmt_tag, int bps, int channels, char *error, int error_len)
+{
+    if (fmt_tag != 1) {
+        snprintf(error, error_len, "Unsupported format tag %d (only PCM=1)", fmt_tag);
+        return -1;
+    }
+    if (bps != 16 && bps != 24 && bps != 32) {
+        snprintf(error, error_len, "Unsupported bit depth %d (need 16, 24, or 32)", bps);
+        return -1;
+    }
+    if (channels < 1 || channels > 2) {
+        snprintf(error, error_len, "Unsupported channel count %d", channels);
+        return -1;
+    }
+    return 0;
+}
+
+/* Convert little-endian samples of bps bits to 16-bit */
+static void convert_to_16(const uint8_t *src, int16_t *out, int samples, int bps)
+{
+    if (bps == 16) {
+        /* Direct copy (WAV is LE, native x86/ARM is also LE) */
+        memcpy(out, src, (size_t)samples * 2);
+    } else if (bps == 24) {
+        /* 24-bit LE signed → 16-bit: take top 16 bits (right-shift by 8) */
+        for (int i = 0; i < samples; i++) {
+            /* 24-bit LE: byte0=LSB, byte1=mid, byte2=MSB (sign) */
+            int32_t val = (int32_t)(((uint32_t)src[1] << 8) |
+                                    ((uint32_t)src[2] << 16));
+            /* Sign-extend from 24-bit */
+            val = (val << 8) >> 8;
+            out[i] = (int16_t)(val >> 8);
+            src += 3;
+        }
+    } else {  /* 32-bit */
+        /* 32-bit LE signed → 16-bit: take top 16 bits (right-shift by 16) */
+        for (int i = 0; i < samples; i++) {
+            int32_t val = (int32_t)read_u32_le(src);
+            out[i] = (int16_t)(val >> 16);
+            src += 4;
+        }
+    }
+}
+
 int wav_read(wav_file_t *wav, const uint8_t *data, size_t data_len)
 {
     memset(wav, 0, sizeof(*wav));
@@ -76,22 +126,9 @@ int wav_read(wav_file_t *wav, const uint8_t *data, size_t data_len)
                 snprintf(wav->error, sizeof(wav->error), "data chunk before fmt chunk");
                 return -1;
             }
-            if (fmt_tag != 1) {
-                snprintf(wav->error, sizeof(wav->error),
-                         "Unsupported format tag %d (only PCM=1)", fmt_tag);
-                return -1;
-            }
             int bps = wav->bits_per_sample;
-            if (bps != 16 && bps != 24 && bps != 32) {
-                snprintf(wav->error, sizeof(wav->error),
-                         "Unsupported bit depth %d (need 16, 24, or 32)", bps);
+            if (check_format(fmt_tag, bps, wav->channels, wav->error, sizeof(wav->error)) != 0)
                 return -1;
-            }
-            if (wav->channels < 1 || wav->channels > 2) {
-                snprintf(wav->error, sizeof(wav->error),
-                         "Unsupported channel count %d", wav->channels);
-                return -1;
-            }
 
             int bytes_per_sample = bps / 8;
             int bytes_per_frame = wav->channels * bytes_per_sample;
@@ -109,30 +146,7 @@ int wav_read(wav_file_t *wav, const uint8_t *data, size_t data_len)
                 return -1;
             }
 
-            if (bps == 16) {
-                /* Direct copy (WAV is LE, native x86/ARM is also LE) */
-                memcpy(wav->pcm_data, chunk_data, (size_t)total_samples * 2);
-            } else if (bps == 24) {
-                /* 24-bit LE signed → 16-bit: take top 16 bits (right-shift by 8) */
-                const uint8_t *src = chunk_data;
-                for (int i = 0; i < total_samples; i++) {
-                    /* 24-bit LE: byte0=LSB, byte1=mid, byte2=MSB (sign) */
-                    int32_t val = (int32_t)(((uint32_t)src[1] << 8) |
-                                            ((uint32_t)src[2] << 16));
-                    /* Sign-extend from 24-bit */
-                    val = (val << 8) >> 8;
-                    wav->pcm_data[i] = (int16_t)(val >> 8);
-                    src += 3;
-                }
-            } else {  /* 32-bit */
-                /* 32-bit LE signed → 16-bit: take top 16 bits (right-shift by 16) */
-                const uint8_t *src = chunk_data;
-                for (int i = 0; i < total_samples; i++) {
-                    int32_t val = (int32_t)read_u32_le(src);
-                    wav->pcm_data[i] = (int16_t)(val >> 16);
-                    src += 4;
-                }
-            }
+            convert_to_16(chunk_data, wav->pcm_data, total_samples, bps);
             /* Output is always 16-bit regardless of input */
             wav->bits_per_sample = 16;
             found_data = 1;
@@ -164,3 +178,129 @@ void wav_free(wav_file_t *wav)
     }
     wav->num_frames = 0;
 }
+
+/* --- Streaming --- */
+
+/* Read exactly len bytes. Returns 0, or -1 on error or end of file. */
+static int read_full(int fd, void *buf, size_t len)
+{
+    uint8_t *p = (uint8_t *)buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+int wav_stream_open(wav_stream_t *ws, const char *path)
+{
+    memset(ws, 0, sizeof(*ws));
+    ws->fd = open(path, O_RDONLY);
+    if (ws->fd < 0) {
+        snprintf(ws->error, sizeof(ws->error), "Cannot open '%s'", path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(ws->fd, &st) != 0) {
+        snprintf(ws->error, sizeof(ws->error), "Cannot stat '%s'", path);
+        return -1;
+    }
+
+    uint8_t riff[12];
+    if (st.st_size < 44 || read_full(ws->fd, riff, sizeof(riff)) != 0) {
+        snprintf(ws->error, sizeof(ws->error), "File too small (%lld bytes)",
+                 (long long)st.st_size);
+        return -1;
+    }
+    if (!tag_eq(riff, "RIFF") || !tag_eq(riff + 8, "WAVE")) {
+        snprintf(ws->error, sizeof(ws->error), "Not a RIFF/WAVE file");
+        return -1;
+    }
+
+    /* Walk chunk headers, reading fmt and seeking past everything else */
+    int found_fmt = 0;
+    uint16_t fmt_tag = 0;
+    off_t offset = 12;
+    uint8_t h[8];
+    while (offset + 8 <= st.st_size && read_full(ws->fd, h, sizeof(h)) == 0) {
+        uint32_t chunk_len = read_u32_le(h + 4);
+        off_t avail = st.st_size - offset - 8;
+
+        if (tag_eq(h, "data")) {
+            if (!found_fmt) {
+                snprintf(ws->error, sizeof(ws->error), "data chunk before fmt chunk");
+                return -1;
+            }
+            int bps = ws->bits_per_sample;
+            if (check_format(fmt_tag, bps, ws->channels, ws->error, sizeof(ws->error)) != 0)
+                return -1;
+
+            /* Tolerate a truncated data chunk, as wav_read() does */
+            off_t data_len = (off_t)chunk_len < avail ? (off_t)chunk_len : avail;
+            int bytes_per_frame = ws->channels * (bps / 8);
+            off_t frames = data_len / bytes_per_frame;
+            if (frames > INT32_MAX) frames = INT32_MAX;
+            ws->num_frames = (int)frames;
+            if (ws->num_frames <= 0) {
+                snprintf(ws->error, sizeof(ws->error), "No audio frames in data chunk");
+                return -1;
+            }
+            ws->frames_left = ws->num_frames;
+            ws->raw = (uint8_t *)malloc((size_t)WAV_STREAM_BLOCK * bytes_per_frame);
+            if (!ws->raw) {
+                snprintf(ws->error, sizeof(ws->error), "Failed to allocate read buffer");
+                return -1;
+            }
+            return 0;
+        }
+
+        if ((off_t)chunk_len > avail) break;  /* truncated chunk */
+        if (tag_eq(h, "fmt ") && chunk_len >= 16) {
+            uint8_t fmt[16];
+            if (read_full(ws->fd, fmt, sizeof(fmt)) != 0) break;
+            fmt_tag = read_u16_le(fmt);
+            ws->channels = read_u16_le(fmt + 2);
+            ws->sample_rate = (int)read_u32_le(fmt + 4);
+            ws->bits_per_sample = read_u16_le(fmt + 14);
+            found_fmt = 1;
+        }
+
+        /* Advance to next chunk (WAV chunks are word-aligned) */
+        offset += 8 + chunk_len + (chunk_len & 1);
+        if (lseek(ws->fd, offset, SEEK_SET) != offset) break;
+    }
+
+    snprintf(ws->error, sizeof(ws->error), found_fmt ? "No data chunk found" : "No fmt chunk found");
+    return -1;
+}
+
+int wav_stream_read(wav_stream_t *ws, int16_t *out, int max_frames)
+{
+    int bytes_per_frame = ws->channels * (ws->bits_per_sample / 8);
+    int done = 0;
+    while (done < max_frames && ws->frames_left > 0) {
+        int n = max_frames - done;
+        if (n > ws->frames_left) n = ws->frames_left;
+        if (n > WAV_STREAM_BLOCK) n = WAV_STREAM_BLOCK;
+        if (read_full(ws->fd, ws->raw, (size_t)n * bytes_per_frame) != 0) {
+            snprintf(ws->error, sizeof(ws->error), "Read error in data chunk");
+            return -1;
+        }
+        convert_to_16(ws->raw, out + (size_t)done * ws->channels, n * ws->channels,
+                      ws->bits_per_sample);
+        ws->frames_left -= n;
+        done += n;
+    }
+    return done;
+}
+
+void wav_stream_close(wav_stream_t *ws)
+{
+    if (ws->fd >= 0) close(ws->fd);
+    ws->fd = -1;
+    free(ws->raw);
+    ws->raw = NULL;
+}
@@ -5,6 +5,11 @@
  * Always outputs 16-bit PCM (higher depths are right-shifted to 16-bit).
  * Extracts sample rate, channels, and converted PCM data.
  *
+ * wav_stream_* reads a file incrementally instead: the chunks are walked
+ * with reads and seeks up to the audio, which is then converted one
+ * caller-sized block at a time, so long recordings need no more memory
+ * than short ones.
+ *
  * License: MIT
  */
 
@@ -31,4 +36,28 @@ int wav_read(wav_file_t *wav, const uint8_t *data, size_t data_len);
 /* Free resources allocated by wav_read */
 void wav_free(wav_file_t *wav);
 
+#define WAV_STREAM_BLOCK 4096  /* frames converted per raw read */
+
+typedef struct {
+    int fd;
+    int sample_rate;
+    int channels;
+    int bits_per_sample;     /* of the file; output is always 16-bit */
+    int num_frames;          /* per-channel frame count */
+    int frames_left;         /* not yet read */
+    uint8_t *raw;            /* WAV_STREAM_BLOCK frames of file data */
+    char error[256];
+} wav_stream_t;
+
+/* Open path and position it at the first audio frame, with the same format
+ * checks as wav_read(). Returns 0 on success, -1 on error (check
+ * ws->error). Call wav_stream_close() either way. */
+int wav_stream_open(wav_stream_t *ws, const char *path);
+
+/* Read up to max_frames frames as interleaved 16-bit PCM.
+ * Returns the frames read (0 at the end), or -1 on error. */
+int wav_stream_read(wav_stream_t *ws, int16_t *out, int max_frames);
+
+void wav_stream_close(wav_stream_t *ws);
+
 #endif /* WAV_READER_H */
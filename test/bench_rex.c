@@ -0,0 +1,606 @@
+/*
+ * REX Benchmark Suite
+ *
+ * Measures the codec, parser and render paths and prints one JSON object
+ * per line, so runs can be diffed or collected across builds:
+ *
+ *   dwop_encode / dwop_encode_stereo   PCM in, MB/s and samples/s
+ *   dwop_decode / dwop_decode_stereo   PCM out, MB/s and samples/s
+ *   rex_parse (full, lazy)             whole file, MB/s of REX input
+ *   rex_decode_slice                   every slice of a lazy parse
+ *   render                             render_block cost at 1/16/64
+ *                                      voices for each interpolation
+ *   render_offline                     a 16th-note pattern bounced through
+ *                                      the headless API (rex_render.h),
+ *                                      times real time
+ *
+ * Inputs are synthetic loops (sine, white noise, decaying drum-like
+ * bursts; mono and stereo) plus any .rx2/.rex files or folders given on
+ * the command line. Render timing loads the plugin (--plugin, default
+ * build/bench/dsp.so) against a synthetic stereo loop.
+ *
+ * Each measurement repeats until it has run for at least MIN_TIME_S and
+ * MIN_ITERS times; throughput is from the fastest run.
+ *
+ * Build and run: scripts/bench.sh [corpus files or folders...]
+ *
+ * License: MIT
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <time.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "dwop.h"
+#include "dwop_encode.h"
+#include "rex_writer.h"
+#include "rex_parser.h"
+#include "rex_render.h"
+
+#define SAMPLE_RATE   44100
+#define SYNTH_FRAMES  (SAMPLE_RATE * 10)  /* 10 s per synthetic signal */
+#define MIN_TIME_S    0.25
+#define MIN_ITERS     3
+#define RENDER_FRAMES 128
+#define RENDER_BLOCKS 1500                 /* ~4.4 s, inside one slice */
+#define RENDER_SLICES 4
+#define RENDER_SLICE_FRAMES (SAMPLE_RATE * 8)  /* outlasts the run at +7 */
+#define OFFLINE_FRAMES (SAMPLE_RATE * 20)      /* audio per offline render */
+#define OFFLINE_CHUNK  1024
+
+/* Plugin API, as declared by rex_plugin.c */
+typedef struct {
+    uint32_t api_version;
+    int sample_rate;
+    int frames_per_block;
+    uint8_t *mapped_memory;
+    int audio_out_offset;
+    int audio_in_offset;
+    void (*log)(const char *msg);
+    int (*midi_send_internal)(const uint8_t *msg, int len);
+    int (*midi_send_external)(const uint8_t *msg, int len);
+} host_api_v1_t;
+
+typedef struct {
+    uint32_t api_version;
+    void *(*create_instance)(const char *module_dir, const char *json_defaults);
+    void (*destroy_instance)(void *instance);
+    void (*on_midi)(void *instance, const uint8_t *msg, int len, int source);
+    void (*set_param)(void *instance, const char *key, const char *val);
+    int (*get_param)(void *instance, const char *key, char *buf, int buf_len);
+    int (*get_error)(void *instance, char *buf, int buf_len);
+    void (*render_block)(void *instance, int16_t *out_interleaved_lr, int frames);
+} plugin_api_v2_t;
+
+typedef plugin_api_v2_t *(*plugin_init_fn)(const host_api_v1_t *host);
+
+/* Headless API, looked up in the same plugin */
+typedef struct {
+    rex_render_t *(*open)(const char *path, const char *settings, char *err, int err_len);
+    void (*midi)(rex_render_t *r, const uint8_t *msg, int len, int frame_offset);
+    void (*run)(rex_render_t *r, int16_t *out, int frames);
+    void (*close)(rex_render_t *r);
+} render_api_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* ------------------------------------------------------------------ */
+/* Timing                                                              */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    int iters;
+    double best_s;
+    double mean_s;
+} timing_t;
+
+static timing_t time_it(void (*fn)(void *ctx), void *ctx)
+{
+    timing_t t = { 0, 1e30, 0.0 };
+    double total = 0.0;
+    while (t.iters < MIN_ITERS || total < MIN_TIME_S) {
+        double t0 = now_s();
+        fn(ctx);
+        double dt = now_s() - t0;
+        if (dt < t.best_s) t.best_s = dt;
+        total += dt;
+        t.iters++;
+    }
+    t.mean_s = total / t.iters;
+    return t;
+}
+
+/* One result line; bytes and samples are per iteration */
+static void report(const char *bench, const char *input, const timing_t *t,
+                   double bytes, double samples)
+{
+    printf("{\"bench\":\"%s\",\"input\":\"%s\",\"iters\":%d,\"best_ms\":%.3f,"
+           "\"mean_ms\":%.3f,\"mb_per_s\":%.2f,\"samples_per_s\":%.0f}\n",
+           bench, input, t->iters, t->best_s * 1e3, t->mean_s * 1e3,
+           bytes / t->best_s / 1e6, samples / t->best_s);
+    fflush(stdout);
+}
+
+/* ------------------------------------------------------------------ */
+/* Synthetic signals                                                   */
+/* ------------------------------------------------------------------ */
+
+enum { SIG_SINE, SIG_NOISE, SIG_DRUMS, SIG_COUNT };
+static const char *g_signal_names[SIG_COUNT] = { "sine", "noise", "drums" };
+
+/* Interleaved 16-bit PCM; the right channel differs from the left so the
+ * stereo delta channel has work to do */
+static int16_t *make_signal(int kind, int channels, int frames)
+{
+    int16_t *pcm = (int16_t *)malloc((size_t)frames * channels * sizeof(int16_t));
+    if (!pcm) return NULL;
+    uint32_t seed = 0x5EED + kind;
+    double env = 0.0;
+    for (int i = 0; i < frames; i++) {
+        for (int c = 0; c < channels; c++) {
+            seed = seed * 1664525 + 1013904223;
+            double noise = ((int32_t)(seed >> 8) - (1 << 23)) / (double)(1 << 23);
+            double v;
+            if (kind == SIG_SINE) {
+                v = 0.5 * sin(2.0 * M_PI * (440.0 + 3.0 * c) * i / SAMPLE_RATE);
+            } else if (kind == SIG_NOISE) {
+                v = 0.7 * noise;
+            } else {
+                /* A hit every eighth note at 120 BPM over a low tone */
+                if (c == 0 && i % (SAMPLE_RATE / 4) == 0) env = 1.0;
+                v = 0.6 * env * noise +
+                    0.3 * sin(2.0 * M_PI * (55.0 + c) * i / SAMPLE_RATE);
+                if (c == channels - 1) env *= 0.9995;
+            }
+            pcm[(size_t)i * channels + c] = (int16_t)lrint(v * 32767.0);
+        }
+    }
+    return pcm;
+}
+
+/* ------------------------------------------------------------------ */
+/* Codec                                                               */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    const int16_t *pcm;
+    int frames;
+    int channels;
+    uint8_t *buf;
+    int buf_cap;
+    int comp_len;
+    int16_t *out;
+} codec_ctx_t;
+
+static void run_encode(void *arg)
+{
+    codec_ctx_t *c = (codec_ctx_t *)arg;
+    if (c->channels == 2) {
+        c->comp_len = dwop_encode_stereo(c->pcm, c->frames, c->buf, c->buf_cap, 1);
+    } else {
+        dwop_enc_state_t st;
+        dwop_enc_init(&st, c->buf, c->buf_cap);
+        dwop_encode(&st, c->pcm, c->frames, 1);
+        c->comp_len = dwop_enc_flush(&st);
+    }
+}
+
+static void run_decode(void *arg)
+{
+    codec_ctx_t *c = (codec_ctx_t *)arg;
+    if (c->channels == 2) {
+        dwop_decode_stereo(c->buf, c->comp_len, c->out, c->frames, 1);
+    } else {
+        dwop_state_t st;
+        dwop_init(&st, c->buf, c->comp_len);
+        dwop_decode(&st, c->out, c->frames, 1);
+    }
+}
+
+static void bench_codec(void)
+{
+    for (int channels = 1; channels <= 2; channels++) {
+        for (int kind = 0; kind < SIG_COUNT; kind++) {
+            char input[64];
+            snprintf(input, sizeof(input), "%s_%s", g_signal_names[kind],
+                     channels == 2 ? "stereo" : "mono");
+
+            codec_ctx_t c;
+            memset(&c, 0, sizeof(c));
+            c.frames = SYNTH_FRAMES;
+            c.channels = channels;
+            c.pcm = make_signal(kind, channels, c.frames);
+            c.buf_cap = c.frames * channels * 4 + 4096;
+            c.buf = (uint8_t *)malloc(c.buf_cap);
+            c.out = (int16_t *)malloc((size_t)c.frames * channels * sizeof(int16_t));
+            if (!c.pcm || !c.buf || !c.out) {
+                fprintf(stderr, "bench_rex: out of memory\n");
+                exit(1);
+            }
+
+            double bytes = (double)c.frames * channels * sizeof(int16_t);
+            double samples = (double)c.frames * channels;
+            timing_t t = time_it(run_encode, &c);
+            report(channels == 2 ? "dwop_encode_stereo" : "dwop_encode", input, &t, bytes, samples);
+            t = time_it(run_decode, &c);
+            report(channels == 2 ? "dwop_decode_stereo" : "dwop_decode", input, &t, bytes, samples);
+            if (memcmp(c.out, c.pcm, (size_t)bytes) != 0)
+                fprintf(stderr, "bench_rex: %s did not round-trip\n", input);
+
+            free((void *)c.pcm);
+            free(c.buf);
+            free(c.out);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Parser                                                              */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    int flags;
+    rex_file_t *rex;
+    int16_t *out;
+} parse_ctx_t;
+
+static void run_parse(void *arg)
+{
+    parse_ctx_t *p = (parse_ctx_t *)arg;
+    if (rex_parse_ex(p->rex, p->data, p->len, p->flags) == 0) rex_free(p->rex);
+}
+
+static void run_decode_slices(void *arg)
+{
+    parse_ctx_t *p = (parse_ctx_t *)arg;
+    for (int i = 0; i < p->rex->slice_count; i++)
+        rex_decode_slice(p->rex, i, p->out);
+}
+
+/* REX2 image of pcm cut into equal slices; caller frees */
+static uint8_t *make_rex(const int16_t *pcm, int channels, int frames, int slices, int *len)
+{
+    rex_write_slice_t sl[REX_MAX_SLICES];
+    for (int i = 0; i < slices; i++) {
+        sl[i].sample_offset = (uint32_t)((int64_t)frames * i / slices);
+        sl[i].sample_length = (uint32_t)((int64_t)frames * (i + 1) / slices) - sl[i].sample_offset;
+    }
+    rex_write_params_t wp;
+    memset(&wp, 0, sizeof(wp));
+    wp.tempo_bpm = 120.0f;
+    wp.bars = 4;
+    wp.time_sig_num = 4;
+    wp.time_sig_den = 4;
+    wp.sample_rate = SAMPLE_RATE;
+    wp.channels = channels;
+    wp.pcm_data = pcm;
+    wp.num_frames = frames;
+    wp.slice_count = slices;
+    wp.slices = sl;
+
+    int cap = frames * channels * 4 + 4096;
+    uint8_t *buf = (uint8_t *)malloc(cap);
+    *len = buf ? rex_write(&wp, buf, cap) : 0;
+    if (*len <= 0) {
+        free(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+static void bench_parse_one(const char *input, const uint8_t *data, size_t len)
+{
+    static rex_file_t rex;
+    parse_ctx_t p = { data, len, 0, &rex, NULL };
+    if (rex_parse_ex(&rex, data, len, 0) != 0) {
+        fprintf(stderr, "bench_rex: %s: %s\n", input, rex.error);
+        return;
+    }
+    double samples = (double)rex.pcm_samples * rex.pcm_channels;
+    rex_free(&rex);
+
+    timing_t t = time_it(run_parse, &p);
+    report("rex_parse", input, &t, (double)len, samples);
+
+    p.flags = REX_PARSE_LAZY;
+    t = time_it(run_parse, &p);
+    report("rex_parse_lazy", input, &t, (double)len, samples);
+
+    /* Slice decode from the lazy index: the on-demand path */
+    if (rex_parse_ex(&rex, data, len, REX_PARSE_LAZY) != 0) return;
+    uint32_t longest = 0;
+    for (int i = 0; i < rex.slice_count; i++)
+        if (rex.slices[i].sample_length > longest) longest = rex.slices[i].sample_length;
+    p.out = (int16_t *)malloc(((size_t)longest + 1) * rex.pcm_channels * sizeof(int16_t));
+    if (p.out) {
+        double out_samples = 0.0;
+        for (int i = 0; i < rex.slice_count; i++)
+            out_samples += (double)rex.slices[i].sample_length * rex.pcm_channels;
+        t = time_it(run_decode_slices, &p);
+        report("rex_decode_slice", input, &t, out_samples * sizeof(int16_t), out_samples);
+        free(p.out);
+    }
+    rex_free(&rex);
+}
+
+static void bench_parse_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "bench_rex: cannot open %s\n", path);
+        return;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = len > 0 ? (uint8_t *)malloc(len) : NULL;
+    if (data && fread(data, 1, len, f) == (size_t)len) {
+        const char *name = strrchr(path, '/');
+        bench_parse_one(name ? name + 1 : path, data, (size_t)len);
+    }
+    free(data);
+    fclose(f);
+}
+
+static int is_rex_name(const char *name)
+{
+    const char *dot = strrchr(name, '.');
+    return dot && (strcasecmp(dot, ".rx2") == 0 || strcasecmp(dot, ".rex") == 0);
+}
+
+/* A corpus argument: one file, or every REX file in a folder */
+static void bench_corpus(const char *arg)
+{
+    struct stat st;
+    if (stat(arg, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        bench_parse_file(arg);
+        return;
+    }
+    DIR *d = opendir(arg);
+    if (!d) return;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.' || !is_rex_name(e->d_name)) continue;
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", arg, e->d_name);
+        bench_parse_file(path);
+    }
+    closedir(d);
+}
+
+static void bench_parse_synthetic(void)
+{
+    for (int channels = 1; channels <= 2; channels++) {
+        for (int kind = 0; kind < SIG_COUNT; kind++) {
+            char input[64];
+            snprintf(input, sizeof(input), "%s_%s", g_signal_names[kind],
+                     channels == 2 ? "stereo" : "mono");
+            int16_t *pcm = make_signal(kind, channels, SYNTH_FRAMES);
+            int len = 0;
+            uint8_t *file = pcm ? make_rex(pcm, channels, SYNTH_FRAMES, 32, &len) : NULL;
+            if (file) bench_parse_one(input, file, (size_t)len);
+            free(file);
+            free(pcm);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Render                                                              */
+/* ------------------------------------------------------------------ */
+
+static void quiet_log(const char *msg) { }
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Write the render loop into dir/loops. Returns 0 on success. */
+static int write_render_loop(const char *dir)
+{
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/loops", dir);
+    if (mkdir(path, 0755) != 0) return -1;
+
+    int frames = RENDER_SLICES * RENDER_SLICE_FRAMES;
+    int16_t *pcm = make_signal(SIG_DRUMS, 2, frames);
+    int len = 0;
+    uint8_t *file = pcm ? make_rex(pcm, 2, frames, RENDER_SLICES, &len) : NULL;
+    free(pcm);
+    if (!file) return -1;
+
+    snprintf(path, sizeof(path), "%s/loops/bench.rx2", dir);
+    FILE *f = fopen(path, "wb");
+    int ok = f && fwrite(file, 1, len, f) == (size_t)len;
+    if (f) fclose(f);
+    free(file);
+    return ok ? 0 : -1;
+}
+
+typedef struct {
+    const render_api_t *api;
+    const char *path;
+    const char *settings;
+} offline_ctx_t;
+
+/* Open, bounce OFFLINE_FRAMES of 16th notes at 120 BPM over the slices
+ * (trigger mode, so voices overlap up to the polyphony), close. After the
+ * first run the open is served from the decoded-loop cache. */
+static void run_offline(void *arg)
+{
+    const offline_ctx_t *c = (const offline_ctx_t *)arg;
+    char err[256];
+    rex_render_t *r = c->api->open(c->path, c->settings, err, sizeof(err));
+    if (!r) return;
+
+    int16_t out[OFFLINE_CHUNK * 2];
+    int step = SAMPLE_RATE / 8, n = 0;
+    for (int pos = 0; pos < OFFLINE_FRAMES; pos += OFFLINE_CHUNK) {
+        for (; n * step < pos + OFFLINE_CHUNK; n++) {
+            uint8_t on[3] = { 0x90, (uint8_t)(36 + n % RENDER_SLICES), 100 };
+            c->api->midi(r, on, 3, n * step - pos);
+        }
+        c->api->run(r, out, OFFLINE_CHUNK);
+    }
+    c->api->close(r);
+}
+
+static void bench_render_offline(void *h, const char *dir)
+{
+    render_api_t api = {
+        (rex_render_t *(*)(const char *, const char *, char *, int))dlsym(h, "rex_render_open"),
+        (void (*)(rex_render_t *, const uint8_t *, int, int))dlsym(h, "rex_render_midi"),
+        (void (*)(rex_render_t *, int16_t *, int))dlsym(h, "rex_render_run"),
+        (void (*)(rex_render_t *))dlsym(h, "rex_render_close"),
+    };
+    if (!api.open || !api.midi || !api.run || !api.close) {
+        fprintf(stderr, "bench_rex: plugin has no headless API (render_offline skipped)\n");
+        return;
+    }
+
+    static const char *qualities[] = { "linear", "hermite", "sinc8", "sinc16" };
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/loops/bench.rx2", dir);
+    for (int qi = 0; qi < 4; qi++) {
+        char settings[256];
+        snprintf(settings, sizeof(settings),
+                 "{\"transpose\":7,\"interpolation\":\"%s\",\"disk_cache\":\"off\"}",
+                 qualities[qi]);
+        offline_ctx_t ctx = { &api, path, settings };
+        timing_t t = time_it(run_offline, &ctx);
+        printf("{\"bench\":\"render_offline\",\"input\":\"drums_stereo\","
+               "\"interpolation\":\"%s\",\"iters\":%d,\"frames\":%d,\"best_ms\":%.3f,"
+               "\"mean_ms\":%.3f,\"x_realtime\":%.1f}\n",
+               qualities[qi], t.iters, OFFLINE_FRAMES, t.best_s * 1e3, t.mean_s * 1e3,
+               OFFLINE_FRAMES / (double)SAMPLE_RATE / t.best_s);
+        fflush(stdout);
+    }
+}
+
+static void bench_render(const char *plugin_path)
+{
+    void *h = dlopen(plugin_path, RTLD_NOW | RTLD_LOCAL);
+    plugin_init_fn init = h ? (plugin_init_fn)dlsym(h, "move_plugin_init_v2") : NULL;
+    if (!init) {
+        fprintf(stderr, "bench_rex: cannot load plugin %s (render skipped)\n", plugin_path);
+        return;
+    }
+    static host_api_v1_t host = {
+        .api_version = 1, .sample_rate = SAMPLE_RATE,
+        .frames_per_block = RENDER_FRAMES, .log = quiet_log,
+    };
+    plugin_api_v2_t *api = init(&host);
+
+    char dir[] = "/tmp/bench_rex.XXXXXX";
+    if (!mkdtemp(dir) || write_render_loop(dir) != 0) {
+        fprintf(stderr, "bench_rex: cannot write the render loop\n");
+        return;
+    }
+
+    static const int voice_counts[] = { 1, 16, 64 };
+    static const char *qualities[] = { "linear", "hermite", "sinc8", "sinc16" };
+    static double block_us[RENDER_BLOCKS];
+    double budget_us = RENDER_FRAMES * 1e6 / SAMPLE_RATE;
+
+    for (int qi = 0; qi < 4; qi++) {
+        for (int vi = 0; vi < 3; vi++) {
+            int voices = voice_counts[vi];
+            char defaults[256];
+            snprintf(defaults, sizeof(defaults),
+                     "{\"polyphony\":64,\"choke\":\"off\",\"transpose\":7,"
+                     "\"interpolation\":\"%s\",\"disk_cache\":\"off\"}", qualities[qi]);
+            void *inst = api->create_instance(dir, defaults);
+            if (!inst) continue;
+
+            /* Voices spread over the slices, held for the whole run */
+            int16_t out[RENDER_FRAMES * 2];
+            for (int v = 0; v < voices; v++) {
+                uint8_t on[3] = { 0x90, (uint8_t)(36 + v % RENDER_SLICES), 100 };
+                api->on_midi(inst, on, 3, 0);
+            }
+            double sum = 0.0;
+            for (int b = 0; b < RENDER_BLOCKS; b++) {
+                double t0 = now_s();
+                api->render_block(inst, out, RENDER_FRAMES);
+                block_us[b] = (now_s() - t0) * 1e6;
+                sum += block_us[b];
+            }
+            api->destroy_instance(inst);
+
+            qsort(block_us, RENDER_BLOCKS, sizeof(block_us[0]), cmp_double);
+            double avg = sum / RENDER_BLOCKS;
+            printf("{\"bench\":\"render\",\"input\":\"drums_stereo\",\"voices\":%d,"
+                   "\"interpolation\":\"%s\",\"blocks\":%d,\"avg_us\":%.2f,\"p99_us\":%.2f,"
+                   "\"max_us\":%.2f,\"budget_pct\":%.2f,\"us_per_voice\":%.3f}\n",
+                   voices, qualities[qi], RENDER_BLOCKS, avg,
+                   block_us[RENDER_BLOCKS * 99 / 100], block_us[RENDER_BLOCKS - 1],
+                   avg * 100.0 / budget_us, avg / voices);
+            fflush(stdout);
+        }
+    }
+
+    bench_render_offline(h, dir);
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/loops/bench.rx2", dir);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/loops", dir);
+    rmdir(path);
+    rmdir(dir);
+}
+
+/* ------------------------------------------------------------------ */
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "Usage: bench_rex [--plugin dsp.so] [--no-render] [file.rx2|folder ...]\n"
+            "Prints one JSON object per measurement.\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *plugin = "build/bench/dsp.so";
+    int render = 1;
+    int first_input = argc;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--plugin") == 0 && i + 1 < argc) {
+            plugin = argv[++i];
+        } else if (strcmp(argv[i], "--no-render") == 0) {
+            render = 0;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            usage();
+            return 0;
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 1;
+        } else {
+            first_input = i;
+            break;
+        }
+    }
+
+    bench_codec();
+    bench_parse_synthetic();
+    for (int i = first_input; i < argc; i++)
+        bench_corpus(argv[i]);
+    if (render) bench_render(plugin);
+    return 0;
+}
@@ -2,11 +2,14 @@
  * DWOP Encoder Round-Trip Test
  *
  * Verifies: encode PCM → DWOP bitstream → decode with dwop_decode() → exact match.
- * Tests: silence, DC, impulse, ramp, sine, short buffers, stereo.
+ * Tests: silence, DC, impulse, ramp, sine, short buffers, stereo,
+ *        bit reader state across calls, the unary safety bail and
+ *        signals that select each of the five predictors.
  *
  * Build (native macOS/Linux):
  *   cc -O2 -I../src/dsp -o test_dwop_roundtrip \
- *      test_dwop_roundtrip.c ../src/dsp/dwop_encode.c ../src/dsp/dwop.c -lm
+ *      test_dwop_roundtrip.c ../src/dsp/dwop_encode.c ../src/dsp/byte_sink.c \
+ *      ../src/dsp/dwop.c -lm
  *
  * Run:   ./test_dwop_roundtrip
  */
@@ -274,6 +277,84 @@ int main(void)
         roundtrip_stereo("Stereo single frame", one, 1);
     }
 
+    /* --- Decoder kernel tests --- */
+    printf("\nDecoder kernel tests:\n");
+
+    /* 15. Decoding in odd-sized pieces resumes the bit reader exactly */
+    {
+        int n = 8192;
+        int16_t *pcm = malloc(n * sizeof(int16_t));
+        int16_t *dec = malloc(n * sizeof(int16_t));
+        uint8_t *comp = malloc(BUF_CAP);
+        uint32_t seed = 7;
+        for (int i = 0; i < n; i++) {
+            seed = seed * 1664525 + 1013904223;
+            pcm[i] = (int16_t)((int32_t)(seed >> 16) >> (i % 13));
+        }
+        dwop_enc_state_t enc;
+        dwop_enc_init(&enc, comp, BUF_CAP);
+        dwop_encode(&enc, pcm, n, 1);
+        int comp_bytes = dwop_enc_flush(&enc);
+
+        dwop_state_t st;
+        dwop_init(&st, comp, comp_bytes);
+        int got = 0, chunk = 1;
+        while (got < n) {
+            int want = (chunk < n - got) ? chunk : n - got;
+            int d = dwop_decode(&st, dec + got, want, 1);
+            got += d;
+            if (d < want) break;
+            chunk = chunk * 3 % 97 + 1;
+        }
+        test_count++;
+        printf("  %-30s (%6d samples) ... ", "Chunked decode", n);
+        if (got == n && memcmp(dec, pcm, n * sizeof(int16_t)) == 0) {
+            printf("PASS\n");
+            pass_count++;
+        } else {
+            printf("FAIL (decoded %d/%d)\n", got, n);
+        }
+        free(pcm);
+        free(dec);
+        free(comp);
+    }
+
+    /* 16. An all-zero stream is an endless unary run: must bail, not hang */
+    {
+        uint8_t zeros[64];
+        int16_t out[16];
+        memset(zeros, 0, sizeof(zeros));
+        dwop_state_t st;
+        dwop_init(&st, zeros, sizeof(zeros));
+        int d = dwop_decode(&st, out, 16, 1);
+        test_count++;
+        printf("  %-30s (%6d bytes)   ... ", "All-zero stream bails", (int)sizeof(zeros));
+        if (d == 0) {
+            printf("PASS\n");
+            pass_count++;
+        } else {
+            printf("FAIL (decoded %d)\n", d);
+        }
+    }
+
+    /* 17/18. Smooth polynomials pull the minimum energy onto the higher
+     * order predictors (2nd..4th difference), mono and stereo */
+    {
+        int n = 4096;
+        int16_t *poly = malloc(n * sizeof(int16_t));
+        int16_t *stereo = malloc(n * 2 * sizeof(int16_t));
+        for (int i = 0; i < n; i++) {
+            double x = (double)i / n - 0.5;
+            poly[i] = (int16_t)(120000.0 * x * x * x + 9000.0 * x * x);
+            stereo[i * 2] = poly[i];
+            stereo[i * 2 + 1] = (int16_t)(20000.0 * x * x - 4000.0);
+        }
+        roundtrip_mono("Cubic polynomial", poly, n);
+        roundtrip_stereo("Stereo polynomials", stereo, n);
+        free(poly);
+        free(stereo);
+    }
+
     /* Summary */
     printf("\n=== Results: %d/%d passed ===\n", pass_count, test_count);
     return (pass_count == test_count) ? 0 : 1;
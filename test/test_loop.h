@@ -0,0 +1,117 @@
+/*
+ * Test Loop Fixtures
+ *
+ * Builds the REX2 files the tests parse, cache and play: tones (one
+ * frequency per channel), optionally with noise, fading out within each
+ * slice, or marked 24-bit; or one click per slice, for timing playback.
+ * Header-only, so every test keeps its one-file build line.
+ *
+ * License: MIT
+ */
+
+#ifndef TEST_LOOP_H
+#define TEST_LOOP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "rex_writer.h"
+
+#define TEST_LOOP_MAX_SLICES 64
+
+typedef struct {
+    int channels;      /* 1 or 2 */
+    int frames;
+    int slices;        /* 1 - TEST_LOOP_MAX_SLICES */
+    float tempo;       /* BPM, 0 for 120 */
+    int bars;          /* 0 for 1 */
+    int hires;         /* mark the file 24-bit (its samples stay 16-bit) */
+    int jitter;        /* slices vary in length by up to this many frames */
+    int fade;          /* each slice fades out to silence by its middle */
+    uint32_t noise;    /* seed for noise on top of the tones, 0 for none */
+    int impulse;       /* no tones: each slice is one click, then silence */
+} test_loop_t;
+
+/* Encode p into a new buffer in *out (free it); returns its length, or
+ * 0 or less on failure */
+static inline int test_loop_encode(const test_loop_t *p, uint8_t **out)
+{
+    int ch = p->channels;
+    int16_t *pcm = (int16_t *)malloc((size_t)p->frames * ch * sizeof(int16_t));
+    rex_write_slice_t slices[TEST_LOOP_MAX_SLICES];
+    *out = NULL;
+    if (!pcm || p->slices < 1 || p->slices > TEST_LOOP_MAX_SLICES) {
+        free(pcm);
+        return -1;
+    }
+
+    uint32_t pos = 0;
+    for (int i = 0; i < p->slices; i++) {
+        uint32_t len = (i == p->slices - 1)
+            ? (uint32_t)p->frames - pos
+            : (uint32_t)(p->frames / p->slices + (i % 3) * p->jitter - p->jitter);
+        slices[i].sample_offset = pos;
+        slices[i].sample_length = len;
+        pos += len;
+    }
+
+    uint32_t seed = p->noise;
+    double amp = p->noise ? 10000.0 : 16000.0;
+    for (int s = 0; s < p->slices; s++) {
+        uint32_t len = slices[s].sample_length;
+        for (uint32_t k = 0; k < len; k++) {
+            uint32_t i = slices[s].sample_offset + k;
+            double gain = !p->fade ? 1.0 : k < len / 2 ? 1.0 - (double)k / (len / 2) : 0.0;
+            for (int c = 0; c < ch; c++) {
+                double v = amp * sin(2.0 * M_PI * (440.0 + 220.0 * c) * i / 44100.0);
+                if (p->impulse) v = k == 0 ? 20000.0 : 0.0;
+                if (p->noise) {
+                    seed = seed * 1664525 + 1013904223;
+                    v += ((int32_t)(seed >> 16) - 32768) / 6;
+                }
+                pcm[(size_t)i * ch + c] = (int16_t)(v * gain);
+            }
+        }
+    }
+
+    rex_write_params_t wp;
+    memset(&wp, 0, sizeof(wp));
+    wp.tempo_bpm = p->tempo > 0.0f ? p->tempo : 120.0f;
+    wp.bars = p->bars > 0 ? p->bars : 1;
+    wp.time_sig_num = 4;
+    wp.time_sig_den = 4;
+    wp.sample_rate = 44100;
+    wp.channels = ch;
+    wp.pcm_data = pcm;
+    wp.num_frames = p->frames;
+    wp.slice_count = p->slices;
+    wp.slices = slices;
+
+    int cap = p->frames * ch * 4 + 4096;
+    *out = (uint8_t *)malloc(cap);
+    int written = *out ? rex_write(&wp, *out, cap) : -1;
+    for (int i = 0; p->hires && i + 14 <= written; i++) {
+        if (memcmp(*out + i, "HEAD", 4) == 0) {
+            (*out)[i + 8 + 5] = 3;  /* bytes_per_sample */
+            break;
+        }
+    }
+    free(pcm);
+    return written;
+}
+
+/* Write p's file to path. Returns 0 on success. */
+static inline int test_loop_write(const char *path, const test_loop_t *p)
+{
+    uint8_t *buf;
+    int written = test_loop_encode(p, &buf);
+    FILE *f = written > 0 ? fopen(path, "wb") : NULL;
+    int ok = f && fwrite(buf, 1, written, f) == (size_t)written;
+    if (f) fclose(f);
+    free(buf);
+    return ok ? 0 : -1;
+}
+
+#endif /* TEST_LOOP_H */
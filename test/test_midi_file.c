@@ -0,0 +1,224 @@
+/*
+ * MIDI File Reader Test
+ *
+ * Verifies: events are timed through the tempo map (including a tempo
+ * change in another track of a format 1 file), tracks merge in tick order
+ * keeping file order within a tick, running status and skipped meta/SysEx
+ * events are handled, SMPTE divisions are timed in seconds, and truncated
+ * or unsupported files are rejected.
+ *
+ * Build (native macOS/Linux):
+ *   cc -O2 -Isrc/dsp -o test/test_midi_file \
+ *      test/test_midi_file.c src/dsp/midi_file.c -lm
+ *
+ * Run:   ./test/test_midi_file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "midi_file.h"
+
+#define SR 44100
+
+static int test_count = 0;
+static int pass_count = 0;
+
+static void check(const char *name, int ok)
+{
+    test_count++;
+    printf("  %-40s ... %s\n", name, ok ? "PASS" : "FAIL");
+    if (ok) pass_count++;
+}
+
+/* File under construction */
+typedef struct {
+    uint8_t data[1024];
+    int len;
+    int track_start;
+} smf_t;
+
+static void put(smf_t *f, const uint8_t *bytes, int n)
+{
+    memcpy(f->data + f->len, bytes, n);
+    f->len += n;
+}
+
+static void put_vlq(smf_t *f, uint32_t v)
+{
+    uint8_t b[4];
+    int n = 0;
+    b[n++] = v & 0x7F;
+    while (v >>= 7) b[n++] = 0x80 | (v & 0x7F);
+    while (n > 0) put(f, &b[--n], 1);
+}
+
+static void header(smf_t *f, int format, int tracks, uint16_t division)
+{
+    uint8_t h[14] = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, (uint8_t)format, 0, (uint8_t)tracks,
+                      (uint8_t)(division >> 8), (uint8_t)division };
+    f->len = 0;
+    put(f, h, sizeof(h));
+}
+
+static void begin_track(smf_t *f)
+{
+    static const uint8_t t[8] = { 'M', 'T', 'r', 'k', 0, 0, 0, 0 };
+    f->track_start = f->len;
+    put(f, t, sizeof(t));
+}
+
+/* delta, then raw event bytes */
+static void event(smf_t *f, uint32_t delta, const uint8_t *bytes, int n)
+{
+    put_vlq(f, delta);
+    put(f, bytes, n);
+}
+
+static void end_track(smf_t *f, uint32_t delta)
+{
+    static const uint8_t eot[3] = { 0xFF, 0x2F, 0x00 };
+    event(f, delta, eot, 3);
+    uint32_t len = (uint32_t)(f->len - f->track_start - 8);
+    uint8_t *p = f->data + f->track_start + 4;
+    p[0] = (uint8_t)(len >> 24);
+    p[1] = (uint8_t)(len >> 16);
+    p[2] = (uint8_t)(len >> 8);
+    p[3] = (uint8_t)len;
+}
+
+static void tempo(smf_t *f, uint32_t delta, uint32_t us_per_quarter)
+{
+    uint8_t t[6] = { 0xFF, 0x51, 0x03, (uint8_t)(us_per_quarter >> 16),
+                     (uint8_t)(us_per_quarter >> 8), (uint8_t)us_per_quarter };
+    event(f, delta, t, 6);
+}
+
+static int is_event(const midi_file_event_t *e, uint32_t frame, uint8_t status, uint8_t note)
+{
+    return e->frame == frame && e->msg[0] == status && e->msg[1] == note;
+}
+
+int main(void)
+{
+    printf("=== MIDI File Reader Tests ===\n\n");
+
+    smf_t f;
+    midi_file_t mf;
+
+    /* Format 0 at the default tempo, with running status and skipped events */
+    {
+        header(&f, 0, 1, 96);
+        begin_track(&f);
+        static const uint8_t name[] = { 0xFF, 0x03, 0x02, 'h', 'i' };
+        static const uint8_t sysex[] = { 0xF0, 0x02, 0x7E, 0xF7 };
+        static const uint8_t on[] = { 0x90, 36, 100 };
+        static const uint8_t on_running[] = { 38, 90 };
+        static const uint8_t off[] = { 0x80, 36, 0 };
+        static const uint8_t program[] = { 0xC0, 5 };
+        event(&f, 0, name, sizeof(name));
+        event(&f, 0, on, sizeof(on));
+        event(&f, 48, on_running, sizeof(on_running));  /* an eighth at 120 BPM */
+        event(&f, 0, sysex, sizeof(sysex));
+        event(&f, 48, off, sizeof(off));
+        event(&f, 0, program, sizeof(program));
+        end_track(&f, 96);
+        int ok = midi_file_read(&mf, f.data, f.len, SR) == 0 && mf.event_count == 4;
+        ok = ok && is_event(&mf.events[0], 0, 0x90, 36) && mf.events[0].msg[2] == 100 &&
+             is_event(&mf.events[1], SR / 4, 0x90, 38) && mf.events[1].msg[2] == 90 &&
+             is_event(&mf.events[2], SR / 2, 0x80, 36) &&
+             mf.events[3].len == 2 && mf.events[3].msg[1] == 5 &&
+             mf.end_frame == SR;
+        midi_file_free(&mf);
+        check("Default tempo and running status", ok);
+    }
+
+    /* Format 1: the tempo track changes tempo mid-way through the notes */
+    {
+        header(&f, 1, 2, 480);
+        begin_track(&f);
+        tempo(&f, 0, 1000000);    /* 60 BPM: a quarter is 1 s */
+        tempo(&f, 960, 250000);   /* 240 BPM from tick 960 (2 s) */
+        end_track(&f, 0);
+        begin_track(&f);
+        static const uint8_t a[] = { 0x90, 40, 64 };
+        static const uint8_t b[] = { 0x90, 41, 64 };
+        event(&f, 480, a, sizeof(a));   /* 1 s */
+        event(&f, 960, b, sizeof(b));   /* tick 1440: 2 s + 0.125 s */
+        end_track(&f, 480);             /* tick 1920: 2.25 s */
+        int ok = midi_file_read(&mf, f.data, f.len, SR) == 0 && mf.event_count == 2;
+        ok = ok && is_event(&mf.events[0], SR, 0x90, 40) &&
+             is_event(&mf.events[1], SR * 2 + SR / 4, 0x90, 41) &&
+             mf.end_frame == (uint32_t)(SR * 2 + SR / 2);
+        midi_file_free(&mf);
+        check("Tempo map from another track", ok);
+    }
+
+    /* Tracks merge in tick order, file order within a tick */
+    {
+        header(&f, 1, 2, 96);
+        begin_track(&f);
+        static const uint8_t t1a[] = { 0x90, 50, 1 };
+        static const uint8_t t1b[] = { 0x80, 51, 0 };
+        event(&f, 96, t1a, sizeof(t1a));
+        event(&f, 96, t1b, sizeof(t1b));
+        end_track(&f, 0);
+        begin_track(&f);
+        static const uint8_t t2a[] = { 0x91, 52, 1 };
+        static const uint8_t t2b[] = { 0x91, 53, 1 };
+        event(&f, 0, t2a, sizeof(t2a));
+        event(&f, 96, t2b, sizeof(t2b));
+        end_track(&f, 0);
+        int ok = midi_file_read(&mf, f.data, f.len, SR) == 0 && mf.event_count == 4;
+        ok = ok && is_event(&mf.events[0], 0, 0x91, 52) &&
+             is_event(&mf.events[1], SR / 2, 0x90, 50) &&
+             is_event(&mf.events[2], SR / 2, 0x91, 53) &&
+             is_event(&mf.events[3], SR, 0x80, 51);
+        midi_file_free(&mf);
+        check("Tracks merged in time order", ok);
+    }
+
+    /* SMPTE division: 25 fps, 40 ticks per frame (1 ms per tick) */
+    {
+        header(&f, 0, 1, (uint16_t)((uint8_t)-25 << 8 | 40));
+        begin_track(&f);
+        static const uint8_t on[] = { 0x90, 60, 100 };
+        tempo(&f, 0, 250000);      /* ignored under SMPTE timing */
+        event(&f, 500, on, sizeof(on));
+        end_track(&f, 0);
+        int ok = midi_file_read(&mf, f.data, f.len, SR) == 0 && mf.event_count == 1 &&
+                 is_event(&mf.events[0], SR / 2, 0x90, 60);
+        midi_file_free(&mf);
+        check("SMPTE division in seconds", ok);
+    }
+
+    /* Bad input */
+    {
+        header(&f, 0, 1, 96);
+        begin_track(&f);
+        static const uint8_t on[] = { 0x90, 60, 100 };
+        event(&f, 0, on, sizeof(on));
+        end_track(&f, 0);
+        int ok = midi_file_read(&mf, f.data, f.len - 2, SR) != 0 && mf.error[0];
+        midi_file_free(&mf);
+        ok = ok && midi_file_read(&mf, (const uint8_t *)"RIFF0000WAVE", 12, SR) != 0;
+        midi_file_free(&mf);
+        header(&f, 2, 1, 96);
+        begin_track(&f);
+        end_track(&f, 0);
+        ok = ok && midi_file_read(&mf, f.data, f.len, SR) != 0;
+        midi_file_free(&mf);
+        header(&f, 0, 1, 96);
+        begin_track(&f);
+        static const uint8_t data_only[] = { 60, 100 };  /* no status to run on */
+        event(&f, 0, data_only, sizeof(data_only));
+        end_track(&f, 0);
+        ok = ok && midi_file_read(&mf, f.data, f.len, SR) != 0;
+        midi_file_free(&mf);
+        check("Truncated and unsupported files rejected", ok);
+    }
+
+    printf("\n=== Results: %d/%d passed ===\n", pass_count, test_count);
+    return (pass_count == test_count) ? 0 : 1;
+}
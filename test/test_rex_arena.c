@@ -0,0 +1,180 @@
+/*
+ * Decode Buffer Arena Test
+ *
+ * Verifies: a released buffer is reused for a request it covers with at
+ * most 2x to spare; the pool drops its oldest buffers to stay within its
+ * limit and trims on request; parsing through an arena matches a plain
+ * parse, sizes buffers exactly and recycles them on the next load (full,
+ * planar and lazy); and a file without a SINF length is sized to its
+ * slices.
+ *
+ * Build (native macOS/Linux):
+ *   cc -O2 -Isrc/dsp -o test/test_rex_arena \
+ *      test/test_rex_arena.c src/dsp/rex_writer.c src/dsp/dwop_encode.c \
+ *      src/dsp/byte_sink.c src/dsp/rex_parser.c src/dsp/dwop.c -lm -lpthread
+ *
+ * Run:   ./test/test_rex_arena
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "test_loop.h"
+#include "rex_parser.h"
+
+#define FRAMES 30000
+
+static int test_count = 0;
+static int pass_count = 0;
+
+static void check(const char *name, int ok)
+{
+    test_count++;
+    printf("  %-40s ... %s\n", name, ok ? "PASS" : "FAIL");
+    if (ok) pass_count++;
+}
+
+/* Encode a loop of 4 equal slices; returns its size, buffer in *out */
+static int make_loop(int channels, uint8_t **out)
+{
+    test_loop_t p = { .channels = channels, .frames = FRAMES, .slices = 4 };
+    return test_loop_encode(&p, out);
+}
+
+/* Zero the SINF total length, as in files written without one */
+static int clear_sinf_length(uint8_t *data, int len)
+{
+    for (int i = 0; i + 18 <= len; i++) {
+        if (memcmp(data + i, "SINF", 4) == 0) {
+            memset(data + i + 8 + 6, 0, 4);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int same_audio(const rex_file_t *a, const rex_file_t *b)
+{
+    return a->pcm_samples == b->pcm_samples && a->pcm_channels == b->pcm_channels &&
+           a->slice_count == b->slice_count &&
+           memcmp(a->pcm_data, b->pcm_data,
+                  (size_t)a->pcm_samples * a->pcm_channels * sizeof(int16_t)) == 0;
+}
+
+int main(void)
+{
+    printf("=== Decode Buffer Arena Tests ===\n\n");
+
+    rex_arena_stats_t st;
+
+    /* Reuse of a fitting buffer */
+    {
+        rex_arena_t *arena = rex_arena_create(1 << 20);
+        void *a = rex_arena_alloc(arena, 1000);
+        int ok = a && ((uintptr_t)a & 15) == 0 && rex_arena_capacity(a) == 1000;
+        rex_arena_release(arena, a);
+        void *b = rex_arena_alloc(arena, 900);
+        ok = ok && b == a;
+        rex_arena_release(arena, b);
+        void *c = rex_arena_alloc(arena, 400);  /* 1000 is over 2x */
+        ok = ok && c != a;
+        rex_arena_stats(arena, &st);
+        ok = ok && st.reuses == 1 && st.allocs == 2 && st.idle_count == 1;
+        rex_arena_release(arena, c);
+        rex_arena_destroy(arena);
+        check("Released buffer reused when it fits", ok);
+    }
+
+    /* Limit and trim */
+    {
+        rex_arena_t *arena = rex_arena_create(3000);
+        void *a = rex_arena_alloc(arena, 2000);
+        void *b = rex_arena_alloc(arena, 1500);
+        void *c = rex_arena_alloc(arena, 4000);
+        rex_arena_release(arena, a);
+        rex_arena_release(arena, b);  /* a is dropped to make room */
+        rex_arena_release(arena, c);  /* over the limit: freed */
+        rex_arena_stats(arena, &st);
+        int ok = st.idle_count == 1 && st.idle_bytes == 1500;
+        rex_arena_trim(arena, 0);
+        rex_arena_stats(arena, &st);
+        ok = ok && st.idle_count == 0 && st.idle_bytes == 0;
+        rex_arena_destroy(arena);
+        check("Pool keeps to its limit and trims", ok);
+    }
+
+    uint8_t *mono = NULL, *stereo = NULL;
+    int mono_len = make_loop(1, &mono);
+    int stereo_len = make_loop(2, &stereo);
+
+    /* Full parse: same audio, exact size, recycled on the next load */
+    {
+        rex_arena_t *arena = rex_arena_create(1 << 24);
+        rex_file_t plain, a;
+        int ok = rex_parse(&plain, stereo, stereo_len) == 0 &&
+                 rex_parse_arena(&a, stereo, stereo_len, 0, arena) == 0;
+        ok = ok && same_audio(&plain, &a) &&
+             rex_arena_capacity(a.pcm_data) == (size_t)FRAMES * 2 * sizeof(int16_t);
+        const int16_t *first = a.pcm_data;
+        rex_free(&a);
+        ok = ok && rex_parse_arena(&a, stereo, stereo_len, 0, arena) == 0;
+        ok = ok && a.pcm_data == first && same_audio(&plain, &a);
+        rex_arena_stats(arena, &st);
+        ok = ok && st.reuses == 1 && st.allocs == 1;
+        rex_free(&a);
+        rex_free(&plain);
+        rex_arena_destroy(arena);
+        check("Full parse sized exactly and recycled", ok);
+    }
+
+    /* Planar and lazy buffers come from the arena too */
+    {
+        rex_arena_t *arena = rex_arena_create(1 << 24);
+        rex_file_t a;
+        int ok = rex_parse_arena(&a, mono, mono_len, REX_PARSE_PLANAR_F32, arena) == 0;
+        ok = ok && a.planar == REX_PLANAR_F32 && ((uintptr_t)a.planar_data & 15) == 0;
+        rex_free(&a);
+        rex_arena_stats(arena, &st);
+        ok = ok && st.idle_count == 2;
+        ok = ok && rex_parse_arena(&a, mono, mono_len, REX_PARSE_PLANAR_F32, arena) == 0;
+        rex_arena_stats(arena, &st);
+        ok = ok && st.reuses == 2 && st.idle_count == 0;
+        rex_free(&a);
+
+        ok = ok && rex_parse_arena(&a, mono, mono_len, REX_PARSE_LAZY, arena) == 0;
+        ok = ok && a.lazy && rex_arena_capacity(a.sdat_data) == a.sdat_len;
+        int16_t out[FRAMES / 4];
+        rex_file_t plain;
+        ok = ok && rex_parse(&plain, mono, mono_len) == 0 &&
+             rex_decode_slice(&a, 2, out) == FRAMES / 4 &&
+             memcmp(out, plain.pcm_data + FRAMES / 2, sizeof(out)) == 0;
+        rex_free(&plain);
+        rex_free(&a);
+        rex_arena_destroy(arena);
+        check("Planar and lazy buffers recycled", ok);
+    }
+
+    /* No SINF length: sized to the slices, neither padded nor cut short
+     * (this loop compresses past the old chunk-size bound) */
+    {
+        rex_arena_t *arena = rex_arena_create(1 << 24);
+        rex_file_t plain, a;
+        int ok = rex_parse(&plain, mono, mono_len) == 0;
+        ok = ok && clear_sinf_length(mono, mono_len) == 0;
+        ok = ok && rex_parse_arena(&a, mono, mono_len, 0, arena) == 0;
+        ok = ok && a.total_sample_length == 0 && same_audio(&plain, &a) &&
+             rex_arena_capacity(a.pcm_data) == (size_t)FRAMES * sizeof(int16_t);
+        rex_free(&a);
+        rex_free(&plain);
+        rex_arena_destroy(arena);
+        check("Missing SINF length still sized exactly", ok);
+    }
+
+    free(mono);
+    free(stereo);
+
+    printf("\n=== Results: %d/%d passed ===\n", pass_count, test_count);
+    return (pass_count == test_count) ? 0 : 1;
+}
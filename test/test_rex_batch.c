@@ -0,0 +1,203 @@
+/*
+ * Batch Encoding Test
+ *
+ * Verifies: a manifest is parsed (comments, optional tempo, malformed
+ * lines rejected), a directory becomes one evenly sliced job per WAV, and
+ * a parallel run under a tight memory budget encodes every good file,
+ * reports each bad one without stopping the others, and produces files
+ * identical to single-file encoding.
+ *
+ * Build (native macOS/Linux):
+ *   cc -O2 -Isrc/dsp -o test/test_rex_batch \
+ *      test/test_rex_batch.c src/dsp/rex_batch.c src/dsp/wav_reader.c \
+ *      src/dsp/rex_writer.c src/dsp/dwop_encode.c src/dsp/byte_sink.c \
+ *      src/dsp/rex_sidecar.c src/dsp/mapped_file.c src/dsp/rex_parser.c \
+ *      src/dsp/dwop.c -lm -lpthread
+ *
+ * Run:   ./test/test_rex_batch
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "rex_batch.h"
+#include "rex_parser.h"
+#include "mapped_file.h"
+
+#define DIR_PATH "/tmp/test_rex_batch"
+#define NUM_WAVS 5
+
+static int test_count = 0;
+static int pass_count = 0;
+
+static void check(const char *name, int ok)
+{
+    test_count++;
+    printf("  %-40s ... %s\n", name, ok ? "PASS" : "FAIL");
+    if (ok) pass_count++;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+/* 16-bit PCM WAV of num_frames */
+static void write_wav(const char *path, int channels, int num_frames, double freq)
+{
+    uint32_t data_len = (uint32_t)(num_frames * channels * 2);
+    uint8_t h[44];
+    memcpy(h, "RIFF", 4); put_u32(h + 4, 36 + data_len); memcpy(h + 8, "WAVE", 4);
+    memcpy(h + 12, "fmt ", 4); put_u32(h + 16, 16);
+    h[20] = 1; h[21] = 0; h[22] = (uint8_t)channels; h[23] = 0;
+    put_u32(h + 24, 44100); put_u32(h + 28, 44100 * channels * 2);
+    h[32] = (uint8_t)(channels * 2); h[33] = 0; h[34] = 16; h[35] = 0;
+    memcpy(h + 36, "data", 4); put_u32(h + 40, data_len);
+
+    int16_t *pcm = (int16_t *)malloc(data_len);
+    for (int i = 0; i < num_frames * channels; i++)
+        pcm[i] = (int16_t)(15000.0 * sin(2.0 * M_PI * freq * (i / channels) / 44100.0 + i % channels));
+    FILE *f = fopen(path, "wb");
+    if (f) {
+        fwrite(h, 1, sizeof(h), f);
+        fwrite(pcm, 1, data_len, f);
+        fclose(f);
+    }
+    free(pcm);
+}
+
+static int read_all(const char *path, uint8_t **data, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    fseek(f, 0, SEEK_END);
+    *len = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    *data = (uint8_t *)malloc(*len ? *len : 1);
+    size_t got = fread(*data, 1, *len, f);
+    fclose(f);
+    return got == *len ? 0 : -1;
+}
+
+static int g_ok = 0, g_failed = 0, g_failed_line = 0;
+
+static void report(const rex_encode_job_t *job, const rex_encode_stats_t *stats,
+                   const char *err, void *ctx)
+{
+    (void)stats;
+    (void)ctx;
+    if (err) {
+        g_failed++;
+        g_failed_line = job->line;
+    } else {
+        g_ok++;
+    }
+}
+
+int main(void)
+{
+    printf("=== Batch Encoding Tests ===\n\n");
+
+    char path[256];
+    mkdir(DIR_PATH, 0755);
+    mkdir(DIR_PATH "/out", 0755);
+    for (int i = 0; i < NUM_WAVS; i++) {
+        snprintf(path, sizeof(path), DIR_PATH "/take%d.wav", i);
+        write_wav(path, 1 + (i & 1), 20000 + i * 5000, 220.0 * (i + 1));
+    }
+
+    /* Manifest: good jobs, a comment, and one missing input */
+    FILE *f = fopen(DIR_PATH "/manifest.txt", "w");
+    fprintf(f, "# sample pack\n\n");
+    for (int i = 0; i < NUM_WAVS; i++) {
+        fprintf(f, DIR_PATH "/take%d.wav\t" DIR_PATH "/out/m%d.rx2\t0,10000,20000%s\n",
+                i, i, i == 2 ? "\t95" : "");
+    }
+    fprintf(f, DIR_PATH "/missing.wav\t" DIR_PATH "/out/missing.rx2\t0,100\n");
+    fclose(f);
+
+    rex_encode_job_t *jobs = NULL;
+    char err[256];
+    int n = rex_batch_load_manifest(DIR_PATH "/manifest.txt", &jobs, err, sizeof(err));
+    check("Manifest parsed", n == NUM_WAVS + 1 && jobs[0].line == 3 &&
+          strcmp(jobs[1].boundaries, "0,10000,20000") == 0 &&
+          jobs[2].tempo == 95.0f && jobs[0].tempo == REX_BATCH_DEFAULT_TEMPO);
+
+    /* Tiny budget: jobs run one at a time but all complete */
+    int failed = rex_batch_run(jobs, n, 3, 1, report, NULL);
+    check("Failures reported per file", failed == 1 && g_failed == 1 &&
+          g_failed_line == NUM_WAVS + 3 && g_ok == NUM_WAVS);
+
+    /* Parallel output equals a single-file encode */
+    rex_encode_job_t single = jobs[3];
+    single.rx2_path = DIR_PATH "/out/single.rx2";
+    int same = rex_encode_file(&single, NULL, err, sizeof(err)) == 0;
+    uint8_t *a = NULL, *b = NULL;
+    size_t a_len = 0, b_len = 0;
+    same = same && read_all(DIR_PATH "/out/single.rx2", &a, &a_len) == 0 &&
+           read_all(DIR_PATH "/out/m3.rx2", &b, &b_len) == 0 &&
+           a_len == b_len && memcmp(a, b, a_len) == 0;
+    check("Batch output matches single encode", same);
+    free(a);
+    free(b);
+    rex_batch_free(jobs, n);
+
+    /* Directory mode, evenly sliced, all cores */
+    n = rex_batch_from_dir(DIR_PATH, DIR_PATH "/out", 4, 100.0f, &jobs, err, sizeof(err));
+    check("Directory lists the WAVs", n == NUM_WAVS &&
+          strcmp(jobs[0].wav_path, DIR_PATH "/take0.wav") == 0 &&
+          strcmp(jobs[0].rx2_path, DIR_PATH "/out/take0.rx2") == 0 && !jobs[0].boundaries);
+    g_ok = g_failed = 0;
+    failed = rex_batch_run(jobs, n, 0, (size_t)64 << 20, report, NULL);
+    int parsed = failed == 0 && g_ok == NUM_WAVS;
+    for (int i = 0; parsed && i < NUM_WAVS; i++) {
+        mapped_file_t mf;
+        rex_file_t rex;
+        parsed = mapped_file_open(&mf, jobs[i].rx2_path, 1 << 24, err, sizeof(err)) == 0;
+        if (!parsed) break;
+        parsed = rex_parse(&rex, mf.data, mf.len) == 0;
+        if (parsed) {
+            parsed = rex.slice_count == 4 && rex.pcm_samples == 20000 + i * 5000 &&
+                     rex.slices[3].sample_offset + rex.slices[3].sample_length ==
+                         (uint32_t)(20000 + i * 5000);
+            rex_free(&rex);
+        }
+        mapped_file_close(&mf);
+    }
+    check("Directory batch encodes even slices", parsed);
+
+    /* Clean up */
+    for (int i = 0; i < n; i++) {
+        char sidecar[512];
+        unlink(jobs[i].rx2_path);
+        snprintf(sidecar, sizeof(sidecar), DIR_PATH "/out/.rexcache/take%d.rx2.pcm", i);
+        unlink(sidecar);
+        snprintf(sidecar, sizeof(sidecar), DIR_PATH "/out/.rexcache/m%d.rx2.pcm", i);
+        unlink(sidecar);
+        snprintf(sidecar, sizeof(sidecar), DIR_PATH "/out/m%d.rx2", i);
+        unlink(sidecar);
+        unlink(jobs[i].wav_path);
+    }
+    rex_batch_free(jobs, n);
+
+    /* Malformed manifest line */
+    f = fopen(DIR_PATH "/manifest.txt", "w");
+    fprintf(f, "only_one_field.wav\n");
+    fclose(f);
+    n = rex_batch_load_manifest(DIR_PATH "/manifest.txt", &jobs, err, sizeof(err));
+    check("Malformed manifest rejected", n == -1 && strstr(err, ":1:") != NULL);
+
+    unlink(DIR_PATH "/out/single.rx2");
+    unlink(DIR_PATH "/out/.rexcache/single.rx2.pcm");
+    rmdir(DIR_PATH "/out/.rexcache");
+    rmdir(DIR_PATH "/out");
+    unlink(DIR_PATH "/manifest.txt");
+    rmdir(DIR_PATH);
+
+    printf("\n=== Results: %d/%d passed ===\n", pass_count, test_count);
+    return (pass_count == test_count) ? 0 : 1;
+}
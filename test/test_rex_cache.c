@@ -0,0 +1,148 @@
+/*
+ * Decoded Loop Cache Test
+ *
+ * Verifies: repeated acquires share one decoded copy, a file changed on
+ * disk is decoded again, idle entries are evicted under the budget,
+ * prefetched entries go first, the counters see each hit and load, and
+ * browsing a full cache recycles decode buffers instead of allocating.
+ *
+ * Build (native macOS/Linux):
+ *   cc -O2 -Isrc/dsp -o test/test_rex_cache \
+ *      test/test_rex_cache.c src/dsp/rex_cache.c src/dsp/rex_sidecar.c \
+ *      src/dsp/mapped_file.c src/dsp/rex_writer.c src/dsp/dwop_encode.c \
+ *      src/dsp/byte_sink.c src/dsp/rex_parser.c src/dsp/dwop.c -lm -lpthread
+ *
+ * Run:   ./test/test_rex_cache
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "test_loop.h"
+#include "rex_cache.h"
+
+static int test_count = 0;
+static int pass_count = 0;
+
+static void check(const char *name, int ok)
+{
+    test_count++;
+    printf("  %-40s ... %s\n", name, ok ? "PASS" : "FAIL");
+    if (ok) pass_count++;
+}
+
+/* Write a mono two-slice loop of num_frames to path */
+static int write_loop(const char *path, int num_frames, float tempo)
+{
+    test_loop_t p = { .channels = 1, .frames = num_frames, .slices = 2, .tempo = tempo };
+    return test_loop_write(path, &p);
+}
+
+int main(void)
+{
+    printf("=== Decoded Loop Cache Tests ===\n\n");
+
+    const char *a = "/tmp/test_rex_cache_a.rx2";
+    const char *b = "/tmp/test_rex_cache_b.rx2";
+    char err[256];
+
+    if (write_loop(a, 22050, 120.0f) != 0 || write_loop(b, 44100, 90.0f) != 0) {
+        printf("FAIL (cannot write test files)\n");
+        return 1;
+    }
+
+    /* Shared copy */
+    rex_cache_stats_t s0, s1, s2;
+    rex_cache_stats(&s0);
+    const rex_file_t *r1 = rex_cache_acquire(a, 0, err, sizeof(err));
+    rex_cache_stats(&s1);
+    const rex_file_t *r2 = rex_cache_acquire(a, 0, err, sizeof(err));
+    rex_cache_stats(&s2);
+    check("Acquire decodes the file", r1 && r1->pcm_samples == 22050);
+    check("Second acquire shares the copy", r1 && r1 == r2);
+    check("Counters see one load, then a hit",
+          s1.misses == s0.misses + 1 &&
+          s1.parses + s1.sidecar_loads == s0.parses + s0.sidecar_loads + 1 &&
+          s2.hits == s1.hits + 1 && s2.misses == s1.misses);
+
+    size_t one = rex_cache_bytes();
+    rex_cache_release(r2);
+    rex_cache_release(r1);
+    check("Idle entry stays cached", rex_cache_bytes() == one);
+
+    const rex_file_t *r3 = rex_cache_acquire(a, 0, err, sizeof(err));
+    check("Re-acquire hits the idle entry", r3 == r1);
+
+    /* Changed on disk: different size invalidates */
+    write_loop(a, 11024, 120.0f);
+    const rex_file_t *r4 = rex_cache_acquire(a, 0, err, sizeof(err));
+    check("Changed file is decoded again", r4 && r4 != r3 && r4->pcm_samples == 11024);
+    check("Old copy still readable while held", r3->pcm_samples == 22050);
+    rex_cache_release(r3);
+    rex_cache_release(r4);
+
+    /* Budget: only one idle loop fits */
+    rex_cache_set_budget(rex_cache_bytes());
+    const rex_file_t *rb = rex_cache_acquire(b, 0, err, sizeof(err));
+    check("Held entry survives over-budget", rb && rb->pcm_samples == 44100);
+    rex_cache_release(rb);
+    check("Idle entries evicted to budget", rex_cache_bytes() <= rex_cache_get_budget());
+
+    rex_cache_set_budget(0);
+    check("Zero budget empties the cache", rex_cache_bytes() == 0);
+
+    /* Prefetch: evicted before used entries, never evicts them */
+    rex_cache_set_budget(REX_CACHE_DEFAULT_BUDGET);
+    const rex_file_t *ua = rex_cache_acquire(a, 0, err, sizeof(err));
+    rex_cache_release(ua);
+    size_t used_only = rex_cache_bytes();
+    check("Prefetch decodes into the cache", rex_cache_prefetch(b, 0) == 0 &&
+          rex_cache_bytes() > used_only);
+    rex_cache_set_budget(used_only);
+    check("Prefetched entry is evicted first", rex_cache_bytes() == used_only);
+    check("Prefetch does not evict used entries", rex_cache_prefetch(b, 0) != 0 &&
+          rex_cache_bytes() == used_only);
+    const rex_file_t *ua2 = rex_cache_acquire(a, 0, err, sizeof(err));
+    check("Used entry survived prefetch pressure", ua2 == ua);
+    rex_cache_release(ua2);
+    rex_cache_set_budget(0);
+
+    /* Browsing a full cache: each evicted loop's buffer carries the next */
+    {
+        char paths[8][64];
+        for (int i = 0; i < 8; i++) {
+            snprintf(paths[i], sizeof(paths[i]), "/tmp/test_rex_cache_browse%d.rx2", i);
+            write_loop(paths[i], 22050, 100.0f + i);
+        }
+        rex_cache_set_budget(REX_CACHE_DEFAULT_BUDGET);
+        rex_cache_release(rex_cache_acquire(paths[0], 0, err, sizeof(err)));
+        rex_cache_set_budget(rex_cache_bytes() * 5);
+        rex_cache_stats_t before, after;
+        for (int pass = 0; pass < 2; pass++) {
+            if (pass == 1) rex_cache_stats(&before);
+            for (int i = 0; i < 8; i++)
+                rex_cache_release(rex_cache_acquire(paths[i], 0, err, sizeof(err)));
+        }
+        rex_cache_stats(&after);
+        check("Full cache recycles decode buffers",
+              after.misses == before.misses + 8 &&
+              after.buffer_reuses == before.buffer_reuses + 8 &&
+              after.buffer_allocs == before.buffer_allocs);
+        rex_cache_set_budget(0);
+        for (int i = 0; i < 8; i++) unlink(paths[i]);
+    }
+
+    /* Missing file */
+    check("Missing file reports an error",
+          rex_cache_acquire("/tmp/test_rex_cache_missing.rx2", 0, err, sizeof(err)) == NULL &&
+          err[0] != '\0');
+
+    unlink(a);
+    unlink(b);
+
+    printf("\n=== Results: %d/%d passed ===\n", pass_count, test_count);
+    return (pass_count == test_count) ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+/*
+ * Shared Loop Catalog Test
+ *
+ * Verifies: instances opening the same folder share one catalog, a folder
+ * with more than the old 512-entry limit is listed in full, a refresh of
+ * an unchanged folder keeps the same view, a folder change publishes a new
+ * view while older views stay readable, and the last close frees it.
+ *
+ * Build (native macOS/Linux):
+ *   cc -O2 -Isrc/dsp -o test/test_rex_catalog \
+ *      test/test_rex_catalog.c src/dsp/rex_catalog.c src/dsp/rex_library.c \
+ *      src/dsp/mapped_file.c src/dsp/rex_parser.c src/dsp/dwop.c \
+ *      -lm -lpthread
+ *
+ * Run:   ./test/test_rex_catalog
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+#include "rex_catalog.h"
+
+#define DIR_PATH  "/tmp/test_rex_catalog"
+#define NUM_FILES 600
+
+static int test_count = 0;
+static int pass_count = 0;
+
+static void check(const char *name, int ok)
+{
+    test_count++;
+    printf("  %-40s ... %s\n", name, ok ? "PASS" : "FAIL");
+    if (ok) pass_count++;
+}
+
+/* An unparseable placeholder is still listed (with scanned unset) */
+static void touch_loop(int i)
+{
+    char path[256];
+    snprintf(path, sizeof(path), DIR_PATH "/loop%04d.rx2", i);
+    FILE *f = fopen(path, "w");
+    if (f) fclose(f);
+}
+
+static void remove_loop(int i)
+{
+    char path[256];
+    snprintf(path, sizeof(path), DIR_PATH "/loop%04d.rx2", i);
+    unlink(path);
+}
+
+/* Set the folder's mtime seconds_ago into the past, as if it last
+ * changed then (each step uses a new value, as real changes would) */
+static void age_dir(int seconds_ago)
+{
+    struct utimbuf t = { time(NULL) - seconds_ago, time(NULL) - seconds_ago };
+    utime(DIR_PATH, &t);
+}
+
+int main(void)
+{
+    printf("=== Shared Loop Catalog Tests ===\n\n");
+
+    mkdir(DIR_PATH, 0755);
+    unlink(DIR_PATH "/.rexcache/library.idx");
+    for (int i = 0; i < NUM_FILES + 1; i++) remove_loop(i);
+    for (int i = 0; i < NUM_FILES; i++) touch_loop(i);
+    age_dir(30);
+
+    rex_catalog_t *a = rex_catalog_open(DIR_PATH);
+    rex_catalog_t *b = rex_catalog_open(DIR_PATH);
+    check("Same folder shares one catalog", a && a == b);
+
+    const rex_catalog_view_t *v1 = rex_catalog_current(a);
+    check("Lists past the old 512 limit", rex_catalog_count(v1) == NUM_FILES);
+    check("Entries sorted with names",
+          strcmp(rex_catalog_name(v1, 0), "loop0000") == 0 &&
+          strcmp(rex_catalog_name(v1, NUM_FILES - 1), "loop0599") == 0 &&
+          strcmp(rex_catalog_path(v1, 7), DIR_PATH "/loop0007.rx2") == 0 &&
+          !rex_catalog_info(v1, 7)->scanned);
+    check("Lookup by name and path",
+          rex_catalog_find_name(v1, "loop0123") == 123 &&
+          rex_catalog_find_path(v1, DIR_PATH "/loop0456.rx2") == 456 &&
+          rex_catalog_find_name(v1, "missing") == -1);
+
+    check("Unchanged folder keeps the view", rex_catalog_refresh(b) == v1);
+
+    /* Add one, remove one: refresh publishes a new listing */
+    const char *old_path = rex_catalog_path(v1, 0);
+    touch_loop(NUM_FILES);
+    remove_loop(0);
+    age_dir(20);
+    const rex_catalog_view_t *v2 = rex_catalog_refresh(b);
+    check("Changed folder publishes a new view",
+          v2 != v1 && rex_catalog_current(a) == v2 && rex_catalog_count(v2) == NUM_FILES &&
+          rex_catalog_find_name(v2, "loop0600") == NUM_FILES - 1 &&
+          rex_catalog_find_name(v2, "loop0000") == -1);
+    check("Older view stays readable",
+          rex_catalog_count(v1) == NUM_FILES &&
+          strcmp(old_path, DIR_PATH "/loop0000.rx2") == 0);
+
+    rex_catalog_close(a);
+    check("Catalog survives until the last close", rex_catalog_current(b) == v2);
+    rex_catalog_close(b);
+
+    rex_catalog_t *c = rex_catalog_open(DIR_PATH);
+    check("Reopen after last close scans again",
+          c && rex_catalog_count(rex_catalog_current(c)) == NUM_FILES);
+    rex_catalog_close(c);
+
+    rex_catalog_t *empty = rex_catalog_open("/tmp/no_such_rex_dir");
+    check("Missing folder lists nothing",
+          empty && rex_catalog_count(rex_catalog_current(empty)) == 0 &&
+          rex_catalog_refresh(empty) == rex_catalog_current(empty));
+    rex_catalog_close(empty);
+
+    for (int i = 0; i < NUM_FILES + 1; i++) remove_loop(i);
+    unlink(DIR_PATH "/.rexcache/library.idx");
+    rmdir(DIR_PATH "/.rexcache");
+    rmdir(DIR_PATH);
+
+    printf("\n=== Results: %d/%d passed ===\n", pass_count, test_count);
+    return (pass_count == test_count) ? 0 : 1;
+}
@@ -0,0 +1,238 @@
+/*
+ * Multi-Loop Kit Test
+ *
+ * Verifies: kit text is parsed into zones (ranges, notes, follow-on
+ * placement, names holding '@' or ':'), and bad text is rejected; a kit
+ * packs its zones' slices back to back into one aligned pool with each
+ * note's offset and length in its slice table, a mono loop playing on
+ * both sides of a stereo kit, planar buffers and slice analysis matching
+ * the loops' own (24-bit precision included); overlapping zones, zones past note 127 or
+ * past a loop's last slice, and missing loops are errors.
+ *
+ * Build (native macOS/Linux):
+ *   cc -O2 -Isrc/dsp -o test/test_rex_kit \
+ *      test/test_rex_kit.c src/dsp/rex_kit.c src/dsp/rex_cache.c \
+ *      src/dsp/rex_sidecar.c src/dsp/mapped_file.c src/dsp/rex_writer.c \
+ *      src/dsp/dwop_encode.c src/dsp/byte_sink.c src/dsp/rex_parser.c \
+ *      src/dsp/dwop.c -lm -lpthread
+ *
+ * Run:   ./test/test_rex_kit
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "test_loop.h"
+#include "rex_kit.h"
+#include "rex_cache.h"
+#include "rex_sidecar.h"
+
+static int test_count = 0;
+static int pass_count = 0;
+
+static void check(const char *name, int ok)
+{
+    test_count++;
+    printf("  %-40s ... %s\n", name, ok ? "PASS" : "FAIL");
+    if (ok) pass_count++;
+}
+
+/* Write a loop of num_frames noisy tones in num_slices uneven slices to
+ * path; with hires it is marked 24-bit. Returns 0 on success. */
+static int write_loop(const char *path, int channels, int num_frames, int num_slices,
+                      int hires, uint32_t seed)
+{
+    test_loop_t p = { .channels = channels, .frames = num_frames, .slices = num_slices,
+                      .tempo = channels == 2 ? 100.0f : 120.0f, .hires = hires,
+                      .jitter = 53, .noise = seed };
+    return test_loop_write(path, &p);
+}
+
+/* Note's slice in kit holds slice s of loop, planes and analysis included */
+static int same_audio(const rex_file_t *kit, int note, const rex_file_t *loop, int s)
+{
+    const rex_slice_t *d = &kit->slices[note], *src = &loop->slices[s];
+    if (d->sample_length != src->sample_length) return 0;
+    int kch = kit->pcm_channels, lch = loop->pcm_channels;
+    for (uint32_t i = 0; i < d->sample_length; i++) {
+        for (int c = 0; c < kch; c++) {
+            int16_t want = loop->pcm_data[(size_t)(src->sample_offset + i) * lch + (lch == 2 ? c : 0)];
+            if (kit->pcm_data[(size_t)(d->sample_offset + i) * kch + c] != want) return 0;
+        }
+    }
+
+    /* The loop's slice analysis, which is also the kit's own audio's */
+    rex_slice_stats_t st;
+    rex_analyze_pcm(kit->pcm_data + (size_t)d->sample_offset * kch, kch, d->sample_length, &st);
+    if (!d->stats.analyzed || memcmp(&d->stats, &src->stats, sizeof(st)) != 0 ||
+        memcmp(&d->stats, &st, sizeof(st)) != 0)
+        return 0;
+
+    if (!kit->planar) return !d->plane[0];
+
+    size_t elem = kit->planar == REX_PLANAR_F32 ? 4 : kit->planar == REX_PLANAR_I24 ? 3 : 2;
+    size_t n = src->sample_length + 2 * REX_PLANAR_GUARD;
+    for (int c = 0; c < kch; c++) {
+        const uint8_t *pk = (const uint8_t *)d->plane[c] - REX_PLANAR_GUARD * elem;
+        const void *pl = src->plane[lch == 2 ? c : 0];
+        if (loop->planar == kit->planar) {
+            if (memcmp(pk, (const uint8_t *)pl - REX_PLANAR_GUARD * elem, n * elem) != 0)
+                return 0;
+            continue;
+        }
+        /* A 16-bit loop's int16 planes in an int24 kit */
+        const int16_t *p16 = (const int16_t *)pl - REX_PLANAR_GUARD;
+        for (size_t k = 0; k < n; k++) {
+            int32_t v = (int32_t)((uint32_t)pk[k * 3] | (uint32_t)pk[k * 3 + 1] << 8 |
+                                  (uint32_t)(int8_t)pk[k * 3 + 2] << 16);
+            if (v != p16[k] * 256) return 0;
+        }
+    }
+    return 1;
+}
+
+static rex_file_t *build(const char *text, const char *const *paths, int flags,
+                         char *err, int err_len)
+{
+    rex_kit_spec_t spec;
+    if (rex_kit_parse(&spec, text, 36, err, err_len) != 0) return NULL;
+    for (int i = 0; i < spec.zone_count; i++) spec.zones[i].path = paths[i];
+    return rex_kit_build(&spec, flags, err, err_len);
+}
+
+int main(void)
+{
+    printf("=== Multi-Loop Kit Tests ===\n\n");
+
+    char err[256];
+    rex_kit_spec_t spec;
+
+    /* Text */
+    {
+        int ok = rex_kit_parse(&spec, " Amen.rx2:0-7@40 ; Think me@2.rx2 ;;Funky:x.rx2:4-",
+                               36, err, sizeof(err)) == 0 && spec.zone_count == 3;
+        ok = ok && strcmp(spec.zones[0].name, "Amen.rx2") == 0 &&
+             spec.zones[0].first == 0 && spec.zones[0].last == 7 && spec.zones[0].note == 40;
+        ok = ok && strcmp(spec.zones[1].name, "Think me@2.rx2") == 0 &&
+             spec.zones[1].first == 0 && spec.zones[1].last == -1 && spec.zones[1].note == -1;
+        ok = ok && strcmp(spec.zones[2].name, "Funky:x.rx2") == 0 &&
+             spec.zones[2].first == 4 && spec.zones[2].last == -1 &&
+             spec.first_note == 36;
+        ok = ok && rex_kit_parse(&spec, "Solo:3@60", 36, err, sizeof(err)) == 0 &&
+             spec.zone_count == 1 && spec.zones[0].first == 3 && spec.zones[0].last == 3;
+        check("Zones parsed", ok);
+
+        ok = rex_kit_parse(&spec, "a.rx2:5-2", 36, err, sizeof(err)) != 0 && err[0] &&
+             rex_kit_parse(&spec, "a.rx2@128", 36, err, sizeof(err)) != 0 &&
+             rex_kit_parse(&spec, ":1-2@40", 36, err, sizeof(err)) != 0 &&
+             rex_kit_parse(&spec, " ; ", 36, err, sizeof(err)) != 0;
+        check("Bad kit text rejected", ok);
+    }
+
+    const char *mono = "/tmp/test_rex_kit_mono.rx2";
+    const char *stereo = "/tmp/test_rex_kit_stereo.rx2";
+    const char *deep = "/tmp/test_rex_kit_24.rx2";
+    rex_sidecar_set_enabled(0);
+    if (write_loop(mono, 1, 30000, 8, 0, 11) != 0 || write_loop(stereo, 2, 40000, 10, 0, 22) != 0 ||
+        write_loop(deep, 2, 20000, 6, 1, 33) != 0) {
+        check("Test loops written", 0);
+        return 1;
+    }
+
+    rex_file_t *lm = rex_load_file(mono, REX_PARSE_PLANAR_F32, err, sizeof(err));
+    rex_file_t *ls = rex_load_file(stereo, REX_PARSE_PLANAR_F32, err, sizeof(err));
+    if (!lm || !ls) {
+        check("Test loops load", 0);
+        return 1;
+    }
+
+    /* Two loops packed into one pool */
+    {
+        const char *paths[] = { stereo, mono };
+        rex_file_t *kit = build("stereo:2-5@48; mono:1-", paths, REX_PARSE_PLANAR_F32,
+                                err, sizeof(err));
+        int ok = kit && kit->kit == 11 && kit->slice_count == REX_KIT_NOTES &&
+                 kit->pcm_channels == 2 && kit->planar == REX_PLANAR_F32 &&
+                 kit->tempo_bpm == 100.0f && !kit->lazy &&
+                 rex_decoded_frames(kit) == kit->pcm_samples &&
+                 ((uintptr_t)kit->pcm_data & 15) == 0;
+        for (int k = 0; ok && k < 4; k++) ok = same_audio(kit, 48 + k, ls, 2 + k);
+        for (int k = 0; ok && k < 7; k++) ok = same_audio(kit, 52 + k, lm, 1 + k);
+
+        /* Back to back in zone order, nothing else mapped */
+        uint32_t at = 0;
+        for (int n = 48; ok && n < 59; n++) {
+            ok = kit->slices[n].sample_offset == at;
+            at += kit->slices[n].sample_length;
+        }
+        ok = ok && at == (uint32_t)kit->pcm_samples;
+        for (int n = 0; ok && n < REX_KIT_NOTES; n++) {
+            if (n < 48 || n >= 59) ok = kit->slices[n].sample_length == 0;
+        }
+        check("Zones packed into one pool", ok);
+        rex_kit_free(kit);
+    }
+
+    /* Follow-on placement from first_note, int16 planes */
+    {
+        const char *paths[] = { mono, stereo };
+        rex_file_t *kit = build("mono:0-2; stereo:0-1", paths, REX_PARSE_PLANAR_I16,
+                                err, sizeof(err));
+        rex_file_t *lm16 = rex_load_file(mono, REX_PARSE_PLANAR_I16, err, sizeof(err));
+        rex_file_t *ls16 = rex_load_file(stereo, REX_PARSE_PLANAR_I16, err, sizeof(err));
+        int ok = kit && lm16 && ls16 && kit->kit == 5 && kit->planar == REX_PLANAR_I16 &&
+                 kit->tempo_bpm == 120.0f;
+        for (int k = 0; ok && k < 3; k++) ok = same_audio(kit, 36 + k, lm16, k);
+        for (int k = 0; ok && k < 2; k++) ok = same_audio(kit, 39 + k, ls16, k);
+        check("Zones follow on from first_note", ok);
+        rex_kit_free(kit);
+        rex_file_destroy(lm16);
+        rex_file_destroy(ls16);
+    }
+
+    /* No planar buffers, then 24-bit precision kept */
+    {
+        const char *paths[] = { mono };
+        rex_file_t *kit = build("mono", paths, 0, err, sizeof(err));
+        int ok = kit && kit->kit == 8 && kit->pcm_channels == 1 && !kit->planar_data;
+        for (int k = 0; ok && k < 8; k++) ok = same_audio(kit, 36 + k, lm, k);
+        rex_kit_free(kit);
+
+        const char *paths2[] = { deep, mono };
+        int flags = REX_PARSE_PLANAR_I16 | REX_PARSE_HIRES;
+        kit = build("deep@60; mono:0-1@20", paths2, flags, err, sizeof(err));
+        rex_file_t *l24 = rex_load_file(deep, flags, err, sizeof(err));
+        rex_file_t *lm16 = rex_load_file(mono, flags, err, sizeof(err));
+        ok = ok && kit && l24 && lm16 && l24->planar == REX_PLANAR_I24 &&
+             kit->planar == REX_PLANAR_I24 && kit->bytes_per_sample == 3;
+        for (int k = 0; ok && k < 6; k++) ok = same_audio(kit, 60 + k, l24, k);
+        for (int k = 0; ok && k < 2; k++) ok = same_audio(kit, 20 + k, lm16, k);
+        check("Plain and 24-bit kits", ok);
+        rex_kit_free(kit);
+        rex_file_destroy(l24);
+        rex_file_destroy(lm16);
+    }
+
+    /* Errors */
+    {
+        const char *paths[] = { stereo, mono };
+        const char *missing[] = { stereo, NULL };
+        int ok = !build("stereo:0-3@40; mono@42", paths, 0, err, sizeof(err)) && err[0] &&
+                 !build("stereo@120", paths, 0, err, sizeof(err)) &&
+                 !build("stereo:8-12", paths, 0, err, sizeof(err)) &&
+                 !build("stereo; nowhere", missing, 0, err, sizeof(err)) &&
+                 strstr(err, "nowhere") != NULL;
+        check("Bad zones rejected", ok);
+    }
+
+    rex_file_destroy(lm);
+    rex_file_destroy(ls);
+    remove(mono);
+    remove(stereo);
+    remove(deep);
+
+    printf("\n=== Results: %d/%d passed ===\n", pass_count, test_count);
+    return (pass_count == test_count) ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+/*
+ * Loop Library Index Test
+ *
+ * Verifies: REX_PARSE_HEADER reads metadata without decoding audio, a
+ * folder scan lists loops sorted with their metadata, an index written
+ * after the folder's last change is used without rescanning, and a folder
+ * change rescans only files that are new or changed.
+ *
+ * Build (native macOS/Linux):
+ *   cc -O2 -Isrc/dsp -o test/test_rex_library \
+ *      test/test_rex_library.c src/dsp/rex_library.c src/dsp/mapped_file.c \
+ *      src/dsp/rex_writer.c src/dsp/dwop_encode.c src/dsp/rex_parser.c \
+ *      src/dsp/byte_sink.c src/dsp/dwop.c -lm -lpthread
+ *
+ * Run:   ./test/test_rex_library
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+#include "test_loop.h"
+#include "rex_parser.h"
+#include "rex_library.h"
+
+#define DIR_PATH "/tmp/test_rex_library"
+
+static int test_count = 0;
+static int pass_count = 0;
+
+static void check(const char *name, int ok)
+{
+    test_count++;
+    printf("  %-40s ... %s\n", name, ok ? "PASS" : "FAIL");
+    if (ok) pass_count++;
+}
+
+/* Write a two-bar loop of num_slices equal slices to path */
+static int write_loop(const char *path, int channels, int num_frames,
+                      int num_slices, float tempo)
+{
+    test_loop_t p = { .channels = channels, .frames = num_frames, .slices = num_slices,
+                      .tempo = tempo, .bars = 2 };
+    return test_loop_write(path, &p);
+}
+
+/* Rewrite every "<old>" tempo field in the index to new_tempo */
+static void patch_index_tempo(const char *old_tempo, const char *new_tempo)
+{
+    char text[8192];
+    FILE *f = fopen(DIR_PATH "/.rexcache/library.idx", "r");
+    if (!f) return;
+    size_t n = fread(text, 1, sizeof(text) - 1, f);
+    fclose(f);
+    text[n] = '\0';
+    char *p = strstr(text, old_tempo);
+    if (p) memcpy(p, new_tempo, strlen(new_tempo));
+    f = fopen(DIR_PATH "/.rexcache/library.idx", "w");
+    if (f) {
+        fputs(text, f);
+        fclose(f);
+    }
+}
+
+/* Set the folder's mtime seconds_ago into the past, as if it last
+ * changed then (each step uses a new value, as real changes would) */
+static void age_dir(int seconds_ago)
+{
+    struct utimbuf t = { time(NULL) - seconds_ago, time(NULL) - seconds_ago };
+    utime(DIR_PATH, &t);
+}
+
+int main(void)
+{
+    printf("=== Loop Library Index Tests ===\n\n");
+
+    /* Header-only parse */
+    test_loop_t loop = { .channels = 2, .frames = 44100, .slices = 8, .tempo = 96.0f, .bars = 2 };
+    uint8_t *buf;
+    int written = test_loop_encode(&loop, &buf);
+    rex_file_t rex;
+    int rc = rex_parse_ex(&rex, buf, written, REX_PARSE_HEADER);
+    check("Header parse succeeds", rc == 0);
+    check("Header parse has metadata",
+          rex.slice_count == 8 && rex.channels == 2 && rex.bars == 2 &&
+          fabsf(rex.tempo_bpm - 96.0f) < 0.01f && rex.total_sample_length == 44100);
+    check("Header parse decodes no audio", !rex.pcm_data && !rex.sdat_data && !rex.lazy);
+    rex_free(&rex);
+    free(buf);
+
+    /* Fresh folder */
+    mkdir(DIR_PATH, 0755);
+    unlink(DIR_PATH "/.rexcache/library.idx");
+    unlink(DIR_PATH "/b.rx2");
+    unlink(DIR_PATH "/a.rx2");
+    unlink(DIR_PATH "/c.rx2");
+    write_loop(DIR_PATH "/b.rx2", 2, 22050, 4, 120.0f);
+    write_loop(DIR_PATH "/a.rx2", 1, 11025, 2, 90.0f);
+    FILE *f = fopen(DIR_PATH "/notes.txt", "w");
+    if (f) fclose(f);
+
+    rex_library_entry_t *e = NULL;
+    int n = rex_library_scan(DIR_PATH, &e, NULL);
+    check("Scan lists only loops, sorted", n == 2 &&
+          strcmp(e[0].name, "a") == 0 && strcmp(e[1].name, "b") == 0);
+    check("Scan reads metadata", n == 2 && e[0].info.scanned && e[1].info.scanned &&
+          e[0].info.slice_count == 2 && e[0].info.channels == 1 && e[0].info.frames == 11025 &&
+          e[1].info.slice_count == 4 && e[1].info.channels == 2 &&
+          fabsf(e[1].info.tempo_bpm - 120.0f) < 0.01f);
+
+    /* Index written after the folder changed: used as is */
+    age_dir(30);
+    free(e);
+    rex_library_scan(DIR_PATH, &e, NULL);  /* folder "changed": index rewritten */
+    free(e);
+    patch_index_tempo("120.000", "777.000");
+    n = rex_library_scan(DIR_PATH, &e, NULL);
+    check("Unchanged folder uses the index", n == 2 && fabsf(e[1].info.tempo_bpm - 777.0f) < 0.01f);
+
+    /* New file: rescan, but unchanged files keep their indexed metadata */
+    write_loop(DIR_PATH "/c.rx2", 2, 8000, 3, 140.0f);
+    age_dir(20);
+    free(e);
+    n = rex_library_scan(DIR_PATH, &e, NULL);
+    check("Changed folder finds the new file", n == 3 && strcmp(e[2].name, "c") == 0 &&
+          e[2].info.slice_count == 3);
+    check("Unchanged files are not rescanned", n == 3 && fabsf(e[1].info.tempo_bpm - 777.0f) < 0.01f);
+
+    /* Changed file is rescanned */
+    write_loop(DIR_PATH "/b.rx2", 2, 22050 * 2, 4, 120.0f);
+    unlink(DIR_PATH "/c.rx2");
+    age_dir(10);
+    free(e);
+    n = rex_library_scan(DIR_PATH, &e, NULL);
+    check("Changed file is rescanned", n == 2 && fabsf(e[1].info.tempo_bpm - 120.0f) < 0.01f &&
+          e[1].info.frames == 44100);
+
+    free(e);
+    check("Missing folder lists nothing",
+          rex_library_scan("/tmp/no_such_rex_dir", &e, NULL) == 0 && e == NULL);
+
+    unlink(DIR_PATH "/.rexcache/library.idx");
+    rmdir(DIR_PATH "/.rexcache");
+    unlink(DIR_PATH "/notes.txt");
+    unlink(DIR_PATH "/a.rx2");
+    unlink(DIR_PATH "/b.rx2");
+    rmdir(DIR_PATH);
+
+    printf("\n=== Results: %d/%d passed ===\n", pass_count, test_count);
+    return (pass_count == test_count) ? 0 : 1;
+}
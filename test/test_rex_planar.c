@@ -0,0 +1,234 @@
+/*
+ * Planar Slice Buffer Test
+ *
+ * Verifies: parsing with REX_PARSE_PLANAR_F32 / REX_PARSE_PLANAR_I16 gives
+ * every slice 16-byte aligned L/R buffers that match the interleaved
+ * decode, padded with REX_PLANAR_GUARD copies of the edge samples, and that
+ * lazy parsing ignores the planar flags. For a 24-bit file, REX_PARSE_HIRES
+ * keeps the low 8 bits in float planes and packed int24 planes while the
+ * interleaved PCM stays truncated to 16 bits.
+ *
+ * Build (native macOS/Linux):
+ *   cc -O2 -Isrc/dsp -o test/test_rex_planar \
+ *      test/test_rex_planar.c src/dsp/rex_writer.c src/dsp/dwop_encode.c \
+ *      src/dsp/byte_sink.c src/dsp/rex_parser.c src/dsp/dwop.c -lm -lpthread
+ *
+ * Run:   ./test/test_rex_planar
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "rex_writer.h"
+#include "rex_parser.h"
+
+static int test_count = 0;
+static int pass_count = 0;
+
+/* Sample k (-REX_PLANAR_GUARD .. len + REX_PLANAR_GUARD - 1) of a plane */
+static float plane_at(const rex_file_t *rex, const rex_slice_t *s, int c, int k)
+{
+    if (rex->planar == REX_PLANAR_F32) return ((const float *)s->plane[c])[k];
+    if (rex->planar == REX_PLANAR_I24) {
+        const uint8_t *b = (const uint8_t *)s->plane[c] + k * 3;
+        return (float)((int32_t)((uint32_t)b[0] << 8 | (uint32_t)b[1] << 16 |
+                                 (uint32_t)b[2] << 24) >> 8);
+    }
+    return (float)((const int16_t *)s->plane[c])[k];
+}
+
+static int test_planar(const char *name, int channels, int num_frames,
+                       int num_slices, int flags)
+{
+    test_count++;
+    printf("  %-40s ... ", name);
+
+    int16_t *pcm = (int16_t *)malloc((size_t)num_frames * channels * sizeof(int16_t));
+    uint32_t seed = 0x5EED;
+    for (int i = 0; i < num_frames; i++) {
+        for (int c = 0; c < channels; c++) {
+            seed = seed * 1664525 + 1013904223;
+            double tone = 9000.0 * sin(2.0 * M_PI * (330.0 + 55.0 * c) * i / 44100.0);
+            pcm[i * channels + c] = (int16_t)(tone + ((int32_t)(seed >> 16) - 32768) / 8);
+        }
+    }
+
+    /* Uneven slice lengths, so buffers need padding to stay aligned */
+    rex_write_slice_t slices[64];
+    uint32_t pos = 0;
+    for (int i = 0; i < num_slices; i++) {
+        uint32_t len = (i == num_slices - 1)
+            ? (uint32_t)num_frames - pos
+            : (uint32_t)(num_frames / num_slices) + (i % 5) * 3 - 7;
+        slices[i].sample_offset = pos;
+        slices[i].sample_length = len;
+        pos += len;
+    }
+
+    rex_write_params_t wp;
+    memset(&wp, 0, sizeof(wp));
+    wp.tempo_bpm = 120.0f;
+    wp.bars = 1;
+    wp.time_sig_num = 4;
+    wp.time_sig_den = 4;
+    wp.sample_rate = 44100;
+    wp.channels = channels;
+    wp.pcm_data = pcm;
+    wp.num_frames = num_frames;
+    wp.slice_count = num_slices;
+    wp.slices = slices;
+
+    int buf_cap = num_frames * channels * 4 + 4096;
+    uint8_t *buf = (uint8_t *)malloc(buf_cap);
+    int written = rex_write(&wp, buf, buf_cap);
+
+    rex_file_t rex, lazy;
+    int errors = 0;
+    if (written <= 0 || rex_parse_ex(&rex, buf, written, flags) != 0 ||
+        rex_parse_ex(&lazy, buf, written, flags | REX_PARSE_LAZY) != 0) {
+        printf("FAIL (write/parse)\n");
+        free(buf);
+        free(pcm);
+        return 0;
+    }
+
+    int want = (flags & REX_PARSE_PLANAR_F32) ? REX_PLANAR_F32 : REX_PLANAR_I16;
+    if (rex.planar != want || !rex.planar_data || !rex.pcm_data) {
+        printf("FAIL (no planar buffers)\n");
+        errors++;
+    }
+    if (lazy.planar != REX_PLANAR_NONE || lazy.planar_data || lazy.slices[0].plane[0]) {
+        printf("FAIL (lazy file has planar buffers)\n");
+        errors++;
+    }
+
+    for (int i = 0; errors == 0 && i < rex.slice_count; i++) {
+        const rex_slice_t *s = &rex.slices[i];
+        const int16_t *src = rex.pcm_data + (size_t)s->sample_offset * channels;
+        int len = (int)s->sample_length;
+
+        if (channels == 1 && s->plane[1] != s->plane[0]) errors++;
+        for (int c = 0; c < channels; c++) {
+            if (((uintptr_t)s->plane[c] & 15) != 0) errors++;
+            for (int k = 0; k < len; k++) {
+                if (plane_at(&rex, s, c, k) != (float)src[k * channels + c]) errors++;
+            }
+            for (int g = 1; g <= REX_PLANAR_GUARD; g++) {
+                if (plane_at(&rex, s, c, -g) != (float)src[c]) errors++;
+                if (plane_at(&rex, s, c, len - 1 + g) != (float)src[(len - 1) * channels + c])
+                    errors++;
+            }
+        }
+        if (errors) printf("FAIL (slice %d mismatch)\n", i);
+    }
+
+    rex_free(&rex);
+    rex_free(&lazy);
+    free(buf);
+    free(pcm);
+
+    if (errors == 0) {
+        printf("PASS\n");
+        pass_count++;
+        return 1;
+    }
+    return 0;
+}
+
+/* The writer only makes 16-bit files. Marking one as 24-bit makes each
+ * encoded sample v a 24-bit value v, to be played at v / 256. */
+static int test_hires(const char *name, int channels, int flags)
+{
+    test_count++;
+    printf("  %-40s ... ", name);
+
+    int num_frames = 4000;
+    int16_t *pcm = (int16_t *)malloc((size_t)num_frames * channels * sizeof(int16_t));
+    for (int i = 0; i < num_frames * channels; i++)
+        pcm[i] = (int16_t)(12000.0 * sin(0.01 * i) + (i % 7) * 37);
+
+    rex_write_slice_t slices[2] = { { 0, 1500 }, { 1500, 2500 } };
+    rex_write_params_t wp;
+    memset(&wp, 0, sizeof(wp));
+    wp.tempo_bpm = 120.0f;
+    wp.bars = 1;
+    wp.time_sig_num = 4;
+    wp.time_sig_den = 4;
+    wp.sample_rate = 44100;
+    wp.channels = channels;
+    wp.pcm_data = pcm;
+    wp.num_frames = num_frames;
+    wp.slice_count = 2;
+    wp.slices = slices;
+
+    int buf_cap = num_frames * channels * 4 + 4096;
+    uint8_t *buf = (uint8_t *)malloc(buf_cap);
+    int written = rex_write(&wp, buf, buf_cap);
+    for (int i = 0; i + 14 <= written; i++) {
+        if (memcmp(buf + i, "HEAD", 4) == 0) {
+            buf[i + 8 + 5] = 3;
+            break;
+        }
+    }
+
+    rex_file_t hi, lo;
+    if (written <= 0 || rex_parse_ex(&hi, buf, written, flags | REX_PARSE_HIRES) != 0 ||
+        rex_parse_ex(&lo, buf, written, flags) != 0) {
+        printf("FAIL (write/parse)\n");
+        free(buf);
+        free(pcm);
+        return 0;
+    }
+
+    int errors = 0;
+    int want = (flags & REX_PARSE_PLANAR_F32) ? REX_PLANAR_F32 : REX_PLANAR_I24;
+    float scale = want == REX_PLANAR_F32 ? 1.0f / 256.0f : 1.0f;
+    if (hi.bytes_per_sample != 3 || hi.planar != want || lo.planar != rex_planar_format(flags, 3)) {
+        printf("FAIL (planar format)\n");
+        errors++;
+    }
+    for (int i = 0; errors == 0 && i < hi.slice_count; i++) {
+        const rex_slice_t *s = &hi.slices[i];
+        int len = (int)s->sample_length;
+        for (int c = 0; c < channels; c++) {
+            for (int k = -REX_PLANAR_GUARD; k < len + REX_PLANAR_GUARD; k++) {
+                int at = k < 0 ? 0 : (k >= len ? len - 1 : k);
+                size_t j = ((size_t)s->sample_offset + at) * channels + c;
+                if (plane_at(&hi, s, c, k) != (float)pcm[j] * scale) errors++;
+                if (plane_at(&lo, &lo.slices[i], c, k) != (float)(pcm[j] >> 8)) errors++;
+                if (k == at && (hi.pcm_data[j] != pcm[j] >> 8 || lo.pcm_data[j] != pcm[j] >> 8))
+                    errors++;
+            }
+        }
+        if (errors) printf("FAIL (slice %d mismatch)\n", i);
+    }
+
+    rex_free(&hi);
+    rex_free(&lo);
+    free(buf);
+    free(pcm);
+
+    if (errors == 0) {
+        printf("PASS\n");
+        pass_count++;
+        return 1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    printf("=== Planar Slice Buffer Tests ===\n\n");
+
+    test_planar("Mono float 1 slice", 1, 8000, 1, REX_PARSE_PLANAR_F32);
+    test_planar("Mono int16 16 slices", 1, 44100, 16, REX_PARSE_PLANAR_I16);
+    test_planar("Stereo float 8 slices", 2, 44100, 8, REX_PARSE_PLANAR_F32);
+    test_planar("Stereo int16 64 slices", 2, 88200, 64, REX_PARSE_PLANAR_I16);
+    test_hires("24-bit mono float", 1, REX_PARSE_PLANAR_F32);
+    test_hires("24-bit stereo int24", 2, REX_PARSE_PLANAR_I16);
+
+    printf("\n=== Results: %d/%d passed ===\n", pass_count, test_count);
+    return (pass_count == test_count) ? 0 : 1;
+}
@@ -0,0 +1,267 @@
+/*
+ * Progressive Decode Test
+ *
+ * Verifies: a REX_PARSE_PROGRESSIVE parse decodes one step up front and
+ * rex_decode_step() the rest, in any step size; every slice at or below
+ * the watermark already matches the full parse, planar buffers included
+ * (float, int16 and 24-bit int24); the finished file equals the full
+ * parse and has let go of its SDAT copy. Through the cache, a progressive
+ * acquire returns the file unfinished, an ordinary acquire of it gets the
+ * whole file, and rex_cache_finish() completes it; the cache charges the
+ * SDAT copy until then. rex_cache_finish_step() completes it a step at a
+ * time, reported as one parse even with another in between, and the
+ * loader publishes a newer request while an older loop is still decoding.
+ *
+ * Build (native macOS/Linux):
+ *   cc -O2 -Isrc/dsp -o test/test_rex_progressive \
+ *      test/test_rex_progressive.c src/dsp/rex_loader.c src/dsp/rex_kit.c \
+ *      src/dsp/rex_cache.c src/dsp/rex_sidecar.c \
+ *      src/dsp/mapped_file.c src/dsp/rex_writer.c src/dsp/dwop_encode.c \
+ *      src/dsp/byte_sink.c src/dsp/rex_parser.c src/dsp/dwop.c -lm -lpthread
+ *
+ * Run:   ./test/test_rex_progressive
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include "test_loop.h"
+#include "rex_cache.h"
+#include "rex_loader.h"
+#include "rex_sidecar.h"
+
+static int test_count = 0;
+static int pass_count = 0;
+
+static void check(const char *name, int ok)
+{
+    test_count++;
+    printf("  %-40s ... %s\n", name, ok ? "PASS" : "FAIL");
+    if (ok) pass_count++;
+}
+
+/* Encode num_frames of noisy tones in num_slices uneven slices. With
+ * hires the file is marked 24-bit. Returns the length written to *out. */
+static int make_loop(uint8_t **out, int channels, int num_frames, int num_slices, int hires)
+{
+    test_loop_t p = { .channels = channels, .frames = num_frames, .slices = num_slices,
+                      .hires = hires, .jitter = 101, .noise = 0xF00D };
+    return test_loop_encode(&p, out);
+}
+
+/* Slice i of a and b hold the same samples and planes */
+static int same_slice(const rex_file_t *a, const rex_file_t *b, int i)
+{
+    const rex_slice_t *sa = &a->slices[i], *sb = &b->slices[i];
+    int ch = a->pcm_channels;
+    size_t n = (size_t)sa->sample_length * ch;
+    if (memcmp(a->pcm_data + (size_t)sa->sample_offset * ch,
+               b->pcm_data + (size_t)sb->sample_offset * ch, n * sizeof(int16_t)) != 0)
+        return 0;
+    if (a->planar != b->planar || !sa->plane[0] != !sb->plane[0]) return 0;
+    if (!sa->plane[0]) return 1;
+
+    size_t elem = a->planar == REX_PLANAR_F32 ? 4 : a->planar == REX_PLANAR_I24 ? 3 : 2;
+    size_t bytes = (sa->sample_length + 2 * REX_PLANAR_GUARD) * elem;
+    for (int c = 0; c < ch; c++) {
+        const uint8_t *pa = (const uint8_t *)sa->plane[c] - REX_PLANAR_GUARD * elem;
+        const uint8_t *pb = (const uint8_t *)sb->plane[c] - REX_PLANAR_GUARD * elem;
+        if (memcmp(pa, pb, bytes) != 0) return 0;
+    }
+    return 1;
+}
+
+static void test_steps(const char *name, int channels, int hires, int flags, int step)
+{
+    uint8_t *buf;
+    int len = make_loop(&buf, channels, 50000, 12, hires);
+
+    rex_file_t full, prog;
+    if (len <= 0 || rex_parse_ex(&full, buf, len, flags) != 0 ||
+        rex_parse_ex(&prog, buf, len, flags | REX_PARSE_PROGRESSIVE) != 0) {
+        check(name, 0);
+        free(buf);
+        return;
+    }
+
+    int ok = rex_decoded_frames(&full) == full.pcm_samples && !full.progress &&
+             prog.progress && rex_decoded_frames(&prog) == REX_DECODE_STEP &&
+             prog.pcm_samples == full.pcm_samples && prog.planar == full.planar;
+
+    /* Slices become whole in end order as the watermark passes them */
+    int seen[REX_MAX_SLICES] = {0};
+    int last = 0, more = 1;
+    while (ok) {
+        int decoded = rex_decoded_frames(&prog);
+        ok = decoded >= last;
+        last = decoded;
+        for (int i = 0; ok && i < prog.slice_count; i++) {
+            const rex_slice_t *s = &prog.slices[i];
+            if (seen[i] || s->sample_offset + s->sample_length > (uint32_t)decoded) continue;
+            ok = same_slice(&full, &prog, i);
+            seen[i] = 1;
+        }
+        if (!more) break;
+        more = rex_decode_step(&prog, step);
+    }
+
+    ok = ok && last == prog.pcm_samples && !prog.progress && !prog.sdat_data &&
+         memcmp(full.pcm_data, prog.pcm_data,
+                (size_t)full.pcm_samples * channels * sizeof(int16_t)) == 0 &&
+         rex_decode_step(&prog, step) == 0;
+    for (int i = 0; ok && i < prog.slice_count; i++) ok = seen[i];
+
+    rex_free(&full);
+    rex_free(&prog);
+    free(buf);
+    check(name, ok);
+}
+
+static void *acquire_whole(void *arg)
+{
+    char err[256];
+    return (void *)rex_cache_acquire((const char *)arg, REX_PARSE_PLANAR_F32, err, sizeof(err));
+}
+
+int main(void)
+{
+    printf("=== Progressive Decode Tests ===\n\n");
+
+    test_steps("Mono, no planar, 1000-frame steps", 1, 0, 0, 1000);
+    test_steps("Mono float, 4097-frame steps", 1, 0, REX_PARSE_PLANAR_F32, 4097);
+    test_steps("Stereo int16, 777-frame steps", 2, 0, REX_PARSE_PLANAR_I16, 777);
+    test_steps("Stereo float, one big step", 2, 0, REX_PARSE_PLANAR_F32, 1 << 20);
+    test_steps("24-bit stereo int24, 3000-frame steps", 2, 1,
+               REX_PARSE_PLANAR_I16 | REX_PARSE_HIRES, 3000);
+    test_steps("24-bit mono float, 5000-frame steps", 1, 1,
+               REX_PARSE_PLANAR_F32 | REX_PARSE_HIRES, 5000);
+
+    /* Through the cache */
+    {
+        const char *path = "/tmp/test_rex_progressive.rx2";
+        char err[256];
+        uint8_t *buf;
+        int len = make_loop(&buf, 2, 80000, 16, 0);
+        FILE *f = fopen(path, "wb");
+        int ok = f && fwrite(buf, 1, len, f) == (size_t)len;
+        if (f) fclose(f);
+        free(buf);
+        rex_sidecar_set_enabled(0);
+
+        const rex_file_t *r1 = ok ? rex_cache_acquire(path, REX_PARSE_PLANAR_F32 |
+                                                      REX_PARSE_PROGRESSIVE,
+                                                      err, sizeof(err)) : NULL;
+        int unfinished = r1 && rex_decoded_frames(r1) < r1->pcm_samples;
+        size_t held = rex_cache_bytes(), sdat = r1 ? r1->sdat_len : 0;
+
+        /* Needs the whole file: finishes it, or waits for whoever does */
+        pthread_t t;
+        const rex_file_t *r2 = NULL;
+        if (r1 && pthread_create(&t, NULL, acquire_whole, (void *)path) == 0) {
+            void *res;
+            pthread_join(t, &res);
+            r2 = (const rex_file_t *)res;
+        }
+        rex_cache_finish(r1);
+
+        check("Progressive acquire returns early", unfinished);
+        check("Ordinary acquire gets the whole file",
+              r2 == r1 && r2 && rex_decoded_frames(r2) == r2->pcm_samples && !r2->progress);
+        check("SDAT copy charged until finished",
+              sdat > 0 && rex_cache_bytes() + sdat <= held);
+
+        const rex_file_t *r3 = rex_cache_acquire(path, REX_PARSE_PLANAR_F32 |
+                                                 REX_PARSE_PROGRESSIVE, err, sizeof(err));
+        check("Finished copy is shared", r3 == r1);
+
+        rex_cache_release(r3);
+        rex_cache_release(r2);
+        rex_cache_release(r1);
+        remove(path);
+    }
+
+    /* Stepped through the cache, with another parse in between */
+    {
+        const char *path = "/tmp/test_rex_progressive_step.rx2";
+        const char *other = "/tmp/test_rex_progressive_other.rx2";
+        char err[256];
+        test_loop_t loop = { .channels = 2, .frames = 60000, .slices = 8, .noise = 0xF00D };
+        test_loop_t small = { .channels = 1, .frames = 20000, .slices = 4 };
+        int ok = test_loop_write(path, &loop) == 0 && test_loop_write(other, &small) == 0;
+        struct stat st_path, st_other;
+        ok = ok && stat(path, &st_path) == 0 && stat(other, &st_other) == 0;
+
+        const rex_file_t *r = ok ? rex_cache_acquire(path, REX_PARSE_PROGRESSIVE,
+                                                     err, sizeof(err)) : NULL;
+        int before = r ? rex_decoded_frames(r) : 0;
+        int first = r && rex_cache_finish_step(r) == 1;
+        rex_cache_stats_t mid, end;
+        rex_cache_prefetch(other, 0);
+        rex_cache_stats(&mid);
+        int steps = 1;
+        while (r && rex_cache_finish_step(r)) steps++;
+        rex_cache_stats(&end);
+        check("Finish steps advance to the end",
+              first && rex_decoded_frames(r) > before + REX_DECODE_STEP - 1 &&
+              rex_decoded_frames(r) == r->pcm_samples && !r->progress &&
+              steps >= (r->pcm_samples - before) / REX_DECODE_STEP &&
+              rex_cache_finish_step(r) == 0);
+        check("Last parse is one whole file",
+              mid.last_parse_bytes == (size_t)st_other.st_size &&
+              end.last_parse_bytes == (size_t)st_path.st_size &&
+              end.last_parse_ns > 0 &&
+              end.last_parse_ns <= end.parse_ns - mid.last_parse_ns);
+        rex_cache_release(r);
+        remove(path);
+        remove(other);
+    }
+
+    /* Browsing on while a long loop decodes */
+    {
+        const char *long_path = "/tmp/test_rex_progressive_long.rx2";
+        const char *next_path = "/tmp/test_rex_progressive_next.rx2";
+        uint8_t *buf;
+        int ok = 1;
+        for (int k = 0; k < 2; k++) {
+            int len = make_loop(&buf, 2, k ? 30000 : 1500000, 16, 0);
+            FILE *f = fopen(k ? next_path : long_path, "wb");
+            ok = ok && f && fwrite(buf, 1, len, f) == (size_t)len;
+            if (f) fclose(f);
+            free(buf);
+        }
+
+        rex_loader_t *ld = ok ? rex_loader_create(NULL) : NULL;
+        const rex_file_t *cur = NULL, *got = NULL, *first = NULL;
+        int unfinished = 0;
+        if (ld) {
+            rex_loader_set_flags(ld, REX_PARSE_PROGRESSIVE);
+            rex_loader_request(ld, long_path);
+            while (!(got = rex_loader_swap(ld, cur))) sched_yield();
+            cur = first = got;
+            rex_loader_request(ld, next_path);
+            while (!(got = rex_loader_swap(ld, cur))) sched_yield();
+            cur = got;
+
+            /* The long loop went to the retire ring: look it up again */
+            char err[256];
+            const rex_file_t *again = rex_cache_acquire(long_path, REX_PARSE_PROGRESSIVE,
+                                                        err, sizeof(err));
+            unfinished = again == first && rex_decoded_frames(again) < again->pcm_samples;
+            rex_cache_release(again);
+        }
+        check("Newer request is not held up", unfinished && cur && cur != first);
+
+        rex_loader_destroy(ld);
+        rex_loader_release(cur);
+        remove(long_path);
+        remove(next_path);
+    }
+
+    printf("\n=== Results: %d/%d passed ===\n", pass_count, test_count);
+    return (pass_count == test_count) ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+/*
+ * Note Timing Test
+ *
+ * Verifies, through the headless renderer (rex_render.h) on a loop of
+ * clicks: a note queued frame_offset frames into a block starts sounding
+ * on exactly that frame, on either side of the 128-frame sub-block
+ * boundaries and in a later block; a full MIDI queue applies what it
+ * holds at once and keeps the new event's timing; and notes at the top
+ * of the 0-127 range start and stop while bytes above it are ignored;
+ * the voice pool steals at its polyphony and note-offs find every voice
+ * still on a note.
+ *
+ * Build (native macOS/Linux):
+ *   cc -O2 -Isrc/dsp -o test/test_rex_render \
+ *      test/test_rex_render.c src/dsp/rex_plugin.c src/dsp/rex_loader.c \
+ *      src/dsp/rex_kit.c src/dsp/rex_cache.c src/dsp/rex_sidecar.c \
+ *      src/dsp/rex_library.c src/dsp/rex_catalog.c src/dsp/resample.c \
+ *      src/dsp/mapped_file.c src/dsp/rex_writer.c src/dsp/dwop_encode.c \
+ *      src/dsp/byte_sink.c src/dsp/rex_parser.c src/dsp/dwop.c -lm -lpthread
+ *
+ * Run:   ./test/test_rex_render
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "test_loop.h"
+#include "rex_render.h"
+#include "rex_sidecar.h"
+
+#define PATH       "/tmp/test_rex_render.rx2"
+#define TONES_PATH "/tmp/test_rex_render_tones.rx2"
+#define SLICES     8
+#define BLOCK      512   /* frames per rex_render_run(): four sub-blocks */
+#define QUEUE_SIZE 256   /* MIDI_QUEUE_SIZE in rex_plugin.c */
+
+static int test_count = 0;
+static int pass_count = 0;
+
+static void check(const char *name, int ok)
+{
+    test_count++;
+    printf("  %-40s ... %s\n", name, ok ? "PASS" : "FAIL");
+    if (ok) pass_count++;
+}
+
+static void note(rex_render_t *r, uint8_t status, int key, int velocity, int offset)
+{
+    uint8_t msg[3] = { status, (uint8_t)key, (uint8_t)velocity };
+    rex_render_midi(r, msg, 3, offset);
+}
+
+/* Render blocks of BLOCK frames; returns how many frames sound, their
+ * indexes (from the first block's start) in at[]. A click is one frame
+ * long, scaled down by the shortest attack but never to silence. */
+static int render_onsets(rex_render_t *r, int blocks, int *at, int max)
+{
+    int16_t out[BLOCK * 2];
+    int n = 0;
+    for (int b = 0; b < blocks; b++) {
+        rex_render_run(r, out, BLOCK);
+        for (int i = 0; i < BLOCK; i++) {
+            if (out[i * 2] != 0 && n < max)
+                at[n++] = b * BLOCK + i;
+        }
+    }
+    return n;
+}
+
+static int same_onsets(const int *at, int n, const int *want, int want_n)
+{
+    if (n != want_n) return 0;
+    for (int i = 0; i < n; i++) {
+        if (at[i] != want[i]) return 0;
+    }
+    return 1;
+}
+
+int main(void)
+{
+    printf("=== Note Timing Tests ===\n\n");
+
+    rex_sidecar_set_enabled(0);
+    test_loop_t loop = { .channels = 2, .frames = SLICES * 4000, .slices = SLICES,
+                         .impulse = 1 };
+    test_loop_t tones = { .channels = 2, .frames = SLICES * 4000, .slices = SLICES };
+    if (test_loop_write(PATH, &loop) != 0 || test_loop_write(TONES_PATH, &tones) != 0) {
+        printf("Cannot write the test loops\n");
+        return 1;
+    }
+    char err[256];
+    int at[64];
+
+    /* Offsets around the sub-block boundaries, and past the block */
+    {
+        static const int offsets[] = { 0, 1, 127, 128, 129, 255, 256, 300, 511, 700 };
+        const int count = (int)(sizeof(offsets) / sizeof(offsets[0]));
+        rex_render_t *r = rex_render_open(PATH, NULL, err, sizeof(err));
+        int n = 0;
+        if (r) {
+            int first = rex_render_start_note(r);
+            for (int i = 0; i < count; i++)
+                note(r, 0x90, first + i % SLICES, 127, offsets[i]);
+            n = render_onsets(r, 2, at, 64);
+        }
+        check("Notes sound on their frame", r && same_onsets(at, n, offsets, count));
+        rex_render_close(r);
+    }
+
+    /* Queue full: what is queued plays now, the new event on time */
+    {
+        rex_render_t *r = rex_render_open(PATH, NULL, err, sizeof(err));
+        int n = 0;
+        if (r) {
+            int first = rex_render_start_note(r);
+            note(r, 0x90, first, 127, 300);
+            for (int i = 1; i < QUEUE_SIZE; i++)
+                note(r, 0x80, first + 1, 0, 400);
+            note(r, 0x90, first + 2, 127, 50);
+            n = render_onsets(r, 1, at, 64);
+        }
+        static const int want[] = { 0, 50 };
+        check("Full queue is late, not lost", r && same_onsets(at, n, want, 2));
+        rex_render_close(r);
+    }
+
+    /* Note 127 in gate mode, and data bytes above it */
+    {
+        rex_render_t *r = rex_render_open(TONES_PATH, "{\"start_note\":120,\"mode\":\"gate\"}",
+                                          err, sizeof(err));
+        int on = 0, off = -1, bad = -1;
+        if (r) {
+            note(r, 0x90, 127, 127, 10);
+            on = render_onsets(r, 1, at, 64) > 0 && at[0] == 10 && rex_render_voices(r) == 1;
+            note(r, 0x80, 127, 0, 0);
+            render_onsets(r, 1, at, 64);
+            off = rex_render_voices(r);
+
+            note(r, 0x90, 128, 127, 0);
+            note(r, 0x90, 255, 127, 0);
+            note(r, 0x90, 127, 128, 0);
+            note(r, 0x80, 200, 0, 0);
+            bad = render_onsets(r, 1, at, 64) + rex_render_voices(r);
+        }
+        check("Note 127 starts and stops", on && off == 0);
+        check("Data bytes above 127 ignored", bad == 0);
+        rex_render_close(r);
+    }
+
+    /* Voice pool: steals at the polyphony limit, and note-offs still find
+     * every voice left on each note's chain */
+    {
+        rex_render_t *r = rex_render_open(TONES_PATH, "{\"polyphony\":8,\"mode\":\"gate\"}",
+                                          err, sizeof(err));
+        int full = 0, left = -1;
+        if (r) {
+            int first = rex_render_start_note(r);
+            for (int i = 0; i < 12; i++)
+                note(r, 0x90, first + i % 3, 100, i * 10);
+            render_onsets(r, 1, at, 64);
+            full = rex_render_voices(r) == 8;
+            for (int i = 0; i < 3; i++)
+                note(r, 0x80, first + i, 0, 0);
+            render_onsets(r, 1, at, 64);
+            left = rex_render_voices(r);
+        }
+        check("Voices stolen at the polyphony limit", full);
+        check("Note-offs find every voice after steals", left == 0);
+        rex_render_close(r);
+    }
+
+    remove(PATH);
+    remove(TONES_PATH);
+
+    printf("\n=== Results: %d/%d passed ===\n", pass_count, test_count);
+    return (pass_count == test_count) ? 0 : 1;
+}
@@ -7,7 +7,7 @@
  * Build (native macOS/Linux):
  *   cc -O2 -Isrc/dsp -o test/test_rex_roundtrip \
  *      test/test_rex_roundtrip.c src/dsp/rex_writer.c src/dsp/dwop_encode.c \
- *      src/dsp/rex_parser.c src/dsp/dwop.c -lm
+ *      src/dsp/byte_sink.c src/dsp/rex_parser.c src/dsp/dwop.c -lm -lpthread
  *
  * Run:   ./test/test_rex_roundtrip
  */
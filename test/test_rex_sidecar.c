@@ -0,0 +1,142 @@
+/*
+ * Decoded PCM Sidecar Test
+ *
+ * Verifies: a full load writes a sidecar, the next load is served from it
+ * (proven by a marker sample patched into the sidecar), planar buffers are
+ * still built on a hit, and a source file with a new mtime, a corrupt
+ * sidecar or a disabled switch all fall back to decoding.
+ *
+ * Build (native macOS/Linux):
+ *   cc -O2 -Isrc/dsp -o test/test_rex_sidecar \
+ *      test/test_rex_sidecar.c src/dsp/rex_sidecar.c src/dsp/rex_cache.c \
+ *      src/dsp/mapped_file.c src/dsp/rex_writer.c src/dsp/dwop_encode.c \
+ *      src/dsp/byte_sink.c src/dsp/rex_parser.c src/dsp/dwop.c -lm -lpthread
+ *
+ * Run:   ./test/test_rex_sidecar
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+#include "test_loop.h"
+#include "rex_cache.h"
+#include "rex_sidecar.h"
+
+#define MARKER 12345
+
+static int test_count = 0;
+static int pass_count = 0;
+
+static void check(const char *name, int ok)
+{
+    test_count++;
+    printf("  %-40s ... %s\n", name, ok ? "PASS" : "FAIL");
+    if (ok) pass_count++;
+}
+
+/* Write a stereo two-slice loop of num_frames to path */
+static int write_loop(const char *path, int num_frames)
+{
+    test_loop_t p = { .channels = 2, .frames = num_frames, .slices = 2 };
+    return test_loop_write(path, &p);
+}
+
+/* Overwrite the last int16 of the sidecar (the final R sample) */
+static int patch_last_sample(const char *sidecar, int16_t value)
+{
+    FILE *f = fopen(sidecar, "r+b");
+    if (!f) return -1;
+    fseek(f, -(long)sizeof(int16_t), SEEK_END);
+    fwrite(&value, sizeof(value), 1, f);
+    fclose(f);
+    return 0;
+}
+
+static int last_sample(const rex_file_t *rex)
+{
+    return rex->pcm_data[(size_t)rex->pcm_samples * rex->pcm_channels - 1];
+}
+
+int main(void)
+{
+    printf("=== Decoded PCM Sidecar Tests ===\n\n");
+
+    const char *path = "/tmp/test_rex_sidecar.rx2";
+    char sidecar[1024], err[256];
+    struct stat st;
+
+    if (write_loop(path, 22050) != 0 || rex_sidecar_path(path, sidecar, sizeof(sidecar)) != 0) {
+        printf("FAIL (cannot write test file)\n");
+        return 1;
+    }
+    check("Sidecar path in .rexcache",
+          strcmp(sidecar, "/tmp/.rexcache/test_rex_sidecar.rx2.pcm") == 0);
+    unlink(sidecar);
+
+    /* Cold load decodes and writes the sidecar */
+    rex_file_t *decoded = rex_load_file(path, 0, err, sizeof(err));
+    check("Cold load decodes", decoded && decoded->pcm_samples == 22050);
+    check("Cold load writes the sidecar", stat(sidecar, &st) == 0);
+
+    /* Warm load is served from the sidecar */
+    patch_last_sample(sidecar, MARKER);
+    rex_file_t *warm = rex_load_file(path, REX_PARSE_PLANAR_F32, err, sizeof(err));
+    check("Warm load comes from the sidecar", warm && last_sample(warm) == MARKER);
+    int same = warm && decoded && warm->pcm_samples == decoded->pcm_samples &&
+               warm->pcm_channels == decoded->pcm_channels &&
+               warm->slice_count == decoded->slice_count &&
+               warm->tempo_bpm == decoded->tempo_bpm &&
+               memcmp(warm->pcm_data, decoded->pcm_data,
+                      ((size_t)decoded->pcm_samples * 2 - 1) * sizeof(int16_t)) == 0;
+    for (int i = 0; same && i < decoded->slice_count; i++) {
+        same = warm->slices[i].sample_offset == decoded->slices[i].sample_offset &&
+               warm->slices[i].sample_length == decoded->slices[i].sample_length;
+    }
+    check("Sidecar matches the decode", same);
+    check("Planar buffers built on a hit",
+          warm && warm->planar == REX_PLANAR_F32 && warm->slices[1].plane[1] &&
+          ((const float *)warm->slices[1].plane[1])[warm->slices[1].sample_length - 1] == MARKER);
+    rex_file_destroy(warm);
+
+    /* Lazy loads never use it */
+    rex_file_t *lazy = rex_load_file(path, REX_PARSE_LAZY, err, sizeof(err));
+    check("Lazy load ignores the sidecar", lazy && lazy->lazy && !lazy->pcm_data);
+    rex_file_destroy(lazy);
+
+    /* Disabled: decode without touching it */
+    rex_sidecar_set_enabled(0);
+    rex_file_t *off = rex_load_file(path, 0, err, sizeof(err));
+    check("Disabled switch decodes", off && last_sample(off) == last_sample(decoded));
+    rex_file_destroy(off);
+    rex_sidecar_set_enabled(1);
+
+    /* Source touched: sidecar is stale and gets rewritten */
+    stat(path, &st);
+    struct utimbuf times = { st.st_atime, st.st_mtime + 10 };
+    utime(path, &times);
+    rex_file_t *stale = rex_load_file(path, 0, err, sizeof(err));
+    check("Stale sidecar is not used", stale && last_sample(stale) == last_sample(decoded));
+    rex_file_destroy(stale);
+    patch_last_sample(sidecar, MARKER);
+    rex_file_t *again = rex_load_file(path, 0, err, sizeof(err));
+    check("Stale sidecar was rewritten", again && last_sample(again) == MARKER);
+    rex_file_destroy(again);
+
+    /* Truncated sidecar is rejected */
+    truncate(sidecar, 100);
+    rex_file_t *bad = rex_load_file(path, 0, err, sizeof(err));
+    check("Truncated sidecar falls back", bad && last_sample(bad) == last_sample(decoded));
+    rex_file_destroy(bad);
+
+    rex_file_destroy(decoded);
+    unlink(sidecar);
+    unlink(path);
+
+    printf("\n=== Results: %d/%d passed ===\n", pass_count, test_count);
+    return (pass_count == test_count) ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+/*
+ * Streaming Writer Test
+ *
+ * Verifies: DWOP and REX2 output streamed into a growable sink or a file
+ * descriptor is byte-identical to the fixed-buffer output, chunk lengths
+ * are back-patched correctly (including into bytes already written out to
+ * the file), the file parses and decodes, and a fixed buffer that is too
+ * small fails without overrunning.
+ *
+ * Build (native macOS/Linux):
+ *   cc -O2 -Isrc/dsp -o test/test_rex_sink \
+ *      test/test_rex_sink.c src/dsp/byte_sink.c src/dsp/rex_writer.c \
+ *      src/dsp/dwop_encode.c src/dsp/rex_parser.c src/dsp/dwop.c -lm -lpthread
+ *
+ * Run:   ./test/test_rex_sink
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "byte_sink.h"
+#include "dwop_encode.h"
+#include "rex_writer.h"
+#include "rex_parser.h"
+
+#define NUM_FRAMES 120000  /* compresses to well past the fd staging size */
+#define NUM_SLICES 6
+
+static int test_count = 0;
+static int pass_count = 0;
+
+static void check(const char *name, int ok)
+{
+    test_count++;
+    printf("  %-40s ... %s\n", name, ok ? "PASS" : "FAIL");
+    if (ok) pass_count++;
+}
+
+int main(void)
+{
+    printf("=== Streaming Writer Tests ===\n\n");
+
+    /* Noisy stereo, so it does not compress much */
+    int16_t *pcm = (int16_t *)malloc((size_t)NUM_FRAMES * 2 * sizeof(int16_t));
+    uint32_t seed = 99;
+    for (int i = 0; i < NUM_FRAMES; i++) {
+        seed = seed * 1664525 + 1013904223;
+        pcm[i * 2] = (int16_t)(12000.0 * sin(2.0 * M_PI * 220.0 * i / 44100.0) +
+                               (int16_t)(seed >> 16) / 8);
+        pcm[i * 2 + 1] = (int16_t)((int16_t)(seed >> 8) / 4);
+    }
+
+    rex_write_slice_t slices[NUM_SLICES];
+    for (int i = 0; i < NUM_SLICES; i++) {
+        slices[i].sample_offset = (uint32_t)(NUM_FRAMES / NUM_SLICES * i);
+        slices[i].sample_length = (uint32_t)(NUM_FRAMES / NUM_SLICES);
+    }
+    rex_write_params_t wp;
+    memset(&wp, 0, sizeof(wp));
+    wp.tempo_bpm = 128.0f;
+    wp.bars = 2;
+    wp.time_sig_num = 4;
+    wp.time_sig_den = 4;
+    wp.sample_rate = 44100;
+    wp.channels = 2;
+    wp.pcm_data = pcm;
+    wp.num_frames = NUM_FRAMES;
+    wp.slice_count = NUM_SLICES;
+    wp.slices = slices;
+
+    /* DWOP: sink and fixed buffer agree */
+    int comp_cap = NUM_FRAMES * 2 * 3 + 4096;
+    uint8_t *comp = (uint8_t *)malloc(comp_cap);
+    int comp_bytes = dwop_encode_stereo(pcm, NUM_FRAMES, comp, comp_cap, 1);
+    byte_sink_t sink;
+    byte_sink_init_growable(&sink);
+    int sink_bytes = dwop_encode_stereo_sink(pcm, NUM_FRAMES, &sink, 1);
+    check("DWOP sink matches fixed buffer",
+          comp_bytes > 0 && sink_bytes == comp_bytes &&
+          byte_sink_tell(&sink) == (size_t)comp_bytes &&
+          memcmp(sink.buf, comp, comp_bytes) == 0);
+    byte_sink_free(&sink);
+    free(comp);
+
+    /* REX2: fixed buffer reference */
+    int buf_cap = NUM_FRAMES * 2 * 3 + 4096;
+    uint8_t *ref = (uint8_t *)malloc(buf_cap);
+    int ref_bytes = rex_write(&wp, ref, buf_cap);
+    check("Fixed-buffer write succeeds", ref_bytes > 2 * BYTE_SINK_STAGING);
+
+    /* Growable, appended after existing bytes */
+    byte_sink_init_growable(&sink);
+    byte_sink_write(&sink, "abc", 3);
+    int grown = rex_write_sink(&wp, &sink);
+    size_t grown_len;
+    uint8_t *grown_buf = byte_sink_take(&sink, &grown_len);
+    check("Growable sink matches, at an offset",
+          grown == ref_bytes && grown_len == (size_t)ref_bytes + 3 &&
+          memcmp(grown_buf, "abc", 3) == 0 && memcmp(grown_buf + 3, ref, ref_bytes) == 0);
+    free(grown_buf);
+    byte_sink_free(&sink);
+
+    /* File descriptor: the CAT length is patched into flushed bytes */
+    const char *path = "/tmp/test_rex_sink.rx2";
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    int fd_bytes = 0;
+    if (fd >= 0 && byte_sink_init_fd(&sink, fd) == 0) {
+        fd_bytes = rex_write_sink(&wp, &sink);
+        if (byte_sink_flush(&sink) != 0) fd_bytes = 0;
+    }
+    byte_sink_free(&sink);
+    uint8_t *file = (uint8_t *)malloc(buf_cap);
+    ssize_t file_len = fd >= 0 ? pread(fd, file, buf_cap, 0) : -1;
+    if (fd >= 0) close(fd);
+    check("Fd sink matches",
+          fd_bytes == ref_bytes && file_len == ref_bytes && memcmp(file, ref, ref_bytes) == 0);
+
+    rex_file_t rex;
+    int ok = file_len > 0 && rex_parse(&rex, file, (size_t)file_len) == 0;
+    check("Streamed file decodes to the input",
+          ok && rex.slice_count == NUM_SLICES && rex.pcm_samples == NUM_FRAMES &&
+          memcmp(rex.pcm_data, pcm, (size_t)NUM_FRAMES * 2 * sizeof(int16_t)) == 0);
+    if (ok) rex_free(&rex);
+    free(file);
+    unlink(path);
+
+    /* Too small a fixed buffer fails without writing past it */
+    int small_cap = ref_bytes / 2;
+    uint8_t *small = (uint8_t *)malloc(small_cap + 16);
+    memset(small + small_cap, 0xA5, 16);
+    int small_bytes = rex_write(&wp, small, small_cap);
+    int intact = 1;
+    for (int i = 0; i < 16; i++) intact &= small[small_cap + i] == 0xA5;
+    check("Short buffer fails cleanly", small_bytes == 0 && intact);
+    free(small);
+
+    free(ref);
+    free(pcm);
+
+    printf("\n=== Results: %d/%d passed ===\n", pass_count, test_count);
+    return (pass_count == test_count) ? 0 : 1;
+}
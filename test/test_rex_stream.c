@@ -0,0 +1,277 @@
+/*
+ * Streaming Encode Test
+ *
+ * Verifies: the incremental WAV reader returns the same PCM as wav_read()
+ * for 16/24/32-bit input with extra chunks and for a truncated data chunk,
+ * reading in odd block sizes; block-wise stereo DWOP encoding and a REX2
+ * file pulled through read_pcm are byte-identical to the whole-buffer
+ * output; and a sidecar appended block by block matches one stored from
+ * the decoded file.
+ *
+ * Build (native macOS/Linux):
+ *   cc -O2 -Isrc/dsp -o test/test_rex_stream \
+ *      test/test_rex_stream.c src/dsp/wav_reader.c src/dsp/rex_writer.c \
+ *      src/dsp/dwop_encode.c src/dsp/byte_sink.c src/dsp/rex_sidecar.c \
+ *      src/dsp/mapped_file.c src/dsp/rex_parser.c src/dsp/dwop.c -lm -lpthread
+ *
+ * Run:   ./test/test_rex_stream
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "wav_reader.h"
+#include "dwop_encode.h"
+#include "rex_writer.h"
+#include "rex_sidecar.h"
+
+#define DIR_PATH "/tmp/test_rex_stream"
+#define NUM_FRAMES 30011  /* not a multiple of any block size */
+
+static int test_count = 0;
+static int pass_count = 0;
+
+static void check(const char *name, int ok)
+{
+    test_count++;
+    printf("  %-40s ... %s\n", name, ok ? "PASS" : "FAIL");
+    if (ok) pass_count++;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put_u32(uint8_t *p, uint32_t v) { put_u16(p, (uint16_t)v); put_u16(p + 2, (uint16_t)(v >> 16)); }
+
+/* WAV with a LIST chunk ahead of fmt; truncate drops the data tail */
+static size_t make_wav(uint8_t *buf, int channels, int bps, int frames, int truncate)
+{
+    int bpf = channels * bps / 8;
+    uint32_t data_len = (uint32_t)(frames * bpf);
+    uint8_t *p = buf + 12;
+    memcpy(p, "LIST", 4); put_u32(p + 4, 3); memcpy(p + 8, "abc\0", 4); p += 12;
+    memcpy(p, "fmt ", 4); put_u32(p + 4, 16);
+    put_u16(p + 8, 1); put_u16(p + 10, (uint16_t)channels);
+    put_u32(p + 12, 44100); put_u32(p + 16, 44100 * bpf);
+    put_u16(p + 20, (uint16_t)bpf); put_u16(p + 22, (uint16_t)bps); p += 24;
+    memcpy(p, "data", 4); put_u32(p + 4, data_len); p += 8;
+
+    uint32_t seed = 7;
+    for (int i = 0; i < frames * channels; i++) {
+        seed = seed * 1664525 + 1013904223;
+        int32_t v = (int32_t)(2.0e9 * sin(0.01 * i)) + (int32_t)(seed >> 12);
+        for (int b = 0; b < bps / 8; b++) *p++ = (uint8_t)(v >> (32 - bps + 8 * b));
+    }
+    size_t len = (size_t)(p - buf);
+    if (truncate) len -= (size_t)truncate;
+    memcpy(buf, "RIFF", 4); put_u32(buf + 4, (uint32_t)(len - 8)); memcpy(buf + 8, "WAVE", 4);
+    return len;
+}
+
+static int write_file(const char *path, const void *data, size_t len)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    size_t n = fwrite(data, 1, len, f);
+    fclose(f);
+    return n == len ? 0 : -1;
+}
+
+static int read_file(const char *path, uint8_t **data, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    fseek(f, 0, SEEK_END);
+    *len = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    *data = (uint8_t *)malloc(*len ? *len : 1);
+    size_t got = fread(*data, 1, *len, f);
+    fclose(f);
+    return got == *len ? 0 : -1;
+}
+
+/* Stream path into out in blocks cycling through odd sizes */
+static int stream_all(const char *path, wav_stream_t *ws, int16_t *out)
+{
+    static const int sizes[] = { 1, 4095, 4096, 4097, 777 };
+    if (wav_stream_open(ws, path) != 0) return -1;
+    int total = 0;
+    for (int i = 0;; i++) {
+        int got = wav_stream_read(ws, out + (size_t)total * ws->channels, sizes[i % 5]);
+        if (got < 0) return -1;
+        if (got == 0) break;
+        total += got;
+    }
+    return total;
+}
+
+typedef struct {
+    const int16_t *pcm;
+    int channels;
+    int pos;
+    int calls;
+} mem_source_t;
+
+static int read_mem(void *ctx, int16_t *buf, int max_frames)
+{
+    mem_source_t *src = (mem_source_t *)ctx;
+    int n = max_frames > 1000 ? max_frames - 1000 : max_frames;  /* short reads */
+    memcpy(buf, src->pcm + (size_t)src->pos * src->channels,
+           (size_t)n * src->channels * sizeof(int16_t));
+    src->pos += n;
+    src->calls++;
+    return n;
+}
+
+int main(void)
+{
+    printf("=== Streaming Encode Tests ===\n\n");
+
+    mkdir(DIR_PATH, 0755);
+    const char *wav_path = DIR_PATH "/in.wav";
+    uint8_t *file = (uint8_t *)malloc((size_t)NUM_FRAMES * 8 + 256);
+    int16_t *streamed = (int16_t *)malloc((size_t)NUM_FRAMES * 2 * sizeof(int16_t));
+
+    /* Reader: every depth, plus a truncated data chunk */
+    static const int depths[][3] = { { 2, 16, 0 }, { 1, 24, 0 }, { 2, 32, 0 }, { 2, 24, 7 } };
+    for (int t = 0; t < 4; t++) {
+        size_t len = make_wav(file, depths[t][0], depths[t][1], NUM_FRAMES, depths[t][2]);
+        write_file(wav_path, file, len);
+        wav_file_t wav;
+        wav_stream_t ws;
+        int ok = wav_read(&wav, file, len) == 0;
+        int frames = stream_all(wav_path, &ws, streamed);
+        ok = ok && frames == wav.num_frames && ws.num_frames == wav.num_frames &&
+             ws.channels == wav.channels && ws.sample_rate == wav.sample_rate &&
+             memcmp(streamed, wav.pcm_data, (size_t)frames * wav.channels * 2) == 0;
+        wav_stream_close(&ws);
+        if (ok) wav_free(&wav);
+        char name[64];
+        snprintf(name, sizeof(name), "Stream reader %dch %d-bit%s", depths[t][0], depths[t][1],
+                 depths[t][2] ? " truncated" : "");
+        check(name, ok);
+    }
+
+    /* Not a WAV */
+    wav_stream_t ws;
+    write_file(wav_path, "RIFF\0\0\0\0JUNKxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx", 52);
+    int bad = wav_stream_open(&ws, wav_path) != 0 && strstr(ws.error, "RIFF") != NULL;
+    wav_stream_close(&ws);
+    check("Stream reader rejects non-WAV", bad);
+
+    /* Stereo source for the encoder checks */
+    size_t len = make_wav(file, 2, 16, NUM_FRAMES, 0);
+    write_file(wav_path, file, len);
+    int frames = stream_all(wav_path, &ws, streamed);
+    wav_stream_close(&ws);
+
+    /* Stereo DWOP in blocks equals one shot */
+    byte_sink_t whole, blocks;
+    byte_sink_init_growable(&whole);
+    byte_sink_init_growable(&blocks);
+    int whole_bytes = dwop_encode_stereo_sink(streamed, frames, &whole, 1);
+    dwop_stereo_enc_t enc;
+    int ok = dwop_stereo_enc_init_sink(&enc, &blocks) == 0;
+    for (int pos = 0, n = 1; ok && pos < frames; pos += n, n = n * 3 + 1) {
+        if (n > frames - pos) n = frames - pos;
+        ok = dwop_stereo_enc_block(&enc, streamed + (size_t)pos * 2, n, 1) == n;
+    }
+    int block_bytes = ok ? dwop_enc_flush(&enc.bw) : 0;
+    check("Block stereo DWOP matches one shot",
+          whole_bytes > 0 && block_bytes == whole_bytes &&
+          memcmp(whole.buf, blocks.buf, whole_bytes) == 0);
+    byte_sink_free(&whole);
+    byte_sink_free(&blocks);
+
+    /* REX2 pulled through read_pcm equals the buffer version, both
+     * layouts */
+    for (int ch = 1; ch <= 2; ch++) {
+        int16_t *pcm = streamed;
+        int16_t *mono = NULL;
+        if (ch == 1) {
+            mono = (int16_t *)malloc((size_t)frames * sizeof(int16_t));
+            for (int i = 0; i < frames; i++) mono[i] = streamed[i * 2];
+            pcm = mono;
+        }
+        rex_write_slice_t slices[2] = { { 0, 10000 }, { 10000, (uint32_t)frames - 10000 } };
+        rex_write_params_t wp;
+        memset(&wp, 0, sizeof(wp));
+        wp.tempo_bpm = 120.0f;
+        wp.bars = 1;
+        wp.time_sig_num = 4;
+        wp.time_sig_den = 4;
+        wp.sample_rate = 44100;
+        wp.channels = ch;
+        wp.pcm_data = pcm;
+        wp.num_frames = frames;
+        wp.slice_count = 2;
+        wp.slices = slices;
+        byte_sink_init_growable(&whole);
+        int ref = rex_write_sink(&wp, &whole);
+
+        mem_source_t src = { pcm, ch, 0, 0 };
+        wp.pcm_data = NULL;
+        wp.read_pcm = read_mem;
+        wp.read_ctx = &src;
+        byte_sink_init_growable(&blocks);
+        int pulled = rex_write_sink(&wp, &blocks);
+        check(ch == 1 ? "Pulled mono REX2 matches buffer" : "Pulled stereo REX2 matches buffer",
+              ref > 0 && pulled == ref && src.pos == frames && src.calls > frames / REX_WRITE_BLOCK &&
+              memcmp(whole.buf, blocks.buf, ref) == 0);
+
+        /* Sidecar: appended in blocks vs stored from the decoded file */
+        if (ch == 2) {
+            const char *rx2 = DIR_PATH "/out.rx2";
+            char sc_path[512];
+            uint8_t *a = NULL, *b = NULL;
+            size_t a_len = 0, b_len = 0;
+            write_file(rx2, blocks.buf, (size_t)pulled);
+            rex_sidecar_path(rx2, sc_path, sizeof(sc_path));
+
+            rex_file_t rex;
+            int same = rex_parse(&rex, blocks.buf, (size_t)pulled) == 0 &&
+                       rex_sidecar_store(rx2, &rex) == 0 &&
+                       read_file(sc_path, &a, &a_len) == 0;
+            unlink(sc_path);
+
+            rex_sidecar_writer_t w;
+            same = same && rex_sidecar_begin(&w, rx2) == 0;
+            for (int pos = 0; same && pos < frames; pos += 5000) {
+                int n = frames - pos < 5000 ? frames - pos : 5000;
+                same = rex_sidecar_append(&w, streamed + (size_t)pos * 2, (size_t)n * 2) == 0;
+            }
+            same = same && rex_sidecar_finish(&w, rx2, &rex) == 0 &&
+                   read_file(sc_path, &b, &b_len) == 0 &&
+                   a_len == b_len && memcmp(a, b, a_len) == 0;
+            check("Appended sidecar matches stored", same);
+            rex_free(&rex);
+            free(a);
+            free(b);
+
+            /* An aborted writer leaves the existing sidecar alone */
+            same = rex_sidecar_begin(&w, rx2) == 0 && rex_sidecar_append(&w, streamed, 100) == 0;
+            rex_sidecar_abort(&w);
+            rex_file_t again;
+            same = same && rex_sidecar_load(rx2, &again, NULL) == 0 && again.pcm_samples == frames;
+            if (same) rex_free(&again);
+            check("Abort keeps the previous sidecar", same);
+
+            unlink(sc_path);
+            unlink(rx2);
+            rmdir(DIR_PATH "/" REX_SIDECAR_DIR);
+        }
+        byte_sink_free(&whole);
+        byte_sink_free(&blocks);
+        free(mono);
+    }
+
+    unlink(wav_path);
+    rmdir(DIR_PATH);
+    free(streamed);
+    free(file);
+
+    printf("\n=== Results: %d/%d passed ===\n", pass_count, test_count);
+    return (pass_count == test_count) ? 0 : 1;
+}